@@ -0,0 +1,90 @@
+#include <allocation_tracking.hpp>
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+std::atomic<std::uint64_t> total_allocations(0);
+std::atomic<std::uint64_t> total_allocated_bytes(0);
+
+thread_local alia::allocation_counts* active_allocation_counts = nullptr;
+
+void*
+tracked_allocate(std::size_t size)
+{
+    total_allocations.fetch_add(1, std::memory_order_relaxed);
+    total_allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+    if (active_allocation_counts)
+    {
+        ++active_allocation_counts->allocations;
+        active_allocation_counts->bytes += size;
+    }
+    void* p = std::malloc(size ? size : 1);
+    if (!p)
+        throw std::bad_alloc();
+    return p;
+}
+
+} // namespace
+
+void*
+operator new(std::size_t size)
+{
+    return tracked_allocate(size);
+}
+
+void*
+operator new[](std::size_t size)
+{
+    return tracked_allocate(size);
+}
+
+void
+operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void
+operator delete[](void* p) noexcept
+{
+    std::free(p);
+}
+
+void
+operator delete(void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+void
+operator delete[](void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+namespace alia {
+
+allocation_counts
+get_allocation_counts()
+{
+    allocation_counts counts;
+    counts.allocations = total_allocations.load(std::memory_order_relaxed);
+    counts.bytes = total_allocated_bytes.load(std::memory_order_relaxed);
+    return counts;
+}
+
+scoped_allocation_counter::scoped_allocation_counter(allocation_counts& counts)
+    : previous_(active_allocation_counts)
+{
+    active_allocation_counts = &counts;
+}
+
+scoped_allocation_counter::~scoped_allocation_counter()
+{
+    active_allocation_counts = previous_;
+}
+
+} // namespace alia
@@ -0,0 +1,41 @@
+#ifndef ALIA_ALLOCATION_TRACKING_HPP
+#define ALIA_ALLOCATION_TRACKING_HPP
+
+#include <cstdint>
+
+// This file provides heap allocation tracking for the unit tests and the
+// benchmarks.
+//
+// The accompanying source file replaces the global allocation operators so
+// that they can count allocations, so it must only be linked into test and
+// benchmark programs (never into the library itself).
+
+namespace alia {
+
+// allocation_counts records a number of heap allocations (via global operator
+// new) and the total bytes requested.
+struct allocation_counts
+{
+    std::uint64_t allocations = 0;
+    std::uint64_t bytes = 0;
+};
+
+// Get the counts for the whole process since it started.
+allocation_counts
+get_allocation_counts();
+
+// scoped_allocation_counter adds the allocations made on the current thread
+// during its lifetime to :counts. (Allocations made by other threads aren't
+// included.)
+struct scoped_allocation_counter
+{
+    scoped_allocation_counter(allocation_counts& counts);
+    ~scoped_allocation_counter();
+
+ private:
+    allocation_counts* previous_;
+};
+
+} // namespace alia
+
+#endif
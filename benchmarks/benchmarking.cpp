@@ -0,0 +1,178 @@
+#include <benchmarking.hpp>
+
+#include <functional>
+
+namespace alia {
+
+namespace {
+
+struct registered_benchmark
+{
+    char const* name;
+    benchmark_function function;
+    bool has_arg;
+    long long arg;
+};
+
+std::vector<registered_benchmark>&
+get_registry()
+{
+    static std::vector<registered_benchmark> registry;
+    return registry;
+}
+
+// the minimum total run time for a benchmark to be considered measured
+double const minimum_run_time = 0.25;
+
+// Run :benchmark for the given number of iterations, returning the elapsed
+// time and recording the number of allocations in :allocations.
+double
+time_iterations(
+    registered_benchmark const& benchmark,
+    std::size_t iterations,
+    std::uint64_t* allocations)
+{
+    benchmark_state state(iterations, benchmark.arg);
+    benchmark.function(state);
+    *allocations = state.allocations();
+    return state.elapsed_time();
+}
+
+std::string
+get_full_name(registered_benchmark const& benchmark)
+{
+    std::string name = benchmark.name;
+    if (benchmark.has_arg)
+        name += "/" + std::to_string(benchmark.arg);
+    return name;
+}
+
+benchmark_result
+measure_benchmark(registered_benchmark const& benchmark)
+{
+    std::size_t iterations = 1;
+    double elapsed;
+    std::uint64_t allocations;
+    while ((elapsed = time_iterations(benchmark, iterations, &allocations))
+           < minimum_run_time)
+    {
+        // Extrapolate from the time so far, but don't grow too fast, since
+        // the first runs often include one-time setup costs.
+        std::size_t const max_growth = iterations * 10;
+        std::size_t predicted
+            = elapsed > 0
+                  ? std::size_t(iterations * minimum_run_time * 1.2 / elapsed)
+                  : max_growth;
+        if (predicted <= iterations)
+            predicted = iterations + 1;
+        iterations = predicted < max_growth ? predicted : max_growth;
+    }
+    benchmark_result result;
+    result.name = get_full_name(benchmark);
+    result.base_name = benchmark.name;
+    result.has_arg = benchmark.has_arg;
+    result.arg = benchmark.arg;
+    result.iterations = iterations;
+    result.ns_per_iteration = elapsed * 1e9 / double(iterations);
+    result.allocations_per_iteration
+        = double(allocations) / double(iterations);
+    return result;
+}
+
+void
+run_matching_benchmarks(
+    std::string const& filter,
+    std::function<void(benchmark_result const&)> const& report)
+{
+    for (auto const& benchmark : get_registry())
+    {
+        if (get_full_name(benchmark).find(filter) == std::string::npos)
+            continue;
+        report(measure_benchmark(benchmark));
+    }
+}
+
+} // namespace
+
+benchmark_registrar::benchmark_registrar(
+    char const* name, benchmark_function function)
+{
+    get_registry().push_back(registered_benchmark{name, function, false, 0});
+}
+
+benchmark_registrar::benchmark_registrar(
+    char const* name,
+    benchmark_function function,
+    std::initializer_list<long long> args)
+{
+    for (long long arg : args)
+    {
+        get_registry().push_back(
+            registered_benchmark{name, function, true, arg});
+    }
+}
+
+std::vector<benchmark_result>
+run_benchmarks(std::string const& filter)
+{
+    std::vector<benchmark_result> results;
+    run_matching_benchmarks(filter, [&](benchmark_result const& result) {
+        results.push_back(result);
+    });
+    return results;
+}
+
+void
+run_benchmarks(std::string const& filter, benchmark_output_format format)
+{
+    switch (format)
+    {
+        case benchmark_output_format::TEXT:
+            run_matching_benchmarks(
+                filter, [](benchmark_result const& result) {
+                    std::printf(
+                        "%-48s %12zu %14.1f ns/iter %10.2f allocs/iter\n",
+                        result.name.c_str(),
+                        result.iterations,
+                        result.ns_per_iteration,
+                        result.allocations_per_iteration);
+                    std::fflush(stdout);
+                });
+            break;
+        case benchmark_output_format::JSON:
+            write_benchmark_results_json(stdout, run_benchmarks(filter));
+            break;
+    }
+}
+
+void
+write_benchmark_results_json(
+    std::FILE* out, std::vector<benchmark_result> const& results)
+{
+    // Benchmark names are C identifiers (plus an optional '/<arg>'), so they
+    // never need escaping.
+    std::fprintf(out, "{\n  \"benchmarks\": [");
+    bool first = true;
+    for (auto const& result : results)
+    {
+        std::fprintf(
+            out,
+            "%s\n    {\"name\": \"%s\", \"base_name\": \"%s\", ",
+            first ? "" : ",",
+            result.name.c_str(),
+            result.base_name.c_str());
+        if (result.has_arg)
+            std::fprintf(out, "\"arg\": %lld, ", result.arg);
+        std::fprintf(
+            out,
+            "\"iterations\": %zu, \"ns_per_iteration\": %.1f, "
+            "\"allocations_per_iteration\": %.2f}",
+            result.iterations,
+            result.ns_per_iteration,
+            result.allocations_per_iteration);
+        first = false;
+    }
+    std::fprintf(out, "\n  ]\n}\n");
+}
+
+} // namespace alia
@@ -0,0 +1,187 @@
+#ifndef ALIA_BENCHMARKING_HPP
+#define ALIA_BENCHMARKING_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <initializer_list>
+#include <string>
+#include <vector>
+
+#include <allocation_tracking.hpp>
+
+// This is a minimal benchmarking harness for alia.
+//
+// A benchmark is a function that takes a benchmark_state and runs its
+// workload once per iteration of a keep_running() loop:
+//
+//   ALIA_BENCHMARK(my_benchmark)
+//   {
+//       // ... setup ...
+//       while (state.keep_running())
+//       {
+//           // ... workload ...
+//       }
+//   }
+//
+// Only the keep_running() loop is timed, so setup work doesn't affect the
+// results.
+//
+// Benchmarks can also be parameterized by an integer argument (typically the
+// size of the workload). A parameterized benchmark is run once for each of
+// the arguments that it's declared with, and it can access the current
+// argument via state.arg():
+//
+//   ALIA_BENCHMARK_WITH_ARGS(my_benchmark, 10, 100, 1000)
+//   {
+//       auto data = make_data(state.arg());
+//       while (state.keep_running())
+//       {
+//           // ... workload ...
+//       }
+//   }
+//
+// The runner invokes each benchmark with increasing iteration counts until
+// the total run time is long enough to give a meaningful per-iteration time.
+// It also reports the number of heap allocations per iteration (again, only
+// counting the keep_running() loop).
+
+namespace alia {
+
+struct benchmark_state
+{
+    // Call this once per iteration. It returns false when the benchmark should
+    // stop.
+    bool
+    keep_running()
+    {
+        if (completed_iterations_ == 0)
+        {
+            start_allocations_ = get_allocation_counts();
+            start_time_ = std::chrono::steady_clock::now();
+        }
+        if (completed_iterations_++ < iterations_)
+            return true;
+        end_time_ = std::chrono::steady_clock::now();
+        end_allocations_ = get_allocation_counts();
+        return false;
+    }
+
+    std::size_t
+    iterations() const
+    {
+        return iterations_;
+    }
+
+    // the argument that the benchmark is being run with (or 0 if it's not
+    // parameterized)
+    long long
+    arg() const
+    {
+        return arg_;
+    }
+
+    // the time spent in the keep_running() loop, in seconds
+    double
+    elapsed_time() const
+    {
+        return std::chrono::duration<double>(end_time_ - start_time_).count();
+    }
+
+    // the number of heap allocations made in the keep_running() loop
+    std::uint64_t
+    allocations() const
+    {
+        return end_allocations_.allocations - start_allocations_.allocations;
+    }
+
+    benchmark_state(std::size_t iterations, long long arg)
+        : iterations_(iterations), arg_(arg), completed_iterations_(0)
+    {
+    }
+
+ private:
+    std::size_t iterations_;
+    long long arg_;
+    std::size_t completed_iterations_;
+    std::chrono::steady_clock::time_point start_time_, end_time_;
+    allocation_counts start_allocations_, end_allocations_;
+};
+
+typedef void (*benchmark_function)(benchmark_state& state);
+
+struct benchmark_registrar
+{
+    benchmark_registrar(char const* name, benchmark_function function);
+
+    benchmark_registrar(
+        char const* name,
+        benchmark_function function,
+        std::initializer_list<long long> args);
+};
+
+enum class benchmark_output_format
+{
+    TEXT,
+    JSON
+};
+
+// the measured results of a single benchmark run
+struct benchmark_result
+{
+    // the name of the benchmark, including its argument (if any), as in
+    // 'my_benchmark/100'
+    std::string name;
+    std::string base_name;
+    bool has_arg;
+    long long arg;
+    std::size_t iterations;
+    double ns_per_iteration;
+    double allocations_per_iteration;
+};
+
+// Run all registered benchmarks whose full names (including arguments)
+// contain :filter and return the results.
+std::vector<benchmark_result>
+run_benchmarks(std::string const& filter);
+
+// Run all registered benchmarks whose full names contain :filter and report
+// the results to stdout in the given format.
+// In TEXT format, each result is written as it's measured. In JSON format,
+// the results are written together once all benchmarks have been run.
+void
+run_benchmarks(std::string const& filter, benchmark_output_format format);
+
+// Write a set of results as JSON.
+void
+write_benchmark_results_json(
+    std::FILE* out, std::vector<benchmark_result> const& results);
+
+// Prevent the compiler from optimizing away a value computed by a benchmark.
+template<class T>
+void
+do_not_optimize(T const& value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static T const* volatile sink;
+    sink = &value;
+#endif
+}
+
+} // namespace alia
+
+#define ALIA_BENCHMARK(name)                                                  \
+    static void name(::alia::benchmark_state& state);                        \
+    static ::alia::benchmark_registrar name##_registrar(#name, name);         \
+    static void name(::alia::benchmark_state& state)
+
+#define ALIA_BENCHMARK_WITH_ARGS(name, ...)                                   \
+    static void name(::alia::benchmark_state& state);                        \
+    static ::alia::benchmark_registrar name##_registrar(                      \
+        #name, name, {__VA_ARGS__});                                          \
+    static void name(::alia::benchmark_state& state)
+
+#endif
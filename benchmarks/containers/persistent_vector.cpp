@@ -0,0 +1,50 @@
+#include <alia/containers/persistent_vector.hpp>
+
+#include <alia/flow/actions.hpp>
+#include <alia/signals/state.hpp>
+
+#include <string>
+#include <vector>
+
+#include <benchmarking.hpp>
+
+using namespace alia;
+
+namespace {
+
+// Repeatedly update an item in a list of :state.arg() items in state,
+// keeping a snapshot of the list before each update (as an undo history
+// would).
+template<class List>
+void
+run_snapshot_update_benchmark(benchmark_state& state)
+{
+    size_t const item_count = size_t(state.arg());
+    List list;
+    for (size_t i = 0; i != item_count; ++i)
+        list.push_back("an item");
+    state_holder<List> holder(std::move(list));
+    auto s = make_state_signal(holder);
+    std::vector<List> history(8);
+    size_t n = 0;
+    while (state.keep_running())
+    {
+        history[n % history.size()] = holder.get();
+        perform_action(
+            update_at(s) << ((n * 7919) % item_count) << "an updated item");
+        ++n;
+    }
+    do_not_optimize(holder.get().size());
+}
+
+} // namespace
+
+ALIA_BENCHMARK_WITH_ARGS(std_vector_snapshot_update, 100, 10000, 100000)
+{
+    run_snapshot_update_benchmark<std::vector<std::string>>(state);
+}
+
+ALIA_BENCHMARK_WITH_ARGS(persistent_vector_snapshot_update, 100, 10000, 100000)
+{
+    run_snapshot_update_benchmark<persistent_vector<std::string>>(state);
+}
@@ -0,0 +1,47 @@
+#include <alia/flow/actions.hpp>
+
+#include <alia/signals/adaptors.hpp>
+#include <alia/signals/state.hpp>
+
+#include <benchmarking.hpp>
+
+using namespace alia;
+
+namespace {
+
+// Repeatedly append to (and trim) a log of :state.arg() items via the given
+// signal to the log.
+template<class MakeSignal>
+void
+run_append_benchmark(benchmark_state& state, MakeSignal const& make_signal)
+{
+    state_holder<std::vector<std::string>> log(
+        std::vector<std::string>(size_t(state.arg()), "an entry"));
+    auto s = make_signal(log);
+    while (state.keep_running())
+    {
+        perform_action(push_back(s) << "another entry");
+        perform_action(erase_at(s) << (log.get().size() - 1));
+    }
+    do_not_optimize(log.get().size());
+}
+
+} // namespace
+
+// appending in place
+ALIA_BENCHMARK_WITH_ARGS(in_place_append, 100, 10000, 100000)
+{
+    run_append_benchmark(state, [](auto& log) {
+        return make_state_signal(log);
+    });
+}
+
+// appending by copying the container (which is what happens when the signal
+// doesn't support in-place mutation)
+ALIA_BENCHMARK_WITH_ARGS(copying_append, 100, 10000, 100000)
+{
+    run_append_benchmark(state, [](auto& log) {
+        return add_fallback(
+            make_state_signal(log), empty<std::vector<std::string>>());
+    });
+}
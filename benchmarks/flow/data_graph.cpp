@@ -0,0 +1,124 @@
+#include <alia/flow/data_graph.hpp>
+
+#include <vector>
+
+#include <alia/flow/macros.hpp>
+#include <alia/system.hpp>
+
+#include <benchmarking.hpp>
+
+using namespace alia;
+
+namespace {
+
+// the number of get_data calls in each nested block for the nested
+// traversal benchmarks
+int const nodes_per_block = 10;
+
+} // namespace
+
+// a refresh pass over a flat graph of N nodes
+ALIA_BENCHMARK_WITH_ARGS(get_data_flat, 100, 1000, 10000)
+{
+    long long const n = state.arg();
+    alia::system sys;
+    sys.controller = [=](context ctx) {
+        for (long long i = 0; i != n; ++i)
+        {
+            int* x;
+            if (get_data(ctx, &x))
+                *x = int(i);
+            do_not_optimize(*x);
+        }
+    };
+    refresh_system(sys);
+    while (state.keep_running())
+        refresh_system(sys);
+}
+
+// a refresh pass over a graph of N nodes, grouped into conditional blocks
+ALIA_BENCHMARK_WITH_ARGS(get_data_nested, 100, 1000, 10000)
+{
+    long long const n = state.arg();
+    alia::system sys;
+    sys.controller = [=](context ctx) {
+        for (long long i = 0; i < n; i += nodes_per_block)
+        {
+            ALIA_IF(i >= 0)
+            {
+                for (int j = 0; j != nodes_per_block; ++j)
+                {
+                    int* x;
+                    if (get_data(ctx, &x))
+                        *x = j;
+                    do_not_optimize(*x);
+                }
+            }
+            ALIA_END
+        }
+    };
+    refresh_system(sys);
+    while (state.keep_running())
+        refresh_system(sys);
+}
+
+// named_block lookups over a list of 1000 blocks, where the given percentage
+// of the blocks are new on each pass (and so miss in the naming map and are
+// then destroyed at the end of the pass)
+ALIA_BENCHMARK_WITH_ARGS(named_block_miss_percent, 0, 10, 50, 100)
+{
+    long long const miss_percent = state.arg();
+    int const block_count = 1000;
+    int fresh_id = block_count;
+    alia::system sys;
+    sys.controller = [&](context ctx) {
+        naming_context nc(ctx);
+        for (int i = 0; i != block_count; ++i)
+        {
+            int id = (i % 100) < miss_percent ? fresh_id++ : i;
+            named_block nb(nc, make_id(id));
+            int* x;
+            if (get_data(ctx, &x))
+                *x = i;
+            do_not_optimize(*x);
+        }
+    };
+    refresh_system(sys);
+    while (state.keep_running())
+        refresh_system(sys);
+}
+
+// clearing the cache of a block that contains N cached values, spread across
+// nested blocks
+// (Each iteration also repopulates the cache, since there would be nothing to
+// clear otherwise.)
+ALIA_BENCHMARK_WITH_ARGS(clear_cached_data, 100, 1000, 10000)
+{
+    long long const n = state.arg();
+    data_graph graph;
+    data_block root;
+    std::vector<data_block*> children;
+    auto populate = [&]() {
+        data_traversal traversal;
+        scoped_data_traversal sdt(graph, traversal);
+        scoped_data_block root_block(traversal, root);
+        for (long long i = 0; i < n; i += nodes_per_block)
+        {
+            data_block* child;
+            get_data(traversal, &child);
+            scoped_data_block child_block(traversal, *child);
+            for (int j = 0; j != nodes_per_block; ++j)
+            {
+                std::vector<int>* cached;
+                if (get_cached_data(traversal, &cached))
+                    cached->assign(4, j);
+            }
+        }
+    };
+    populate();
+    while (state.keep_running())
+    {
+        populate();
+        clear_cached_data(root);
+    }
+}
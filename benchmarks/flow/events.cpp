@@ -0,0 +1,76 @@
+#include <alia/flow/events.hpp>
+
+#include <alia/flow/macros.hpp>
+#include <alia/system.hpp>
+
+#include <benchmarking.hpp>
+
+using namespace alia;
+
+namespace {
+
+struct benchmark_event
+{
+    int handled = 0;
+};
+
+// Set up a system with :region_count routing regions, each containing a few
+// nodes and an event handler. The region in the middle is recorded in
+// *target.
+void
+initialize_region_system(
+    alia::system& sys, long long region_count, routing_region_ptr* target)
+{
+    sys.controller = [=](context ctx) {
+        for (long long i = 0; i != region_count; ++i)
+        {
+            scoped_routing_region srr(ctx);
+            ALIA_IF(srr.is_relevant())
+            {
+                for (int j = 0; j != 4; ++j)
+                {
+                    int* x;
+                    if (get_data(ctx, &x))
+                        *x = j;
+                    do_not_optimize(*x);
+                }
+                on_event<benchmark_event>(
+                    ctx, [](auto, auto& e) { ++e.handled; });
+                if (i == region_count / 2)
+                    *target = get_active_routing_region(ctx);
+            }
+            ALIA_END
+        }
+    };
+    refresh_system(sys);
+}
+
+} // namespace
+
+// dispatching an event to every region
+ALIA_BENCHMARK_WITH_ARGS(broadcast_dispatch, 10, 100, 1000)
+{
+    alia::system sys;
+    routing_region_ptr target;
+    initialize_region_system(sys, state.arg(), &target);
+    while (state.keep_running())
+    {
+        benchmark_event event;
+        impl::dispatch_event(sys, event);
+        do_not_optimize(event.handled);
+    }
+}
+
+// dispatching an event to a single region
+ALIA_BENCHMARK_WITH_ARGS(targeted_dispatch, 10, 100, 1000)
+{
+    alia::system sys;
+    routing_region_ptr target;
+    initialize_region_system(sys, state.arg(), &target);
+    while (state.keep_running())
+    {
+        benchmark_event event;
+        impl::dispatch_targeted_event(sys, event, target);
+        do_not_optimize(event.handled);
+    }
+}
@@ -0,0 +1,52 @@
+#include <alia/flow/for_each.hpp>
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <alia/signals/basic.hpp>
+#include <alia/system.hpp>
+
+#include <benchmarking.hpp>
+
+using namespace alia;
+
+// a refresh pass over a for_each loop over a vector of N items
+ALIA_BENCHMARK_WITH_ARGS(for_each_vector, 10, 100, 1000)
+{
+    std::vector<int> items;
+    for (long long i = 0; i != state.arg(); ++i)
+        items.push_back(int(i));
+    alia::system sys;
+    sys.controller = [&](context ctx) {
+        for_each(ctx, direct(items), [](context ctx, auto item) {
+            int* x;
+            if (get_data(ctx, &x))
+                *x = read_signal(item);
+            do_not_optimize(*x);
+        });
+    };
+    refresh_system(sys);
+    while (state.keep_running())
+        refresh_system(sys);
+}
+
+// a refresh pass over a for_each loop over a map with N items
+ALIA_BENCHMARK_WITH_ARGS(for_each_map, 10, 100, 1000)
+{
+    std::map<std::string, int> items;
+    for (long long i = 0; i != state.arg(); ++i)
+        items["item " + std::to_string(i)] = int(i);
+    alia::system sys;
+    sys.controller = [&](context ctx) {
+        for_each(ctx, direct(items), [](context ctx, auto, auto value) {
+            int* x;
+            if (get_data(ctx, &x))
+                *x = read_signal(value);
+            do_not_optimize(*x);
+        });
+    };
+    refresh_system(sys);
+    while (state.keep_running())
+        refresh_system(sys);
+}
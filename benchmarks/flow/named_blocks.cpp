@@ -0,0 +1,111 @@
+#include <alia/flow/data_graph.hpp>
+
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <vector>
+
+#include <alia/system.hpp>
+
+#include <benchmarking.hpp>
+
+using namespace alia;
+
+namespace {
+
+std::size_t const list_size = 1000;
+
+// Set up a system whose controller visits a named block (with a little data
+// inside it) for each item in *order.
+void
+initialize_list_system(alia::system& sys, std::vector<int> const* const* order)
+{
+    sys.controller = [=](context ctx) {
+        naming_context nc(ctx);
+        for (int i : **order)
+        {
+            named_block nb(nc, make_id(i));
+            int* x;
+            if (get_data(ctx, &x))
+                *x = i;
+            do_not_optimize(*x);
+        }
+    };
+}
+
+std::vector<int>
+make_sequence(int first, std::size_t size)
+{
+    std::vector<int> sequence(size);
+    std::iota(sequence.begin(), sequence.end(), first);
+    return sequence;
+}
+
+// Run a benchmark that cycles through the given orderings of the list.
+void
+cycle_through_orders(
+    benchmark_state& state, std::vector<std::vector<int>> const& orders)
+{
+    std::vector<int> const* order = &orders[0];
+    alia::system sys;
+    initialize_list_system(sys, &order);
+    refresh_system(sys);
+    std::size_t n = 0;
+    while (state.keep_running())
+    {
+        order = &orders[++n % orders.size()];
+        refresh_system(sys);
+    }
+}
+
+} // namespace
+
+ALIA_BENCHMARK(named_blocks_stable)
+{
+    cycle_through_orders(state, {make_sequence(0, list_size)});
+}
+
+ALIA_BENCHMARK(named_blocks_shuffle)
+{
+    std::vector<std::vector<int>> orders;
+    std::mt19937 rng(0);
+    for (int i = 0; i != 16; ++i)
+    {
+        orders.push_back(make_sequence(0, list_size));
+        std::shuffle(orders.back().begin(), orders.back().end(), rng);
+    }
+    cycle_through_orders(state, orders);
+}
+
+// This alternates between inserting and removing an item at the front.
+// Inserting was already cheap before references were indexed (since only the
+// inserted item misses the prediction), so any difference here comes from the
+// removals, which leave the prediction stuck on the removed item.
+ALIA_BENCHMARK(named_blocks_insert_front)
+{
+    cycle_through_orders(
+        state, {make_sequence(0, list_size), make_sequence(-1, list_size + 1)});
+}
+
+ALIA_BENCHMARK(named_blocks_reverse)
+{
+    auto forward = make_sequence(0, list_size);
+    auto reversed = forward;
+    std::reverse(reversed.begin(), reversed.end());
+    cycle_through_orders(state, {forward, reversed});
+}
+
+// Each pass moves the first item to the back. Without indexing, the
+// prediction gets stuck on the moved item, so every item after it misses and
+// gets a new reference.
+ALIA_BENCHMARK(named_blocks_rotate)
+{
+    std::vector<std::vector<int>> orders;
+    auto order = make_sequence(0, list_size);
+    for (int i = 0; i != 16; ++i)
+    {
+        orders.push_back(order);
+        std::rotate(order.begin(), order.begin() + 1, order.end());
+    }
+    cycle_through_orders(state, orders);
+}
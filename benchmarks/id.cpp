@@ -0,0 +1,153 @@
+#include <alia/id.hpp>
+
+#include <string>
+#include <vector>
+
+#include <benchmarking.hpp>
+
+using namespace alia;
+
+namespace {
+
+// Capture :id and then repeatedly compare it against :same (which should match)
+// and :different (which shouldn't).
+template<class Id>
+void
+capture_and_compare(
+    benchmark_state& state, Id const& id, Id const& same, Id const& different)
+{
+    captured_id captured;
+    while (state.keep_running())
+    {
+        captured.capture(id);
+        do_not_optimize(captured.matches(same));
+        do_not_optimize(captured.matches(different));
+    }
+}
+
+// Repeatedly check a large value for changes (as a signal shadow would),
+// using :make_value_id to identify the value. If :changing is true, the value
+// changes before every check.
+template<class Item, class MakeValueId>
+void
+check_large_value(
+    benchmark_state& state,
+    Item const& item,
+    bool changing,
+    MakeValueId&& make_value_id)
+{
+    std::vector<Item> value(size_t(state.arg()), item);
+    captured_id captured;
+    while (state.keep_running())
+    {
+        if (changing)
+            value[0] = value[0] == item ? value[1] + value[1] : item;
+        auto const& id = make_value_id(value);
+        if (!captured.matches(id))
+            captured.capture(id);
+    }
+    do_not_optimize(value.size());
+}
+
+} // namespace
+
+ALIA_BENCHMARK(captured_id_simple_int)
+{
+    capture_and_compare(state, make_id(1), make_id(1), make_id(2));
+}
+
+ALIA_BENCHMARK(captured_id_simple_string)
+{
+    std::string const text = "a string that's too long for the SSO buffer";
+    capture_and_compare(
+        state, make_id(text), make_id(text), make_id(text + "!"));
+}
+
+ALIA_BENCHMARK(captured_id_by_reference)
+{
+    std::string const a = "a string that's too long for the SSO buffer";
+    std::string const b = a;
+    std::string const c = a + "!";
+    capture_and_compare(
+        state,
+        make_id_by_reference(a),
+        make_id_by_reference(b),
+        make_id_by_reference(c));
+}
+
+ALIA_BENCHMARK(captured_id_pair)
+{
+    capture_and_compare(
+        state,
+        combine_ids(make_id(1), make_id(2)),
+        combine_ids(make_id(1), make_id(2)),
+        combine_ids(make_id(1), make_id(3)));
+}
+
+ALIA_BENCHMARK(captured_id_ref)
+{
+    auto a = make_id(1);
+    auto b = make_id(1);
+    auto c = make_id(2);
+    capture_and_compare(state, ref(a), ref(b), ref(c));
+}
+
+ALIA_BENCHMARK_WITH_ARGS(large_value_id_by_reference, 100, 10000, 100000)
+{
+    check_large_value(
+        state, 1.5, false, [](std::vector<double> const& value) {
+            return make_id_by_reference(value);
+        });
+}
+
+ALIA_BENCHMARK_WITH_ARGS(large_value_id_by_hash, 100, 10000, 100000)
+{
+    check_large_value(
+        state, 1.5, false, [](std::vector<double> const& value) {
+            return make_id(get_stable_hash(value));
+        });
+}
+
+ALIA_BENCHMARK_WITH_ARGS(large_value_id_by_version, 100, 10000, 100000)
+{
+    unsigned version = 1;
+    check_large_value(state, 1.5, false, [&](std::vector<double> const&) {
+        return make_id(version);
+    });
+}
+
+ALIA_BENCHMARK_WITH_ARGS(changing_numbers_id_by_reference, 100, 100000)
+{
+    check_large_value(state, 1.5, true, [](std::vector<double> const& value) {
+        return make_id_by_reference(value);
+    });
+}
+
+ALIA_BENCHMARK_WITH_ARGS(changing_numbers_id_by_hash, 100, 100000)
+{
+    check_large_value(state, 1.5, true, [](std::vector<double> const& value) {
+        return make_id(get_stable_hash(value));
+    });
+}
+
+ALIA_BENCHMARK_WITH_ARGS(changing_strings_id_by_reference, 100, 100000)
+{
+    check_large_value(
+        state,
+        std::string("a string that's too long for the SSO buffer"),
+        true,
+        [](std::vector<std::string> const& value) {
+            return make_id_by_reference(value);
+        });
+}
+
+ALIA_BENCHMARK_WITH_ARGS(changing_strings_id_by_hash, 100, 100000)
+{
+    check_large_value(
+        state,
+        std::string("a string that's too long for the SSO buffer"),
+        true,
+        [](std::vector<std::string> const& value) {
+            return make_id(get_stable_hash(value));
+        });
+}
@@ -0,0 +1,23 @@
+#include <benchmarking.hpp>
+
+#include <cstring>
+
+// usage: benchmarks [--json] [filter]
+// Only benchmarks whose names contain the filter string are run.
+// With --json, the results are written to stdout as a JSON document (suitable
+// for comparing results across versions).
+int
+main(int argc, char** argv)
+{
+    auto format = alia::benchmark_output_format::TEXT;
+    char const* filter = "";
+    for (int i = 1; i != argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--json") == 0)
+            format = alia::benchmark_output_format::JSON;
+        else
+            filter = argv[i];
+    }
+    alia::run_benchmarks(filter, format);
+    return 0;
+}
@@ -0,0 +1,187 @@
+#include <alia/signals/text.hpp>
+
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <benchmarking.hpp>
+
+using namespace alia;
+
+// These compare alia's string conversions against the iostream-based
+// equivalents (which is how alia used to implement them).
+
+namespace {
+
+template<class T>
+std::string
+stream_to_string(T const& value)
+{
+    std::ostringstream s;
+    s << value;
+    return s.str();
+}
+
+template<class T>
+bool
+stream_from_string(T* value, std::string const& str)
+{
+    std::istringstream s(str);
+    T x;
+    if (!(s >> x))
+        return false;
+    *value = x;
+    return true;
+}
+
+// Get a representative set of values of type T to convert.
+template<class T>
+std::vector<T>
+make_conversion_samples()
+{
+    std::vector<T> samples;
+    for (int i = 0; i != 16; ++i)
+    {
+        // Floating point values have a mix of short and long forms.
+        double fraction = std::is_floating_point<T>::value
+                              ? (i % 2 == 0 ? 0.25 : i / 7.)
+                              : 0;
+        samples.push_back(T(i * 997 % 120 + fraction));
+    }
+    return samples;
+}
+template<>
+std::vector<std::string>
+make_conversion_samples()
+{
+    return {"a", "short string", "a string that's too long for the SSO buffer"};
+}
+
+template<class T>
+std::vector<std::string>
+make_conversion_sample_text()
+{
+    std::vector<std::string> text;
+    for (auto const& x : make_conversion_samples<T>())
+        text.push_back(to_string(x));
+    return text;
+}
+
+template<class T>
+void
+benchmark_to_string(benchmark_state& state)
+{
+    auto samples = make_conversion_samples<T>();
+    while (state.keep_running())
+    {
+        for (auto const& x : samples)
+            do_not_optimize(to_string(x));
+    }
+}
+
+template<class T>
+void
+benchmark_stream_to_string(benchmark_state& state)
+{
+    auto samples = make_conversion_samples<T>();
+    while (state.keep_running())
+    {
+        for (auto const& x : samples)
+            do_not_optimize(stream_to_string(x));
+    }
+}
+
+template<class T>
+void
+benchmark_from_string(benchmark_state& state)
+{
+    auto text = make_conversion_sample_text<T>();
+    T x;
+    while (state.keep_running())
+    {
+        for (auto const& s : text)
+        {
+            from_string(&x, s);
+            do_not_optimize(x);
+        }
+    }
+}
+
+template<class T>
+void
+benchmark_stream_from_string(benchmark_state& state)
+{
+    auto text = make_conversion_sample_text<T>();
+    T x;
+    while (state.keep_running())
+    {
+        for (auto const& s : text)
+        {
+            do_not_optimize(stream_from_string(&x, s));
+            do_not_optimize(x);
+        }
+    }
+}
+
+} // namespace
+
+#define ALIA_CONVERSION_BENCHMARKS(name, T)                                    \
+    ALIA_BENCHMARK(to_string_##name)                                           \
+    {                                                                          \
+        benchmark_to_string<T>(state);                                         \
+    }                                                                          \
+    ALIA_BENCHMARK(stream_to_string_##name)                                    \
+    {                                                                          \
+        benchmark_stream_to_string<T>(state);                                  \
+    }                                                                          \
+    ALIA_BENCHMARK(from_string_##name)                                         \
+    {                                                                          \
+        benchmark_from_string<T>(state);                                       \
+    }                                                                          \
+    ALIA_BENCHMARK(stream_from_string_##name)                                  \
+    {                                                                          \
+        benchmark_stream_from_string<T>(state);                                \
+    }
+
+ALIA_CONVERSION_BENCHMARKS(short, short int)
+ALIA_CONVERSION_BENCHMARKS(unsigned_short, unsigned short int)
+ALIA_CONVERSION_BENCHMARKS(int, int)
+ALIA_CONVERSION_BENCHMARKS(unsigned, unsigned int)
+ALIA_CONVERSION_BENCHMARKS(long, long int)
+ALIA_CONVERSION_BENCHMARKS(unsigned_long, unsigned long int)
+ALIA_CONVERSION_BENCHMARKS(long_long, long long int)
+ALIA_CONVERSION_BENCHMARKS(unsigned_long_long, unsigned long long int)
+ALIA_CONVERSION_BENCHMARKS(float, float)
+ALIA_CONVERSION_BENCHMARKS(double, double)
+ALIA_CONVERSION_BENCHMARKS(string, std::string)
+
+// formatting with a format that's parsed on every call (as printf used to)
+ALIA_BENCHMARK(snprintf_formatting)
+{
+    std::string const format = "%s: %d items (%.1f%%)";
+    int n = 0;
+    while (state.keep_running())
+    {
+        do_not_optimize(invoke_snprintf(format, "total", n, n * 0.5));
+        ++n;
+    }
+}
+
+// formatting with a precompiled format into a reused string
+ALIA_BENCHMARK(compiled_printf_formatting)
+{
+    printf_format format;
+    compile_printf_format(format, "%s: %d items (%.1f%%)");
+    std::string output;
+    int n = 0;
+    while (state.keep_running())
+    {
+        printf_argument const arguments[] = {make_printf_argument("total"),
+                                             make_printf_argument(n),
+                                             make_printf_argument(n * 0.5)};
+        format_printf(output, format, arguments, 3);
+        do_not_optimize(output);
+        ++n;
+    }
+}
@@ -0,0 +1,57 @@
+#include <alia/timing/smoothing.hpp>
+
+#include <alia/system.hpp>
+
+#include <benchmarking.hpp>
+
+using namespace alia;
+
+namespace {
+
+// Run refreshes of a system where :count values are always in transition
+// (using the animation engine if :engine isn't null).
+void
+run_smoothing_benchmark(benchmark_state& state, animation_engine* engine)
+{
+    virtual_clock clock;
+    alia::system sys;
+    sys.clock = &clock;
+    sys.animations = engine;
+    long long const count = state.arg();
+    double target = 0;
+    sys.controller = [&](context ctx) {
+        for (long long i = 0; i != count; ++i)
+        {
+            auto x = smooth(
+                ctx,
+                value(target + double(i)),
+                animated_transition{
+                    i % 2 == 0 ? default_curve : ease_in_out_curve, 1000});
+            do_not_optimize(read_signal(x));
+        }
+    };
+    refresh_system(sys);
+    while (state.keep_running())
+    {
+        // Retarget the values every so often so that they keep animating.
+        advance_virtual_clock_ms(clock, 16);
+        if (clock.now % 800000 == 0)
+            target = target == 0 ? 100 : 0;
+        refresh_system(sys);
+    }
+}
+
+} // namespace
+
+// smoothing values individually as they're traversed
+ALIA_BENCHMARK_WITH_ARGS(unbatched_smoothing, 100, 1000, 10000)
+{
+    run_smoothing_benchmark(state, nullptr);
+}
+
+// smoothing values via the animation engine
+ALIA_BENCHMARK_WITH_ARGS(batched_smoothing, 100, 1000, 10000)
+{
+    animation_engine engine;
+    run_smoothing_benchmark(state, &engine);
+}
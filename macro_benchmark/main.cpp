@@ -0,0 +1,206 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+
+#include <alia/flow/data_graph.hpp>
+#include <alia/system.hpp>
+
+#include <measurement.hpp>
+#include <synthetic_ui.hpp>
+
+using namespace alia;
+
+// usage: macro_benchmark [options]
+//   --sections N   the number of sections in the synthetic UI (default: 50)
+//   --items N      the initial number of items per section (default: 125)
+//   --frames N     the number of scripted frames to run (default: 2000)
+//   --seed N       the seed for the script (default: 1)
+//   --json         Write the results as JSON.
+// With the default configuration, the data graph has roughly 50,000 nodes.
+
+namespace {
+
+// The system is driven by a virtual clock that advances by a fixed amount each
+// frame, so that animations progress identically from run to run.
+millisecond_count const frame_duration = 16;
+
+struct frame_sample
+{
+    double microseconds;
+    allocation_counts allocations;
+};
+
+double
+get_elapsed_microseconds(
+    std::chrono::steady_clock::time_point start,
+    std::chrono::steady_clock::time_point end)
+{
+    return std::chrono::duration<double, std::micro>(end - start).count();
+}
+
+// Run a single frame: perform the action, refresh, and render.
+template<class Action>
+frame_sample
+run_frame(Action&& action)
+{
+    allocation_counts before = get_allocation_counts();
+    auto start = std::chrono::steady_clock::now();
+    action();
+    auto end = std::chrono::steady_clock::now();
+    allocation_counts after = get_allocation_counts();
+    frame_sample sample;
+    sample.microseconds = get_elapsed_microseconds(start, end);
+    sample.allocations.allocations = after.allocations - before.allocations;
+    sample.allocations.bytes = after.bytes - before.bytes;
+    return sample;
+}
+
+} // namespace
+
+int
+main(int argc, char** argv)
+{
+    synthetic_ui_config config;
+    int frame_count = 2000;
+    bool json = false;
+    for (int i = 1; i != argc; ++i)
+    {
+        auto next_int = [&]() {
+            if (i + 1 == argc)
+            {
+                std::fprintf(stderr, "missing value for %s\n", argv[i]);
+                std::exit(1);
+            }
+            return std::atoi(argv[++i]);
+        };
+        if (std::strcmp(argv[i], "--sections") == 0)
+            config.section_count = next_int();
+        else if (std::strcmp(argv[i], "--items") == 0)
+            config.items_per_section = next_int();
+        else if (std::strcmp(argv[i], "--frames") == 0)
+            frame_count = next_int();
+        else if (std::strcmp(argv[i], "--seed") == 0)
+            config.seed = unsigned(next_int());
+        else if (std::strcmp(argv[i], "--json") == 0)
+            json = true;
+        else
+        {
+            std::fprintf(stderr, "unknown option: %s\n", argv[i]);
+            return 1;
+        }
+    }
+    if (config.section_count <= 0 || config.items_per_section < 0
+        || frame_count <= 0)
+    {
+        std::fprintf(stderr, "invalid configuration\n");
+        return 1;
+    }
+
+    synthetic_model model = make_synthetic_model(config);
+    virtual_clock clock;
+    alia::system sys;
+    sys.clock = &clock;
+    sys.controller = [&](context ctx) { do_synthetic_ui(ctx, model); };
+
+    std::ostringstream rendering;
+    auto render = [&]() {
+        rendering.str(std::string());
+        render_synthetic_ui(sys, rendering);
+    };
+
+    // The initial frame builds the data graph, so record it separately.
+    frame_sample initial = run_frame([&]() {
+        refresh_system(sys);
+        render();
+    });
+
+    std::mt19937 rng(config.seed);
+    std::vector<double> latencies;
+    latencies.reserve(frame_count);
+    allocation_counts total_allocations;
+    for (int i = 0; i != frame_count; ++i)
+    {
+        script_action action = generate_script_action(rng, model);
+        frame_sample sample = run_frame([&]() {
+            perform_script_action(sys, model, action);
+            advance_virtual_clock_ms(clock, frame_duration);
+            refresh_system(sys);
+            render();
+        });
+        latencies.push_back(sample.microseconds);
+        total_allocations.allocations += sample.allocations.allocations;
+        total_allocations.bytes += sample.allocations.bytes;
+    }
+
+    std::size_t node_count = compute_data_graph_stats(sys.data).total_nodes;
+    double allocations_per_frame
+        = double(total_allocations.allocations) / frame_count;
+    double bytes_per_frame = double(total_allocations.bytes) / frame_count;
+    double p50 = get_percentile(latencies, 50);
+    double p90 = get_percentile(latencies, 90);
+    double p99 = get_percentile(latencies, 99);
+    double max = latencies.back();
+    std::size_t peak_rss = get_peak_rss();
+
+    if (json)
+    {
+        std::printf(
+            "{\n"
+            "  \"sections\": %d,\n"
+            "  \"items_per_section\": %d,\n"
+            "  \"frames\": %d,\n"
+            "  \"seed\": %u,\n"
+            "  \"data_graph_nodes\": %zu,\n"
+            "  \"initial_frame_us\": %.1f,\n"
+            "  \"initial_frame_allocations\": %llu,\n"
+            "  \"latency_us\": {\"p50\": %.1f, \"p90\": %.1f, \"p99\": %.1f, "
+            "\"max\": %.1f},\n"
+            "  \"allocations_per_frame\": %.1f,\n"
+            "  \"allocated_bytes_per_frame\": %.1f,\n"
+            "  \"peak_rss_bytes\": %zu\n"
+            "}\n",
+            config.section_count,
+            config.items_per_section,
+            frame_count,
+            config.seed,
+            node_count,
+            initial.microseconds,
+            (unsigned long long) initial.allocations.allocations,
+            p50,
+            p90,
+            p99,
+            max,
+            allocations_per_frame,
+            bytes_per_frame,
+            peak_rss);
+    }
+    else
+    {
+        std::printf(
+            "%d sections x %d items, %d frames (seed %u)\n",
+            config.section_count,
+            config.items_per_section,
+            frame_count,
+            config.seed);
+        std::printf("data graph nodes:      %zu\n", node_count);
+        std::printf(
+            "initial frame:         %.1f us, %llu allocations\n",
+            initial.microseconds,
+            (unsigned long long) initial.allocations.allocations);
+        std::printf(
+            "frame latency (us):    p50 %.1f, p90 %.1f, p99 %.1f, max %.1f\n",
+            p50,
+            p90,
+            p99,
+            max);
+        std::printf(
+            "allocations per frame: %.1f (%.1f bytes)\n",
+            allocations_per_frame,
+            bytes_per_frame);
+        std::printf(
+            "peak RSS:              %.1f MB\n", double(peak_rss) / 1048576);
+    }
+    return 0;
+}
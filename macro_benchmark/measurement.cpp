@@ -0,0 +1,51 @@
+#include <measurement.hpp>
+
+#include <algorithm>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#ifdef _MSC_VER
+#pragma comment(lib, "psapi.lib")
+#endif
+#else
+#include <sys/resource.h>
+#endif
+
+namespace alia {
+
+std::size_t
+get_peak_rss()
+{
+#if defined(_WIN32)
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        return counters.PeakWorkingSetSize;
+    return 0;
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return 0;
+#if defined(__APPLE__)
+    // macOS reports this in bytes.
+    return std::size_t(usage.ru_maxrss);
+#else
+    // Linux reports this in kilobytes.
+    return std::size_t(usage.ru_maxrss) * 1024;
+#endif
+#endif
+}
+
+double
+get_percentile(std::vector<double>& samples, double percentile)
+{
+    if (samples.empty())
+        return 0;
+    std::sort(samples.begin(), samples.end());
+    std::size_t index
+        = std::size_t(percentile / 100 * double(samples.size() - 1) + 0.5);
+    return samples[std::min(index, samples.size() - 1)];
+}
+
+} // namespace alia
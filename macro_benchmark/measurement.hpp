@@ -0,0 +1,27 @@
+#ifndef ALIA_MACRO_BENCHMARK_MEASUREMENT_HPP
+#define ALIA_MACRO_BENCHMARK_MEASUREMENT_HPP
+
+#include <cstddef>
+#include <vector>
+
+#include <allocation_tracking.hpp>
+
+// This file provides the process-level measurements used by the macro
+// benchmark. (Allocations are counted via the allocation tracking that's
+// shared with the unit tests.)
+
+namespace alia {
+
+// Get the peak resident set size of the process, in bytes.
+// (This returns 0 on platforms where it isn't supported.)
+std::size_t
+get_peak_rss();
+
+// Get the value at the given percentile (in the range [0, 100]) of a set of
+// samples. :samples is sorted as a side effect.
+double
+get_percentile(std::vector<double>& samples, double percentile);
+
+} // namespace alia
+
+#endif
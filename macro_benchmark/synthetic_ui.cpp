@@ -0,0 +1,199 @@
+#include <synthetic_ui.hpp>
+
+#include <ostream>
+
+#include <alia/flow/events.hpp>
+#include <alia/flow/for_each.hpp>
+#include <alia/flow/macros.hpp>
+#include <alia/signals/application.hpp>
+#include <alia/signals/basic.hpp>
+#include <alia/signals/state.hpp>
+#include <alia/signals/text.hpp>
+#include <alia/timing/smoothing.hpp>
+
+namespace alia {
+
+// These allow for_each to identify items and sections by their IDs rather
+// than their positions.
+auto
+get_alia_id(synthetic_item const& item)
+{
+    return make_id(item.id);
+}
+auto
+get_alia_id(synthetic_section const& section)
+{
+    return make_id(section.id);
+}
+
+synthetic_model
+make_synthetic_model(synthetic_ui_config const& config)
+{
+    synthetic_model model;
+    for (int i = 0; i != config.section_count; ++i)
+    {
+        synthetic_section section;
+        section.id = i;
+        for (int j = 0; j != config.items_per_section; ++j)
+        {
+            synthetic_item item;
+            item.id = model.next_item_id++;
+            item.value = j;
+            section.items.push_back(item);
+        }
+        model.sections.push_back(std::move(section));
+    }
+    return model;
+}
+
+template<class Text>
+void
+render_text(context ctx, Text const& text)
+{
+    ostream_event* oe;
+    if (detect_event(ctx, &oe) && signal_has_value(text))
+        *oe->stream << read_signal(text) << ";";
+}
+
+static void
+do_synthetic_item(context ctx, synthetic_item const& item)
+{
+    auto clicks = get_state(ctx, 0);
+    on_event<click_item_event>(ctx, [&](auto ctx, auto& e) {
+        if (e.item_id == item.id)
+        {
+            write_signal(clicks, read_signal(clicks) + 1);
+            abort_traversal(ctx);
+        }
+    });
+
+    auto score = apply(
+        ctx,
+        [](int value, int clicks) { return value * 2.0 + clicks; },
+        value(item.value),
+        clicks);
+    render_text(ctx, as_text(ctx, score));
+
+    auto position = smooth(ctx, score);
+    render_text(ctx, as_text(ctx, position));
+
+    ALIA_IF(read_signal(clicks) % 2 != 0)
+    {
+        render_text(ctx, value("selected"));
+        render_text(ctx, as_text(ctx, clicks));
+    }
+    ALIA_END
+}
+
+static void
+do_synthetic_section(context ctx, synthetic_section const& section)
+{
+    auto collapsed = get_state(ctx, false);
+    on_event<toggle_section_event>(ctx, [&](auto ctx, auto& e) {
+        // The event is only meant for this section, and the rest of the
+        // traversal would see the section's new contents (which haven't been
+        // refreshed yet), so stop here.
+        if (e.section_id == section.id)
+        {
+            write_signal(collapsed, !read_signal(collapsed));
+            abort_traversal(ctx);
+        }
+    });
+
+    render_text(ctx, as_text(ctx, value(section.id)));
+
+    ALIA_IF(!read_signal(collapsed))
+    {
+        for_each(ctx, direct(section.items), [](context ctx, auto item) {
+            do_synthetic_item(ctx, read_signal(item));
+        });
+    }
+    ALIA_END
+}
+
+void
+do_synthetic_ui(context ctx, synthetic_model& model)
+{
+    for_each(ctx, direct(model.sections), [](context ctx, auto section) {
+        do_synthetic_section(ctx, read_signal(section));
+    });
+}
+
+script_action
+generate_script_action(std::mt19937& rng, synthetic_model const& model)
+{
+    script_action action;
+    action.section_index = int(rng() % model.sections.size());
+    auto const& items = model.sections[action.section_index].items;
+    action.item_index = items.empty() ? 0 : int(rng() % items.size());
+    action.value = int(rng() % 1000);
+
+    // Most frames are idle (or animating), so weight the script accordingly.
+    unsigned roll = rng() % 100;
+    if (roll < 60)
+        action.kind = script_action_kind::IDLE;
+    else if (roll < 75)
+        action.kind = script_action_kind::EDIT_ITEM;
+    else if (roll < 87)
+        action.kind = script_action_kind::CLICK_ITEM;
+    else if (roll < 90)
+        action.kind = script_action_kind::TOGGLE_SECTION;
+    else if (roll < 95)
+        action.kind = script_action_kind::INSERT_ITEM;
+    else
+        action.kind = script_action_kind::REMOVE_ITEM;
+
+    // Actions on items need an item to act on.
+    if (items.empty() && action.kind != script_action_kind::TOGGLE_SECTION)
+        action.kind = script_action_kind::INSERT_ITEM;
+
+    return action;
+}
+
+void
+perform_script_action(
+    alia::system& sys, synthetic_model& model, script_action const& action)
+{
+    auto& section = model.sections[action.section_index];
+    switch (action.kind)
+    {
+        case script_action_kind::IDLE:
+            break;
+        case script_action_kind::EDIT_ITEM:
+            section.items[action.item_index].value = action.value;
+            break;
+        case script_action_kind::CLICK_ITEM: {
+            click_item_event event;
+            event.item_id = section.items[action.item_index].id;
+            impl::dispatch_event(sys, event);
+            break;
+        }
+        case script_action_kind::TOGGLE_SECTION: {
+            toggle_section_event event;
+            event.section_id = section.id;
+            impl::dispatch_event(sys, event);
+            break;
+        }
+        case script_action_kind::INSERT_ITEM: {
+            synthetic_item item;
+            item.id = model.next_item_id++;
+            item.value = action.value;
+            section.items.insert(
+                section.items.begin() + action.item_index, item);
+            break;
+        }
+        case script_action_kind::REMOVE_ITEM:
+            section.items.erase(section.items.begin() + action.item_index);
+            break;
+    }
+}
+
+void
+render_synthetic_ui(alia::system& sys, std::ostream& out)
+{
+    ostream_event event;
+    event.stream = &out;
+    impl::dispatch_event(sys, event);
+}
+
+} // namespace alia
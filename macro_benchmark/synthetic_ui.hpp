@@ -0,0 +1,136 @@
+#ifndef ALIA_MACRO_BENCHMARK_SYNTHETIC_UI_HPP
+#define ALIA_MACRO_BENCHMARK_SYNTHETIC_UI_HPP
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include <alia/context/interface.hpp>
+#include <alia/system.hpp>
+
+// This file defines a synthetic application that's meant to resemble a large,
+// realistic alia controller.
+//
+// The application's model is a list of sections, each containing a list of
+// items. Each section can be collapsed, and each item has some local state, a
+// value derived from that state and the model, textual views of that value,
+// and an animated view of it. The application is 'rendered' headlessly, by
+// dispatching an ostream_event that visits all the visible text.
+//
+// The application is driven by a pseudorandom (but deterministic) script of
+// actions, which mixes idle frames, changes to the model, and UI events.
+
+namespace alia {
+
+struct synthetic_ui_config
+{
+    int section_count = 50;
+    int items_per_section = 125;
+    unsigned seed = 1;
+};
+
+// (Items and sections are comparable so that they can be used with signals.)
+
+struct synthetic_item
+{
+    int id;
+    int value;
+};
+inline bool
+operator==(synthetic_item const& a, synthetic_item const& b)
+{
+    return a.id == b.id && a.value == b.value;
+}
+inline bool
+operator<(synthetic_item const& a, synthetic_item const& b)
+{
+    return a.id < b.id || (a.id == b.id && a.value < b.value);
+}
+
+struct synthetic_section
+{
+    int id;
+    std::vector<synthetic_item> items;
+};
+inline bool
+operator==(synthetic_section const& a, synthetic_section const& b)
+{
+    return a.id == b.id && a.items == b.items;
+}
+inline bool
+operator<(synthetic_section const& a, synthetic_section const& b)
+{
+    return a.id < b.id || (a.id == b.id && a.items < b.items);
+}
+
+struct synthetic_model
+{
+    std::vector<synthetic_section> sections;
+    int next_item_id = 0;
+};
+
+synthetic_model
+make_synthetic_model(synthetic_ui_config const& config);
+
+// events that the synthetic UI responds to
+
+struct ostream_event
+{
+    std::ostream* stream;
+};
+
+struct click_item_event
+{
+    int item_id;
+};
+
+struct toggle_section_event
+{
+    int section_id;
+};
+
+void
+do_synthetic_ui(context ctx, synthetic_model& model);
+
+enum class script_action_kind
+{
+    // Just refresh the UI (e.g., for an animation frame).
+    IDLE,
+    // Change the value of an item in the model.
+    EDIT_ITEM,
+    // Dispatch a click_item_event.
+    CLICK_ITEM,
+    // Dispatch a toggle_section_event.
+    TOGGLE_SECTION,
+    // Insert a new item into the model.
+    INSERT_ITEM,
+    // Remove an item from the model.
+    REMOVE_ITEM
+};
+
+struct script_action
+{
+    script_action_kind kind;
+    int section_index;
+    int item_index;
+    int value;
+};
+
+// Generate the next action in the script.
+script_action
+generate_script_action(std::mt19937& rng, synthetic_model const& model);
+
+// Perform a scripted action.
+// Actions that change the model only update the model itself. Actions that
+// involve UI events dispatch the event to :sys.
+void
+perform_script_action(
+    alia::system& sys, synthetic_model& model, script_action const& action);
+
+// Render the UI to :out via an ostream_event.
+void
+render_synthetic_ui(alia::system& sys, std::ostream& out);
+
+} // namespace alia
+
+#endif
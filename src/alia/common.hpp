@@ -9,6 +9,7 @@
 #include <ostream>
 #include <string>
 #include <type_traits>
+#include <utility>
 
 // This file defines some generic functionality that's commonly used throughout
 // alia.
@@ -17,6 +18,16 @@ namespace alia {
 
 typedef long long counter_type;
 
+// alia's primary sense of time is that of a monotonically increasing
+// millisecond counter. It's understood to have an arbitrary start point and is
+// allowed to wrap around, so 'unsigned' is considered sufficient.
+typedef unsigned millisecond_count;
+
+// For code that needs finer resolution (e.g., frame pacing on high refresh
+// rate displays) or a counter that never wraps, alia also maintains a 64-bit
+// microsecond counter. The millisecond counter is always derived from it.
+typedef std::uint64_t microsecond_count;
+
 // Inspired by Boost, inheriting from noncopyable disables copying for a type.
 // The namespace prevents unintended ADL if used by applications.
 namespace impl {
@@ -81,6 +92,55 @@ struct make_void
 template<typename... Ts>
 using void_t = typename make_void<Ts...>::type;
 
+// is_map_like<Container>::value yields a compile-time boolean indicating
+// whether or not Container behaves like a map for the purposes of alia
+// iteration and indexing. (This is determined by checking whether or not
+// Container has both a key_type and a mapped_type member.)
+template<class T, class = void_t<>>
+struct is_map_like : std::false_type
+{
+};
+template<class T>
+struct is_map_like<T, void_t<typename T::key_type, typename T::mapped_type>>
+    : std::true_type
+{
+};
+
+// is_vector_like<Container>::value yields a compile-time boolean indicating
+// whether or not Container behaves like a vector for the purposes of alia
+// iteration and indexing. (This is determined by checking whether or not
+// Container can be subscripted with a size_t. This is sufficient because the
+// main purpose is to distinguish vector-like containers from list-like ones.)
+template<class Container, class = void_t<>>
+struct is_vector_like : std::false_type
+{
+};
+template<class Container>
+struct is_vector_like<
+    Container,
+    void_t<decltype(std::declval<Container>()[size_t(0)])>> : std::true_type
+{
+};
+
+// has_item_identity<Container, Index>::value yields a compile-time boolean
+// indicating whether or not Container can identify its items independently of
+// their values. (This is determined by checking whether or not it has an
+// item_identity(index) member that returns a shared pointer, as the persistent
+// containers do.)
+template<class Container, class Index, class = void_t<>>
+struct has_item_identity : std::false_type
+{
+};
+template<class Container, class Index>
+struct has_item_identity<
+    Container,
+    Index,
+    void_t<decltype(std::shared_ptr<void const>(
+        std::declval<Container const&>().item_identity(
+            std::declval<Index const&>())))>> : std::true_type
+{
+};
+
 // ALIA_LAMBDIFY(f) produces a lambda that calls f, which is essentially a
 // version of f that can be passed as an argument and still allows normal
 // overload resolution.
@@ -0,0 +1,559 @@
+#ifndef ALIA_CONTAINERS_PERSISTENT_MAP_HPP
+#define ALIA_CONTAINERS_PERSISTENT_MAP_HPP
+
+#include <alia/common.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+namespace alia {
+
+// persistent_map<Key, Value> is an unordered map with value semantics whose
+// copies share their structure. Internally, it's a hash array mapped trie
+// (with 32-way nodes), so copying one is O(1), and inserting, updating or
+// erasing an entry in a copy only copies the O(log n) nodes along the path to
+// that entry. (As with persistent_vector, nodes that aren't shared are modified
+// in place.)
+//
+// Like persistent_vector, each entry is stored in its own (shared) cell, and
+// item_identity(key) identifies the entry for a key across copies of the map.
+//
+// Iteration order is unspecified (but deterministic for a given set of keys).
+
+// Count the bits that are set in :bits.
+inline unsigned
+count_set_bits(std::uint32_t bits)
+{
+    bits = bits - ((bits >> 1) & 0x55555555u);
+    bits = (bits & 0x33333333u) + ((bits >> 2) & 0x33333333u);
+    return (((bits + (bits >> 4)) & 0x0f0f0f0fu) * 0x01010101u) >> 24;
+}
+
+template<
+    class Key,
+    class Value,
+    class Hash = std::hash<Key>,
+    class KeyEqual = std::equal_to<Key>>
+struct persistent_map
+{
+ private:
+    struct node;
+
+ public:
+    typedef Key key_type;
+    typedef Value mapped_type;
+    typedef std::pair<Key const, Value> value_type;
+    typedef size_t size_type;
+    typedef value_type const& reference;
+    typedef value_type const& const_reference;
+
+    struct const_iterator
+    {
+        typedef std::forward_iterator_tag iterator_category;
+        typedef std::pair<Key const, Value> value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef value_type const* pointer;
+        typedef value_type const& reference;
+
+        const_iterator()
+        {
+        }
+
+        value_type const&
+        operator*() const
+        {
+            frame const& top = stack_[depth_ - 1];
+            return top.n->entries[top.entry_index]->value;
+        }
+        value_type const*
+        operator->() const
+        {
+            return &**this;
+        }
+
+        const_iterator&
+        operator++()
+        {
+            ++stack_[depth_ - 1].entry_index;
+            settle();
+            return *this;
+        }
+        const_iterator
+        operator++(int)
+        {
+            const_iterator old = *this;
+            ++*this;
+            return old;
+        }
+
+        friend bool
+        operator==(const_iterator const& a, const_iterator const& b)
+        {
+            return a.depth_ == b.depth_
+                   && (a.depth_ == 0
+                       || (a.stack_[a.depth_ - 1].n == b.stack_[b.depth_ - 1].n
+                           && a.stack_[a.depth_ - 1].entry_index
+                                  == b.stack_[b.depth_ - 1].entry_index));
+        }
+        friend bool
+        operator!=(const_iterator const& a, const_iterator const& b)
+        {
+            return !(a == b);
+        }
+
+     private:
+        friend struct persistent_map;
+
+        explicit const_iterator(node const* root)
+        {
+            if (root)
+            {
+                stack_[0] = frame{root, 0, 0};
+                depth_ = 1;
+                settle();
+            }
+        }
+
+        // Advance until the top of the stack refers to an entry (or the stack
+        // is empty). Each node's own entries are visited before its children.
+        void
+        settle()
+        {
+            while (depth_ != 0)
+            {
+                frame& top = stack_[depth_ - 1];
+                if (top.entry_index < top.n->entries.size())
+                    return;
+                if (top.child_index < top.n->children.size())
+                {
+                    node const* child
+                        = top.n->children[top.child_index++].get();
+                    stack_[depth_++] = frame{child, 0, 0};
+                    continue;
+                }
+                --depth_;
+            }
+        }
+
+        struct frame
+        {
+            node const* n;
+            size_t entry_index;
+            size_t child_index;
+        };
+        frame stack_[persistent_map::max_depth];
+        unsigned depth_ = 0;
+    };
+    typedef const_iterator iterator;
+
+    persistent_map()
+    {
+    }
+    persistent_map(std::initializer_list<value_type> entries)
+    {
+        for (auto const& entry : entries)
+            insert_or_assign(entry.first, entry.second);
+    }
+
+    size_t
+    size() const
+    {
+        return size_;
+    }
+    bool
+    empty() const
+    {
+        return size_ == 0;
+    }
+
+    const_iterator
+    begin() const
+    {
+        return const_iterator(root_.get());
+    }
+    const_iterator
+    end() const
+    {
+        return const_iterator();
+    }
+
+    size_t
+    count(Key const& key) const
+    {
+        return find_entry(key) ? 1 : 0;
+    }
+
+    Value const&
+    at(Key const& key) const
+    {
+        entry_ptr const* entry = find_entry(key);
+        if (!entry)
+            throw std::out_of_range("persistent_map key not found");
+        return (*entry)->value.second;
+    }
+
+    // Get mutable access to the value associated with :key, inserting a
+    // default-constructed value if there's none.
+    // If the entry is shared with another map, this copies it first.
+    Value&
+    operator[](Key const& key)
+    {
+        if (!find_entry(key))
+            insert_or_assign(key, Value());
+        entry_ptr& entry = get_mutable_entry(hash_(key), key);
+        if (entry.use_count() != 1)
+            entry = std::make_shared<entry_type>(*entry);
+        return entry->value.second;
+    }
+
+    // Associate :value with :key, replacing any existing value.
+    // Returns true iff a new entry was inserted.
+    bool
+    insert_or_assign(Key key, Value value)
+    {
+        size_t hash = hash_(key);
+        if (!root_)
+            root_ = std::make_shared<node>();
+        bool inserted = assign(
+            root_,
+            0,
+            std::make_shared<entry_type>(
+                hash, std::move(key), std::move(value)));
+        if (inserted)
+            ++size_;
+        return inserted;
+    }
+
+    // Remove the entry for :key (if any).
+    // Returns the number of entries removed.
+    size_t
+    erase(Key const& key)
+    {
+        // Check first so that nothing is copied if there's nothing to erase.
+        if (!find_entry(key))
+            return 0;
+        remove(root_, hash_(key), 0, key);
+        --size_;
+        if (size_ == 0)
+            root_.reset();
+        return 1;
+    }
+
+    void
+    clear()
+    {
+        root_.reset();
+        size_ = 0;
+    }
+
+    // Get an object that identifies the entry for :key.
+    // As with persistent_vector::item_identity, this is preserved across copies
+    // of the map until the entry itself is modified.
+    // If there's no entry for :key, this returns a null pointer.
+    std::shared_ptr<void const>
+    item_identity(Key const& key) const
+    {
+        entry_ptr const* entry = find_entry(key);
+        return entry ? *entry : nullptr;
+    }
+
+    // Do this map and :other share all of their structure?
+    bool
+    shares_structure_with(persistent_map const& other) const
+    {
+        return root_ == other.root_;
+    }
+
+ private:
+    static constexpr unsigned node_bits = 5;
+    static constexpr unsigned node_mask = (1u << node_bits) - 1;
+    static constexpr unsigned hash_bits = sizeof(size_t) * 8;
+    // the number of levels in the trie (including the collision level)
+    static constexpr unsigned max_depth
+        = (hash_bits + node_bits - 1) / node_bits + 1;
+
+    struct entry_type
+    {
+        entry_type(size_t hash, Key key, Value value)
+            : hash(hash), value(std::move(key), std::move(value))
+        {
+        }
+        size_t hash;
+        value_type value;
+    };
+    typedef std::shared_ptr<entry_type> entry_ptr;
+
+    // Each node stores entries and children in separate arrays, each indexed
+    // by a bitmap of the hash slots that they occupy. Once the hash bits are
+    // exhausted, a node simply stores a list of colliding entries (and its
+    // bitmaps are unused).
+    struct node
+    {
+        std::uint32_t entry_map = 0;
+        std::uint32_t child_map = 0;
+        std::vector<entry_ptr> entries;
+        std::vector<std::shared_ptr<node>> children;
+    };
+
+    static node&
+    make_unique_node(std::shared_ptr<node>& n)
+    {
+        if (n.use_count() != 1)
+            n = std::make_shared<node>(*n);
+        return *n;
+    }
+
+    static std::uint32_t
+    hash_slot_bit(size_t hash, unsigned shift)
+    {
+        return std::uint32_t(1) << ((hash >> shift) & node_mask);
+    }
+
+    // Get the position of the slot marked by :bit within the array indexed by
+    // :map.
+    static size_t
+    slot_position(std::uint32_t map, std::uint32_t bit)
+    {
+        return count_set_bits(map & (bit - 1));
+    }
+
+    entry_ptr const*
+    find_entry(Key const& key) const
+    {
+        if (!root_)
+            return nullptr;
+        size_t hash = hash_(key);
+        node const* n = root_.get();
+        for (unsigned shift = 0;; shift += node_bits)
+        {
+            if (shift >= hash_bits)
+            {
+                for (auto const& entry : n->entries)
+                {
+                    if (equal_(entry->value.first, key))
+                        return &entry;
+                }
+                return nullptr;
+            }
+            std::uint32_t bit = hash_slot_bit(hash, shift);
+            if (n->entry_map & bit)
+            {
+                auto const& entry
+                    = n->entries[slot_position(n->entry_map, bit)];
+                return entry->hash == hash && equal_(entry->value.first, key)
+                           ? &entry
+                           : nullptr;
+            }
+            if (!(n->child_map & bit))
+                return nullptr;
+            n = n->children[slot_position(n->child_map, bit)].get();
+        }
+    }
+
+    // Get the (uniquely owned) pointer to the existing entry for :key.
+    entry_ptr&
+    get_mutable_entry(size_t hash, Key const& key)
+    {
+        node* n = &make_unique_node(root_);
+        for (unsigned shift = 0;; shift += node_bits)
+        {
+            if (shift >= hash_bits)
+            {
+                for (auto& entry : n->entries)
+                {
+                    if (equal_(entry->value.first, key))
+                        return entry;
+                }
+                // (The entry is known to exist.)
+                assert(false);
+                return n->entries.front();
+            }
+            std::uint32_t bit = hash_slot_bit(hash, shift);
+            if (n->entry_map & bit)
+                return n->entries[slot_position(n->entry_map, bit)];
+            n = &make_unique_node(
+                n->children[slot_position(n->child_map, bit)]);
+        }
+    }
+
+    // Add :entry to the subtree rooted at :p (at :shift), replacing any entry
+    // with the same key. Returns true iff the entry is new.
+    bool
+    assign(std::shared_ptr<node>& p, unsigned shift, entry_ptr entry)
+    {
+        node& n = make_unique_node(p);
+        if (shift >= hash_bits)
+        {
+            for (auto& existing : n.entries)
+            {
+                if (equal_(existing->value.first, entry->value.first))
+                {
+                    existing = std::move(entry);
+                    return false;
+                }
+            }
+            n.entries.push_back(std::move(entry));
+            return true;
+        }
+        std::uint32_t bit = hash_slot_bit(entry->hash, shift);
+        if (n.entry_map & bit)
+        {
+            size_t position = slot_position(n.entry_map, bit);
+            entry_ptr& existing = n.entries[position];
+            if (existing->hash == entry->hash
+                && equal_(existing->value.first, entry->value.first))
+            {
+                existing = std::move(entry);
+                return false;
+            }
+            // The slot is taken by a different key, so both entries have to
+            // move down into a new child.
+            auto child = std::make_shared<node>();
+            assign(child, shift + node_bits, std::move(existing));
+            assign(child, shift + node_bits, std::move(entry));
+            n.entries.erase(n.entries.begin() + position);
+            n.entry_map &= ~bit;
+            n.children.insert(
+                n.children.begin() + slot_position(n.child_map, bit),
+                std::move(child));
+            n.child_map |= bit;
+            return true;
+        }
+        if (n.child_map & bit)
+        {
+            return assign(
+                n.children[slot_position(n.child_map, bit)],
+                shift + node_bits,
+                std::move(entry));
+        }
+        n.entries.insert(
+            n.entries.begin() + slot_position(n.entry_map, bit),
+            std::move(entry));
+        n.entry_map |= bit;
+        return true;
+    }
+
+    // Remove the (existing) entry for :key from the subtree rooted at :p.
+    void
+    remove(
+        std::shared_ptr<node>& p, size_t hash, unsigned shift, Key const& key)
+    {
+        node& n = make_unique_node(p);
+        if (shift >= hash_bits)
+        {
+            for (auto i = n.entries.begin(); i != n.entries.end(); ++i)
+            {
+                if (equal_((*i)->value.first, key))
+                {
+                    n.entries.erase(i);
+                    return;
+                }
+            }
+            return;
+        }
+        std::uint32_t bit = hash_slot_bit(hash, shift);
+        if (n.entry_map & bit)
+        {
+            n.entries.erase(
+                n.entries.begin() + slot_position(n.entry_map, bit));
+            n.entry_map &= ~bit;
+            return;
+        }
+        size_t position = slot_position(n.child_map, bit);
+        auto& child = n.children[position];
+        remove(child, hash, shift + node_bits, key);
+        // Keep the trie compact: A child that's left with only a single entry
+        // is replaced by that entry. (This also keeps the shape of the trie
+        // (and thus the iteration order) determined solely by its keys.)
+        if (child->children.empty() && child->entries.size() <= 1)
+        {
+            if (!child->entries.empty())
+            {
+                entry_ptr entry = std::move(child->entries.front());
+                n.entries.insert(
+                    n.entries.begin() + slot_position(n.entry_map, bit),
+                    std::move(entry));
+                n.entry_map |= bit;
+            }
+            n.children.erase(n.children.begin() + position);
+            n.child_map &= ~bit;
+        }
+    }
+
+    std::shared_ptr<node> root_;
+    size_t size_ = 0;
+    Hash hash_;
+    KeyEqual equal_;
+};
+
+template<class Key, class Value, class Hash, class KeyEqual>
+bool
+operator==(
+    persistent_map<Key, Value, Hash, KeyEqual> const& a,
+    persistent_map<Key, Value, Hash, KeyEqual> const& b)
+{
+    if (a.size() != b.size())
+        return false;
+    if (a.shares_structure_with(b))
+        return true;
+    for (auto const& entry : a)
+    {
+        if (!b.count(entry.first) || !(b.at(entry.first) == entry.second))
+            return false;
+    }
+    return true;
+}
+template<class Key, class Value, class Hash, class KeyEqual>
+bool
+operator!=(
+    persistent_map<Key, Value, Hash, KeyEqual> const& a,
+    persistent_map<Key, Value, Hash, KeyEqual> const& b)
+{
+    return !(a == b);
+}
+
+// Get pointers to the entries in :m, sorted by key.
+template<class Key, class Value, class Hash, class KeyEqual>
+std::vector<std::pair<Key const, Value> const*>
+get_sorted_entries(persistent_map<Key, Value, Hash, KeyEqual> const& m)
+{
+    std::vector<std::pair<Key const, Value> const*> entries;
+    entries.reserve(m.size());
+    for (auto const& entry : m)
+        entries.push_back(&entry);
+    std::sort(entries.begin(), entries.end(), [](auto* a, auto* b) {
+        return a->first < b->first;
+    });
+    return entries;
+}
+
+// This orders maps by comparing their entries in key order (as std::map does).
+// It's mainly there so that maps can be used as IDs, so it's not particularly
+// fast.
+template<class Key, class Value, class Hash, class KeyEqual>
+bool
+operator<(
+    persistent_map<Key, Value, Hash, KeyEqual> const& a,
+    persistent_map<Key, Value, Hash, KeyEqual> const& b)
+{
+    if (a.shares_structure_with(b))
+        return false;
+    auto a_entries = get_sorted_entries(a);
+    auto b_entries = get_sorted_entries(b);
+    return std::lexicographical_compare(
+        a_entries.begin(),
+        a_entries.end(),
+        b_entries.begin(),
+        b_entries.end(),
+        [](auto* x, auto* y) { return *x < *y; });
+}
+
+} // namespace alia
+
+#endif
@@ -0,0 +1,480 @@
+#ifndef ALIA_CONTAINERS_PERSISTENT_VECTOR_HPP
+#define ALIA_CONTAINERS_PERSISTENT_VECTOR_HPP
+
+#include <alia/common.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+namespace alia {
+
+// persistent_vector<T> is a vector with value semantics whose copies share
+// their structure. Internally, it's a 32-way trie of shared nodes, so copying
+// one is O(1), and modifying a copy only copies the O(log n) nodes along the
+// path to the affected item. (Nodes that aren't shared are modified in place,
+// so there's no copying at all when a vector has a single owner.) This makes it
+// cheap to keep old versions of a vector around (e.g., for undo).
+//
+// Each item is stored in its own (shared) cell, so modifying a vector never
+// copies items other than the one being modified, and each item has an
+// identity (see item_identity) that survives modifications to the rest of the
+// vector. alia uses this to give each item its own value ID when the vector is
+// accessed through signals.
+//
+// Appending and removing items at the end is O(log n). Inserting or erasing
+// elsewhere is O(n) (but only moves pointers, not items).
+
+template<class T>
+struct persistent_vector
+{
+    typedef T value_type;
+    typedef size_t size_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef T const& reference;
+    typedef T const& const_reference;
+
+    struct const_iterator
+    {
+        typedef std::random_access_iterator_tag iterator_category;
+        typedef T value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef T const* pointer;
+        typedef T const& reference;
+
+        const_iterator()
+        {
+        }
+        const_iterator(persistent_vector const* vector, size_t index)
+            : vector_(vector), index_(index)
+        {
+        }
+
+        T const&
+        operator*() const
+        {
+            // Cache the leaf so that sequential iteration doesn't have to
+            // search the trie for every item.
+            size_t base = index_ & ~size_t(node_mask);
+            if (!leaf_ || leaf_base_ != base)
+            {
+                leaf_ = vector_->get_leaf(index_);
+                leaf_base_ = base;
+            }
+            return *leaf_->items[index_ & node_mask];
+        }
+        T const*
+        operator->() const
+        {
+            return &**this;
+        }
+        T const&
+        operator[](difference_type n) const
+        {
+            return (*vector_)[size_t(difference_type(index_) + n)];
+        }
+
+        const_iterator&
+        operator++()
+        {
+            ++index_;
+            return *this;
+        }
+        const_iterator
+        operator++(int)
+        {
+            const_iterator old = *this;
+            ++index_;
+            return old;
+        }
+        const_iterator&
+        operator--()
+        {
+            --index_;
+            return *this;
+        }
+        const_iterator
+        operator--(int)
+        {
+            const_iterator old = *this;
+            --index_;
+            return old;
+        }
+        const_iterator&
+        operator+=(difference_type n)
+        {
+            index_ = size_t(difference_type(index_) + n);
+            return *this;
+        }
+        const_iterator&
+        operator-=(difference_type n)
+        {
+            index_ = size_t(difference_type(index_) - n);
+            return *this;
+        }
+        friend const_iterator
+        operator+(const_iterator i, difference_type n)
+        {
+            return i += n;
+        }
+        friend const_iterator
+        operator+(difference_type n, const_iterator i)
+        {
+            return i += n;
+        }
+        friend const_iterator
+        operator-(const_iterator i, difference_type n)
+        {
+            return i -= n;
+        }
+        friend difference_type
+        operator-(const_iterator const& a, const_iterator const& b)
+        {
+            return difference_type(a.index_) - difference_type(b.index_);
+        }
+
+        friend bool
+        operator==(const_iterator const& a, const_iterator const& b)
+        {
+            return a.index_ == b.index_;
+        }
+        friend bool
+        operator!=(const_iterator const& a, const_iterator const& b)
+        {
+            return a.index_ != b.index_;
+        }
+        friend bool
+        operator<(const_iterator const& a, const_iterator const& b)
+        {
+            return a.index_ < b.index_;
+        }
+        friend bool
+        operator>(const_iterator const& a, const_iterator const& b)
+        {
+            return a.index_ > b.index_;
+        }
+        friend bool
+        operator<=(const_iterator const& a, const_iterator const& b)
+        {
+            return a.index_ <= b.index_;
+        }
+        friend bool
+        operator>=(const_iterator const& a, const_iterator const& b)
+        {
+            return a.index_ >= b.index_;
+        }
+
+        // the index of the item that this refers to
+        size_t
+        index() const
+        {
+            return index_;
+        }
+
+     private:
+        persistent_vector const* vector_ = nullptr;
+        size_t index_ = 0;
+        mutable typename persistent_vector::node const* leaf_ = nullptr;
+        mutable size_t leaf_base_ = 0;
+    };
+    typedef const_iterator iterator;
+
+    persistent_vector()
+    {
+    }
+    persistent_vector(std::initializer_list<T> items)
+    {
+        for (auto const& item : items)
+            push_back(item);
+    }
+    template<class InputIterator>
+    persistent_vector(InputIterator first, InputIterator last)
+    {
+        for (; first != last; ++first)
+            push_back(*first);
+    }
+
+    size_t
+    size() const
+    {
+        return size_;
+    }
+    bool
+    empty() const
+    {
+        return size_ == 0;
+    }
+
+    const_iterator
+    begin() const
+    {
+        return const_iterator(this, 0);
+    }
+    const_iterator
+    end() const
+    {
+        return const_iterator(this, size_);
+    }
+
+    T const&
+    operator[](size_t index) const
+    {
+        return *get_leaf(index)->items[index & node_mask];
+    }
+    T const&
+    at(size_t index) const
+    {
+        if (index >= size_)
+            throw std::out_of_range("persistent_vector index out of range");
+        return (*this)[index];
+    }
+    T const&
+    front() const
+    {
+        return (*this)[0];
+    }
+    T const&
+    back() const
+    {
+        return (*this)[size_ - 1];
+    }
+
+    // Get mutable access to the item at :index.
+    // If the item is shared with another vector, this copies it first.
+    T&
+    operator[](size_t index)
+    {
+        item_ptr& item = get_mutable_item(index);
+        if (item.use_count() != 1)
+            item = std::make_shared<T>(*item);
+        return *item;
+    }
+
+    // Replace the item at :index.
+    // Unlike assigning through operator[], this never copies the old item.
+    void
+    set(size_t index, T value)
+    {
+        item_ptr& item = get_mutable_item(index);
+        if (item.use_count() == 1)
+            *item = std::move(value);
+        else
+            item = std::make_shared<T>(std::move(value));
+    }
+
+    void
+    push_back(T value)
+    {
+        push_item(std::make_shared<T>(std::move(value)));
+    }
+
+    void
+    pop_back()
+    {
+        assert(size_ != 0);
+        --size_;
+        if (size_ == 0)
+        {
+            clear();
+            return;
+        }
+        remove_last_item(make_unique_node(root_), shift_);
+        // If the root only has one child left, that child can be the root.
+        while (shift_ != 0 && root_->children.size() == 1)
+        {
+            std::shared_ptr<node> child = root_->children[0];
+            root_ = std::move(child);
+            shift_ -= node_bits;
+        }
+    }
+
+    const_iterator
+    insert(const_iterator position, T value)
+    {
+        size_t index = position.index();
+        std::vector<item_ptr> tail = remove_items_from(index);
+        push_item(std::make_shared<T>(std::move(value)));
+        for (auto& item : tail)
+            push_item(std::move(item));
+        return const_iterator(this, index);
+    }
+
+    const_iterator
+    erase(const_iterator position)
+    {
+        size_t index = position.index();
+        std::vector<item_ptr> tail = remove_items_from(index);
+        for (size_t i = 1; i < tail.size(); ++i)
+            push_item(std::move(tail[i]));
+        return const_iterator(this, index);
+    }
+
+    void
+    clear()
+    {
+        root_.reset();
+        size_ = 0;
+        shift_ = 0;
+    }
+
+    // Get an object that identifies the item at :index.
+    // Two vectors yield the same identity for an item as long as that item
+    // hasn't been modified (in either vector) since they were copied from one
+    // another. Holding onto the identity keeps it from being reused.
+    // If :index is out of range, this returns a null pointer.
+    std::shared_ptr<void const>
+    item_identity(size_t index) const
+    {
+        if (index >= size_)
+            return nullptr;
+        return get_leaf(index)->items[index & node_mask];
+    }
+
+    // Do this vector and :other share all of their structure?
+    // (If so, they're certainly equal.)
+    bool
+    shares_structure_with(persistent_vector const& other) const
+    {
+        return root_ == other.root_ && size_ == other.size_;
+    }
+
+ private:
+    static constexpr unsigned node_bits = 5;
+    static constexpr size_t node_width = size_t(1) << node_bits;
+    static constexpr size_t node_mask = node_width - 1;
+
+    typedef std::shared_ptr<T> item_ptr;
+
+    // A node is either a leaf (which holds items) or a branch (which holds
+    // children), depending on its level within the trie.
+    struct node
+    {
+        std::vector<std::shared_ptr<node>> children;
+        std::vector<item_ptr> items;
+    };
+
+    // Make sure that :n isn't shared with any other vector (by copying it if
+    // necessary) so that it can be modified.
+    static node&
+    make_unique_node(std::shared_ptr<node>& n)
+    {
+        if (n.use_count() != 1)
+            n = std::make_shared<node>(*n);
+        return *n;
+    }
+
+    node const*
+    get_leaf(size_t index) const
+    {
+        node const* n = root_.get();
+        for (unsigned level = shift_; level != 0; level -= node_bits)
+            n = n->children[(index >> level) & node_mask].get();
+        return n;
+    }
+
+    item_ptr&
+    get_mutable_item(size_t index)
+    {
+        node* n = &make_unique_node(root_);
+        for (unsigned level = shift_; level != 0; level -= node_bits)
+        {
+            n = &make_unique_node(
+                n->children[(index >> level) & node_mask]);
+        }
+        return n->items[index & node_mask];
+    }
+
+    void
+    push_item(item_ptr item)
+    {
+        if (!root_)
+        {
+            root_ = std::make_shared<node>();
+            shift_ = 0;
+        }
+        // If the trie is full, add a new level at the root.
+        else if (size_ == node_width << shift_)
+        {
+            auto new_root = std::make_shared<node>();
+            new_root->children.push_back(std::move(root_));
+            root_ = std::move(new_root);
+            shift_ += node_bits;
+        }
+        node* n = &make_unique_node(root_);
+        for (unsigned level = shift_; level != 0; level -= node_bits)
+        {
+            size_t child_index = (size_ >> level) & node_mask;
+            if (child_index == n->children.size())
+                n->children.push_back(std::make_shared<node>());
+            n = &make_unique_node(n->children[child_index]);
+        }
+        n->items.push_back(std::move(item));
+        ++size_;
+    }
+
+    // Remove the last item from the subtree rooted at :n (at :level).
+    // (size_ has already been decremented, so it's the index of that item.)
+    void
+    remove_last_item(node& n, unsigned level)
+    {
+        if (level == 0)
+        {
+            n.items.pop_back();
+            return;
+        }
+        auto& child = n.children.back();
+        remove_last_item(make_unique_node(child), level - node_bits);
+        if (child->children.empty() && child->items.empty())
+            n.children.pop_back();
+    }
+
+    // Remove all items starting at :index and return them.
+    std::vector<item_ptr>
+    remove_items_from(size_t index)
+    {
+        assert(index <= size_);
+        std::vector<item_ptr> tail;
+        tail.reserve(size_ - index);
+        for (size_t i = index; i != size_; ++i)
+            tail.push_back(get_leaf(i)->items[i & node_mask]);
+        while (size_ > index)
+            pop_back();
+        return tail;
+    }
+
+    std::shared_ptr<node> root_;
+    size_t size_ = 0;
+    // the bit shift of the root level (0 if the root is a leaf)
+    unsigned shift_ = 0;
+};
+
+template<class T>
+bool
+operator==(persistent_vector<T> const& a, persistent_vector<T> const& b)
+{
+    if (a.size() != b.size())
+        return false;
+    if (a.shares_structure_with(b))
+        return true;
+    return std::equal(a.begin(), a.end(), b.begin());
+}
+template<class T>
+bool
+operator!=(persistent_vector<T> const& a, persistent_vector<T> const& b)
+{
+    return !(a == b);
+}
+template<class T>
+bool
+operator<(persistent_vector<T> const& a, persistent_vector<T> const& b)
+{
+    return std::lexicographical_compare(a.begin(), a.end(), b.begin(), b.end());
+}
+
+} // namespace alia
+
+#endif
@@ -63,7 +63,7 @@ void
 perform_action(action_interface<Args...> const& action, Args... args)
 {
     if (action.is_ready())
-        action.perform([]() {}, args...);
+        action.perform([]() {}, std::forward<Args>(args)...);
 }
 
 // action_ref is a reference to an action that implements the action interface
@@ -90,7 +90,7 @@ struct action_ref : action_interface<Args...>
     void
     perform(std::function<void()> const& intermediary, Args... args) const
     {
-        action_->perform(intermediary, args...);
+        action_->perform(intermediary, std::forward<Args>(args)...);
     }
 
  private:
@@ -173,7 +173,8 @@ struct bound_action<Action, Signal, action_interface<BoundArg, Args...>>
     void
     perform(std::function<void()> const& intermediary, Args... args) const
     {
-        action_.perform(intermediary, signal_.read(), args...);
+        action_.perform(
+            intermediary, signal_.read(), std::forward<Args>(args)...);
     }
 
  private:
@@ -199,9 +200,9 @@ template<
         is_action_type<Action>::value && !is_signal_type<Value>::value,
         int> = 0>
 auto
-operator<<(Action const& action, Value const& v)
+operator<<(Action const& action, Value v)
 {
-    return action << value(v);
+    return action << value(std::move(v));
 }
 
 // operator <<=
@@ -227,9 +228,11 @@ struct copy_action : action_interface<>
     void
     perform(std::function<void()> const& intermediary) const
     {
+        // The source still owns its value, so this is the only copy that's
+        // made. It's moved into the sink.
         auto value = source_.read();
         intermediary();
-        sink_.write(value);
+        sink_.write(std::move(value));
     }
 
  private:
@@ -259,7 +262,7 @@ template<
 auto
 operator<<=(Sink sink, Source source)
 {
-    return sink <<= value(source);
+    return sink <<= value(std::move(source));
 }
 
 // toggle(flag), where :flag is a signal to a boolean, creates an action
@@ -275,13 +278,19 @@ toggle(Flag flag)
     return flag <<= !flag;
 }
 
-// push_back(container), where :container is a signal, creates an action that
-// takes an item as a parameter and pushes it onto the back of :container.
-
-template<class Container, class Item>
-struct push_back_action : action_interface<Item>
+// The following actions modify the items in a container signal.
+// If the signal supports in-place mutation (see mutate_signal_items), the
+// container is modified in place and only the affected items are marked as
+// changed. Otherwise, the container is copied, modified, and written back.
+// Actions that take an index do nothing if the index is out of range.
+// (Since the modifications happen in place, these inspect the container after
+// invoking the intermediary, so they see the effects of any actions that
+// preceded them.)
+
+template<class Container, class... Args>
+struct container_action : action_interface<Args...>
 {
-    push_back_action(Container container) : container_(container)
+    container_action(Container container) : container_(container)
     {
     }
 
@@ -291,26 +300,148 @@ struct push_back_action : action_interface<Item>
         return container_.has_value() && container_.ready_to_write();
     }
 
+ protected:
+    Container container_;
+};
+
+template<class Container>
+using container_item_type = typename Container::value_type::value_type;
+
+// push_back(container), where :container is a signal, creates an action that
+// takes an item as a parameter and pushes it onto the back of :container.
+
+template<class Container, class Item>
+struct push_back_action : container_action<Container, Item>
+{
+    using container_action<Container, Item>::container_action;
+
     void
     perform(std::function<void()> const& intermediary, Item item) const
     {
-        auto new_container = container_.read();
-        new_container.push_back(item);
         intermediary();
-        container_.write(new_container);
+        size_t n = this->container_.read().size();
+        mutate_signal_items(
+            this->container_,
+            n,
+            n + 1,
+            [&](typename Container::value_type& items) {
+                items.push_back(std::move(item));
+            });
     }
-
- private:
-    Container container_;
 };
 
 template<class Container>
 auto
 push_back(Container container)
 {
-    return push_back_action<
-        Container,
-        typename Container::value_type::value_type>(container);
+    return push_back_action<Container, container_item_type<Container>>(
+        container);
+}
+
+// insert(container), where :container is a signal, creates an action that
+// takes an index and an item as parameters and inserts the item into
+// :container at that index.
+
+template<class Container, class Item>
+struct insert_action : container_action<Container, size_t, Item>
+{
+    using container_action<Container, size_t, Item>::container_action;
+
+    void
+    perform(
+        std::function<void()> const& intermediary,
+        size_t index,
+        Item item) const
+    {
+        intermediary();
+        if (index > this->container_.read().size())
+            return;
+        // All items from the insertion point on have changed.
+        mutate_signal_items(
+            this->container_,
+            index,
+            size_t(-1),
+            [&](typename Container::value_type& items) {
+                items.insert(items.begin() + index, std::move(item));
+            });
+    }
+};
+
+template<class Container>
+auto
+insert(Container container)
+{
+    return insert_action<Container, container_item_type<Container>>(
+        container);
+}
+
+// erase_at(container), where :container is a signal, creates an action that
+// takes an index as a parameter and erases the item at that index from
+// :container.
+
+template<class Container>
+struct erase_at_action : container_action<Container, size_t>
+{
+    using container_action<Container, size_t>::container_action;
+
+    void
+    perform(std::function<void()> const& intermediary, size_t index) const
+    {
+        intermediary();
+        if (index >= this->container_.read().size())
+            return;
+        // All items from the erasure point on have changed.
+        mutate_signal_items(
+            this->container_,
+            index,
+            size_t(-1),
+            [&](typename Container::value_type& items) {
+                items.erase(items.begin() + index);
+            });
+    }
+};
+
+template<class Container>
+auto
+erase_at(Container container)
+{
+    return erase_at_action<Container>(container);
+}
+
+// update_at(container), where :container is a signal, creates an action that
+// takes an index and an item as parameters and replaces the item at that
+// index within :container.
+
+template<class Container, class Item>
+struct update_at_action : container_action<Container, size_t, Item>
+{
+    using container_action<Container, size_t, Item>::container_action;
+
+    void
+    perform(
+        std::function<void()> const& intermediary,
+        size_t index,
+        Item item) const
+    {
+        intermediary();
+        if (index >= this->container_.read().size())
+            return;
+        mutate_signal_items(
+            this->container_,
+            index,
+            index + 1,
+            [&](typename Container::value_type& items) {
+                items[index] = std::move(item);
+            });
+    }
+};
+
+template<class Container>
+auto
+update_at(Container container)
+{
+    return update_at_action<Container, container_item_type<Container>>(
+        container);
 }
 
 // lambda_action(is_ready, perform) creates an action whose behavior is
@@ -361,7 +492,7 @@ struct lambda_action_object<IsReady, Perform, action_interface<Args...>>
     perform(std::function<void()> const& intermediary, Args... args) const
     {
         intermediary();
-        perform_(args...);
+        perform_(std::forward<Args>(args)...);
     }
 
  private:
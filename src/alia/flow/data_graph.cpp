@@ -1,9 +1,35 @@
 #include <alia/flow/data_graph.hpp>
 #include <map>
+#include <typeinfo>
 #include <vector>
 
 namespace alia {
 
+data_graph_counters
+operator-(data_graph_counters const& later, data_graph_counters const& earlier)
+{
+    data_graph_counters difference;
+    difference.nodes_created = later.nodes_created - earlier.nodes_created;
+    difference.nodes_destroyed
+        = later.nodes_destroyed - earlier.nodes_destroyed;
+    difference.cache_clears = later.cache_clears - earlier.cache_clears;
+    difference.named_block_hits
+        = later.named_block_hits - earlier.named_block_hits;
+    difference.named_block_misses
+        = later.named_block_misses - earlier.named_block_misses;
+    return difference;
+}
+
+// the counters for the graph that's currently being traversed on this thread
+// (This is needed to record work done in places where the graph isn't readily
+// available, like node destruction and cache clearing.)
+static thread_local data_graph_counters* active_counters = nullptr;
+
+// the traversal that's currently active on this thread
+// (Named block references are released in places where the traversal isn't
+// readily available, but their retention depends on its tick count.)
+static thread_local data_traversal* active_traversal = nullptr;
+
 struct named_block_node;
 
 struct naming_map
@@ -14,6 +40,22 @@ struct naming_map
         id_interface_pointer_less_than_test>
         map_type;
     map_type blocks;
+
+    // the list of inactive manual_delete blocks in this map, ordered from most
+    // to least recently used
+    named_block_node* inactive_head = nullptr;
+    named_block_node* inactive_tail = nullptr;
+    size_t inactive_count = 0;
+
+    // the retention limit for inactive blocks in this map
+    // If this isn't set explicitly, the graph's default applies.
+    size_t inactive_limit = unlimited_inactive_blocks;
+    bool has_inactive_limit = false;
+
+    // the number of inactive blocks in this map that are being retained (See
+    // scoped_cache_retention.) - This is only an upper bound. It's recomputed
+    // whenever the retained blocks are checked.
+    size_t retained_count = 0;
 };
 
 struct named_block_node : noncopyable
@@ -44,8 +86,59 @@ struct named_block_node : noncopyable
     // to know where that map is so it can remove itself if it's no longer
     // needed.
     naming_map* map;
+
+    // If this block was referenced from a data_block whose named blocks are
+    // being matched out of order, this is the position of that reference
+    // within the named_block_ref_index. (This is only a hint. It can be stale
+    // or belong to another index, so it must be validated before use.)
+    size_t indexed_position = 0;
+
+    // the cache retention period that was in effect where this block last
+    // appeared
+    millisecond_count cache_retention = 0;
+
+    // If this block is inactive and subject to manual deletion, it's stored in
+    // its map's list of inactive blocks. This flag indicates that, and these
+    // are the pointers for that list.
+    bool inactive = false;
+    named_block_node* inactive_prev = nullptr;
+    named_block_node* inactive_next = nullptr;
 };
 
+// Add a newly inactive manual_delete block to the front of its map's list of
+// inactive blocks.
+static void
+add_inactive_block(naming_map& map, named_block_node* node)
+{
+    node->inactive_prev = nullptr;
+    node->inactive_next = map.inactive_head;
+    if (map.inactive_head)
+        map.inactive_head->inactive_prev = node;
+    else
+        map.inactive_tail = node;
+    map.inactive_head = node;
+    node->inactive = true;
+    ++map.inactive_count;
+}
+
+// Remove a block from its map's list of inactive blocks.
+static void
+remove_inactive_block(naming_map& map, named_block_node* node)
+{
+    if (node->inactive_prev)
+        node->inactive_prev->inactive_next = node->inactive_next;
+    else
+        map.inactive_head = node->inactive_next;
+    if (node->inactive_next)
+        node->inactive_next->inactive_prev = node->inactive_prev;
+    else
+        map.inactive_tail = node->inactive_prev;
+    node->inactive = false;
+    node->inactive_prev = nullptr;
+    node->inactive_next = nullptr;
+    --map.inactive_count;
+}
+
 // naming_maps are always created via a naming_map_node, which takes care of
 // associating them with the data_graph.
 struct naming_map_node : noncopyable
@@ -88,8 +181,8 @@ naming_map_node::~naming_map_node()
         graph->map_list = next;
 }
 
-static void
-deactivate(named_block_ref_node& ref);
+static bool
+deactivate(named_block_ref_node& ref, bool retainable = false);
 
 // named_block_ref_nodes are stored as lists within data_blocks to hold
 // references to the named_block_nodes that occur within that block.
@@ -100,7 +193,10 @@ struct named_block_ref_node : noncopyable
     {
         if (node)
         {
-            deactivate(*this);
+            // If this leaves the block inactive, it may be retained for a
+            // grace period (in which case it stays in its map, even if it's
+            // no longer referenced).
+            bool retained = deactivate(*this, true);
 
             --node->reference_count;
             if (!node->reference_count)
@@ -109,11 +205,18 @@ struct named_block_ref_node : noncopyable
                 {
                     if (!node->manual_delete)
                     {
-                        node->map->blocks.erase(&node->id.get());
-                        delete node;
+                        if (!retained)
+                        {
+                            node->map->blocks.erase(&node->id.get());
+                            delete node;
+                        }
                     }
                     else
-                        clear_cached_data(node->block);
+                    {
+                        if (!retained)
+                            clear_cached_data(node->block);
+                        add_inactive_block(*node->map, node);
+                    }
                 }
                 else
                     delete node;
@@ -140,16 +243,79 @@ activate(named_block_ref_node& ref)
         ref.active = true;
     }
 }
-static void
-deactivate(named_block_ref_node& ref)
+// Start the grace period for a block that has just become inactive, if its
+// retention period applies. Returns true iff the block is being retained.
+static bool
+retain_inactive_block(named_block_node& node)
 {
+    data_traversal* traversal = active_traversal;
+    if (!traversal || !traversal->cache_clearing_enabled || !node.map
+        || node.cache_retention == 0)
+    {
+        return false;
+    }
+    node.block.cache_retained = true;
+    node.block.inactive_since = traversal->tick_count;
+    ++node.map->retained_count;
+    return true;
+}
+
+// Deactivate a reference. If this leaves the referenced block inactive, its
+// cached data is cleared, unless :retainable is set and the block is retained
+// instead (in which case this returns true).
+static bool
+deactivate(named_block_ref_node& ref, bool retainable)
+{
+    bool retained = false;
     if (ref.active)
     {
         --ref.node->active_count;
         if (ref.node->active_count == 0)
-            clear_cached_data(ref.node->block);
+        {
+            retained = retainable && retain_inactive_block(*ref.node);
+            if (!retained)
+                clear_cached_data(ref.node->block);
+        }
         ref.active = false;
     }
+    return retained;
+}
+
+// Release the retained blocks in :map whose grace periods have expired (or all
+// of them, if :traversal is null). Blocks that are no longer referenced are
+// deleted. Others just have their cached data cleared.
+static void
+release_retained_blocks(naming_map& map, data_traversal const* traversal)
+{
+    size_t retained_count = 0;
+    std::vector<named_block_node*> expired;
+    for (auto const& entry : map.blocks)
+    {
+        named_block_node* node = entry.second;
+        data_block& block = node->block;
+        if (!block.cache_retained || node->active_count != 0)
+            continue;
+        if (traversal
+            && millisecond_count(traversal->tick_count - block.inactive_since)
+                   < node->cache_retention)
+        {
+            ++retained_count;
+            continue;
+        }
+        if (node->reference_count == 0 && !node->manual_delete)
+            expired.push_back(node);
+        else
+            clear_cached_data(block);
+    }
+    map.retained_count = retained_count;
+    // Deleting a block can release references to other blocks in this map
+    // (but never to one of these), so this has to happen outside the loop.
+    for (named_block_node* node : expired)
+    {
+        map.blocks.erase(&node->id.get());
+        node->map = 0;
+        delete node;
+    }
 }
 
 static void
@@ -163,6 +329,137 @@ delete_named_block_ref_list(named_block_ref_node* head)
     }
 }
 
+// named_block_ref_index stores the unclaimed references from the last pass
+// over a data_block once its named blocks have been encountered out of order.
+//
+// This is essentially the keyed reconciliation that virtual DOM libraries do
+// when the children of a node are reordered: rather than discarding the old
+// references and allocating new ones, references are claimed by the node that
+// they reference, regardless of where they appear in the list.
+//
+// Since we only see the new order one block at a time, we can't compute a
+// true longest increasing subsequence of the old positions. Instead, after
+// each claim, the prediction resumes immediately after the claimed position,
+// so any run of blocks that maintains its relative order from the last pass
+// (e.g., everything after an inserted or moved block) is still found via the
+// prediction, and only the blocks that actually moved require a lookup.
+struct named_block_ref_index
+{
+    // the references from the last pass, in their original order
+    // (Claimed references are set to null.)
+    std::vector<named_block_ref_node*> refs;
+
+    // For each position in refs, this is either the position itself (if the
+    // reference there is unclaimed) or a position at or before the next
+    // unclaimed reference. (This is a disjoint-set forest with path
+    // compression, so finding the next unclaimed reference is effectively
+    // constant time, even when references are claimed in reverse order.)
+    std::vector<size_t> successors;
+
+    // the position of the next predicted reference within refs
+    size_t next = 0;
+};
+
+static void
+build_named_block_ref_index(data_traversal& traversal)
+{
+    named_block_ref_index* index = new named_block_ref_index;
+    for (named_block_ref_node* i = traversal.predicted_named_block; i;
+         i = i->next)
+    {
+        i->node->indexed_position = index->refs.size();
+        index->successors.push_back(index->refs.size());
+        index->refs.push_back(i);
+    }
+    // Add a sentinel position to mark the end of the list.
+    index->successors.push_back(index->refs.size());
+    traversal.predicted_named_block = nullptr;
+    traversal.named_block_index = index;
+}
+
+// Find the first unclaimed position at or after :position.
+static size_t
+find_unclaimed(named_block_ref_index& index, size_t position)
+{
+    size_t root = position;
+    while (index.successors[root] != root)
+        root = index.successors[root];
+    while (position != root)
+    {
+        size_t next = index.successors[position];
+        index.successors[position] = root;
+        position = next;
+    }
+    return root;
+}
+
+// Get the predicted reference from an index (without claiming it).
+static named_block_ref_node*
+get_predicted_ref(named_block_ref_index& index)
+{
+    index.next = find_unclaimed(index, index.next);
+    return index.next != index.refs.size() ? index.refs[index.next] : nullptr;
+}
+
+// Claim the reference at the given position in an index.
+static named_block_ref_node*
+claim_ref(named_block_ref_index& index, size_t position)
+{
+    named_block_ref_node* ref = index.refs[position];
+    index.refs[position] = nullptr;
+    index.successors[position] = position + 1;
+    index.next = position + 1;
+    return ref;
+}
+
+// Claim the reference to :node from the last pass, if there is one.
+static named_block_ref_node*
+claim_ref(data_traversal& traversal, named_block_node* node)
+{
+    if (!traversal.named_block_index)
+    {
+        if (!traversal.predicted_named_block)
+            return nullptr;
+        build_named_block_ref_index(traversal);
+    }
+    named_block_ref_index& index = *traversal.named_block_index;
+    size_t position = node->indexed_position;
+    if (position < index.refs.size() && index.refs[position]
+        && index.refs[position]->node == node)
+    {
+        return claim_ref(index, position);
+    }
+    return nullptr;
+}
+
+// Release the index associated with the active block of :traversal.
+// If :discard_unclaimed is true, the unclaimed references are deleted.
+// Otherwise, they're kept alive by appending them to the list of used
+// references.
+static void
+release_named_block_ref_index(
+    data_traversal& traversal, bool discard_unclaimed)
+{
+    named_block_ref_index* index = traversal.named_block_index;
+    for (named_block_ref_node* ref : index->refs)
+    {
+        if (!ref)
+            continue;
+        if (discard_unclaimed)
+        {
+            delete ref;
+        }
+        else
+        {
+            *traversal.named_block_next_ptr = ref;
+            traversal.named_block_next_ptr = &ref->next;
+            ref->next = 0;
+        }
+    }
+    delete index;
+    traversal.named_block_index = nullptr;
+}
+
 // Clear all cached data stored in the subgraph referenced from the given node
 // list.
 static void
@@ -185,6 +482,12 @@ clear_cached_data(data_node* nodes)
             = dynamic_cast<typed_data_node<data_block>*>(i);
         if (block)
             clear_cached_data(block->value);
+
+        // If this node is a naming map, release any blocks it's retaining.
+        typed_data_node<naming_map_node>* map_node
+            = dynamic_cast<typed_data_node<naming_map_node>*>(i);
+        if (map_node && map_node->value.map.retained_count != 0)
+            release_retained_blocks(map_node->value.map, nullptr);
     }
 }
 
@@ -197,6 +500,9 @@ clear_cached_data(data_block& block)
         for (named_block_ref_node* i = block.named_blocks; i; i = i->next)
             deactivate(*i);
         block.cache_clear = true;
+        block.cache_retained = false;
+        if (active_counters)
+            ++active_counters->cache_clears;
     }
 }
 
@@ -213,6 +519,8 @@ clear_data_block(data_block& block)
     {
         data_node* next = node->next;
         delete node;
+        if (active_counters)
+            ++active_counters->nodes_destroyed;
         node = next;
     }
     block.nodes = 0;
@@ -224,23 +532,30 @@ clear_data_block(data_block& block)
 }
 
 void
-scoped_data_block::begin(data_traversal& traversal, data_block& block)
+scoped_data_block::begin(
+    data_traversal& traversal, data_block& block, profiling_site const* site)
 {
+    if (site)
+        profiling_region_.begin(traversal, *site);
+
     traversal_ = &traversal;
 
     old_active_block_ = traversal.active_block;
     old_predicted_named_block_ = traversal.predicted_named_block;
+    old_named_block_index_ = traversal.named_block_index;
     old_used_named_blocks_ = traversal.used_named_blocks;
     old_named_block_next_ptr_ = traversal.named_block_next_ptr;
     old_next_data_ptr_ = traversal.next_data_ptr;
 
     traversal.active_block = &block;
     traversal.predicted_named_block = block.named_blocks;
+    traversal.named_block_index = nullptr;
     traversal.used_named_blocks = 0;
     traversal.named_block_next_ptr = &traversal.used_named_blocks;
     traversal.next_data_ptr = &block.nodes;
 
     block.cache_clear = false;
+    block.cache_retained = false;
 }
 void
 scoped_data_block::end()
@@ -251,7 +566,20 @@ scoped_data_block::end()
 
         // If GC is enabled, record which named blocks were used and clear out
         // the unused ones.
-        if (traversal.gc_enabled && !std::uncaught_exception())
+        bool completed = !std::uncaught_exception();
+        if (traversal.named_block_index)
+        {
+            // The original list has already been dismantled, so if we're
+            // exiting prematurely, the unclaimed references have to be kept
+            // in the new one.
+            release_named_block_ref_index(traversal, completed);
+            if (!completed)
+            {
+                traversal.active_block->named_blocks
+                    = traversal.used_named_blocks;
+            }
+        }
+        if (traversal.gc_enabled && completed)
         {
             traversal.active_block->named_blocks = traversal.used_named_blocks;
             delete_named_block_ref_list(traversal.predicted_named_block);
@@ -259,12 +587,14 @@ scoped_data_block::end()
 
         traversal.active_block = old_active_block_;
         traversal.predicted_named_block = old_predicted_named_block_;
+        traversal.named_block_index = old_named_block_index_;
         traversal.used_named_blocks = old_used_named_blocks_;
         traversal.named_block_next_ptr = old_named_block_next_ptr_;
         traversal.next_data_ptr = old_next_data_ptr_;
 
         traversal_ = 0;
     }
+    profiling_region_.end();
 }
 
 naming_map*
@@ -284,11 +614,61 @@ retrieve_naming_map(data_traversal& traversal)
     return &map_node->map;
 }
 
+// Delete the least recently used inactive blocks in :map until it's within
+// its retention limit.
+static void
+enforce_inactive_block_limit(naming_map& map, size_t limit)
+{
+    while (map.inactive_count > limit)
+    {
+        named_block_node* node = map.inactive_tail;
+        remove_inactive_block(map, node);
+        map.blocks.erase(&node->id.get());
+        node->map = 0;
+        // Note that this can make other manual_delete blocks inactive,
+        // including ones in this map, but those are added at the front of the
+        // list, so this loop still evicts in order.
+        delete node;
+    }
+}
+
 void
 naming_context::begin(data_traversal& traversal)
 {
     traversal_ = &traversal;
     map_ = retrieve_naming_map(traversal);
+    if (traversal.gc_enabled && map_->inactive_count != 0)
+    {
+        enforce_inactive_block_limit(
+            *map_,
+            map_->has_inactive_limit ? map_->inactive_limit
+                                     : traversal.graph->inactive_block_limit);
+    }
+}
+void
+naming_context::end()
+{
+    if (traversal_)
+    {
+        // This is done at the end so that the traversal's tick count is
+        // always valid (even for the root map).
+        if (traversal_->cache_clearing_enabled && map_->retained_count != 0)
+            release_retained_blocks(*map_, traversal_);
+        traversal_ = nullptr;
+    }
+}
+
+void
+set_inactive_block_limit(naming_map& map, size_t limit)
+{
+    map.inactive_limit = limit;
+    map.has_inactive_limit = true;
+}
+
+size_t
+count_inactive_blocks(naming_map const& map)
+{
+    return map.inactive_count;
 }
 
 static void
@@ -300,6 +680,13 @@ record_usage(data_traversal& traversal, named_block_ref_node* ref)
     activate(*ref);
 }
 
+static bool
+matches_named_block(
+    named_block_ref_node const* ref, naming_map& map, id_interface const& id)
+{
+    return ref && ref->node->id.get() == id && ref->node->map == &map;
+}
+
 static named_block_node*
 find_named_block(
     data_traversal& traversal,
@@ -309,19 +696,37 @@ find_named_block(
 {
     // If the sequence of data requests is the same as last pass (which it
     // generally is), then the block we're looking for is the predicted one.
-    named_block_ref_node* predicted = traversal.predicted_named_block;
-    if (predicted && predicted->node->id.get() == id
-        && predicted->node->map == &map)
+    if (!traversal.named_block_index)
     {
-        traversal.predicted_named_block = predicted->next;
-        if (traversal.gc_enabled)
-            record_usage(traversal, predicted);
-        return predicted->node;
+        named_block_ref_node* predicted = traversal.predicted_named_block;
+        if (matches_named_block(predicted, map, id))
+        {
+            ++traversal.graph->counters.named_block_hits;
+            traversal.predicted_named_block = predicted->next;
+            if (traversal.gc_enabled)
+                record_usage(traversal, predicted);
+            return predicted->node;
+        }
+    }
+    else
+    {
+        // Even if the sequence has changed, the rest of it might still follow
+        // the order of the last pass.
+        named_block_ref_index& index = *traversal.named_block_index;
+        named_block_ref_node* predicted = get_predicted_ref(index);
+        if (matches_named_block(predicted, map, id))
+        {
+            ++traversal.graph->counters.named_block_hits;
+            record_usage(traversal, claim_ref(index, index.next));
+            return predicted->node;
+        }
     }
 
     if (!traversal.gc_enabled)
         throw named_block_out_of_order();
 
+    ++traversal.graph->counters.named_block_misses;
+
     // Otherwise, look it up in the map.
     naming_map::map_type::const_iterator i = map.blocks.find(&id);
 
@@ -341,12 +746,24 @@ find_named_block(
     named_block_node* node = i->second;
     assert(node && node->map == &map);
 
-    // Create a new reference node to record the node's usage within this
-    // data_block.
-    named_block_ref_node* ref = new named_block_ref_node;
-    ref->node = node;
-    ref->active = false;
-    ++node->reference_count;
+    // If the block was referenced from this data_block in the last pass, it
+    // has simply moved, so reuse that reference.
+    named_block_ref_node* ref = nullptr;
+    if (node->reference_count != 0)
+        ref = claim_ref(traversal, node);
+
+    // Otherwise, create a new reference node to record the node's usage within
+    // this data_block.
+    if (!ref)
+    {
+        // If the block was inactive, it's now back in use.
+        if (node->inactive)
+            remove_inactive_block(map, node);
+        ref = new named_block_ref_node;
+        ref->node = node;
+        ref->active = false;
+        ++node->reference_count;
+    }
     record_usage(traversal, ref);
 
     return node;
@@ -357,20 +774,49 @@ named_block::begin(
     data_traversal& traversal,
     naming_map& map,
     id_interface const& id,
-    manual_delete manual)
+    manual_delete manual,
+    profiling_site const* site)
 {
-    scoped_data_block_.begin(
-        traversal, find_named_block(traversal, map, id, manual)->block);
+    if (site)
+        profiling_region_.begin(traversal, *site);
+    if (traversal.graph->persistence_enabled)
+        persistent_path_.begin(traversal, id);
+    named_block_node* node = find_named_block(traversal, map, id, manual);
+    node->cache_retention = traversal.cache_retention;
+    scoped_data_block_.begin(traversal, node->block);
 }
 void
 named_block::end()
 {
     scoped_data_block_.end();
+    persistent_path_.end();
+    profiling_region_.end();
+}
+
+void
+scoped_persistent_path::begin(data_traversal& traversal, id_interface const& id)
+{
+    traversal_ = &traversal;
+    old_path_ = traversal.persistent_path;
+    std::uint64_t hash;
+    if (old_path_ != 0 && id.stable_hash(hash))
+    {
+        traversal.persistent_path = combine_stable_hashes(old_path_, hash);
+        // 0 is reserved for unaddressable paths.
+        if (traversal.persistent_path == 0)
+            traversal.persistent_path = 1;
+    }
+    else
+    {
+        traversal.persistent_path = 0;
+    }
 }
 
 void
 delete_named_block(data_graph& graph, id_interface const& id)
 {
+    data_graph_counters* old_counters = active_counters;
+    active_counters = &graph.counters;
     for (naming_map_node* i = graph.map_list; i; i = i->next)
     {
         naming_map::map_type::const_iterator j = i->map.blocks.find(&id);
@@ -386,12 +832,15 @@ delete_named_block(data_graph& graph, id_interface const& id)
             }
             else
             {
+                if (node->inactive)
+                    remove_inactive_block(i->map, node);
                 i->map.blocks.erase(&id);
                 node->map = 0;
                 delete node;
             }
         }
     }
+    active_counters = old_counters;
 }
 
 void
@@ -417,12 +866,64 @@ scoped_cache_clearing_disabler::end()
     }
 }
 
+void
+scoped_cache_retention::begin(
+    data_traversal& traversal, millisecond_count ticks)
+{
+    traversal_ = &traversal;
+    old_cache_retention_ = traversal.cache_retention;
+    traversal.cache_retention = ticks;
+}
+void
+scoped_cache_retention::end()
+{
+    if (traversal_)
+    {
+        traversal_->cache_retention = old_cache_retention_;
+        traversal_ = 0;
+    }
+}
+
+void
+clear_inactive_cached_data(data_traversal& traversal, data_block& block)
+{
+    if (!traversal.cache_clearing_enabled || block.cache_clear)
+        return;
+    if (traversal.cache_retention != 0)
+    {
+        if (!block.cache_retained)
+        {
+            block.cache_retained = true;
+            block.inactive_since = traversal.tick_count;
+            return;
+        }
+        if (millisecond_count(traversal.tick_count - block.inactive_since)
+            < traversal.cache_retention)
+        {
+            return;
+        }
+    }
+    clear_cached_data(block);
+}
+
 void
 scoped_data_traversal::begin(data_graph& graph, data_traversal& traversal)
 {
     traversal.graph = &graph;
     traversal.gc_enabled = true;
     traversal.cache_clearing_enabled = true;
+    traversal.tick_count = 0;
+    traversal.cache_retention = graph.cache_retention;
+    traversal.profiler = nullptr;
+    traversal.data_request_count = 0;
+    traversal.persistent_path
+        = graph.persistence_enabled ? stable_hash_seed : 0;
+    graph_ = &graph;
+    counters_at_begin_ = graph.counters;
+    old_counters_ = active_counters;
+    active_counters = &graph.counters;
+    old_traversal_ = active_traversal;
+    active_traversal = &traversal;
     root_block_.begin(traversal, graph.root_block);
     root_map_.begin(traversal);
 }
@@ -431,6 +932,66 @@ scoped_data_traversal::end()
 {
     root_block_.end();
     root_map_.end();
+    if (graph_)
+    {
+        graph_->last_traversal_counters = graph_->counters - counters_at_begin_;
+        active_counters = old_counters_;
+        active_traversal = old_traversal_;
+        graph_ = nullptr;
+    }
+}
+
+static void
+accumulate_block_stats(data_graph_stats& stats, data_block const& block)
+{
+    for (data_node const* i = block.nodes; i; i = i->next)
+    {
+        ++stats.node_counts[std::type_index(typeid(*i))];
+        ++stats.total_nodes;
+        stats.node_bytes += i->shallow_size();
+
+        typed_data_node<cached_data_holder> const* caching_node
+            = dynamic_cast<typed_data_node<cached_data_holder> const*>(i);
+        if (caching_node && caching_node->value.data)
+        {
+            ++stats.cached_data_objects;
+            stats.cached_data_bytes
+                += caching_node->value.data->shallow_size();
+        }
+
+        typed_data_node<data_block> const* block_node
+            = dynamic_cast<typed_data_node<data_block> const*>(i);
+        if (block_node)
+            accumulate_block_stats(stats, block_node->value);
+    }
+}
+
+data_graph_stats
+compute_data_graph_stats(data_graph const& graph)
+{
+    data_graph_stats stats;
+    accumulate_block_stats(stats, graph.root_block);
+    // Named blocks aren't reachable through the node lists, so visit them via
+    // the naming maps.
+    for (naming_map_node const* i = graph.map_list; i; i = i->next)
+    {
+        naming_map_stats map_stats;
+        for (auto const& entry : i->map.blocks)
+        {
+            named_block_node const* node = entry.second;
+            ++map_stats.named_blocks;
+            if (node->manual_delete)
+                ++map_stats.manual_delete_blocks;
+            accumulate_block_stats(stats, node->block);
+        }
+        map_stats.inactive_blocks = i->map.inactive_count;
+        stats.named_blocks += map_stats.named_blocks;
+        stats.manual_delete_blocks += map_stats.manual_delete_blocks;
+        stats.naming_maps.push_back(map_stats);
+    }
+    stats.estimated_bytes = stats.node_bytes + stats.cached_data_bytes
+                            + stats.named_blocks * sizeof(named_block_node);
+    return stats;
 }
 
 } // namespace alia
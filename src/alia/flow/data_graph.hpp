@@ -5,6 +5,9 @@
 #include <alia/id.hpp>
 #include <alia/signals/core.hpp>
 #include <cassert>
+#include <map>
+#include <typeindex>
+#include <vector>
 
 // This file defines the data retrieval library used for associating mutable
 // state and cached data with alia content graphs. It is designed so that each
@@ -80,12 +83,25 @@ struct data_node : noncopyable
     virtual ~data_node()
     {
     }
+    // Get the size of this node (not including any memory that it owns
+    // indirectly).
+    virtual std::size_t
+    shallow_size() const
+    {
+        return sizeof(data_node);
+    }
     data_node* next;
 };
 template<class T>
 struct typed_data_node : data_node
 {
     T value;
+
+    std::size_t
+    shallow_size() const override
+    {
+        return sizeof(typed_data_node);
+    }
 };
 
 struct named_block_ref_node;
@@ -103,6 +119,12 @@ struct data_block : noncopyable
     // a flag to track if the block's cache is clear
     bool cache_clear = true;
 
+    // If the block is inactive but its cache is being retained (see
+    // scoped_cache_retention), this is set, and inactive_since records the
+    // tick count at which the block was first seen inactive.
+    bool cache_retained = false;
+    millisecond_count inactive_since = 0;
+
     // list of named blocks referenced from this data block - The references
     // maintain shared ownership of the named blocks. The order of the
     // references indicates the order in which the block references appeared in
@@ -120,9 +142,91 @@ clear_data_block(data_block& block);
 
 struct naming_map_node;
 
+// data_graph_counters are cumulative counts of the work that has been done to
+// maintain a data_graph. They're intended for monitoring memory churn and the
+// efficiency of the garbage collector. (The figures for the most recent
+// traversal alone are also recorded. See data_graph::last_traversal_counters.)
+struct data_graph_counters
+{
+    // the number of data nodes created and destroyed
+    counter_type nodes_created = 0;
+    counter_type nodes_destroyed = 0;
+
+    // the number of times that the cached data within a block was cleared
+    counter_type cache_clears = 0;
+
+    // the number of named block lookups that were satisfied by the predicted
+    // block (hits) and those that required a lookup in the naming map (misses)
+    counter_type named_block_hits = 0;
+    counter_type named_block_misses = 0;
+};
+
+// Get the work that was done between the :earlier and :later counts.
+data_graph_counters
+operator-(data_graph_counters const& later, data_graph_counters const& earlier);
+
+struct recording_writer;
+
+// persistent_data is the base class for data that can be written to snapshots
+// of a data_graph (see snapshots.hpp). Instances that have been assigned an
+// address are linked into a list in their graph so that the graph's
+// persistent data can be enumerated without traversing it.
+struct persistent_data : noncopyable
+{
+    virtual ~persistent_data()
+    {
+        if (prev_next)
+        {
+            *prev_next = next;
+            if (next)
+                next->prev_next = prev_next;
+        }
+    }
+
+    // Write the data to a snapshot.
+    // The return value is false if there's currently nothing to write.
+    virtual bool
+    write(recording_writer& writer) const = 0;
+
+    // the address of the data within the graph
+    std::uint64_t address = 0;
+
+    // doubly linked list pointers (prev_next points to whatever points to this)
+    persistent_data* next = nullptr;
+    persistent_data** prev_next = nullptr;
+};
+
+struct data_snapshot;
+
+// the value used to specify that there's no limit on the number of inactive
+// manual_delete blocks in a naming map
+size_t const unlimited_inactive_blocks = ~size_t(0);
+
 // data_graph stores the data graph associated with a function.
 struct data_graph : noncopyable
 {
+    // If this is set, the graph tracks the addresses of persistent data so
+    // that the data can be written to snapshots. (See snapshots.hpp.)
+    // It must be set before the first traversal of the graph.
+    bool persistence_enabled = false;
+
+    // the snapshot that persistent data is restored from (if any)
+    // This must outlive the graph (or be reset before the graph is traversed
+    // again).
+    data_snapshot const* snapshot = nullptr;
+
+    // which of the entries in the snapshot have been attached to data in the
+    // graph (indexed like the snapshot's table) - These aren't carried over
+    // when new snapshots are written. (attached_snapshot is the snapshot that
+    // this applies to.)
+    std::vector<bool> attached_snapshot_entries;
+    data_snapshot const* attached_snapshot = nullptr;
+
+    // the list of persistent data in the graph
+    // (This is declared before the root block so that it outlives any data
+    // that refers to it.)
+    persistent_data* persistent_list = nullptr;
+
     data_block root_block;
 
     naming_map_node* map_list = nullptr;
@@ -135,10 +239,29 @@ struct data_graph : noncopyable
     // blocks. They're cleaned up when someone calls gc_named_data(graph)
     // following a complete traversal.
     named_block_ref_node* unused_named_block_refs = nullptr;
+
+    // the default number of ticks for which the cached data in inactive
+    // branches is retained (See scoped_cache_retention.)
+    millisecond_count cache_retention = 0;
+
+    // the default limit on the number of inactive manual_delete blocks that
+    // each naming map in this graph retains (See set_inactive_block_limit.)
+    size_t inactive_block_limit = unlimited_inactive_blocks;
+
+    // the cumulative counts of the work done to maintain this graph
+    data_graph_counters counters;
+    // the portion of the above that was done by the most recent traversal
+    // (This is updated when the traversal ends, so after a refresh, it
+    // describes the churn caused by that refresh alone.)
+    data_graph_counters last_traversal_counters;
 };
 
 struct naming_map;
 
+struct named_block_ref_index;
+
+struct traversal_profiler;
+
 // data_traversal stores the state associated with a single traversal of a
 // data_graph.
 struct data_traversal
@@ -147,11 +270,29 @@ struct data_traversal
     naming_map* active_map;
     data_block* active_block;
     named_block_ref_node* predicted_named_block;
+    // If the named blocks in the active block are encountered out of order,
+    // the remaining references from the last pass are moved into this index so
+    // that they can be claimed by node rather than strictly in sequence.
+    // (This is null as long as the order matches the last pass.)
+    named_block_ref_index* named_block_index;
     named_block_ref_node* used_named_blocks;
     named_block_ref_node** named_block_next_ptr;
     data_node** next_data_ptr;
     bool gc_enabled;
     bool cache_clearing_enabled;
+    // the tick count for this traversal
+    millisecond_count tick_count;
+    // the number of ticks for which inactive cached data is currently retained
+    millisecond_count cache_retention;
+    // the profiler for this traversal (or null if it's not being profiled)
+    traversal_profiler* profiler;
+    // the number of get_data calls made so far in this traversal
+    counter_type data_request_count;
+    // the address of the active named block for the purposes of persistence
+    // (a hash of the IDs of the named blocks along the path to it)
+    // This is 0 if persistence isn't enabled or if any of those IDs has no
+    // stable hash.
+    std::uint64_t persistent_path;
 };
 
 // The utilities here operate on data_traversals. However, the data_graph
@@ -170,12 +311,82 @@ get_data_traversal(data_traversal& ctx)
     return ctx;
 }
 
+// The following are the hooks for profiling traversals. (See profiling.hpp
+// for the profiler itself.)
+//
+// A profiling_site identifies a static location in the code (e.g., an ALIA_IF
+// or ALIA_FOR). Sites are always declared as static constants so that their
+// addresses uniquely identify them.
+struct profiling_site
+{
+    char const* label;
+    // the source location of the site (or null/0 if it's not specific to a
+    // location)
+    char const* file;
+    int line;
+};
+
+void
+begin_profiling_region(
+    traversal_profiler& profiler,
+    data_traversal& traversal,
+    profiling_site const& site);
+
+void
+end_profiling_region(traversal_profiler& profiler, data_traversal& traversal);
+
+// scoped_profiling_region attributes the work done within its scope to the
+// given site (if the traversal is being profiled).
+struct scoped_profiling_region : noncopyable
+{
+    scoped_profiling_region() : traversal_(0)
+    {
+    }
+
+    scoped_profiling_region(
+        data_traversal& traversal, profiling_site const& site)
+        : traversal_(0)
+    {
+        begin(traversal, site);
+    }
+
+    ~scoped_profiling_region()
+    {
+        end();
+    }
+
+    void
+    begin(data_traversal& traversal, profiling_site const& site)
+    {
+        if (traversal.profiler)
+        {
+            traversal_ = &traversal;
+            begin_profiling_region(*traversal.profiler, traversal, site);
+        }
+    }
+
+    void
+    end()
+    {
+        if (traversal_)
+        {
+            end_profiling_region(*traversal_->profiler, *traversal_);
+            traversal_ = 0;
+        }
+    }
+
+ private:
+    data_traversal* traversal_;
+};
+
 // A scoped_data_block activates the associated data_block at the beginning
 // of its scope and deactivates it at the end. It's useful anytime there is a
 // branch in the code and you need to activate the block associated with the
 // taken branch while that branch is active.
 // Note that the macros defined below make heavy use of this and reduce the
 // need for applications to use it directly.
+// If a profiling site is provided, the time spent within the block is
+// attributed to that site when profiling.
 struct scoped_data_block : noncopyable
 {
     scoped_data_block() : traversal_(0)
@@ -183,9 +394,10 @@ struct scoped_data_block : noncopyable
     }
 
     template<class Context>
-    scoped_data_block(Context& ctx, data_block& block)
+    scoped_data_block(
+        Context& ctx, data_block& block, profiling_site const* site = nullptr)
     {
-        begin(ctx, block);
+        begin(ctx, block, site);
     }
 
     ~scoped_data_block()
@@ -195,22 +407,28 @@ struct scoped_data_block : noncopyable
 
     template<class Context>
     void
-    begin(Context& ctx, data_block& block)
+    begin(
+        Context& ctx, data_block& block, profiling_site const* site = nullptr)
     {
-        begin(get_data_traversal(ctx), block);
+        begin(get_data_traversal(ctx), block, site);
     }
 
     void
-    begin(data_traversal& traversal, data_block& block);
+    begin(
+        data_traversal& traversal,
+        data_block& block,
+        profiling_site const* site = nullptr);
 
     void
     end();
 
  private:
+    scoped_profiling_region profiling_region_;
     data_traversal* traversal_;
     // old state
     data_block* old_active_block_;
     named_block_ref_node* old_predicted_named_block_;
+    named_block_ref_index* old_named_block_index_;
     named_block_ref_node* old_used_named_blocks_;
     named_block_ref_node** old_named_block_next_ptr_;
     data_node** old_next_data_ptr_;
@@ -238,6 +456,34 @@ struct scoped_data_block : noncopyable
 // still be a memory leak, since the data_graph might live on as long as the
 // application is running.)
 
+// scoped_persistent_path extends the persistent path of a traversal with an ID
+// for the duration of its scope. (named_block does this automatically.)
+struct scoped_persistent_path : noncopyable
+{
+    scoped_persistent_path() : traversal_(0)
+    {
+    }
+    ~scoped_persistent_path()
+    {
+        end();
+    }
+    void
+    begin(data_traversal& traversal, id_interface const& id);
+    void
+    end()
+    {
+        if (traversal_)
+        {
+            traversal_->persistent_path = old_path_;
+            traversal_ = 0;
+        }
+    }
+
+ private:
+    data_traversal* traversal_;
+    std::uint64_t old_path_;
+};
+
 // The manual deletion flag is specified via its own structure to make it very
 // obvious at the call site.
 struct manual_delete
@@ -248,6 +494,8 @@ struct manual_delete
     bool value;
 };
 
+// As with scoped_data_block, a profiling site can be provided to attribute the
+// time spent within a named_block (including finding it) to its call site.
 struct named_block : noncopyable
 {
     named_block()
@@ -258,9 +506,10 @@ struct named_block : noncopyable
     named_block(
         Context& ctx,
         id_interface const& id,
-        manual_delete manual = manual_delete(false))
+        manual_delete manual = manual_delete(false),
+        profiling_site const* site = nullptr)
     {
-        begin(ctx, id, manual);
+        begin(ctx, id, manual, site);
     }
 
     template<class Context>
@@ -268,9 +517,10 @@ struct named_block : noncopyable
     begin(
         Context& ctx,
         id_interface const& id,
-        manual_delete manual = manual_delete(false))
+        manual_delete manual = manual_delete(false),
+        profiling_site const* site = nullptr)
     {
-        begin(get_data_traversal(ctx), get_naming_map(ctx), id, manual);
+        begin(get_data_traversal(ctx), get_naming_map(ctx), id, manual, site);
     }
 
     void
@@ -278,12 +528,15 @@ struct named_block : noncopyable
         data_traversal& traversal,
         naming_map& map,
         id_interface const& id,
-        manual_delete manual);
+        manual_delete manual,
+        profiling_site const* site = nullptr);
 
     void
     end();
 
  private:
+    scoped_profiling_region profiling_region_;
+    scoped_persistent_path persistent_path_;
     scoped_data_block scoped_data_block_;
 };
 
@@ -315,9 +568,7 @@ struct naming_context : noncopyable
     begin(data_traversal& traversal);
 
     void
-    end()
-    {
-    }
+    end();
 
     data_traversal&
     traversal()
@@ -331,8 +582,8 @@ struct naming_context : noncopyable
     }
 
  private:
-    data_traversal* traversal_;
-    naming_map* map_;
+    data_traversal* traversal_ = nullptr;
+    naming_map* map_ = nullptr;
 };
 inline data_traversal&
 get_data_traversal(naming_context& ctx)
@@ -364,16 +615,51 @@ delete_named_block(Context& ctx, id_interface const& id)
     delete_named_block(*get_data_traversal(ctx).graph, id);
 }
 
+// Left alone, manual_delete blocks (including the cases of switch blocks) that
+// are no longer referenced anywhere in the graph are retained until they're
+// explicitly deleted or the data_graph is destroyed. In long-running
+// applications, this can amount to unbounded growth, so naming maps can be
+// given a retention limit instead.
+//
+// Each naming map tracks its inactive manual_delete blocks in least recently
+// used order. Whenever the map is visited in a traversal with GC enabled, the
+// least recently used blocks in excess of the limit are deleted.
+//
+// The limit for a map defaults to the data_graph's inactive_block_limit, but
+// it can be overridden for individual maps. A limit of 0 means that inactive
+// manual_delete blocks are deleted on the next pass (but their data still
+// survives for as long as the block is active).
+
+void
+set_inactive_block_limit(naming_map& map, size_t limit);
+
+inline void
+set_inactive_block_limit(naming_context& nc, size_t limit)
+{
+    set_inactive_block_limit(nc.map(), limit);
+}
+
+// Get the number of inactive manual_delete blocks currently retained by a
+// naming map.
+size_t
+count_inactive_blocks(naming_map const& map);
+
 // This is a macro that, given a context, an uninitialized named_block, and an
 // ID, combines the ID with another ID which is unique to that location in the
 // code (but not the graph), and then initializes the named_block with the
 // combined ID.
 // This is not as generally useful as naming_context, but it can be used to
 // identify the combinaion of a function and its argument.
+// (The location's profiling site doubles as its unique ID.)
 #define ALIA_BEGIN_LOCATION_SPECIFIC_NAMED_BLOCK(ctx, named_block, id)         \
     {                                                                          \
-        static int _alia_dummy_static;                                         \
-        named_block.begin(ctx, combine_ids(make_id(&_alia_dummy_static), id)); \
+        static ::alia::profiling_site const _alia_profiling_site               \
+            = {"named_block", __FILE__, __LINE__};                             \
+        named_block.begin(                                                     \
+            ctx,                                                               \
+            combine_ids(make_id(&_alia_profiling_site), id),                   \
+            ::alia::manual_delete(false),                                      \
+            &_alia_profiling_site);                                            \
     }
 
 // disable_gc(traversal) disables the garbage collector for a data traversal.
@@ -426,6 +712,58 @@ struct scoped_cache_clearing_disabler
     bool old_cache_clearing_state_;
 };
 
+// Normally, when a conditional block becomes inactive, its cached data is
+// cleared immediately. For content that toggles rapidly (e.g., hover panels or
+// tooltips), this can mean that expensive cached values are repeatedly
+// discarded and recomputed. scoped_cache_retention sets a grace period (in
+// ticks of the traversal's clock) for the conditional blocks within its scope.
+// The cached data of a block is only cleared once the block has been inactive
+// for at least that long. (Since this is checked as part of refresh passes,
+// the data may actually outlive the grace period until the next refresh.)
+//
+// This also applies to named blocks (including switch cases) that appear
+// within its scope. When one stops appearing, its cached data is retained in
+// the same way, and if it's no longer referenced at all, the block itself is
+// kept until the grace period expires (rather than being deleted immediately).
+// These are checked when their naming context ends.
+//
+// The default retention period for the traversal is taken from the graph
+// (data_graph::cache_retention), which is 0 unless otherwise specified.
+struct scoped_cache_retention
+{
+    scoped_cache_retention() : traversal_(0)
+    {
+    }
+    template<class Context>
+    scoped_cache_retention(Context& ctx, millisecond_count ticks)
+    {
+        begin(ctx, ticks);
+    }
+    ~scoped_cache_retention()
+    {
+        end();
+    }
+    template<class Context>
+    void
+    begin(Context& ctx, millisecond_count ticks)
+    {
+        begin(get_data_traversal(ctx), ticks);
+    }
+    void
+    begin(data_traversal& traversal, millisecond_count ticks);
+    void
+    end();
+
+ private:
+    data_traversal* traversal_;
+    millisecond_count old_cache_retention_;
+};
+
+// Clear the cached data of an inactive block, subject to the retention period
+// of the traversal.
+void
+clear_inactive_cached_data(data_traversal& traversal, data_block& block);
+
 // get_data(traversal, &ptr) represents a data node in the data graph.
 // The call retrieves data from the graph at the current point in the
 // traversal, assigns its address to *ptr, and advances the traversal to the
@@ -440,6 +778,7 @@ bool
 get_data(Context& ctx, T** ptr)
 {
     data_traversal& traversal = get_data_traversal(ctx);
+    ++traversal.data_request_count;
     data_node* node = *traversal.next_data_ptr;
     if (node)
     {
@@ -453,6 +792,7 @@ get_data(Context& ctx, T** ptr)
     else
     {
         typed_data_node<T>* new_node = new typed_data_node<T>;
+        ++traversal.graph->counters.nodes_created;
         *traversal.next_data_ptr = new_node;
         traversal.next_data_ptr = &new_node->next;
         *ptr = &new_node->value;
@@ -481,12 +821,26 @@ struct cached_data
     virtual ~cached_data()
     {
     }
+
+    // Get the size of this object (not including any memory that it owns
+    // indirectly).
+    virtual std::size_t
+    shallow_size() const
+    {
+        return sizeof(cached_data);
+    }
 };
 
 template<class T>
 struct typed_cached_data : cached_data
 {
     T value;
+
+    std::size_t
+    shallow_size() const override
+    {
+        return sizeof(typed_cached_data);
+    }
 };
 
 struct cached_data_holder
@@ -598,6 +952,13 @@ set(keyed_data<Data>& data, Data const& value)
     data.value = value;
     mark_valid(data);
 }
+template<class Data>
+void
+set(keyed_data<Data>& data, Data&& value)
+{
+    data.value = std::move(value);
+    mark_valid(data);
+}
 
 template<class Data>
 Data const&
@@ -641,6 +1002,11 @@ struct keyed_data_signal : signal<keyed_data_signal<Data>, Data, duplex_signal>
     {
         alia::set(*data_, value);
     }
+    void
+    write(Data&& value) const
+    {
+        alia::set(*data_, std::move(value));
+    }
 
  private:
     keyed_data<Data>* data_;
@@ -725,7 +1091,57 @@ struct scoped_data_traversal
  private:
     scoped_data_block root_block_;
     naming_context root_map_;
+    data_graph* graph_ = nullptr;
+    data_graph_counters counters_at_begin_;
+    data_graph_counters* old_counters_;
+    data_traversal* old_traversal_;
+};
+
+// data_graph_stats is a snapshot of the contents of a data_graph.
+struct naming_map_stats
+{
+    // the total number of named blocks in the map
+    std::size_t named_blocks = 0;
+    // the number of those that are flagged for manual deletion
+    std::size_t manual_delete_blocks = 0;
+    // the number of manual_delete blocks that are currently inactive
+    std::size_t inactive_blocks = 0;
 };
+struct data_graph_stats
+{
+    // the number of data nodes of each type
+    // (These are keyed by the type of the node itself, i.e., the
+    // typed_data_node<T>.)
+    std::map<std::type_index, std::size_t> node_counts;
+
+    // the total number of data nodes
+    std::size_t total_nodes = 0;
+
+    // the total (shallow) size of the data nodes
+    std::size_t node_bytes = 0;
+
+    // the number of live cached data objects and their total (shallow) size
+    std::size_t cached_data_objects = 0;
+    std::size_t cached_data_bytes = 0;
+
+    // stats for each naming map in the graph
+    std::vector<naming_map_stats> naming_maps;
+
+    // totals across all naming maps
+    std::size_t named_blocks = 0;
+    std::size_t manual_delete_blocks = 0;
+
+    // an estimate of the total memory used by the graph (including the data
+    // nodes, cached data and named blocks, but not any memory that the data
+    // owns indirectly)
+    std::size_t estimated_bytes = 0;
+};
+
+// Compute stats for a data_graph.
+// Note that this walks the entire graph, so it's not intended to be called
+// every frame.
+data_graph_stats
+compute_data_graph_stats(data_graph const& graph);
 
 } // namespace alia
 
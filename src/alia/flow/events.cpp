@@ -1,7 +1,11 @@
 #include <alia/flow/events.hpp>
 
+#include <alia/flow/profiling.hpp>
+#include <alia/flow/recording.hpp>
 #include <alia/system.hpp>
+#include <alia/timing/animation_engine.hpp>
 #include <alia/timing/ticks.hpp>
+#include <alia/tracing.hpp>
 
 namespace alia {
 
@@ -12,7 +16,12 @@ scoped_routing_region::begin(context ctx)
 
     routing_region_ptr* region;
     if (get_data(ctx, &region))
+    {
         region->reset(new routing_region);
+        system& sys = ctx.get<system_tag>();
+        if (sys.recorder || sys.replayer)
+            impl::register_routing_region(sys, *region);
+    }
 
     if (traversal.active_region)
     {
@@ -53,7 +62,8 @@ scoped_routing_region::end()
 }
 
 static void
-invoke_controller(system& sys, event_traversal& events)
+invoke_controller(
+    system& sys, event_traversal& events, microsecond_count tick_count)
 {
     bool is_refresh = (events.event_type == &typeid(refresh_event));
 
@@ -63,19 +73,36 @@ invoke_controller(system& sys, event_traversal& events)
     data.gc_enabled = data.cache_clearing_enabled = is_refresh;
 
     timing_subsystem timing;
-    timing.tick_counter = sys.external ? sys.external->get_tick_count()
-                                       : get_default_tick_count();
+    timing.precise_tick_counter = tick_count;
+    timing.tick_counter = millisecond_count(tick_count / 1000);
+    data.tick_count = timing.tick_counter;
+
+    // Batched animations are advanced once per frame, before anything reads
+    // them.
+    if (sys.animations && is_refresh)
+        advance_animation_engine(*sys.animations, timing.tick_counter);
+
+    scoped_profiling_frame profiling_frame;
+    if (sys.profiler && is_refresh)
+        profiling_frame.begin(*sys.profiler, data);
 
     context_storage storage;
     context ctx = make_context(&storage, sys, events, data, timing);
 
     sys.controller(ctx);
+
+    if (is_refresh)
+        report_refresh_deadline(sys, timing);
 }
 
 namespace impl {
 
 static void
-route_event_(system& sys, event_traversal& traversal, routing_region* target)
+route_event_(
+    system& sys,
+    event_traversal& traversal,
+    routing_region* target,
+    microsecond_count tick_count)
 {
     // In order to construct the path to the target, we start at the target and
     // follow the 'parent' pointers until we reach the root.
@@ -87,20 +114,61 @@ route_event_(system& sys, event_traversal& traversal, routing_region* target)
         path_node.rest = traversal.path_to_target;
         path_node.node = target;
         traversal.path_to_target = &path_node;
-        route_event_(sys, traversal, target->parent.get());
+        route_event_(sys, traversal, target->parent.get(), tick_count);
     }
     else
     {
-        invoke_controller(sys, traversal);
+        invoke_controller(sys, traversal, tick_count);
     }
 }
 
 void
 route_event(system& sys, event_traversal& traversal, routing_region* target)
 {
+    scoped_trace_span span;
+    if (sys.tracer)
+    {
+        long long path_length = 0;
+        for (routing_region* i = target; i; i = i->parent.get())
+            ++path_length;
+        trace_args args;
+        args("event", traversal.event_type->name())(
+            "path_length", path_length);
+        span.begin(
+            *sys.tracer,
+            traversal.targeted ? "dispatch_targeted_event" : "dispatch_event",
+            "alia",
+            &args);
+    }
+
+    // When recording or replaying, the tick count is managed by the recording
+    // system.
+    struct scoped_recorded_dispatch
+    {
+        system* sys = nullptr;
+        ~scoped_recorded_dispatch()
+        {
+            if (sys)
+                end_recorded_dispatch(*sys);
+        }
+    } recorded_dispatch;
+    // (Recordings only have millisecond resolution.)
+    microsecond_count tick_count;
+    if (sys.recorder || sys.replayer)
+    {
+        tick_count = microsecond_count(
+                         begin_recorded_dispatch(sys, traversal, target))
+                     * 1000;
+        recorded_dispatch.sys = &sys;
+    }
+    else
+    {
+        tick_count = get_precise_tick_count(sys);
+    }
+
     try
     {
-        route_event_(sys, traversal, target);
+        route_event_(sys, traversal, target, tick_count);
     }
     catch (traversal_aborted&)
     {
@@ -34,6 +34,9 @@ typedef std::shared_ptr<routing_region> routing_region_ptr;
 struct routing_region
 {
     routing_region_ptr parent;
+    // a serial number that identifies the region within a recording (or 0)
+    // (See recording.hpp.)
+    counter_type serial = 0;
 };
 
 struct event_routing_path
@@ -8,36 +8,6 @@
 
 namespace alia {
 
-// is_map_like<Container>::value yields a compile-time boolean indicating
-// whether or not Container behaves like a map for the purposes of alia
-// iteration and indexing. (This is determined by checking whether or not
-// Container has both a key_type and a mapped_type member.)
-template<class T, class = void_t<>>
-struct is_map_like : std::false_type
-{
-};
-template<class T>
-struct is_map_like<T, void_t<typename T::key_type, typename T::mapped_type>>
-    : std::true_type
-{
-};
-
-// is_vector_like<Container>::value yields a compile-time boolean indicating
-// whether or not Container behaves like a vector for the purposes of alia
-// iteration and indexing. (This is determined by checking whether or not
-// Container can be subscripted with a size_t. This is sufficient because the
-// main purpose is to distinguish vector-like containers from list-like ones.)
-template<class Container, class = void_t<>>
-struct is_vector_like : std::false_type
-{
-};
-template<class Container>
-struct is_vector_like<
-    Container,
-    void_t<decltype(std::declval<Container>()[size_t(0)])>> : std::true_type
-{
-};
-
 template<class Item>
 auto
 get_alia_id(Item const&)
@@ -45,6 +15,33 @@ get_alia_id(Item const&)
     return null_id;
 }
 
+// get_map_item_block_id(container, item) gets the ID that identifies the
+// block for :item when iterating over the map-like :container (assuming the
+// item doesn't supply its own ID).
+// By default, this is the address of the item, which is stable for node-based
+// maps. However, containers that identify their own items (like
+// persistent_map) replace an entry when it's modified, so the key is used
+// instead.
+template<class Container, class Item>
+std::enable_if_t<
+    !has_item_identity<Container, typename Container::key_type>::value,
+    simple_id<Item const*>>
+get_map_item_block_id(Container const&, Item const& item)
+{
+    return make_id(&item);
+}
+template<class Container, class Item>
+std::enable_if_t<
+    has_item_identity<Container, typename Container::key_type>::value,
+    simple_id_by_reference<typename Container::key_type>>
+get_map_item_block_id(Container const&, Item const& item)
+{
+    return make_id_by_reference(item.first);
+}
+
+// Each instantiation of for_each (and thus, in practice, each call site, since
+// the function is usually a lambda) gets its own profiling site for its items.
+
 // for_each for map-like containers
 template<
     class Context,
@@ -56,6 +53,7 @@ template<
 void
 for_each(Context ctx, ContainerSignal const& container_signal, Fn&& fn)
 {
+    ALIA_DEFINE_PROFILING_SITE(for_each_site, "for_each")
     ALIA_IF(has_value(container_signal))
     {
         naming_context nc(ctx);
@@ -65,9 +63,18 @@ for_each(Context ctx, ContainerSignal const& container_signal, Fn&& fn)
             named_block nb;
             auto iteration_id = get_alia_id(item.first);
             if (iteration_id != null_id)
-                nb.begin(nc, iteration_id);
+            {
+                nb.begin(
+                    nc, iteration_id, manual_delete(false), &for_each_site);
+            }
             else
-                nb.begin(nc, make_id(&item));
+            {
+                nb.begin(
+                    nc,
+                    get_map_item_block_id(container, item),
+                    manual_delete(false),
+                    &for_each_site);
+            }
             auto key = direct(item.first);
             auto value = container_signal[key];
             fn(ctx, key, value);
@@ -88,6 +95,7 @@ template<
 void
 for_each(Context ctx, ContainerSignal const& container_signal, Fn&& fn)
 {
+    ALIA_DEFINE_PROFILING_SITE(for_each_site, "for_each")
     ALIA_IF(has_value(container_signal))
     {
         naming_context nc(ctx);
@@ -98,9 +106,15 @@ for_each(Context ctx, ContainerSignal const& container_signal, Fn&& fn)
             named_block nb;
             auto iteration_id = get_alia_id(container[index]);
             if (iteration_id != null_id)
-                nb.begin(nc, iteration_id);
+            {
+                nb.begin(
+                    nc, iteration_id, manual_delete(false), &for_each_site);
+            }
             else
-                nb.begin(nc, make_id(index));
+            {
+                nb.begin(
+                    nc, make_id(index), manual_delete(false), &for_each_site);
+            }
             fn(ctx, container_signal[value(index)]);
         }
     }
@@ -144,6 +158,11 @@ struct list_item_signal : signal<
     {
         *item_ = value;
     }
+    void
+    write(Item&& value) const
+    {
+        *item_ = std::move(value);
+    }
 
  private:
     ListSignal list_signal_;
@@ -171,6 +190,7 @@ template<
 void
 for_each(Context ctx, ContainerSignal const& container_signal, Fn&& fn)
 {
+    ALIA_DEFINE_PROFILING_SITE(for_each_site, "for_each")
     ALIA_IF(has_value(container_signal))
     {
         naming_context nc(ctx);
@@ -181,9 +201,15 @@ for_each(Context ctx, ContainerSignal const& container_signal, Fn&& fn)
             named_block nb;
             auto iteration_id = get_alia_id(item);
             if (iteration_id != null_id)
-                nb.begin(nc, iteration_id);
+            {
+                nb.begin(
+                    nc, iteration_id, manual_delete(false), &for_each_site);
+            }
             else
-                nb.begin(nc, make_id(&item));
+            {
+                nb.begin(
+                    nc, make_id(&item), manual_delete(false), &for_each_site);
+            }
             fn(ctx, make_list_item_signal(container_signal, index, &item));
             ++index;
         }
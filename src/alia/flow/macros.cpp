@@ -2,21 +2,26 @@
 
 namespace alia {
 
-if_block::if_block(data_traversal& traversal, bool condition)
+if_block::if_block(
+    data_traversal& traversal, bool condition, profiling_site const* site)
 {
     data_block& block = get_data<data_block>(traversal);
     if (condition)
     {
+        if (site)
+            profiling_region_.begin(traversal, *site);
         scoped_data_block_.begin(traversal, block);
     }
-    else if (traversal.cache_clearing_enabled)
+    else
     {
-        clear_cached_data(block);
+        clear_inactive_cached_data(traversal, block);
     }
 }
 
-loop_block::loop_block(data_traversal& traversal)
+loop_block::loop_block(data_traversal& traversal, profiling_site const* site)
 {
+    if (site)
+        profiling_region_.begin(traversal, *site);
     traversal_ = &traversal;
     get_data(traversal, &block_);
 }
@@ -8,11 +8,18 @@ namespace alia {
 // The following are utilities that are used to implement the control flow
 // macros. They shouldn't be used directly by applications.
 
+// If a profiling site is provided to an if_block, loop_block or switch case,
+// the time spent within the block is attributed to that site when profiling.
+
 struct if_block : noncopyable
 {
-    if_block(data_traversal& traversal, bool condition);
+    if_block(
+        data_traversal& traversal,
+        bool condition,
+        profiling_site const* site = nullptr);
 
  private:
+    scoped_profiling_region profiling_region_;
     scoped_data_block scoped_data_block_;
 };
 
@@ -25,10 +32,10 @@ struct switch_block : noncopyable
     }
     template<class Id>
     void
-    activate_case(Id id)
+    activate_case(Id id, profiling_site const* site = nullptr)
     {
         active_case_.end();
-        active_case_.begin(nc_, make_id(id), manual_delete(true));
+        active_case_.begin(nc_, make_id(id), manual_delete(true), site);
     }
 
  private:
@@ -38,7 +45,7 @@ struct switch_block : noncopyable
 
 struct loop_block : noncopyable
 {
-    loop_block(data_traversal& traversal);
+    loop_block(data_traversal& traversal, profiling_site const* site = nullptr);
     ~loop_block();
     data_block&
     block() const
@@ -54,6 +61,7 @@ struct loop_block : noncopyable
     next();
 
  private:
+    scoped_profiling_region profiling_region_;
     data_traversal* traversal_;
     data_block* block_;
 };
@@ -147,6 +155,12 @@ read_condition(T const& x)
 #define ALIA_UNDISABLE_MACRO_WARNINGS
 #endif
 
+// Each of the macros below that introduces a block declares a static
+// profiling_site for itself, so that profilers can attribute time to the
+// location of the macro invocation.
+#define ALIA_DEFINE_PROFILING_SITE(name, label)                                \
+    static ::alia::profiling_site const name = {label, __FILE__, __LINE__};
+
 // if, else_if, else
 
 #define ALIA_IF_(ctx, condition)                                               \
@@ -159,8 +173,11 @@ read_condition(T const& x)
                 = ::alia::condition_is_true(_alia_condition);                  \
             _alia_else_condition                                               \
                 = ::alia::condition_is_false(_alia_condition);                 \
+            ALIA_DEFINE_PROFILING_SITE(_alia_profiling_site, "if")             \
             ::alia::if_block _alia_if_block(                                   \
-                get_data_traversal(ctx), _alia_if_condition);                  \
+                get_data_traversal(ctx),                                       \
+                _alia_if_condition,                                            \
+                &_alia_profiling_site);                                        \
             if (_alia_if_condition)                                            \
             {                                                                  \
                 ALIA_UNDISABLE_MACRO_WARNINGS
@@ -178,8 +195,11 @@ read_condition(T const& x)
               && ::alia::condition_is_true(_alia_condition);                   \
         _alia_else_condition = _alia_else_condition                            \
                                && ::alia::condition_is_false(_alia_condition); \
+        ALIA_DEFINE_PROFILING_SITE(_alia_profiling_site, "else_if")            \
         ::alia::if_block _alia_if_block(                                       \
-            get_data_traversal(ctx), _alia_else_if_condition);                 \
+            get_data_traversal(ctx),                                           \
+            _alia_else_if_condition,                                           \
+            &_alia_profiling_site);                                            \
         if (_alia_else_if_condition)                                           \
         {                                                                      \
             ALIA_UNDISABLE_MACRO_WARNINGS
@@ -191,8 +211,11 @@ read_condition(T const& x)
     }                                                                          \
     }                                                                          \
     {                                                                          \
+        ALIA_DEFINE_PROFILING_SITE(_alia_profiling_site, "else")               \
         ::alia::if_block _alia_if_block(                                       \
-            get_data_traversal(ctx), _alia_else_condition);                    \
+            get_data_traversal(ctx),                                           \
+            _alia_else_condition,                                              \
+            &_alia_profiling_site);                                            \
         if (_alia_else_condition)                                              \
         {                                                                      \
             ALIA_UNDISABLE_MACRO_WARNINGS
@@ -227,16 +250,21 @@ read_condition(T const& x)
 #define ALIA_CONCATENATE(a, b) ALIA_CONCATENATE_HELPER(a, b)
 
 #define ALIA_CASE_(ctx, c)                                                     \
-    case c:                                                                    \
-        _alia_switch_block.activate_case(c);                                   \
+    case c: {                                                                  \
+        ALIA_DEFINE_PROFILING_SITE(_alia_profiling_site, "case")               \
+        _alia_switch_block.activate_case(c, &_alia_profiling_site);            \
+    }                                                                          \
         goto ALIA_CONCATENATE(_alia_dummy_label_, __LINE__);                   \
         ALIA_CONCATENATE(_alia_dummy_label_, __LINE__)
 
 #define ALIA_CASE(c) ALIA_CASE_(ctx, c)
 
 #define ALIA_DEFAULT_(ctx)                                                     \
-    default:                                                                   \
-        _alia_switch_block.activate_case("_alia_default_case");                \
+    default: {                                                                 \
+        ALIA_DEFINE_PROFILING_SITE(_alia_profiling_site, "default")            \
+        _alia_switch_block.activate_case(                                      \
+            "_alia_default_case", &_alia_profiling_site);                      \
+    }                                                                          \
         goto ALIA_CONCATENATE(_alia_dummy_label_, __LINE__);                   \
         ALIA_CONCATENATE(_alia_dummy_label_, __LINE__)
 
@@ -257,7 +285,9 @@ read_condition(T const& x)
     ALIA_DISABLE_MACRO_WARNINGS                                                \
     {                                                                          \
         {                                                                      \
-            ::alia::loop_block _alia_looper(get_data_traversal(ctx));          \
+            ALIA_DEFINE_PROFILING_SITE(_alia_profiling_site, "for")            \
+            ::alia::loop_block _alia_looper(                                   \
+                get_data_traversal(ctx), &_alia_profiling_site);               \
             for (x)                                                            \
             {                                                                  \
                 ::alia::scoped_data_block _alia_scope;                         \
@@ -279,7 +309,9 @@ read_condition(T const& x)
     ALIA_DISABLE_MACRO_WARNINGS                                                \
     {                                                                          \
         {                                                                      \
-            ::alia::loop_block _alia_looper(get_data_traversal(ctx));          \
+            ALIA_DEFINE_PROFILING_SITE(_alia_profiling_site, "while")          \
+            ::alia::loop_block _alia_looper(                                   \
+                get_data_traversal(ctx), &_alia_profiling_site);               \
             while (x)                                                          \
             {                                                                  \
                 ::alia::scoped_data_block _alia_scope;                         \
@@ -0,0 +1,239 @@
+#include <alia/flow/profiling.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <string>
+
+namespace alia {
+
+static profiling_site const frame_profiling_site = {"frame", nullptr, 0};
+
+static std::int64_t
+get_profiling_time()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+traversal_profiler::traversal_profiler()
+{
+    root.site = &frame_profiling_site;
+    root.parent = nullptr;
+}
+
+void
+reset_profiler(traversal_profiler& profiler)
+{
+    profiler.root.children.clear();
+    profiler.root.frame = profiling_totals();
+    profiler.root.cumulative = profiling_totals();
+    profiler.frame_count = 0;
+}
+
+static profiling_node&
+find_profiling_node_child(profiling_node& parent, profiling_site const& site)
+{
+    // Nodes tend to have few children, and the most recently added child is
+    // the most likely match (since it's usually the previous sibling), so
+    // search backwards.
+    for (auto i = parent.children.rbegin(); i != parent.children.rend(); ++i)
+    {
+        if ((*i)->site == &site)
+            return **i;
+    }
+    parent.children.emplace_back(new profiling_node);
+    profiling_node& child = *parent.children.back();
+    child.site = &site;
+    child.parent = &parent;
+    return child;
+}
+
+static void
+push_region(
+    traversal_profiler& profiler,
+    data_traversal& traversal,
+    profiling_node& node)
+{
+    profiler.active_node = &node;
+    traversal_profiler::region_start start;
+    start.data_request_count = traversal.data_request_count;
+    start.time = get_profiling_time();
+    profiler.region_stack.push_back(start);
+}
+
+static void
+pop_region(traversal_profiler& profiler, data_traversal& traversal)
+{
+    std::int64_t end_time = get_profiling_time();
+    traversal_profiler::region_start const& start
+        = profiler.region_stack.back();
+    profiling_node& node = *profiler.active_node;
+    ++node.frame.calls;
+    node.frame.inclusive_time += end_time - start.time;
+    node.frame.data_requests
+        += traversal.data_request_count - start.data_request_count;
+    profiler.region_stack.pop_back();
+    profiler.active_node = node.parent;
+}
+
+void
+begin_profiling_region(
+    traversal_profiler& profiler,
+    data_traversal& traversal,
+    profiling_site const& site)
+{
+    push_region(
+        profiler,
+        traversal,
+        find_profiling_node_child(*profiler.active_node, site));
+}
+
+void
+end_profiling_region(traversal_profiler& profiler, data_traversal& traversal)
+{
+    pop_region(profiler, traversal);
+}
+
+static void
+clear_frame_totals(profiling_node& node)
+{
+    node.frame = profiling_totals();
+    for (auto& child : node.children)
+        clear_frame_totals(*child);
+}
+
+static void
+accumulate_frame_totals(profiling_node& node)
+{
+    node.cumulative.calls += node.frame.calls;
+    node.cumulative.inclusive_time += node.frame.inclusive_time;
+    node.cumulative.data_requests += node.frame.data_requests;
+    for (auto& child : node.children)
+        accumulate_frame_totals(*child);
+}
+
+void
+scoped_profiling_frame::begin(
+    traversal_profiler& profiler, data_traversal& traversal)
+{
+    profiler_ = &profiler;
+    traversal_ = &traversal;
+    clear_frame_totals(profiler.root);
+    profiler.region_stack.clear();
+    traversal.profiler = &profiler;
+    push_region(profiler, traversal, profiler.root);
+}
+
+void
+scoped_profiling_frame::end()
+{
+    if (profiler_)
+    {
+        // If the traversal was interrupted by an exception, there may still
+        // be regions open, so close those first.
+        while (!profiler_->region_stack.empty())
+            pop_region(*profiler_, *traversal_);
+        accumulate_frame_totals(profiler_->root);
+        ++profiler_->frame_count;
+        traversal_->profiler = nullptr;
+        profiler_ = nullptr;
+    }
+}
+
+static void
+summarize_node(
+    std::map<profiling_site const*, profiling_site_summary>& summaries,
+    profiling_node const& node)
+{
+    if (node.frame.calls == 0)
+        return;
+    profiling_site_summary& summary = summaries[node.site];
+    summary.site = node.site;
+    summary.calls += node.frame.calls;
+    summary.inclusive_time += node.frame.inclusive_time;
+    summary.inclusive_data_requests += node.frame.data_requests;
+    std::int64_t exclusive_time = node.frame.inclusive_time;
+    counter_type exclusive_data_requests = node.frame.data_requests;
+    for (auto const& child : node.children)
+    {
+        exclusive_time -= child->frame.inclusive_time;
+        exclusive_data_requests -= child->frame.data_requests;
+        summarize_node(summaries, *child);
+    }
+    summary.exclusive_time += exclusive_time;
+    summary.exclusive_data_requests += exclusive_data_requests;
+}
+
+std::vector<profiling_site_summary>
+summarize_frame(traversal_profiler const& profiler)
+{
+    std::map<profiling_site const*, profiling_site_summary> summaries;
+    summarize_node(summaries, profiler.root);
+    std::vector<profiling_site_summary> sorted;
+    for (auto const& entry : summaries)
+        sorted.push_back(entry.second);
+    std::sort(
+        sorted.begin(),
+        sorted.end(),
+        [](profiling_site_summary const& a, profiling_site_summary const& b) {
+            return a.exclusive_time > b.exclusive_time;
+        });
+    return sorted;
+}
+
+static std::string
+get_site_name(profiling_site const& site)
+{
+    std::string name = site.label;
+    if (site.file)
+    {
+        name += '@';
+        name += site.file;
+        name += ':';
+        name += std::to_string(site.line);
+    }
+    return name;
+}
+
+void
+write_frame_summary(std::ostream& out, traversal_profiler const& profiler)
+{
+    out << "frame " << profiler.frame_count << ": "
+        << double(profiler.root.frame.inclusive_time) / 1e6 << " ms, "
+        << profiler.root.frame.data_requests << " get_data calls\n";
+    for (auto const& summary : summarize_frame(profiler))
+    {
+        out << "  " << get_site_name(*summary.site) << ": " << summary.calls
+            << " calls, " << double(summary.inclusive_time) / 1e6
+            << " ms inclusive, " << double(summary.exclusive_time) / 1e6
+            << " ms exclusive, " << summary.inclusive_data_requests
+            << " get_data calls inclusive, "
+            << summary.exclusive_data_requests << " exclusive\n";
+    }
+}
+
+static void
+write_folded_node(
+    std::ostream& out, std::string const& prefix, profiling_node const& node)
+{
+    if (node.cumulative.calls == 0)
+        return;
+    std::string path = prefix.empty() ? get_site_name(*node.site)
+                                      : prefix + ";" + get_site_name(*node.site);
+    std::int64_t exclusive_time = node.cumulative.inclusive_time;
+    for (auto const& child : node.children)
+        exclusive_time -= child->cumulative.inclusive_time;
+    out << path << " " << exclusive_time / 1000 << "\n";
+    for (auto const& child : node.children)
+        write_folded_node(out, path, *child);
+}
+
+void
+write_folded_stacks(std::ostream& out, traversal_profiler const& profiler)
+{
+    write_folded_node(out, std::string(), profiler.root);
+}
+
+} // namespace alia
@@ -0,0 +1,139 @@
+#ifndef ALIA_FLOW_PROFILING_HPP
+#define ALIA_FLOW_PROFILING_HPP
+
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <vector>
+
+#include <alia/flow/data_graph.hpp>
+
+// This file provides an opt-in profiler for traversals of the data graph.
+//
+// When a profiler is attached to a traversal, the time spent within each
+// profiled block (ALIA_IF, ALIA_FOR, ALIA_CASE, for_each items, etc.) is
+// recorded, along with the number of get_data calls made within it. Blocks are
+// attributed to the static location in the code where they're declared, and
+// the profiler builds a call tree of these sites, so the same site reached via
+// different paths is recorded separately.
+//
+// named_blocks and scoped_data_blocks that are used directly are only profiled
+// if they're given a profiling_site. (Otherwise, their time is attributed to
+// the enclosing site.)
+//
+// The usual way to use this is to attach a profiler to an alia::system (via
+// system::profiler). Each refresh pass is then profiled as a single frame.
+// After a frame, summarize_frame() or write_frame_summary() can be used to
+// inspect the most recent frame, and write_folded_stacks() writes the
+// cumulative profile in the 'folded stacks' format used by flame graph tools.
+
+namespace alia {
+
+// profiling_totals records the totals for one node of the call tree.
+struct profiling_totals
+{
+    // the number of times the region was entered
+    counter_type calls = 0;
+    // the total time spent in the region (including its children), in
+    // nanoseconds
+    std::int64_t inclusive_time = 0;
+    // the number of get_data calls made within the region (including its
+    // children)
+    counter_type data_requests = 0;
+};
+
+struct profiling_node : noncopyable
+{
+    profiling_site const* site;
+    profiling_node* parent;
+    std::vector<std::unique_ptr<profiling_node>> children;
+    // the totals for the most recent frame
+    profiling_totals frame;
+    // the totals across all frames since the profiler was last reset
+    profiling_totals cumulative;
+};
+
+struct traversal_profiler : noncopyable
+{
+    traversal_profiler();
+
+    // the root of the call tree, which represents the entire frame
+    profiling_node root;
+
+    // the number of frames recorded since the profiler was last reset
+    counter_type frame_count = 0;
+
+    // the state of the frame that's currently being recorded (if any)
+    profiling_node* active_node = nullptr;
+    struct region_start
+    {
+        std::int64_t time;
+        counter_type data_request_count;
+    };
+    std::vector<region_start> region_stack;
+};
+
+// Clear all the data recorded by a profiler.
+void
+reset_profiler(traversal_profiler& profiler);
+
+// scoped_profiling_frame profiles a traversal as a single frame.
+// The traversal must already be initialized (via scoped_data_traversal).
+struct scoped_profiling_frame : noncopyable
+{
+    scoped_profiling_frame()
+    {
+    }
+    scoped_profiling_frame(
+        traversal_profiler& profiler, data_traversal& traversal)
+    {
+        begin(profiler, traversal);
+    }
+    ~scoped_profiling_frame()
+    {
+        end();
+    }
+
+    void
+    begin(traversal_profiler& profiler, data_traversal& traversal);
+
+    void
+    end();
+
+ private:
+    traversal_profiler* profiler_ = nullptr;
+    data_traversal* traversal_;
+};
+
+// profiling_site_summary summarizes the time spent at a single site in a
+// frame, merged across all the paths by which it was reached.
+// Note that if a site is nested within itself (e.g., via recursion), its
+// inclusive figures will count the nested time more than once.
+struct profiling_site_summary
+{
+    profiling_site const* site;
+    counter_type calls = 0;
+    std::int64_t inclusive_time = 0;
+    std::int64_t exclusive_time = 0;
+    counter_type inclusive_data_requests = 0;
+    counter_type exclusive_data_requests = 0;
+};
+
+// Summarize the most recent frame recorded by a profiler.
+// The summaries are sorted by exclusive time, highest first.
+std::vector<profiling_site_summary>
+summarize_frame(traversal_profiler const& profiler);
+
+// Write a human-readable summary of the most recent frame to a stream.
+void
+write_frame_summary(std::ostream& out, traversal_profiler const& profiler);
+
+// Write the cumulative profile in the folded stacks format. Each line lists
+// a path through the call tree (with sites separated by semicolons) and the
+// exclusive time spent on that path, in microseconds.
+void
+write_folded_stacks(std::ostream& out, traversal_profiler const& profiler);
+
+} // namespace alia
+
+#endif
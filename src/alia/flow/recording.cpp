@@ -0,0 +1,558 @@
+#include <alia/flow/recording.hpp>
+
+#include <cstring>
+#include <iterator>
+
+namespace alia {
+
+namespace {
+
+char const recording_magic[8] = {'A', 'L', 'I', 'A', 'R', 'E', 'C', '\1'};
+
+enum recording_record_kind : unsigned char
+{
+    // the definition of an event type index: index, name
+    DEFINE_EVENT_TYPE = 1,
+    // a dispatch: depth, tick, type index (or 0 for refreshes), target serial
+    // (or 0), payload size, payload
+    RECORDED_DISPATCH = 2,
+    // a dispatch that couldn't be recorded: depth, tick, type name
+    UNRECORDED_DISPATCH = 3,
+    // the result of an async operation: depth, serial, has_result, payload
+    // size, payload
+    ASYNC_RESULT = 4
+};
+
+// the nesting depth of recorded dispatches on the current thread
+thread_local int recorded_dispatch_depth = 0;
+
+// the nesting depth of live activity while replaying (on the current thread)
+thread_local int live_replay_activity_depth = 0;
+
+} // namespace
+
+void
+write_varint(recording_writer& writer, std::uint64_t value)
+{
+    while (value >= 0x80)
+    {
+        writer.bytes.push_back(char((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+    writer.bytes.push_back(char(value));
+}
+
+void
+write_bytes(recording_writer& writer, void const* data, size_t size)
+{
+    writer.bytes.append(static_cast<char const*>(data), size);
+}
+
+static void
+check_recording_bytes(recording_reader& reader, size_t size)
+{
+    if (size_t(reader.end - reader.position) < size)
+        throw replay_error("unexpected end of recording");
+}
+
+std::uint64_t
+read_varint(recording_reader& reader)
+{
+    std::uint64_t value = 0;
+    for (int shift = 0; shift < 64; shift += 7)
+    {
+        check_recording_bytes(reader, 1);
+        unsigned char byte = static_cast<unsigned char>(*reader.position++);
+        value |= std::uint64_t(byte & 0x7f) << shift;
+        if (!(byte & 0x80))
+            return value;
+    }
+    throw replay_error("malformed integer in recording");
+}
+
+void
+read_bytes(recording_reader& reader, void* data, size_t size)
+{
+    check_recording_bytes(reader, size);
+    std::memcpy(data, reader.position, size);
+    reader.position += size;
+}
+
+static recording_reader
+read_payload(recording_reader& reader)
+{
+    size_t size = size_t(read_varint(reader));
+    check_recording_bytes(reader, size);
+    recording_reader payload;
+    payload.position = reader.position;
+    payload.end = reader.position + size;
+    reader.position += size;
+    return payload;
+}
+
+// RECORDING
+
+event_recorder::event_recorder(
+    std::ostream& out, event_recording_registry const& registry)
+    : out(&out),
+      registry(&registry),
+      defined_types(registry.types.size(), false)
+{
+    out.write(recording_magic, sizeof(recording_magic));
+}
+
+static void
+write_record(event_recorder& recorder, recording_writer const& writer)
+{
+    recorder.out->write(
+        writer.bytes.data(), std::streamsize(writer.bytes.size()));
+}
+
+static recorded_event_type const*
+find_recorded_event_type(
+    event_recorder& recorder, std::type_info const& type, size_t* index)
+{
+    auto const& types = recorder.registry->types;
+    for (size_t i = 0; i != types.size(); ++i)
+    {
+        if (*types[i].type == type)
+        {
+            *index = i;
+            return &types[i];
+        }
+    }
+    return nullptr;
+}
+
+static void
+record_dispatch(
+    event_recorder& recorder,
+    event_traversal const& traversal,
+    routing_region* target,
+    millisecond_count tick)
+{
+    std::lock_guard<std::mutex> lock(recorder.mutex);
+    recording_writer writer;
+
+    bool is_refresh = *traversal.event_type == typeid(refresh_event);
+    size_t index = 0;
+    recorded_event_type const* type
+        = is_refresh ? nullptr
+                     : find_recorded_event_type(
+                         recorder, *traversal.event_type, &index);
+
+    // Events can't be recorded if their type isn't registered or if they're
+    // targeted at a region that we can't identify.
+    if ((!is_refresh && !type) || (target && target->serial == 0))
+    {
+        writer.bytes.push_back(char(UNRECORDED_DISPATCH));
+        write_varint(writer, std::uint64_t(recorded_dispatch_depth));
+        write_varint(writer, tick);
+        recording_codec<std::string>::write(
+            writer, traversal.event_type->name());
+        write_record(recorder, writer);
+        ++recorder.unrecorded_event_count;
+        return;
+    }
+
+    if (type && !recorder.defined_types[index])
+    {
+        writer.bytes.push_back(char(DEFINE_EVENT_TYPE));
+        write_varint(writer, index);
+        recording_codec<std::string>::write(writer, type->name);
+        recorder.defined_types[index] = true;
+    }
+
+    writer.bytes.push_back(char(RECORDED_DISPATCH));
+    write_varint(writer, std::uint64_t(recorded_dispatch_depth));
+    write_varint(writer, tick);
+    write_varint(writer, type ? index + 1 : 0);
+    write_varint(writer, target ? target->serial : 0);
+    if (type)
+    {
+        recording_writer payload;
+        type->encode(traversal.event, payload);
+        write_varint(writer, payload.bytes.size());
+        writer.bytes += payload.bytes;
+    }
+    else
+    {
+        write_varint(writer, 0);
+    }
+    write_record(recorder, writer);
+}
+
+// REPLAYING
+
+event_replayer::event_replayer(
+    std::istream& in, event_recording_registry const& registry)
+    : log(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()),
+      registry(&registry)
+{
+    reader.position = log.data();
+    reader.end = log.data() + log.size();
+    char magic[sizeof(recording_magic)];
+    read_bytes(reader, magic, sizeof(magic));
+    if (std::memcmp(magic, recording_magic, sizeof(magic)) != 0)
+        throw replay_error("not an alia recording");
+}
+
+static void
+read_event_type_definition(event_replayer& replayer)
+{
+    size_t index = size_t(read_varint(replayer.reader));
+    std::string name = recording_codec<std::string>::read(replayer.reader);
+    if (index >= replayer.types.size())
+        replayer.types.resize(index + 1, nullptr);
+    for (auto const& type : replayer.registry->types)
+    {
+        if (type.name == name)
+            replayer.types[index] = &type;
+    }
+}
+
+// Read the kind of the next record, processing any type definitions along the
+// way. Returns false if the end of the log has been reached.
+static bool
+read_record_kind(event_replayer& replayer, recording_record_kind* kind)
+{
+    while (replayer.reader.position != replayer.reader.end)
+    {
+        *kind = recording_record_kind(*replayer.reader.position++);
+        if (*kind != DEFINE_EVENT_TYPE)
+            return true;
+        read_event_type_definition(replayer);
+    }
+    return false;
+}
+
+// Skip the body of a record of the given kind (after its depth).
+static void
+skip_record_body(event_replayer& replayer, recording_record_kind kind)
+{
+    switch (kind)
+    {
+        case RECORDED_DISPATCH:
+            // tick, type, target, payload
+            read_varint(replayer.reader);
+            read_varint(replayer.reader);
+            read_varint(replayer.reader);
+            read_payload(replayer.reader);
+            break;
+        case UNRECORDED_DISPATCH:
+            // tick, type name
+            read_varint(replayer.reader);
+            recording_codec<std::string>::read(replayer.reader);
+            break;
+        case ASYNC_RESULT:
+            // serial, has_result, payload
+            read_varint(replayer.reader);
+            read_varint(replayer.reader);
+            read_payload(replayer.reader);
+            break;
+        default:
+            throw replay_error("malformed recording");
+    }
+}
+
+// Skip any records that are nested deeper than :depth.
+static void
+skip_nested_records(event_replayer& replayer, std::uint64_t depth)
+{
+    while (true)
+    {
+        recording_reader saved = replayer.reader;
+        recording_record_kind kind;
+        if (!read_record_kind(replayer, &kind)
+            || read_varint(replayer.reader) <= depth)
+        {
+            replayer.reader = saved;
+            return;
+        }
+        skip_record_body(replayer, kind);
+    }
+}
+
+static void
+deliver_async_result(event_replayer& replayer)
+{
+    std::uint64_t depth = read_varint(replayer.reader);
+    counter_type serial = counter_type(read_varint(replayer.reader));
+    bool has_result = read_varint(replayer.reader) != 0;
+    recording_reader payload = read_payload(replayer.reader);
+    auto operation = replayer.async_operations.find(serial);
+    if (has_result && operation != replayer.async_operations.end())
+    {
+        auto deliver = std::move(operation->second);
+        replayer.async_operations.erase(operation);
+        deliver(payload);
+        return;
+    }
+    // The result can't be delivered, so anything that it triggered in the
+    // original system is skipped as well.
+    // (Results without a value come from operations that were launched live,
+    // so that's expected.)
+    if (has_result)
+        ++replayer.skipped_record_count;
+    skip_nested_records(replayer, depth);
+}
+
+static routing_region_ptr
+find_replayed_routing_region(event_replayer& replayer, counter_type serial)
+{
+    auto region = replayer.routing_regions.find(serial);
+    if (region == replayer.routing_regions.end())
+        return routing_region_ptr();
+    return region->second.lock();
+}
+
+bool
+replay_next_record(system& sys, event_replayer& replayer)
+{
+    recording_record_kind kind;
+    if (!read_record_kind(replayer, &kind))
+        return false;
+    switch (kind)
+    {
+        case RECORDED_DISPATCH: {
+            if (read_varint(replayer.reader) != 0)
+                throw replay_error("replay diverged: unexpected nested event");
+            millisecond_count tick
+                = millisecond_count(read_varint(replayer.reader));
+            size_t type_index = size_t(read_varint(replayer.reader));
+            counter_type target_serial
+                = counter_type(read_varint(replayer.reader));
+            recording_reader payload = read_payload(replayer.reader);
+
+            recorded_event_type const* type = nullptr;
+            routing_region_ptr target;
+            if (type_index != 0)
+            {
+                type = type_index <= replayer.types.size()
+                           ? replayer.types[type_index - 1]
+                           : nullptr;
+                if (target_serial != 0)
+                    target = find_replayed_routing_region(
+                        replayer, target_serial);
+                if (!type || (target_serial != 0 && !target))
+                {
+                    ++replayer.skipped_record_count;
+                    return true;
+                }
+            }
+
+            replayer.has_pending_tick = true;
+            replayer.pending_tick = tick;
+            try
+            {
+                if (type)
+                    type->dispatch(sys, payload, target);
+                else
+                    refresh_system(sys);
+            }
+            catch (...)
+            {
+                replayer.has_pending_tick = false;
+                throw;
+            }
+            replayer.has_pending_tick = false;
+            return true;
+        }
+        case UNRECORDED_DISPATCH:
+            read_varint(replayer.reader);
+            read_varint(replayer.reader);
+            recording_codec<std::string>::read(replayer.reader);
+            ++replayer.skipped_record_count;
+            return true;
+        case ASYNC_RESULT:
+            deliver_async_result(replayer);
+            return true;
+        default:
+            throw replay_error("malformed recording");
+    }
+}
+
+void
+replay_all_records(system& sys, event_replayer& replayer)
+{
+    while (replay_next_record(sys, replayer))
+        ;
+}
+
+// Get the tick count for a dispatch while replaying.
+static millisecond_count
+take_replayed_tick(event_replayer& replayer)
+{
+    if (replayer.has_pending_tick)
+    {
+        // This is the dispatch that the replayer itself initiated.
+        replayer.has_pending_tick = false;
+        return replayer.pending_tick;
+    }
+
+    // Live activity doesn't appear in the log, so it just happens at the most
+    // recent tick.
+    if (live_replay_activity_depth != 0)
+        return replayer.last_tick;
+
+    // Otherwise, this is a dispatch that's nested within another one (e.g.,
+    // a refresh triggered by an async result), so it should be the next
+    // record in the log.
+    recording_record_kind kind;
+    if (!read_record_kind(replayer, &kind)
+        || (kind != RECORDED_DISPATCH && kind != UNRECORDED_DISPATCH)
+        || read_varint(replayer.reader) == 0)
+    {
+        throw replay_error("replay diverged: unexpected event");
+    }
+    millisecond_count tick = millisecond_count(read_varint(replayer.reader));
+    if (kind == RECORDED_DISPATCH)
+    {
+        // type and target
+        read_varint(replayer.reader);
+        read_varint(replayer.reader);
+        read_payload(replayer.reader);
+    }
+    else
+    {
+        recording_codec<std::string>::read(replayer.reader);
+    }
+    return tick;
+}
+
+namespace impl {
+
+millisecond_count
+begin_recorded_dispatch(
+    system& sys, event_traversal const& traversal, routing_region* target)
+{
+    millisecond_count tick;
+    if (sys.replayer)
+    {
+        tick = take_replayed_tick(*sys.replayer);
+        sys.replayer->last_tick = tick;
+    }
+    else
+        tick = millisecond_count(get_precise_tick_count(sys) / 1000);
+    if (sys.recorder)
+        record_dispatch(*sys.recorder, traversal, target, tick);
+    ++recorded_dispatch_depth;
+    return tick;
+}
+
+void
+end_recorded_dispatch(system&)
+{
+    --recorded_dispatch_depth;
+}
+
+scoped_nested_recording::scoped_nested_recording(bool active)
+    : active_(active)
+{
+    if (active_)
+        ++recorded_dispatch_depth;
+}
+
+scoped_nested_recording::~scoped_nested_recording()
+{
+    if (active_)
+        --recorded_dispatch_depth;
+}
+
+scoped_live_replay_activity::scoped_live_replay_activity()
+{
+    ++live_replay_activity_depth;
+}
+
+scoped_live_replay_activity::~scoped_live_replay_activity()
+{
+    --live_replay_activity_depth;
+}
+
+void
+register_routing_region(system& sys, routing_region_ptr const& region)
+{
+    if (sys.replayer)
+    {
+        event_replayer& replayer = *sys.replayer;
+        region->serial = ++replayer.routing_region_count;
+        // Prune the map of expired regions whenever it doubles in size.
+        if (replayer.routing_regions.size() >= 64
+            && (replayer.routing_regions.size()
+                & (replayer.routing_regions.size() - 1))
+                   == 0)
+        {
+            for (auto i = replayer.routing_regions.begin();
+                 i != replayer.routing_regions.end();)
+            {
+                if (i->second.expired())
+                    i = replayer.routing_regions.erase(i);
+                else
+                    ++i;
+            }
+        }
+        replayer.routing_regions[region->serial] = region;
+    }
+    else if (sys.recorder)
+    {
+        std::lock_guard<std::mutex> lock(sys.recorder->mutex);
+        region->serial = ++sys.recorder->routing_region_count;
+    }
+}
+
+void
+record_async_result(
+    event_recorder& recorder,
+    counter_type serial,
+    bool has_result,
+    recording_writer const& result)
+{
+    std::lock_guard<std::mutex> lock(recorder.mutex);
+    recording_writer writer;
+    writer.bytes.push_back(char(ASYNC_RESULT));
+    write_varint(writer, std::uint64_t(recorded_dispatch_depth));
+    write_varint(writer, serial);
+    write_varint(writer, has_result ? 1 : 0);
+    write_varint(writer, result.bytes.size());
+    writer.bytes += result.bytes;
+    write_record(recorder, writer);
+}
+
+counter_type
+get_recorded_async_serial(event_recorder& recorder)
+{
+    std::lock_guard<std::mutex> lock(recorder.mutex);
+    return ++recorder.async_operation_count;
+}
+
+counter_type
+register_replayed_async(
+    event_replayer& replayer,
+    std::function<void(recording_reader&)> const& deliver)
+{
+    counter_type serial = ++replayer.async_operation_count;
+    if (!deliver)
+        return serial;
+    replayer.async_operations[serial] = deliver;
+
+    // If the operation completed synchronously (while it was being launched),
+    // its result will be the next record in the log, so deliver that now.
+    recording_reader saved = replayer.reader;
+    recording_record_kind kind;
+    if (read_record_kind(replayer, &kind) && kind == ASYNC_RESULT)
+    {
+        recording_reader peek = replayer.reader;
+        if (read_varint(peek) != 0
+            && counter_type(read_varint(peek)) == serial)
+        {
+            deliver_async_result(replayer);
+            return serial;
+        }
+    }
+    replayer.reader = saved;
+    return serial;
+}
+
+} // namespace impl
+
+} // namespace alia
@@ -0,0 +1,339 @@
+#ifndef ALIA_FLOW_RECORDING_HPP
+#define ALIA_FLOW_RECORDING_HPP
+
+#include <cstdint>
+#include <functional>
+#include <istream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <alia/flow/events.hpp>
+#include <alia/system.hpp>
+
+// This file provides the ability to record the activity of an alia::system to
+// a compact binary log and later replay that log against a fresh system.
+//
+// A recording captures every event dispatched to the system (including
+// refreshes), the tick count that was in effect for each dispatch, and the
+// results of async() operations. When replaying, the tick counts come from the
+// log (so the system effectively runs on a virtual clock), async() operations
+// aren't actually launched (their recorded results are delivered instead), and
+// events are dispatched in their original order. As long as the controller
+// itself is deterministic, the replayed system goes through exactly the same
+// sequence of states as the original.
+//
+// In order to be recorded, an event type must be registered (with a name that
+// identifies it in the log) and must have a recording_codec. Codecs are
+// provided for trivially copyable types and std::string, and others can be
+// added by specializing recording_codec. (Note that trivially copyable events
+// that contain pointers shouldn't be registered, since the pointers won't be
+// meaningful when replayed.) Events of unregistered types are noted in the log
+// but can't be replayed.
+//
+// Similarly, async() results are only recorded if the result type has a
+// codec. Otherwise, the log only notes the completion, and the operation is
+// launched normally when replaying. Its live result (and anything that it
+// triggers) is then processed at the tick of the most recently replayed
+// dispatch, and the recorded completion (along with anything that was nested
+// within it) is skipped.
+//
+// A recording should be started with a fresh system, and the replaying system
+// must have the same controller. Events targeted at specific routing regions
+// can only be recorded if the region was created while the recording was
+// active.
+
+namespace alia {
+
+// recording_writer and recording_reader are used to encode values in the log.
+
+struct recording_writer
+{
+    std::string bytes;
+};
+
+void
+write_varint(recording_writer& writer, std::uint64_t value);
+
+void
+write_bytes(recording_writer& writer, void const* data, size_t size);
+
+struct recording_reader
+{
+    char const* position;
+    char const* end;
+};
+
+std::uint64_t
+read_varint(recording_reader& reader);
+
+void
+read_bytes(recording_reader& reader, void* data, size_t size);
+
+// This is thrown when a log is malformed or when the replaying system diverges
+// from the recorded one.
+struct replay_error : exception
+{
+    replay_error(std::string const& message) : exception(message)
+    {
+    }
+};
+
+// recording_codec<T> defines how values of type T are encoded in the log.
+// Specializations must provide the following:
+//
+//   static void write(recording_writer& writer, T const& value);
+//   static T read(recording_reader& reader);
+//
+template<class T, class = void>
+struct recording_codec
+{
+};
+
+template<class T>
+struct recording_codec<
+    T,
+    std::enable_if_t<std::is_trivially_copyable<T>::value>>
+{
+    static void
+    write(recording_writer& writer, T const& value)
+    {
+        write_bytes(writer, &value, sizeof(T));
+    }
+    static T
+    read(recording_reader& reader)
+    {
+        typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+        read_bytes(reader, &storage, sizeof(T));
+        return reinterpret_cast<T&>(storage);
+    }
+};
+
+template<>
+struct recording_codec<std::string>
+{
+    static void
+    write(recording_writer& writer, std::string const& value)
+    {
+        write_varint(writer, value.size());
+        write_bytes(writer, value.data(), value.size());
+    }
+    static std::string
+    read(recording_reader& reader)
+    {
+        std::string value(size_t(read_varint(reader)), '\0');
+        read_bytes(reader, &value[0], value.size());
+        return value;
+    }
+};
+
+template<class T, class = void_t<>>
+struct is_recordable : std::false_type
+{
+};
+template<class T>
+struct is_recordable<T, void_t<decltype(&recording_codec<T>::write)>>
+    : std::true_type
+{
+};
+
+// event_recording_registry lists the event types that can be recorded.
+// The same registry (or an equivalent one) must be used for replaying.
+
+struct recorded_event_type
+{
+    std::string name;
+    std::type_info const* type;
+    void (*encode)(void const* event, recording_writer& writer);
+    void (*dispatch)(
+        system& sys, recording_reader& reader, routing_region_ptr const& target);
+};
+
+struct event_recording_registry
+{
+    std::vector<recorded_event_type> types;
+};
+
+template<class Event>
+void
+encode_recorded_event(void const* event, recording_writer& writer)
+{
+    recording_codec<Event>::write(writer, *static_cast<Event const*>(event));
+}
+
+template<class Event>
+void
+dispatch_recorded_event(
+    system& sys, recording_reader& reader, routing_region_ptr const& target)
+{
+    Event event = recording_codec<Event>::read(reader);
+    if (target)
+        impl::dispatch_targeted_event(sys, event, target);
+    else
+        impl::dispatch_event(sys, event);
+}
+
+template<class Event>
+void
+register_recorded_event(event_recording_registry& registry, char const* name)
+{
+    static_assert(
+        is_recordable<Event>::value,
+        "recorded events must have a recording_codec");
+    recorded_event_type type;
+    type.name = name;
+    type.type = &typeid(Event);
+    type.encode = &encode_recorded_event<Event>;
+    type.dispatch = &dispatch_recorded_event<Event>;
+    registry.types.push_back(type);
+}
+
+// event_recorder records the activity of a system to a stream.
+// To use it, attach it to the system via system::recorder.
+// The stream must outlive the recorder.
+struct event_recorder : noncopyable
+{
+    event_recorder(std::ostream& out, event_recording_registry const& registry);
+
+    std::ostream* out;
+    event_recording_registry const* registry;
+    // Since async results can be reported from other threads, the recorder
+    // is protected by a mutex.
+    std::mutex mutex;
+    // which event types have been defined in the log so far
+    std::vector<bool> defined_types;
+    // the number of dispatches that involved unregistered event types
+    counter_type unrecorded_event_count = 0;
+    // These are used to assign serial numbers to routing regions and async
+    // operations so that they can be identified in the log.
+    counter_type routing_region_count = 0;
+    counter_type async_operation_count = 0;
+};
+
+// event_replayer replays a recorded log.
+// To use it, attach it to the system via system::replayer and call
+// replay_next_record or replay_all_records.
+struct event_replayer : noncopyable
+{
+    event_replayer(std::istream& in, event_recording_registry const& registry);
+
+    std::string log;
+    recording_reader reader;
+    event_recording_registry const* registry;
+    // the registered event types that correspond to each type index in the
+    // log (or null if the type isn't registered)
+    std::vector<recorded_event_type const*> types;
+    // the number of records that couldn't be replayed
+    counter_type skipped_record_count = 0;
+
+    // the tick count for the dispatch that's about to happen (if any)
+    bool has_pending_tick = false;
+    millisecond_count pending_tick;
+    // the tick count of the most recently replayed dispatch
+    millisecond_count last_tick = 0;
+
+    counter_type routing_region_count = 0;
+    std::map<counter_type, std::weak_ptr<routing_region>> routing_regions;
+
+    counter_type async_operation_count = 0;
+    std::map<counter_type, std::function<void(recording_reader&)>>
+        async_operations;
+};
+
+// Replay the next top-level record in the log.
+// Returns false if the end of the log has been reached.
+bool
+replay_next_record(system& sys, event_replayer& replayer);
+
+// Replay all remaining records in the log.
+void
+replay_all_records(system& sys, event_replayer& replayer);
+
+// The following are the hooks that alia uses to record and replay events.
+// They shouldn't be needed by applications.
+
+namespace impl {
+
+// Get the tick count to use for a dispatch to :sys (and record it).
+// This also records the dispatch itself.
+millisecond_count
+begin_recorded_dispatch(
+    system& sys, event_traversal const& traversal, routing_region* target);
+
+void
+end_recorded_dispatch(system& sys);
+
+// While this is active (on the current thread), any recorded events are
+// considered to be nested within the current record. This is used so that the
+// refresh that's triggered by an async result is recorded as part of the
+// result.
+struct scoped_nested_recording : noncopyable
+{
+    scoped_nested_recording(bool active);
+    ~scoped_nested_recording();
+
+ private:
+    bool active_;
+};
+
+// While this is active (on the current thread), dispatches to a replaying
+// system are considered live activity that doesn't correspond to anything in
+// the log. This is used for the results of async operations that are launched
+// normally while replaying.
+struct scoped_live_replay_activity : noncopyable
+{
+    scoped_live_replay_activity();
+    ~scoped_live_replay_activity();
+};
+
+// Assign a serial number to a newly created routing region.
+void
+register_routing_region(system& sys, routing_region_ptr const& region);
+
+// Record the result of an async operation.
+void
+record_async_result(
+    event_recorder& recorder,
+    counter_type serial,
+    bool has_result,
+    recording_writer const& result);
+
+// Register an async operation that's been launched while replaying.
+// :deliver is invoked with a reader for the recorded result when the
+// operation's completion is replayed.
+// Returns the operation's serial number.
+counter_type
+register_replayed_async(
+    event_replayer& replayer,
+    std::function<void(recording_reader&)> const& deliver);
+
+// Get the serial number for an async operation that's being recorded.
+counter_type
+get_recorded_async_serial(event_recorder& recorder);
+
+template<class Result>
+std::enable_if_t<is_recordable<Result>::value>
+record_async_result(
+    event_recorder& recorder, counter_type serial, Result const& result)
+{
+    recording_writer writer;
+    recording_codec<Result>::write(writer, result);
+    record_async_result(recorder, serial, true, writer);
+}
+
+template<class Result>
+std::enable_if_t<!is_recordable<Result>::value>
+record_async_result(event_recorder& recorder, counter_type serial, Result const&)
+{
+    record_async_result(recorder, serial, false, recording_writer());
+}
+
+} // namespace impl
+
+} // namespace alia
+
+#endif
@@ -0,0 +1,310 @@
+#include <alia/flow/snapshots.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <vector>
+
+namespace alia {
+
+static char const snapshot_magic[8] = {'A', 'L', 'I', 'A', 'S', 'N', 'P', '\1'};
+
+// the size of the header (magic and entry count) and of each table entry
+static size_t const snapshot_header_size = 16;
+static size_t const snapshot_entry_size = 24;
+
+static std::uint64_t
+load_snapshot_word(char const* p)
+{
+    unsigned char const* bytes = reinterpret_cast<unsigned char const*>(p);
+    std::uint64_t value = 0;
+    for (int i = 7; i >= 0; --i)
+        value = (value << 8) | bytes[i];
+    return value;
+}
+
+static void
+store_snapshot_word(std::ostream& out, std::uint64_t value)
+{
+    char bytes[8];
+    for (int i = 0; i != 8; ++i)
+        bytes[i] = char((value >> (i * 8)) & 0xff);
+    out.write(bytes, 8);
+}
+
+void
+open_data_snapshot(data_snapshot& snapshot, char const* data, size_t size)
+{
+    if (size < snapshot_header_size
+        || std::memcmp(data, snapshot_magic, sizeof(snapshot_magic)) != 0)
+    {
+        throw snapshot_error("not an alia snapshot");
+    }
+    std::uint64_t entry_count = load_snapshot_word(data + 8);
+    if (entry_count > (size - snapshot_header_size) / snapshot_entry_size)
+        throw snapshot_error("snapshot is truncated");
+    // Check that all entries are in bounds and in order, so that lookups
+    // don't need to.
+    size_t data_size
+        = size - snapshot_header_size - size_t(entry_count) * snapshot_entry_size;
+    char const* table = data + snapshot_header_size;
+    for (std::uint64_t i = 0; i != entry_count; ++i)
+    {
+        char const* entry = table + i * snapshot_entry_size;
+        std::uint64_t offset = load_snapshot_word(entry + 8);
+        std::uint64_t entry_size = load_snapshot_word(entry + 16);
+        if (offset > data_size || entry_size > data_size - offset)
+            throw snapshot_error("snapshot entry is out of bounds");
+        if (i != 0
+            && load_snapshot_word(entry - snapshot_entry_size)
+                   >= load_snapshot_word(entry))
+        {
+            throw snapshot_error("snapshot entries are out of order");
+        }
+    }
+    snapshot.data = data;
+    snapshot.size = size;
+    snapshot.entry_count = entry_count;
+}
+
+void
+read_data_snapshot(data_snapshot& snapshot, std::istream& in)
+{
+    snapshot.storage.assign(
+        std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    open_data_snapshot(
+        snapshot, snapshot.storage.data(), snapshot.storage.size());
+}
+
+static recording_reader
+get_snapshot_entry(data_snapshot const& snapshot, std::uint64_t index)
+{
+    char const* entry
+        = snapshot.data + snapshot_header_size + index * snapshot_entry_size;
+    char const* entry_data = snapshot.data + snapshot_header_size
+                             + snapshot.entry_count * snapshot_entry_size
+                             + load_snapshot_word(entry + 8);
+    recording_reader reader;
+    reader.position = entry_data;
+    reader.end = entry_data + load_snapshot_word(entry + 16);
+    return reader;
+}
+
+// Find the index of the entry for :address in :snapshot's table.
+static bool
+find_snapshot_entry_index(
+    data_snapshot const& snapshot,
+    std::uint64_t address,
+    std::uint64_t* index)
+{
+    char const* table = snapshot.data + snapshot_header_size;
+    std::uint64_t low = 0, high = snapshot.entry_count;
+    while (low < high)
+    {
+        std::uint64_t middle = low + (high - low) / 2;
+        std::uint64_t middle_address
+            = load_snapshot_word(table + middle * snapshot_entry_size);
+        if (middle_address < address)
+        {
+            low = middle + 1;
+        }
+        else if (address < middle_address)
+        {
+            high = middle;
+        }
+        else
+        {
+            *index = middle;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool
+find_snapshot_entry(
+    data_snapshot const& snapshot,
+    std::uint64_t address,
+    recording_reader* entry)
+{
+    std::uint64_t index;
+    if (!find_snapshot_entry_index(snapshot, address, &index))
+        return false;
+    *entry = get_snapshot_entry(snapshot, index);
+    return true;
+}
+
+namespace {
+
+struct pending_snapshot_entry
+{
+    std::uint64_t address;
+    // If the entry comes from the graph's current snapshot, this is where its
+    // data is. Otherwise, its data is in bytes.
+    bool is_carried_over;
+    recording_reader carried_over;
+    std::string bytes;
+    // Is this entry's address used by more than one piece of data?
+    bool is_ambiguous;
+};
+
+} // namespace
+
+void
+write_data_snapshot(std::ostream& out, data_graph const& graph)
+{
+    std::vector<pending_snapshot_entry> entries;
+    for (persistent_data const* i = graph.persistent_list; i; i = i->next)
+    {
+        pending_snapshot_entry entry;
+        entry.address = i->address;
+        entry.is_carried_over = false;
+        entry.is_ambiguous = false;
+        recording_writer writer;
+        if (i->write(writer))
+        {
+            entry.bytes = std::move(writer.bytes);
+            entries.push_back(std::move(entry));
+        }
+    }
+    std::stable_sort(
+        entries.begin(),
+        entries.end(),
+        [](pending_snapshot_entry const& a, pending_snapshot_entry const& b) {
+            return a.address < b.address;
+        });
+    // Mark (and then remove) any ambiguous entries. (Their addresses are
+    // recorded so that they aren't carried over from the current snapshot
+    // either.)
+    std::vector<std::uint64_t> ambiguous_addresses;
+    for (size_t i = 1; i < entries.size(); ++i)
+    {
+        if (entries[i].address == entries[i - 1].address)
+        {
+            if (!entries[i - 1].is_ambiguous)
+                ambiguous_addresses.push_back(entries[i].address);
+            entries[i].is_ambiguous = entries[i - 1].is_ambiguous = true;
+        }
+    }
+    entries.erase(
+        std::remove_if(
+            entries.begin(),
+            entries.end(),
+            [](pending_snapshot_entry const& e) { return e.is_ambiguous; }),
+        entries.end());
+
+    // Merge in any entries from the current snapshot that haven't been
+    // attached to data in the graph. (Attached entries have been superseded by
+    // their data, even if that data has since been destroyed.)
+    if (graph.snapshot)
+    {
+        data_snapshot const& snapshot = *graph.snapshot;
+        bool const any_attached
+            = graph.attached_snapshot == &snapshot
+              && graph.attached_snapshot_entries.size() == snapshot.entry_count;
+        std::vector<pending_snapshot_entry> merged;
+        merged.reserve(entries.size());
+        auto live = entries.begin();
+        auto ambiguous = ambiguous_addresses.begin();
+        for (std::uint64_t i = 0; i != snapshot.entry_count; ++i)
+        {
+            std::uint64_t address = load_snapshot_word(
+                snapshot.data + snapshot_header_size
+                + i * snapshot_entry_size);
+            while (live != entries.end() && live->address < address)
+                merged.push_back(std::move(*live++));
+            if (live != entries.end() && live->address == address)
+                continue;
+            if (any_attached && graph.attached_snapshot_entries[size_t(i)])
+                continue;
+            while (ambiguous != ambiguous_addresses.end()
+                   && *ambiguous < address)
+            {
+                ++ambiguous;
+            }
+            if (ambiguous != ambiguous_addresses.end()
+                && *ambiguous == address)
+            {
+                continue;
+            }
+            pending_snapshot_entry entry;
+            entry.address = address;
+            entry.is_carried_over = true;
+            entry.carried_over = get_snapshot_entry(snapshot, i);
+            entry.is_ambiguous = false;
+            merged.push_back(std::move(entry));
+        }
+        while (live != entries.end())
+            merged.push_back(std::move(*live++));
+        entries = std::move(merged);
+    }
+
+    out.write(snapshot_magic, sizeof(snapshot_magic));
+    store_snapshot_word(out, entries.size());
+    std::uint64_t offset = 0;
+    for (auto const& entry : entries)
+    {
+        std::uint64_t size
+            = entry.is_carried_over
+                  ? std::uint64_t(
+                      entry.carried_over.end - entry.carried_over.position)
+                  : entry.bytes.size();
+        store_snapshot_word(out, entry.address);
+        store_snapshot_word(out, offset);
+        store_snapshot_word(out, size);
+        offset += size;
+    }
+    for (auto const& entry : entries)
+    {
+        if (entry.is_carried_over)
+        {
+            out.write(
+                entry.carried_over.position,
+                entry.carried_over.end - entry.carried_over.position);
+        }
+        else
+        {
+            out.write(entry.bytes.data(), entry.bytes.size());
+        }
+    }
+}
+
+bool
+attach_persistent_data(
+    data_traversal& traversal,
+    persistent_data& data,
+    char const* name,
+    recording_reader* entry)
+{
+    data_graph& graph = *traversal.graph;
+    if (traversal.persistent_path == 0)
+        return false;
+
+    data.address = hash_stable_bytes(
+        name, std::strlen(name), traversal.persistent_path);
+
+    data.next = graph.persistent_list;
+    data.prev_next = &graph.persistent_list;
+    if (graph.persistent_list)
+        graph.persistent_list->prev_next = &data.next;
+    graph.persistent_list = &data;
+
+    if (!graph.snapshot)
+        return false;
+    data_snapshot const& snapshot = *graph.snapshot;
+    std::uint64_t index;
+    if (!find_snapshot_entry_index(snapshot, data.address, &index))
+        return false;
+    if (graph.attached_snapshot != &snapshot
+        || graph.attached_snapshot_entries.size() != snapshot.entry_count)
+    {
+        graph.attached_snapshot_entries.assign(
+            size_t(snapshot.entry_count), false);
+        graph.attached_snapshot = &snapshot;
+    }
+    graph.attached_snapshot_entries[size_t(index)] = true;
+    *entry = get_snapshot_entry(snapshot, index);
+    return true;
+}
+
+} // namespace alia
@@ -0,0 +1,234 @@
+#ifndef ALIA_FLOW_SNAPSHOTS_HPP
+#define ALIA_FLOW_SNAPSHOTS_HPP
+
+#include <istream>
+#include <ostream>
+#include <string>
+
+#include <alia/flow/data_graph.hpp>
+#include <alia/flow/recording.hpp>
+#include <alia/signals/state.hpp>
+
+// This file provides snapshots of the persistent data within a data_graph.
+// A snapshot can be written out when a process exits and used to restore the
+// graph's persistent data in a new process, so that the application doesn't
+// have to rebuild all of its state (and expensive caches) from scratch.
+//
+// Persistence is opt-in at two levels:
+//
+// - The graph must have persistence_enabled set before its first traversal.
+//
+// - Individual pieces of data must be requested with get_persistent_state or
+//   get_persistent_keyed_data, which take a name that identifies the data
+//   within its named block.
+//
+// The address of a piece of persistent data is a hash of its name and the IDs
+// of all the named blocks along the path to it. This means that only named
+// blocks whose IDs have stable hashes (see id_interface::stable_hash) can
+// contain persistent data. (Data in other blocks simply isn't persisted.)
+// Names must be unique within a named block. If two pieces of data end up with
+// the same address, neither is written to snapshots.
+//
+// Values are encoded with recording_codec (see recording.hpp), so that must be
+// specialized for any types that aren't covered by the provided codecs.
+//
+// Restoration is lazy: data is only decoded from the snapshot when it's first
+// requested from the graph. Entries that haven't been requested yet are
+// carried over when a new snapshot is written from the graph. (Entries that
+// have been requested aren't, even if their data has since been destroyed.)
+//
+// The snapshot format is designed so that a snapshot can be used in place
+// (e.g., from a memory-mapped file) without any parsing. It consists of...
+//
+//   - the magic string "ALIASNP\1"
+//   - the number of entries
+//   - a table of entries, sorted by address, each consisting of the address,
+//     the offset of the entry's data (relative to the end of the table) and
+//     the size of the entry's data
+//   - the data for the entries
+//
+// All integers are 64-bit little-endian, so the table is 8-byte aligned.
+
+namespace alia {
+
+// This is thrown when a snapshot is malformed.
+struct snapshot_error : exception
+{
+    snapshot_error(std::string const& message) : exception(message)
+    {
+    }
+};
+
+struct data_snapshot : noncopyable
+{
+    // the contents of the snapshot
+    // These point either into storage or into memory that's managed by the
+    // application.
+    char const* data = nullptr;
+    size_t size = 0;
+    std::uint64_t entry_count = 0;
+
+    std::string storage;
+};
+
+// Open a snapshot that's stored in memory that's managed by the application.
+// The memory must remain valid for as long as the snapshot is in use.
+void
+open_data_snapshot(data_snapshot& snapshot, char const* data, size_t size);
+
+// Read a snapshot from a stream.
+void
+read_data_snapshot(data_snapshot& snapshot, std::istream& in);
+
+// Find the entry for the given address in a snapshot.
+// Returns false if there's no such entry.
+bool
+find_snapshot_entry(
+    data_snapshot const& snapshot,
+    std::uint64_t address,
+    recording_reader* entry);
+
+// Write a snapshot of the persistent data in a graph.
+// (This includes any entries in the graph's current snapshot that haven't
+// been restored yet.)
+void
+write_data_snapshot(std::ostream& out, data_graph const& graph);
+
+// Assign an address to a newly created piece of persistent data and register
+// it with its graph. If the graph's snapshot has an entry for the data, this
+// returns true and sets *entry to it.
+// (This is called by get_persistent_state, etc. It shouldn't normally be
+// needed by applications.)
+bool
+attach_persistent_data(
+    data_traversal& traversal,
+    persistent_data& data,
+    char const* name,
+    recording_reader* entry);
+
+// persistent_state_data is the data that's stored in the graph for
+// get_persistent_state.
+template<class Value>
+struct persistent_state_data : persistent_data
+{
+    state_holder<Value> state;
+
+    bool
+    write(recording_writer& writer) const override
+    {
+        if (!state.is_initialized())
+            return false;
+        recording_codec<Value>::write(writer, state.get());
+        return true;
+    }
+};
+
+// get_persistent_state(ctx, name, initial_value) is the persistent form of
+// get_state(ctx, initial_value). If the state has a value in the graph's
+// snapshot, that's used instead of :initial_value.
+template<class Context, class InitialValue>
+auto
+get_persistent_state(
+    Context ctx, char const* name, InitialValue const& initial_value)
+{
+    auto initial_value_signal = signalize(initial_value);
+    typedef typename decltype(initial_value_signal)::value_type value_type;
+    static_assert(
+        is_recordable<value_type>::value,
+        "persistent state must have a recording_codec");
+
+    persistent_state_data<value_type>* data;
+    if (get_data(ctx, &data))
+    {
+        recording_reader entry;
+        if (attach_persistent_data(
+                get_data_traversal(ctx), *data, name, &entry))
+        {
+            // If the entry can't be decoded (e.g., because the type has
+            // changed since it was written), it's simply ignored.
+            try
+            {
+                data->state.set(recording_codec<value_type>::read(entry));
+            }
+            catch (replay_error&)
+            {
+            }
+        }
+    }
+
+    if (!data->state.is_initialized()
+        && signal_has_value(initial_value_signal))
+    {
+        data->state.set(read_signal(initial_value_signal));
+    }
+
+    return make_state_signal(data->state);
+}
+
+// persistent_keyed_data is the data that's stored in the graph for
+// get_persistent_keyed_data. Along with the value, it stores the stable hash
+// of the key, which is what's written to snapshots. (If the key has no stable
+// hash, the data isn't written.)
+template<class Data>
+struct persistent_keyed_data : persistent_data
+{
+    keyed_data<Data> data;
+    bool has_key_hash = false;
+    std::uint64_t key_hash = 0;
+
+    bool
+    write(recording_writer& writer) const override
+    {
+        if (!is_valid(data) || !has_key_hash)
+            return false;
+        write_varint(writer, key_hash);
+        recording_codec<Data>::write(writer, data.value);
+        return true;
+    }
+};
+
+// get_persistent_keyed_data(ctx, name, key, &signal) is the persistent form of
+// get_keyed_data(ctx, key, &signal). The data is still stored as cached data,
+// so it's discarded when it's inactive, but whenever it's recreated, it's
+// restored from the graph's snapshot (if the snapshot has a value for the
+// same key).
+template<class Context, class Data>
+bool
+get_persistent_keyed_data(
+    Context ctx,
+    char const* name,
+    id_interface const& key,
+    keyed_data_signal<Data>* signal)
+{
+    static_assert(
+        is_recordable<Data>::value,
+        "persistent keyed data must have a recording_codec");
+
+    persistent_keyed_data<Data>* ptr;
+    bool is_new = get_cached_data(ctx, &ptr);
+    if (refresh_keyed_data(ptr->data, key))
+    {
+        ptr->has_key_hash = key.stable_hash(ptr->key_hash);
+        recording_reader entry;
+        if (is_new
+            && attach_persistent_data(
+                get_data_traversal(ctx), *ptr, name, &entry)
+            && ptr->has_key_hash)
+        {
+            try
+            {
+                if (read_varint(entry) == ptr->key_hash)
+                    set(ptr->data, recording_codec<Data>::read(entry));
+            }
+            catch (replay_error&)
+            {
+            }
+        }
+    }
+    *signal = make_signal(&ptr->data);
+    return !is_valid(ptr->data);
+}
+
+} // namespace alia
+
+#endif
@@ -2,9 +2,11 @@
 #define ALIA_ID_HPP
 
 #include <alia/common.hpp>
+#include <cstring>
 #include <functional>
 #include <memory>
 #include <sstream>
+#include <vector>
 
 // This file implements the concept of IDs in alia.
 
@@ -35,8 +37,224 @@ struct id_interface
     // one.
     virtual bool
     less_than(id_interface const& other) const = 0;
+
+    // If this ID has a hash that's stable across processes (i.e., one that
+    // doesn't depend on addresses), store it in :hash and return true.
+    // This is used to address persistent data (see flow/snapshots.hpp), so
+    // the default is to simply report that there's no such hash.
+    virtual bool
+    stable_hash(std::uint64_t& /*hash*/) const
+    {
+        return false;
+    }
+};
+
+// The following are the building blocks for stable ID hashes.
+// (This is 64-bit FNV-1a.)
+
+std::uint64_t const stable_hash_seed = 0xcbf29ce484222325;
+
+inline std::uint64_t
+hash_stable_bytes(void const* data, size_t size, std::uint64_t hash)
+{
+    unsigned char const* bytes = static_cast<unsigned char const*>(data);
+    for (size_t i = 0; i != size; ++i)
+    {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3;
+    }
+    return hash;
+}
+
+inline std::uint64_t
+combine_stable_hashes(std::uint64_t a, std::uint64_t b)
+{
+    for (int i = 0; i != 8; ++i)
+    {
+        a ^= (b >> (i * 8)) & 0xff;
+        a *= 0x100000001b3;
+    }
+    return a;
+}
+
+// Mix a 64-bit word into a stable hash.
+// (This is cheaper than combine_stable_hashes, so it's used for sequences.)
+inline std::uint64_t
+mix_stable_hash(std::uint64_t hash, std::uint64_t word)
+{
+    hash ^= word;
+    hash *= 0x9e3779b97f4a7c15;
+    return hash ^ (hash >> 32);
+}
+
+// is_stable_hash_word_type<Value>::value yields a compile-time boolean
+// indicating whether or not values of type Value can be represented directly
+// as 64-bit words for the purposes of stable hashing (via stable_hash_word).
+template<class Value>
+struct is_stable_hash_word_type
+    : std::integral_constant<
+          bool,
+          std::is_integral<Value>::value || std::is_enum<Value>::value
+              || std::is_same<Value, float>::value
+              || std::is_same<Value, double>::value>
+{
 };
 
+// Get the 64-bit word that represents :value for the purposes of stable
+// hashing. Integers are represented by value (rather than by their bytes), so
+// the hashes don't depend on the size or byte order of the integer type.
+// Floating point values are represented by the bits of their double forms
+// (with zeros normalized, since 0.0 == -0.0).
+template<class Value>
+std::enable_if_t<
+    std::is_integral<Value>::value || std::is_enum<Value>::value,
+    std::uint64_t>
+stable_hash_word(Value value)
+{
+    return static_cast<std::uint64_t>(value);
+}
+template<class Value>
+std::enable_if_t<std::is_floating_point<Value>::value, std::uint64_t>
+stable_hash_word(Value value)
+{
+    double normalized = value == 0 ? 0. : double(value);
+    std::uint64_t word;
+    static_assert(sizeof(word) == sizeof(normalized), "unexpected double size");
+    std::memcpy(&word, &normalized, sizeof(word));
+    return word;
+}
+
+// stable_hash_traits<Value> defines how values of type Value are hashed when
+// they're used as IDs. By default, values have no stable hash.
+template<class Value, class = void>
+struct stable_hash_traits
+{
+    // This marks the default case. (See has_stable_hash.)
+    typedef void no_stable_hash;
+
+    static bool
+    compute(Value const&, std::uint64_t&)
+    {
+        return false;
+    }
+};
+
+// has_stable_hash<Value>::value yields a compile-time boolean indicating
+// whether or not stable_hash_traits has been defined for Value.
+template<class Value, class = void_t<>>
+struct has_stable_hash : std::true_type
+{
+};
+template<class Value>
+struct has_stable_hash<
+    Value,
+    void_t<typename stable_hash_traits<Value>::no_stable_hash>>
+    : std::false_type
+{
+};
+
+template<class Value>
+struct stable_hash_traits<
+    Value,
+    std::enable_if_t<is_stable_hash_word_type<Value>::value>>
+{
+    static bool
+    compute(Value const& value, std::uint64_t& hash)
+    {
+        hash = combine_stable_hashes(stable_hash_seed, stable_hash_word(value));
+        return true;
+    }
+};
+template<>
+struct stable_hash_traits<std::string>
+{
+    static bool
+    compute(std::string const& value, std::uint64_t& hash)
+    {
+        hash = hash_stable_bytes(value.data(), value.size(), ~stable_hash_seed);
+        return true;
+    }
+};
+
+// Get the word that represents :item within the stable hash of a sequence.
+template<class Item>
+std::enable_if_t<is_stable_hash_word_type<Item>::value, bool>
+get_stable_hash_item_word(Item const& item, std::uint64_t& word)
+{
+    word = stable_hash_word(item);
+    return true;
+}
+template<class Item>
+std::enable_if_t<!is_stable_hash_word_type<Item>::value, bool>
+get_stable_hash_item_word(Item const& item, std::uint64_t& word)
+{
+    return stable_hash_traits<Item>::compute(item, word);
+}
+
+// Vectors are hashed by their items (if those have stable hashes).
+template<class Item, class Allocator>
+struct stable_hash_traits<
+    std::vector<Item, Allocator>,
+    std::enable_if_t<has_stable_hash<Item>::value>>
+{
+    static bool
+    compute(std::vector<Item, Allocator> const& value, std::uint64_t& hash)
+    {
+        // The items are mixed into four independent lanes (round robin) so
+        // that consecutive mixes don't have to wait on each other.
+        std::uint64_t a = stable_hash_seed, b = ~stable_hash_seed,
+                      c = value.size(), d = 0;
+        size_t const n = value.size();
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4)
+        {
+            std::uint64_t wa, wb, wc, wd;
+            if (!get_stable_hash_item_word<Item>(value[i], wa)
+                || !get_stable_hash_item_word<Item>(value[i + 1], wb)
+                || !get_stable_hash_item_word<Item>(value[i + 2], wc)
+                || !get_stable_hash_item_word<Item>(value[i + 3], wd))
+            {
+                return false;
+            }
+            a = mix_stable_hash(a, wa);
+            b = mix_stable_hash(b, wb);
+            c = mix_stable_hash(c, wc);
+            d = mix_stable_hash(d, wd);
+        }
+        for (; i != n; ++i)
+        {
+            std::uint64_t w;
+            if (!get_stable_hash_item_word<Item>(value[i], w))
+                return false;
+            a = mix_stable_hash(a, w);
+        }
+        hash = combine_stable_hashes(
+            combine_stable_hashes(a, b), combine_stable_hashes(c, d));
+        return true;
+    }
+};
+
+struct no_stable_hash_error : exception
+{
+    no_stable_hash_error() : exception("value has no stable hash")
+    {
+    }
+};
+
+// Get the stable hash of :value.
+// This throws a no_stable_hash_error if the hash can't be computed.
+template<class Value>
+std::uint64_t
+get_stable_hash(Value const& value)
+{
+    static_assert(
+        has_stable_hash<Value>::value, "value type has no stable hash");
+    std::uint64_t hash;
+    if (!stable_hash_traits<Value>::compute(value, hash))
+        throw no_stable_hash_error();
+    return hash;
+}
+
 // The following convert the interface of the ID operations into the usual form
 // that one would expect, as free functions.
 
@@ -191,6 +409,12 @@ struct id_ref : id_interface
         return *id_ < *other_id.id_;
     }
 
+    bool
+    stable_hash(std::uint64_t& hash) const
+    {
+        return id_->stable_hash(hash);
+    }
+
     void
     deep_copy(id_interface* copy) const
     {
@@ -258,6 +482,12 @@ struct simple_id : id_interface
         return value_ < other_id.value_;
     }
 
+    bool
+    stable_hash(std::uint64_t& hash) const
+    {
+        return stable_hash_traits<Value>::compute(value_, hash);
+    }
+
     void
     deep_copy(id_interface* copy) const
     {
@@ -313,6 +543,12 @@ struct simple_id_by_reference : id_interface
         return *value_ < *other_id.value_;
     }
 
+    bool
+    stable_hash(std::uint64_t& hash) const
+    {
+        return stable_hash_traits<Value>::compute(*value_, hash);
+    }
+
     void
     deep_copy(id_interface* copy) const
     {
@@ -322,6 +558,13 @@ struct simple_id_by_reference : id_interface
             typed_copy.storage_ = this->storage_;
             typed_copy.value_ = this->value_;
         }
+        else if (typed_copy.storage_ && typed_copy.storage_.use_count() == 1)
+        {
+            // The copy already owns storage that no one else sees, so reuse
+            // it rather than allocating new storage for every capture.
+            *typed_copy.storage_ = *this->value_;
+            typed_copy.value_ = typed_copy.storage_.get();
+        }
         else
         {
             typed_copy.storage_.reset(new Value(*this->value_));
@@ -377,6 +620,16 @@ struct id_pair : id_interface
                || (id0_.equals(other_id.id0_) && id1_.less_than(other_id.id1_));
     }
 
+    bool
+    stable_hash(std::uint64_t& hash) const
+    {
+        std::uint64_t hash0, hash1;
+        if (!id0_.stable_hash(hash0) || !id1_.stable_hash(hash1))
+            return false;
+        hash = combine_stable_hashes(hash0, hash1);
+        return true;
+    }
+
     void
     deep_copy(id_interface* copy) const
     {
@@ -0,0 +1,552 @@
+#include <alia/sessions.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+
+namespace alia {
+
+static millisecond_count
+get_session_host_ticks(session_host const& host)
+{
+    return host.config.get_tick_count ? host.config.get_tick_count()
+                                      : get_default_tick_count();
+}
+
+// Ask for the session to be refreshed at :tick (or earlier, if it's already
+// scheduled for an earlier tick). This is called by the claiming thread.
+static void
+set_session_wake_tick(hosted_session& session, millisecond_count tick)
+{
+    // (The comparison is done this way so that it handles wraparound.)
+    if (!session.has_wake_tick || int(tick - session.wake_tick) < 0)
+    {
+        session.has_wake_tick = true;
+        session.wake_tick = tick;
+    }
+}
+
+void
+session_external::request_animation_refresh()
+{
+    set_session_wake_tick(
+        *session, get_session_host_ticks(*host) + host->config.frame_interval);
+}
+
+bool
+session_external::schedule_refresh_at(millisecond_count tick)
+{
+    set_session_wake_tick(*session, tick);
+    return true;
+}
+
+millisecond_count
+session_external::get_tick_count() const
+{
+    return get_session_host_ticks(*host);
+}
+
+static std::string
+get_hibernation_path(session_host const& host, session_id id)
+{
+    return host.config.hibernation_directory + "/session-" + std::to_string(id)
+           + ".snapshot";
+}
+
+// All of the following functions that take a session_host& without a
+// hosted_session& expect the host's mutex to be held by the caller.
+
+static void
+schedule_session(session_host& host, hosted_session& session)
+{
+    // If the session is claimed, it will be rescheduled when it's released.
+    if (!session.queued && !session.claimed)
+    {
+        session.queued = true;
+        host.ready.push_back(&session);
+        host.ready_condition.notify_one();
+    }
+}
+
+void
+session_external::wake()
+{
+    // This can be called from any thread, but the session can't be destroyed
+    // while its system exists.
+    std::lock_guard<std::mutex> lock(host->mutex);
+    if (!session->destroyed)
+    {
+        session->refresh_requested = true;
+        schedule_session(*host, *session);
+    }
+}
+
+static void
+remove_waiting_session(session_host& host, hosted_session& session)
+{
+    if (session.waiting)
+    {
+        host.waiting.erase(
+            std::find(host.waiting.begin(), host.waiting.end(), &session));
+        session.waiting = false;
+    }
+}
+
+// Schedule any waiting sessions whose wake ticks have arrived.
+static void
+wake_due_sessions(session_host& host)
+{
+    if (host.waiting.empty())
+        return;
+    millisecond_count now = get_session_host_ticks(host);
+    for (size_t i = 0; i != host.waiting.size();)
+    {
+        hosted_session& session = *host.waiting[i];
+        if (!session.claimed && int(session.wake_tick - now) <= 0)
+        {
+            host.waiting[i] = host.waiting.back();
+            host.waiting.pop_back();
+            session.waiting = false;
+            session.has_wake_tick = false;
+            schedule_session(host, session);
+        }
+        else
+        {
+            ++i;
+        }
+    }
+}
+
+// Get the number of ticks until the next wake tick of a waiting session.
+// Returns false if no sessions are waiting.
+static bool
+get_next_session_wake_delay(session_host& host, millisecond_count* delay)
+{
+    if (host.waiting.empty())
+        return false;
+    millisecond_count now = get_session_host_ticks(host);
+    int earliest = int(host.waiting.front()->wake_tick - now);
+    for (hosted_session* session : host.waiting)
+        earliest = (std::min)(earliest, int(session->wake_tick - now));
+    *delay = millisecond_count((std::max)(earliest, 0));
+    return true;
+}
+
+static void
+claim_session(session_host& host, hosted_session& session)
+{
+    session.claimed = true;
+    ++host.claimed_count;
+}
+
+static hosted_session*
+claim_ready_session(
+    session_host& host, std::vector<std::function<void(system&)>>& work)
+{
+    hosted_session* session = host.ready.front();
+    host.ready.pop_front();
+    session->queued = false;
+    claim_session(host, *session);
+    work.swap(session->pending);
+    session->refresh_requested = false;
+    // The refresh will request a new wake tick if it needs one.
+    remove_waiting_session(host, *session);
+    session->has_wake_tick = false;
+    return session;
+}
+
+static void
+release_session(session_host& host, hosted_session& session)
+{
+    session.claimed = false;
+    --host.claimed_count;
+    if (session.destroyed)
+    {
+        remove_waiting_session(host, session);
+        host.sessions.erase(session.id);
+    }
+    else if (!session.pending.empty() || session.refresh_requested)
+    {
+        schedule_session(host, session);
+    }
+    else if (session.has_wake_tick && !session.waiting)
+    {
+        session.waiting = true;
+        host.waiting.push_back(&session);
+        // A worker may need to shorten its wait.
+        host.ready_condition.notify_one();
+    }
+    host.idle_condition.notify_all();
+}
+
+// The following are done while the session is claimed but without holding the
+// host's mutex.
+
+static void
+activate_session(session_host& host, hosted_session& session)
+{
+    session.sys.reset(new system);
+    system& sys = *session.sys;
+    sys.controller = session.controller;
+    sys.external = &session.external;
+    sys.data.persistence_enabled = !host.config.hibernation_directory.empty();
+    if (session.hibernated)
+    {
+        std::string path = get_hibernation_path(host, session.id);
+        {
+            std::ifstream in(path, std::ios::binary);
+            std::unique_ptr<data_snapshot> snapshot(new data_snapshot);
+            // If the snapshot is missing or corrupt, the session simply starts
+            // fresh.
+            try
+            {
+                read_data_snapshot(*snapshot, in);
+                session.snapshot = std::move(snapshot);
+                sys.data.snapshot = session.snapshot.get();
+            }
+            catch (snapshot_error&)
+            {
+            }
+        }
+        std::remove(path.c_str());
+    }
+}
+
+namespace {
+
+struct session_processing_result
+{
+    bool restored = false;
+    bool refreshed = false;
+    bool cache_cleared = false;
+    bool budget_exceeded = false;
+    bool failed = false;
+};
+
+} // namespace
+
+static void
+check_session_memory(
+    session_host& host,
+    hosted_session& session,
+    session_processing_result& result)
+{
+    unsigned interval = host.config.memory_check_interval;
+    if (interval == 0 || ++session.refreshes_since_check < interval)
+        return;
+    session.refreshes_since_check = 0;
+
+    data_graph& graph = session.sys->data;
+    session.memory_usage = compute_data_graph_stats(graph).estimated_bytes;
+    if (session.memory_usage > host.config.memory_budget)
+    {
+        clear_cached_data(graph.root_block);
+        result.cache_cleared = true;
+        session.memory_usage = compute_data_graph_stats(graph).estimated_bytes;
+        if (session.memory_usage > host.config.memory_budget)
+        {
+            result.budget_exceeded = true;
+            if (host.config.on_budget_exceeded)
+            {
+                host.config.on_budget_exceeded(
+                    session.id, session.memory_usage);
+            }
+        }
+    }
+}
+
+static session_processing_result
+process_claimed_session(
+    session_host& host,
+    hosted_session& session,
+    std::vector<std::function<void(system&)>>& work)
+{
+    session_processing_result result;
+    try
+    {
+        if (!session.sys)
+        {
+            result.restored = session.hibernated;
+            activate_session(host, session);
+        }
+        for (auto& w : work)
+            w(*session.sys);
+        // This also runs anything that was posted directly to the system.
+        if (!update_system(*session.sys))
+            refresh_system(*session.sys);
+        result.refreshed = true;
+        check_session_memory(host, session, result);
+    }
+    catch (...)
+    {
+        result.failed = true;
+    }
+    return result;
+}
+
+static void
+record_session_processing(
+    session_host& host,
+    hosted_session& session,
+    session_processing_result const& result)
+{
+    if (result.restored)
+    {
+        session.hibernated = false;
+        --host.stats.hibernated_sessions;
+        ++host.stats.restorations;
+    }
+    if (result.refreshed)
+        ++host.stats.refreshes;
+    if (result.cache_cleared)
+        ++host.stats.budget_cache_clears;
+    if (result.budget_exceeded)
+        ++host.stats.budget_violations;
+    if (result.failed)
+        ++host.stats.failures;
+    session.last_active = get_session_host_ticks(host);
+}
+
+static void
+run_session_worker(session_host& host)
+{
+    std::unique_lock<std::mutex> lock(host.mutex);
+    while (true)
+    {
+        if (host.stopping)
+            return;
+        wake_due_sessions(host);
+        if (host.ready.empty())
+        {
+            millisecond_count delay;
+            if (get_next_session_wake_delay(host, &delay))
+            {
+                host.ready_condition.wait_for(
+                    lock, std::chrono::milliseconds(delay));
+            }
+            else
+            {
+                host.ready_condition.wait(lock);
+            }
+            continue;
+        }
+        std::vector<std::function<void(system&)>> work;
+        hosted_session* session = claim_ready_session(host, work);
+        lock.unlock();
+        auto result = process_claimed_session(host, *session, work);
+        lock.lock();
+        record_session_processing(host, *session, result);
+        release_session(host, *session);
+    }
+}
+
+session_host::session_host(session_host_config const& config) : config(config)
+{
+    for (unsigned i = 0; i != config.worker_count; ++i)
+        workers.emplace_back([this] { run_session_worker(*this); });
+}
+
+session_host::~session_host()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    ready_condition.notify_all();
+    for (auto& worker : workers)
+        worker.join();
+    for (auto const& entry : sessions)
+    {
+        if (entry.second->hibernated)
+            std::remove(get_hibernation_path(*this, entry.first).c_str());
+    }
+}
+
+session_id
+create_session(session_host& host, std::function<void(context)> controller)
+{
+    std::unique_ptr<hosted_session> session(new hosted_session);
+    session->controller = std::move(controller);
+    session->external.host = &host;
+    session->external.session = session.get();
+    session->refresh_requested = true;
+
+    std::lock_guard<std::mutex> lock(host.mutex);
+    session->id = host.next_id++;
+    session->last_active = get_session_host_ticks(host);
+    hosted_session& s = *session;
+    host.sessions[s.id] = std::move(session);
+    schedule_session(host, s);
+    return s.id;
+}
+
+void
+destroy_session(session_host& host, session_id id)
+{
+    std::lock_guard<std::mutex> lock(host.mutex);
+    auto i = host.sessions.find(id);
+    if (i == host.sessions.end())
+        return;
+    hosted_session& session = *i->second;
+    if (session.claimed)
+    {
+        session.destroyed = true;
+        return;
+    }
+    if (session.queued)
+    {
+        host.ready.erase(
+            std::find(host.ready.begin(), host.ready.end(), &session));
+    }
+    remove_waiting_session(host, session);
+    if (session.hibernated)
+    {
+        std::remove(get_hibernation_path(host, id).c_str());
+        --host.stats.hibernated_sessions;
+    }
+    host.sessions.erase(i);
+}
+
+bool
+post_to_session(
+    session_host& host, session_id id, std::function<void(system&)> work)
+{
+    std::lock_guard<std::mutex> lock(host.mutex);
+    auto i = host.sessions.find(id);
+    if (i == host.sessions.end() || i->second->destroyed)
+        return false;
+    hosted_session& session = *i->second;
+    session.pending.push_back(std::move(work));
+    schedule_session(host, session);
+    return true;
+}
+
+size_t
+process_ready_sessions(session_host& host)
+{
+    std::unique_lock<std::mutex> lock(host.mutex);
+    wake_due_sessions(host);
+    // Only process the sessions that are ready now. (Sessions that become
+    // ready in the meantime are left for the next call.)
+    size_t count = 0, limit = host.ready.size();
+    for (; count != limit && !host.ready.empty(); ++count)
+    {
+        std::vector<std::function<void(system&)>> work;
+        hosted_session* session = claim_ready_session(host, work);
+        lock.unlock();
+        auto result = process_claimed_session(host, *session, work);
+        lock.lock();
+        record_session_processing(host, *session, result);
+        release_session(host, *session);
+    }
+    return count;
+}
+
+void
+wait_for_idle_sessions(session_host& host)
+{
+    std::unique_lock<std::mutex> lock(host.mutex);
+    host.idle_condition.wait(lock, [&] {
+        return host.ready.empty() && host.claimed_count == 0;
+    });
+}
+
+size_t
+hibernate_idle_sessions(session_host& host)
+{
+    if (host.config.hibernation_directory.empty())
+        return 0;
+
+    // Claim all the sessions that are eligible.
+    std::vector<hosted_session*> candidates;
+    {
+        std::lock_guard<std::mutex> lock(host.mutex);
+        millisecond_count now = get_session_host_ticks(host);
+        for (auto const& entry : host.sessions)
+        {
+            hosted_session& session = *entry.second;
+            if (session.sys && !session.queued && !session.claimed
+                && !session.waiting && !session.has_wake_tick
+                && session.pending.empty()
+                && now - session.last_active >= host.config.idle_timeout)
+            {
+                claim_session(host, session);
+                candidates.push_back(&session);
+            }
+        }
+    }
+
+    // Write out their snapshots.
+    std::vector<bool> hibernated(candidates.size(), false);
+    for (size_t i = 0; i != candidates.size(); ++i)
+    {
+        hosted_session& session = *candidates[i];
+        {
+            std::ofstream out(
+                get_hibernation_path(host, session.id), std::ios::binary);
+            write_data_snapshot(out, session.sys->data);
+            out.close();
+            hibernated[i] = bool(out);
+        }
+        if (hibernated[i])
+        {
+            // The system refers to the snapshot, so it must go first.
+            session.sys.reset();
+            session.snapshot.reset();
+        }
+    }
+
+    // Release them.
+    size_t count = 0;
+    std::lock_guard<std::mutex> lock(host.mutex);
+    for (size_t i = 0; i != candidates.size(); ++i)
+    {
+        hosted_session& session = *candidates[i];
+        if (hibernated[i])
+        {
+            session.hibernated = true;
+            ++host.stats.hibernated_sessions;
+            ++host.stats.hibernations;
+            ++count;
+        }
+        // If the session was destroyed in the meantime, its snapshot is no
+        // longer needed.
+        if (session.destroyed && session.hibernated)
+        {
+            std::remove(get_hibernation_path(host, session.id).c_str());
+            --host.stats.hibernated_sessions;
+        }
+        release_session(host, session);
+    }
+    return count;
+}
+
+bool
+is_session_hibernated(session_host& host, session_id id)
+{
+    std::lock_guard<std::mutex> lock(host.mutex);
+    auto i = host.sessions.find(id);
+    return i != host.sessions.end() && i->second->hibernated;
+}
+
+size_t
+get_session_memory_usage(session_host& host, session_id id)
+{
+    std::lock_guard<std::mutex> lock(host.mutex);
+    auto i = host.sessions.find(id);
+    return i != host.sessions.end() ? i->second->memory_usage : 0;
+}
+
+session_host_stats
+get_session_host_stats(session_host& host)
+{
+    std::lock_guard<std::mutex> lock(host.mutex);
+    session_host_stats stats = host.stats;
+    stats.sessions = host.sessions.size();
+    stats.ready_sessions = host.ready.size();
+    stats.waiting_sessions = host.waiting.size();
+    return stats;
+}
+
+} // namespace alia
@@ -0,0 +1,259 @@
+#ifndef ALIA_SESSIONS_HPP
+#define ALIA_SESSIONS_HPP
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <alia/flow/snapshots.hpp>
+#include <alia/system.hpp>
+
+// This file provides a host for running many alia systems (sessions) in a
+// single process, e.g., one per remote viewer in a server.
+//
+// The host owns the systems and processes them on a fixed pool of worker
+// threads. Work for a session (e.g., dispatching an event) is posted to the
+// host from any thread, and the session is then scheduled. When a worker
+// picks up a session, it runs all of the session's pending work and then
+// refreshes the session once, so any number of pending requests are coalesced
+// into a single refresh. A session is only ever processed by one thread at a
+// time.
+//
+// Sessions that are animating (or that have scheduled future refreshes) aren't
+// kept in the ready queue. Instead, each one gets a wake tick (at most one
+// frame interval away for animations), and it's only scheduled once that tick
+// arrives, so animations are paced and don't monopolize the workers.
+//
+// The host also enforces a memory budget for the data graph of each session.
+// When a session's graph exceeds its budget, its cached data is cleared (since
+// that can always be regenerated). If that's not enough, the host reports the
+// violation via session_host_config::on_budget_exceeded.
+//
+// Finally, sessions that have been idle for a while can be hibernated: their
+// persistent data is written to a snapshot on disk (see flow/snapshots.hpp)
+// and their systems are destroyed. A hibernated session is transparently
+// restored from its snapshot when work is next posted to it. Note that only
+// persistent data survives hibernation. (Everything else is reconstructed as
+// if the session were new.)
+
+namespace alia {
+
+typedef counter_type session_id;
+
+size_t const unlimited_session_memory = ~size_t(0);
+
+struct session_host_config
+{
+    // the number of worker threads
+    // If this is 0, sessions are only processed when the application calls
+    // process_ready_sessions.
+    unsigned worker_count = 0;
+
+    // the memory budget for the data graph of each session (in bytes)
+    size_t memory_budget = unlimited_session_memory;
+
+    // A session's memory usage is checked every time this many refreshes have
+    // been done for it. (Checking requires walking the session's graph.)
+    unsigned memory_check_interval = 16;
+
+    // If this is set, it's called (on the worker thread) when a session
+    // exceeds its memory budget even after its cached data has been cleared.
+    std::function<void(session_id id, size_t memory_usage)>
+        on_budget_exceeded;
+
+    // the directory where hibernated sessions are stored
+    // If this is empty, sessions are never hibernated.
+    std::string hibernation_directory;
+
+    // the number of ticks that a session must be idle before it's hibernated
+    millisecond_count idle_timeout = 60000;
+
+    // the number of ticks between refreshes of an animating session
+    millisecond_count frame_interval = 16;
+
+    // the clock for the host and its sessions
+    // If this isn't set, get_default_tick_count is used.
+    std::function<millisecond_count()> get_tick_count;
+};
+
+struct session_host_stats
+{
+    // the number of sessions, how many of those are hibernated, and how many
+    // are waiting to be processed
+    size_t sessions = 0;
+    size_t hibernated_sessions = 0;
+    size_t ready_sessions = 0;
+    // the number of sessions that are waiting for their wake ticks
+    size_t waiting_sessions = 0;
+
+    // cumulative counts of work done by the host
+    counter_type refreshes = 0;
+    counter_type hibernations = 0;
+    counter_type restorations = 0;
+    counter_type budget_cache_clears = 0;
+    counter_type budget_violations = 0;
+    // the number of times that processing a session threw an exception
+    counter_type failures = 0;
+};
+
+struct session_host;
+struct hosted_session;
+
+// session_external routes a session's requests for future refreshes to its
+// wake tick, and it schedules the session when its system is woken (e.g., by
+// request_refresh or post_to_system).
+struct session_external : external_interface
+{
+    session_host* host;
+    hosted_session* session;
+
+    void
+    wake() override;
+
+    void
+    request_animation_refresh() override;
+
+    bool
+    schedule_refresh_at(millisecond_count tick) override;
+
+    millisecond_count
+    get_tick_count() const override;
+};
+
+struct hosted_session : noncopyable
+{
+    session_id id;
+    std::function<void(context)> controller;
+
+    // the snapshot that the session was restored from (if any)
+    // (This is declared before the system since the system refers to it.)
+    std::unique_ptr<data_snapshot> snapshot;
+    // the session's system (or null if the session is hibernated)
+    std::unique_ptr<system> sys;
+    session_external external;
+
+    // work that's been posted to the session but not yet run
+    std::vector<std::function<void(system&)>> pending;
+    // Does the session need a refresh even if there's no pending work?
+    bool refresh_requested = false;
+
+    // If the session needs to be refreshed at a future tick (e.g., for its
+    // next animation frame), this is that tick. (While the session is
+    // claimed, this is set by the claiming thread.)
+    bool has_wake_tick = false;
+    millisecond_count wake_tick = 0;
+    // Is the session in the host's waiting list?
+    bool waiting = false;
+
+    // Is the session in the host's ready queue?
+    bool queued = false;
+    // Is the session currently claimed by a thread?
+    bool claimed = false;
+    // Has the session been destroyed while it was claimed?
+    bool destroyed = false;
+    bool hibernated = false;
+
+    // the tick count when the session was last processed
+    millisecond_count last_active = 0;
+
+    // the number of refreshes since the session's memory was last checked
+    unsigned refreshes_since_check = 0;
+    // the memory usage at the last check
+    size_t memory_usage = 0;
+};
+
+struct session_host : noncopyable
+{
+    session_host(session_host_config const& config);
+    ~session_host();
+
+    session_host_config config;
+
+    // This protects everything below (but not the sessions' systems, which
+    // are only accessed by the thread that has claimed the session).
+    std::mutex mutex;
+    // This is signaled when sessions become ready or the host is stopping.
+    std::condition_variable ready_condition;
+    // This is signaled when a thread finishes processing a session.
+    std::condition_variable idle_condition;
+
+    std::unordered_map<session_id, std::unique_ptr<hosted_session>> sessions;
+    std::deque<hosted_session*> ready;
+    // the sessions that are waiting for their wake ticks
+    std::vector<hosted_session*> waiting;
+    size_t claimed_count = 0;
+    session_id next_id = 1;
+    session_host_stats stats;
+
+    bool stopping = false;
+    std::vector<std::thread> workers;
+};
+
+// Create a session with the given controller.
+// The session is scheduled for its initial refresh.
+session_id
+create_session(session_host& host, std::function<void(context)> controller);
+
+// Destroy a session (and discard its hibernated state, if any).
+void
+destroy_session(session_host& host, session_id id);
+
+// Post work to a session.
+// The work will be run (on a worker thread) with the session's system, and
+// the session will be refreshed afterwards. Returns false if the session
+// doesn't exist.
+bool
+post_to_session(
+    session_host& host, session_id id, std::function<void(system&)> work);
+
+// Post an event to a session.
+template<class Event>
+bool
+post_event_to_session(session_host& host, session_id id, Event event)
+{
+    return post_to_session(host, id, [event](system& sys) mutable {
+        impl::dispatch_event(sys, event);
+    });
+}
+
+// Process all sessions that are ready in the calling thread.
+// (This includes sessions whose wake ticks have arrived.)
+// (This is how sessions are processed when the host has no workers, but it
+// can also be used to help the workers.)
+// Returns the number of sessions that were processed.
+size_t
+process_ready_sessions(session_host& host);
+
+// Wait until no sessions are ready or being processed.
+// (Sessions that are only waiting for their wake ticks count as idle.)
+// This is only meaningful when the host has workers.
+void
+wait_for_idle_sessions(session_host& host);
+
+// Hibernate all sessions that have been idle for at least the configured
+// timeout. (Sessions that are waiting for wake ticks aren't idle.) This does
+// the hibernation in the calling thread, so it should be called periodically
+// by some maintenance thread.
+// Returns the number of sessions that were hibernated.
+size_t
+hibernate_idle_sessions(session_host& host);
+
+bool
+is_session_hibernated(session_host& host, session_id id);
+
+// Get the memory usage of a session's data graph (as of its last check).
+size_t
+get_session_memory_usage(session_host& host, session_id id);
+
+session_host_stats
+get_session_host_stats(session_host& host);
+
+} // namespace alia
+
+#endif
@@ -70,7 +70,12 @@ struct readability_faker : signal<
     void
     write(typename Wrapped::value_type const& value) const
     {
-        return wrapped_.write(value);
+        wrapped_.write(value);
+    }
+    void
+    write(typename Wrapped::value_type&& value) const
+    {
+        wrapped_.write(std::move(value));
     }
 
  private:
@@ -119,6 +124,7 @@ struct writability_faker : signal<
     }
     // Since this is only faking writability, write() should never be called.
     // LCOV_EXCL_START
+    using signal_interface<typename Wrapped::value_type>::write;
     void
     write(typename Wrapped::value_type const&) const
     {
@@ -166,7 +172,13 @@ struct signal_caster : regular_signal<
     void
     write(To const& value) const
     {
-        return wrapped_.write(static_cast<typename Wrapped::value_type>(value));
+        wrapped_.write(static_cast<typename Wrapped::value_type>(value));
+    }
+    void
+    write(To&& value) const
+    {
+        wrapped_.write(
+            static_cast<typename Wrapped::value_type>(std::move(value)));
     }
 
  private:
@@ -290,6 +302,11 @@ struct fallback_signal : signal<
     {
         primary_.write(value);
     }
+    void
+    write(typename Primary::value_type&& value) const
+    {
+        primary_.write(std::move(value));
+    }
 
  private:
     mutable id_pair<simple_id<bool>, id_ref> id_;
@@ -345,7 +362,12 @@ struct simplified_id_wrapper : regular_signal<
     void
     write(typename Wrapped::value_type const& value) const
     {
-        return wrapped_.write(value);
+        wrapped_.write(value);
+    }
+    void
+    write(typename Wrapped::value_type&& value) const
+    {
+        wrapped_.write(std::move(value));
     }
 
  private:
@@ -358,6 +380,145 @@ simplify_id(Wrapped wrapped)
     return simplified_id_wrapper<Wrapped>(wrapped);
 }
 
+// identify_by_hash(s), where :s is a signal, yields a wrapper for :s with the
+// exact same read/write behavior but whose value ID is the stable hash of its
+// value (see stable_hash_traits).
+//
+// This is meant for signals carrying large values that would otherwise be
+// identified by the values themselves (e.g., value(big_vector)). Capturing
+// such an ID means copying the whole value, and matching it means comparing
+// the whole value. The hash still has to be computed from the whole value, but
+// it doesn't allocate anything, and the captured ID is just the hash. (This
+// pays off for values that are expensive to copy. For flat arrays of numbers,
+// plain comparison is already hard to beat.)
+//
+// Note that equal hashes are taken to mean equal values, so a hash collision
+// would cause a change to be missed.
+//
+template<class Wrapped>
+struct hashed_id_wrapper : signal<
+                               hashed_id_wrapper<Wrapped>,
+                               typename Wrapped::value_type,
+                               typename Wrapped::direction_tag>
+{
+    static_assert(
+        has_stable_hash<typename Wrapped::value_type>::value,
+        "identify_by_hash requires a value type with a stable hash");
+
+    hashed_id_wrapper(Wrapped wrapped) : wrapped_(wrapped)
+    {
+    }
+    bool
+    has_value() const
+    {
+        return wrapped_.has_value();
+    }
+    typename Wrapped::value_type const&
+    read() const
+    {
+        return wrapped_.read();
+    }
+    id_interface const&
+    value_id() const
+    {
+        if (wrapped_.has_value())
+        {
+            id_ = make_id(get_stable_hash(wrapped_.read()));
+            return id_;
+        }
+        return null_id;
+    }
+    bool
+    ready_to_write() const
+    {
+        return wrapped_.ready_to_write();
+    }
+    void
+    write(typename Wrapped::value_type const& value) const
+    {
+        wrapped_.write(value);
+    }
+    void
+    write(typename Wrapped::value_type&& value) const
+    {
+        wrapped_.write(std::move(value));
+    }
+
+ private:
+    Wrapped wrapped_;
+    mutable simple_id<std::uint64_t> id_;
+};
+template<class Wrapped>
+hashed_id_wrapper<Wrapped>
+identify_by_hash(Wrapped wrapped)
+{
+    return hashed_id_wrapper<Wrapped>(wrapped);
+}
+
+// identify_by_version(s, version), where :s is a signal, yields a wrapper for
+// :s with the exact same read/write behavior but whose value ID is simply
+// :version. It's up to the caller to change :version whenever the value of :s
+// changes (including via writes through the wrapper).
+//
+// This is the cheapest way to identify a large value, since the ID doesn't
+// depend on the value at all. It's a natural fit for application data that
+// already carries its own revision counter.
+//
+template<class Wrapped, class Version>
+struct versioned_id_wrapper : signal<
+                                  versioned_id_wrapper<Wrapped, Version>,
+                                  typename Wrapped::value_type,
+                                  typename Wrapped::direction_tag>
+{
+    versioned_id_wrapper(Wrapped wrapped, Version version)
+        : wrapped_(wrapped), id_(std::move(version))
+    {
+    }
+    bool
+    has_value() const
+    {
+        return wrapped_.has_value();
+    }
+    typename Wrapped::value_type const&
+    read() const
+    {
+        return wrapped_.read();
+    }
+    id_interface const&
+    value_id() const
+    {
+        if (wrapped_.has_value())
+            return id_;
+        return null_id;
+    }
+    bool
+    ready_to_write() const
+    {
+        return wrapped_.ready_to_write();
+    }
+    void
+    write(typename Wrapped::value_type const& value) const
+    {
+        wrapped_.write(value);
+    }
+    void
+    write(typename Wrapped::value_type&& value) const
+    {
+        wrapped_.write(std::move(value));
+    }
+
+ private:
+    Wrapped wrapped_;
+    simple_id<Version> id_;
+};
+template<class Wrapped, class Version>
+versioned_id_wrapper<Wrapped, Version>
+identify_by_version(Wrapped wrapped, Version version)
+{
+    return versioned_id_wrapper<Wrapped, Version>(
+        wrapped, std::move(version));
+}
+
 // mask(signal, availibility_flag) does the equivalent of bit masking on
 // individual signals. If :availibility_flag evaluates to true, the mask
 // evaluates to signal equivalent to :signal. Otherwise, it evaluates to an
@@ -402,6 +563,11 @@ struct masking_signal : signal<
     {
         primary_.write(value);
     }
+    void
+    write(typename Primary::value_type&& value) const
+    {
+        primary_.write(std::move(value));
+    }
 
  private:
     Primary primary_;
@@ -469,6 +635,11 @@ struct write_masking_signal : signal<
     {
         primary_.write(value);
     }
+    void
+    write(typename Primary::value_type&& value) const
+    {
+        primary_.write(std::move(value));
+    }
 
  private:
     Primary primary_;
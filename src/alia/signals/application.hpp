@@ -5,6 +5,7 @@
 #include <alia/flow/data_graph.hpp>
 #include <alia/flow/events.hpp>
 #include <alia/signals/utilities.hpp>
+#include <alia/tracing.hpp>
 
 namespace alia {
 
@@ -216,6 +217,8 @@ apply(context ctx, Function f, Args const&... args)
     {
         if (data.status == apply_status::UNCOMPUTED && args_ready)
         {
+            scoped_trace_span span(
+                get<system_tag>(ctx).tracer, "apply", "alia");
             try
             {
                 data.result = f(read_signal(args)...);
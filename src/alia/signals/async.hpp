@@ -4,7 +4,9 @@
 #include <alia/context/interface.hpp>
 #include <alia/flow/data_graph.hpp>
 #include <alia/flow/events.hpp>
+#include <alia/flow/recording.hpp>
 #include <alia/signals/utilities.hpp>
+#include <alia/tracing.hpp>
 
 namespace alia {
 
@@ -102,6 +104,29 @@ process_async_args(
     process_async_args(ctx, data, args_ready, rest...);
 }
 
+// When replaying a recording, async operations whose results can be recorded
+// aren't actually launched. Instead, their recorded results are delivered by
+// the replayer. These return true if that's the case. (Otherwise, the
+// operation is launched normally, and its result is treated as live activity
+// - see scoped_live_replay_activity.)
+template<class Result, class ReportResult>
+std::enable_if_t<is_recordable<Result>::value, bool>
+replay_async_result(event_replayer& replayer, ReportResult const& report_result)
+{
+    impl::register_replayed_async(
+        replayer, [report_result](recording_reader& reader) {
+            report_result(recording_codec<Result>::read(reader));
+        });
+    return true;
+}
+template<class Result, class ReportResult>
+std::enable_if_t<!is_recordable<Result>::value, bool>
+replay_async_result(event_replayer& replayer, ReportResult const&)
+{
+    impl::register_replayed_async(replayer, nullptr);
+    return false;
+}
+
 template<class Result, class Context, class Launcher, class... Args>
 auto
 async(Context ctx, Launcher launcher, Args const&... args)
@@ -120,22 +145,80 @@ async(Context ctx, Launcher launcher, Args const&... args)
         {
             auto* system = &get<system_tag>(ctx);
             auto version = data.version;
-            auto report_result = [system, version, data_ptr](Result result) {
+            // If the system is being traced, the interval between the launch
+            // and the completion is recorded as an async span.
+            // (Note that this means the trace sink must outlive any
+            // outstanding operations.)
+            trace_event_sink* tracer = system->tracer;
+            counter_type trace_id
+                = tracer ? begin_async_trace_span(*tracer, "async", "alia")
+                         : 0;
+            // If the system is being recorded, the result is recorded as well.
+            event_recorder* recorder = system->recorder;
+            counter_type recording_serial
+                = recorder ? impl::get_recorded_async_serial(*recorder) : 0;
+            auto report_result = [system,
+                                  version,
+                                  data_ptr,
+                                  tracer,
+                                  trace_id,
+                                  recorder,
+                                  recording_serial](Result result) {
+                if (recorder)
+                {
+                    impl::record_async_result(
+                        *recorder, recording_serial, result);
+                }
+                if (tracer)
+                {
+                    trace_args args;
+                    args("outcome", "complete");
+                    end_async_trace_span(
+                        *tracer, "async", "alia", trace_id, &args);
+                }
                 auto& data = *data_ptr;
                 if (data.version == version)
                 {
                     data.result = std::move(result);
                     data.status = async_status::COMPLETE;
                 }
+                impl::scoped_nested_recording nested(recorder != nullptr);
                 refresh_system(*system);
             };
             try
             {
-                launcher(ctx, report_result, read_signal(args)...);
+                if (!system->replayer)
+                {
+                    launcher(ctx, report_result, read_signal(args)...);
+                }
+                else if (!replay_async_result<Result>(
+                             *system->replayer, report_result))
+                {
+                    launcher(
+                        ctx,
+                        [report_result](Result result) {
+                            impl::scoped_live_replay_activity live;
+                            report_result(std::move(result));
+                        },
+                        read_signal(args)...);
+                }
+            }
+            // A replay error means the replay itself has failed, so it's not
+            // the operation's failure.
+            catch (replay_error&)
+            {
+                throw;
             }
             catch (...)
             {
                 data.status = async_status::FAILED;
+                if (tracer)
+                {
+                    trace_args args;
+                    args("outcome", "failed");
+                    end_async_trace_span(
+                        *tracer, "async", "alia", trace_id, &args);
+                }
             }
         }
     });
@@ -47,6 +47,7 @@ struct empty_signal : signal<empty_signal<Value>, Value, duplex_signal>
     }
     // Since this is never ready to write, write() should never be called.
     // LCOV_EXCL_START
+    using signal_interface<Value>::write;
     void
     write(Value const&) const
     {
@@ -65,7 +66,7 @@ template<class Value>
 struct value_signal
     : regular_signal<value_signal<Value>, Value, read_only_signal>
 {
-    explicit value_signal(Value const& v) : v_(v)
+    explicit value_signal(Value v) : v_(std::move(v))
     {
     }
     bool
@@ -84,9 +85,9 @@ struct value_signal
 };
 template<class Value>
 value_signal<Value>
-value(Value const& v)
+value(Value v)
 {
-    return value_signal<Value>(v);
+    return value_signal<Value>(std::move(v));
 }
 
 // This is a special overload of value() for C-style string literals.
@@ -159,6 +160,23 @@ struct direct_signal
     {
         *v_ = value;
     }
+    void
+    write(Value&& value) const
+    {
+        *v_ = std::move(value);
+    }
+    template<class Mutator>
+    void
+    mutate(Mutator&& mutator) const
+    {
+        std::forward<Mutator>(mutator)(*v_);
+    }
+    template<class Mutator, class V = Value>
+    std::enable_if_t<is_vector_like<V>::value && !is_map_like<V>::value>
+    mutate_items(size_t, size_t, Mutator&& mutator) const
+    {
+        std::forward<Mutator>(mutator)(*v_);
+    }
 
  private:
     Value* v_;
@@ -137,6 +137,15 @@ struct signal_interface : untyped_signal_base
     // Write the signal's value.
     virtual void
     write(Value const& value) const = 0;
+
+    // Write the signal's value, moving from :value if possible.
+    // By default, this just calls the const& version. Signals that can move
+    // the value to its destination should override it.
+    virtual void
+    write(Value&& value) const
+    {
+        this->write(static_cast<Value const&>(value));
+    }
 };
 
 template<class Derived, class Value, class Direction>
@@ -165,6 +174,8 @@ struct signal<Derived, Value, read_only_signal>
     {
         return false;
     }
+    // (The using declaration keeps the rvalue version of write() visible.)
+    using signal_interface<Value>::write;
     void
     write(Value const&) const
     {
@@ -251,6 +262,11 @@ struct signal_ref : signal<signal_ref<Value, Direction>, Value, Direction>
     {
         ref_->write(value);
     }
+    void
+    write(Value&& value) const
+    {
+        ref_->write(std::move(value));
+    }
 
  private:
     signal_interface<Value> const* ref_;
@@ -354,12 +370,123 @@ signal_ready_to_write(Signal const& signal)
 // Unlike calling signal.write() directly, this will generate a compile-time
 // error if the signal's type doesn't support writing.
 // Note that if the signal isn't ready to write, this is a no op.
+// If :value is an rvalue, it's moved into the signal.
 template<class Signal, class Value>
 std::enable_if_t<signal_is_writable<Signal>::value>
-write_signal(Signal const& signal, Value const& value)
+write_signal(Signal const& signal, Value&& value)
 {
     if (signal.ready_to_write())
-        signal.write(value);
+        signal.write(std::forward<Value>(value));
+}
+
+// Some duplex signals can also mutate their values in place (rather than
+// requiring the whole value to be read, copied and written back). Such signals
+// provide the following:
+//
+//   template<class Mutator>
+//   void
+//   mutate(Mutator&& mutator) const;
+//
+// This invokes :mutator with a non-const reference to the signal's value.
+//
+// Signals to vector-like values can also provide
+//
+//   template<class Mutator>
+//   void
+//   mutate_items(size_t first, size_t last, Mutator&& mutator) const;
+//
+// This invokes :mutator with a non-const reference to the signal's value,
+// with the understanding that only the items in the index range [first, last)
+// (as indexed after the mutation) have changed. (:last may extend past the
+// end of the container.)
+//
+// Signals that track the versions of their individual items can also provide
+//
+//   unsigned
+//   item_version(size_t index) const;
+//
+// which yields a number that changes whenever the item at :index does.
+
+// signal_supports_mutation<Signal>::value yields a compile-time boolean
+// indicating whether or not :Signal provides mutate().
+template<class Signal, class = void_t<>>
+struct signal_supports_mutation : std::false_type
+{
+};
+template<class Signal>
+struct signal_supports_mutation<
+    Signal,
+    void_t<decltype(std::declval<Signal const&>().mutate(
+        std::declval<void (*)(typename Signal::value_type&)>()))>>
+    : std::true_type
+{
+};
+
+// signal_supports_item_mutation<Signal>::value yields a compile-time boolean
+// indicating whether or not :Signal provides mutate_items().
+template<class Signal, class = void_t<>>
+struct signal_supports_item_mutation : std::false_type
+{
+};
+template<class Signal>
+struct signal_supports_item_mutation<
+    Signal,
+    void_t<decltype(std::declval<Signal const&>().mutate_items(
+        size_t(0),
+        size_t(0),
+        std::declval<void (*)(typename Signal::value_type&)>()))>>
+    : std::true_type
+{
+};
+
+// signal_has_item_versions<Signal>::value yields a compile-time boolean
+// indicating whether or not :Signal provides item_version().
+template<class Signal, class = void_t<>>
+struct signal_has_item_versions : std::false_type
+{
+};
+template<class Signal>
+struct signal_has_item_versions<
+    Signal,
+    void_t<decltype(std::declval<Signal const&>().item_version(size_t(0)))>>
+    : std::true_type
+{
+};
+
+// mutate_signal(signal, mutator) applies :mutator to the value of :signal.
+// If :signal doesn't support in-place mutation, this falls back to copying its
+// value, mutating the copy, and writing it back.
+// :signal is expected to have a value and be ready to write.
+template<class Signal, class Mutator>
+std::enable_if_t<signal_supports_mutation<Signal>::value>
+mutate_signal(Signal const& signal, Mutator&& mutator)
+{
+    signal.mutate(std::forward<Mutator>(mutator));
+}
+template<class Signal, class Mutator>
+std::enable_if_t<!signal_supports_mutation<Signal>::value>
+mutate_signal(Signal const& signal, Mutator&& mutator)
+{
+    auto value = signal.read();
+    mutator(value);
+    signal.write(std::move(value));
+}
+
+// mutate_signal_items(signal, first, last, mutator) is like mutate_signal, but
+// it also notes that only the items in [first, last) have changed (if :signal
+// can make use of that).
+template<class Signal, class Mutator>
+std::enable_if_t<signal_supports_item_mutation<Signal>::value>
+mutate_signal_items(
+    Signal const& signal, size_t first, size_t last, Mutator&& mutator)
+{
+    signal.mutate_items(first, last, std::forward<Mutator>(mutator));
+}
+template<class Signal, class Mutator>
+std::enable_if_t<!signal_supports_item_mutation<Signal>::value>
+mutate_signal_items(Signal const& signal, size_t, size_t, Mutator&& mutator)
+{
+    mutate_signal(signal, std::forward<Mutator>(mutator));
 }
 
 // signal_is_duplex<Signal>::value yields a compile-time boolean indicating
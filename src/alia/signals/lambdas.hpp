@@ -218,6 +218,11 @@ struct lambda_duplex_signal
     {
         write_(value);
     }
+    void
+    write(Value&& value) const
+    {
+        write_(std::move(value));
+    }
 
  private:
     HasValue has_value_;
@@ -301,6 +306,11 @@ struct lambda_duplex_signal_with_id : signal<
     {
         write_(value);
     }
+    void
+    write(Value&& value) const
+    {
+        write_(std::move(value));
+    }
 
  private:
     HasValue has_value_;
@@ -38,6 +38,7 @@ struct scaled_signal : regular_signal<
     {
         return n_.ready_to_write() && scale_factor_.has_value();
     }
+    using signal_interface<typename N::value_type>::write;
     void
     write(typename N::value_type const& value) const
     {
@@ -87,6 +88,7 @@ struct offset_signal : regular_signal<
     {
         return n_.ready_to_write() && offset_.has_value();
     }
+    using signal_interface<typename N::value_type>::write;
     void
     write(typename N::value_type const& value) const
     {
@@ -137,6 +139,7 @@ struct rounding_signal_wrapper : regular_signal<
     {
         return n_.ready_to_write() && step_.has_value();
     }
+    using signal_interface<typename N::value_type>::write;
     void
     write(typename N::value_type const& value) const
     {
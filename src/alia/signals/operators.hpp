@@ -377,6 +377,14 @@ struct signal_mux : signal<
         else
             f_.write(value);
     }
+    void
+    write(typename T::value_type&& value) const
+    {
+        if (condition_.read())
+            t_.write(std::move(value));
+        else
+            f_.write(std::move(value));
+    }
 
  private:
     Condition condition_;
@@ -442,9 +450,23 @@ struct field_signal : preferred_id_signal<
     void
     write(Field const& x) const
     {
-        structure_type s = structure_.read();
-        s.*field_ = x;
-        structure_.write(s);
+        // If the structure supports it, this only touches the field itself.
+        mutate_signal(structure_, [&](structure_type& s) { s.*field_ = x; });
+    }
+    void
+    write(Field&& x) const
+    {
+        mutate_signal(
+            structure_, [&](structure_type& s) { s.*field_ = std::move(x); });
+    }
+    // A field can be mutated in place if its structure can.
+    template<class Mutator, class S = StructureSignal>
+    std::enable_if_t<signal_supports_mutation<S>::value>
+    mutate(Mutator&& mutator) const
+    {
+        structure_.mutate([&](structure_type& s) {
+            std::forward<Mutator>(mutator)(s.*field_);
+        });
     }
 
  private:
@@ -619,23 +641,93 @@ struct const_subscript_invoker<
 };
 
 template<class ContainerSignal, class IndexSignal, class Value>
-std::enable_if_t<signal_is_writable<ContainerSignal>::value>
+std::enable_if_t<
+    signal_is_writable<ContainerSignal>::value
+    && !signal_supports_item_mutation<ContainerSignal>::value>
+write_subscript(
+    ContainerSignal const& container,
+    IndexSignal const& index,
+    Value value)
+{
+    mutate_signal(
+        container, [&](typename ContainerSignal::value_type& items) {
+            items[index.read()] = std::move(value);
+        });
+}
+
+// If the container supports it, the item is updated in place.
+template<class ContainerSignal, class IndexSignal, class Value>
+std::enable_if_t<
+    signal_is_writable<ContainerSignal>::value
+    && signal_supports_item_mutation<ContainerSignal>::value>
 write_subscript(
     ContainerSignal const& container,
     IndexSignal const& index,
-    Value const& value)
+    Value value)
 {
-    auto new_container = container.read();
-    new_container[index.read()] = value;
-    container.write(new_container);
+    size_t i = size_t(index.read());
+    container.mutate_items(
+        i, i + 1, [&](typename ContainerSignal::value_type& items) {
+            items[i] = std::move(value);
+        });
 }
 
 template<class ContainerSignal, class IndexSignal, class Value>
 std::enable_if_t<!signal_is_writable<ContainerSignal>::value>
-write_subscript(ContainerSignal const&, IndexSignal const&, Value const&)
+write_subscript(ContainerSignal const&, IndexSignal const&, Value)
 {
 }
 
+// subscript_has_item_identity<ContainerSignal, IndexSignal>::value yields a
+// compile-time boolean indicating whether or not the container can identify
+// the item that's being accessed.
+template<class ContainerSignal, class IndexSignal>
+struct subscript_has_item_identity : has_item_identity<
+                                         typename ContainerSignal::value_type,
+                                         typename IndexSignal::value_type>
+{
+};
+
+// If the container tracks item versions, the ID of a subscript is based on
+// the version of the item (rather than the version of the whole container).
+template<class ContainerSignal, class IndexSignal>
+std::enable_if_t<
+    !subscript_has_item_identity<ContainerSignal, IndexSignal>::value
+        && !signal_has_item_versions<ContainerSignal>::value,
+    id_pair<id_ref, id_ref>>
+get_subscript_id(ContainerSignal const& container, IndexSignal const& index)
+{
+    return combine_ids(ref(container.value_id()), ref(index.value_id()));
+}
+template<class ContainerSignal, class IndexSignal>
+std::enable_if_t<
+    !subscript_has_item_identity<ContainerSignal, IndexSignal>::value
+        && signal_has_item_versions<ContainerSignal>::value,
+    id_pair<simple_id<unsigned>, id_ref>>
+get_subscript_id(ContainerSignal const& container, IndexSignal const& index)
+{
+    return combine_ids(
+        make_id(
+            index.has_value() ? container.item_version(size_t(index.read()))
+                              : 0u),
+        ref(index.value_id()));
+}
+// If the container can identify its items itself (as the persistent
+// containers can), the ID of a subscript is just the identity of the item.
+// (Since an item's identity doesn't change when the item moves within the
+// container, this also preserves IDs across insertions and removals.)
+template<class ContainerSignal, class IndexSignal>
+std::enable_if_t<
+    subscript_has_item_identity<ContainerSignal, IndexSignal>::value,
+    simple_id<std::shared_ptr<void const>>>
+get_subscript_id(ContainerSignal const& container, IndexSignal const& index)
+{
+    return make_id(
+        container.has_value() && index.has_value()
+            ? container.read().item_identity(index.read())
+            : std::shared_ptr<void const>());
+}
+
 template<class ContainerSignal, class IndexSignal>
 struct subscript_signal : preferred_id_signal<
                               subscript_signal<ContainerSignal, IndexSignal>,
@@ -643,7 +735,9 @@ struct subscript_signal : preferred_id_signal<
                                   typename ContainerSignal::value_type,
                                   typename IndexSignal::value_type>::type,
                               typename ContainerSignal::direction_tag,
-                              id_pair<alia::id_ref, alia::id_ref>>
+                              decltype(get_subscript_id(
+                                  std::declval<ContainerSignal>(),
+                                  std::declval<IndexSignal>()))>
 {
     subscript_signal()
     {
@@ -665,7 +759,7 @@ struct subscript_signal : preferred_id_signal<
     auto
     complex_value_id() const
     {
-        return combine_ids(ref(container_.value_id()), ref(index_.value_id()));
+        return get_subscript_id(container_, index_);
     }
     bool
     ready_to_write() const
@@ -678,6 +772,11 @@ struct subscript_signal : preferred_id_signal<
     {
         write_subscript(container_, index_, x);
     }
+    void
+    write(typename subscript_signal::value_type&& x) const
+    {
+        write_subscript(container_, index_, std::move(x));
+    }
 
  private:
     ContainerSignal container_;
@@ -0,0 +1,93 @@
+#include <alia/signals/state.hpp>
+
+#include <alia/system.hpp>
+
+#include <atomic>
+
+namespace alia {
+
+// the transaction that's currently active on this thread (if any)
+static thread_local transaction* active_transaction = nullptr;
+
+// the serial number of the last transaction that was started (on any thread)
+// - State isn't tied to a thread, so this must be unique process-wide.
+static std::atomic<counter_type> last_transaction_serial(0);
+
+transaction::transaction(dataless_context ctx)
+{
+    begin(ctx.get<system_tag>());
+}
+
+transaction::transaction(system& sys)
+{
+    begin(sys);
+}
+
+void
+transaction::begin(system& sys)
+{
+    sys_ = &sys;
+    parent_ = active_transaction;
+    // A nested transaction just becomes part of the outermost one.
+    root_ = parent_ ? parent_->root_ : this;
+    serial_ = parent_ ? parent_->serial_ : ++last_transaction_serial;
+    active_transaction = this;
+}
+
+transaction::~transaction()
+{
+    active_transaction = parent_;
+    if (parent_ || changes_.empty())
+        return;
+    for (change const& c : changes_)
+    {
+        if (c.participant)
+        {
+            c.participant->serial = 0;
+            c.participant->owner = nullptr;
+            c.commit(c.owner);
+        }
+    }
+    request_refresh(*sys_);
+}
+
+size_t
+transaction::changed_state_count() const
+{
+    return root_->changes_.size();
+}
+
+counter_type
+get_active_transaction_serial()
+{
+    return active_transaction ? active_transaction->serial_ : 0;
+}
+
+void
+join_active_transaction(
+    transaction_participant& participant,
+    void* owner,
+    void (*commit)(void* owner))
+{
+    assert(active_transaction);
+    participant.serial = active_transaction->serial_;
+    participant.owner = active_transaction->root_;
+    active_transaction->root_->changes_.push_back(
+        transaction::change{&participant, owner, commit});
+}
+
+transaction_participant::~transaction_participant()
+{
+    // The owning transaction may not be the active one (or even on this
+    // thread), so always go through the owner directly.
+    if (owner)
+    {
+        for (auto& c : owner->changes_)
+        {
+            if (c.participant == this)
+                c.participant = nullptr;
+        }
+    }
+}
+
+} // namespace alia
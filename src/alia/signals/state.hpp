@@ -1,17 +1,215 @@
 #ifndef ALIA_SIGNALS_STATE_HPP
 #define ALIA_SIGNALS_STATE_HPP
 
+#include <alia/context/interface.hpp>
 #include <alia/flow/data_graph.hpp>
 #include <alia/signals/adaptors.hpp>
 #include <alia/signals/core.hpp>
+#include <alia/signals/utilities.hpp>
+
+#include <algorithm>
+#include <vector>
 
 namespace alia {
 
+// state_tracks_item_versions<Value>::value yields a compile-time boolean
+// indicating whether or not a state_holder<Value> tracks the versions of the
+// individual items within its value. This is done for vector-like values whose
+// items are identified by something other than their own values (since those
+// are the cases where it's useful to know exactly which items have changed).
+// Containers that can identify their own items (like persistent_vector) don't
+// need it.
+template<class Value, class = void>
+struct state_tracks_item_versions : std::false_type
+{
+};
+template<class Value>
+struct state_tracks_item_versions<
+    Value,
+    std::enable_if_t<
+        is_vector_like<Value>::value && !is_map_like<Value>::value>>
+    : std::integral_constant<
+          bool,
+          !type_prefers_simple_id<std::decay_t<
+              decltype(std::declval<Value const&>()[size_t(0)])>>::value
+              && !has_item_identity<Value, size_t>::value>
+{
+};
+
+// state_item_versions provides the item version tracking for a state_holder.
+// By default, nothing is tracked.
+template<class Value, class = void>
+struct state_item_versions
+{
+ protected:
+    void
+    reset_item_versions(unsigned)
+    {
+    }
+    void
+    prepare_item_changes(size_t)
+    {
+    }
+    void
+    record_item_changes(size_t, size_t, size_t, unsigned)
+    {
+    }
+};
+template<class Value>
+struct state_item_versions<
+    Value,
+    std::enable_if_t<state_tracks_item_versions<Value>::value>>
+{
+    // Get the version of the item at :index.
+    unsigned
+    item_version(size_t index) const
+    {
+        return index < versions_.size() ? versions_[index] : base_version_;
+    }
+
+ protected:
+    // Note that all items changed at :version.
+    void
+    reset_item_versions(unsigned version)
+    {
+        base_version_ = version;
+        versions_.clear();
+    }
+    // This must be called before an in-place change to a container of size
+    // :size.
+    void
+    prepare_item_changes(size_t size)
+    {
+        if (versions_.empty())
+            versions_.assign(size, base_version_);
+    }
+    // Note that the items in [first, last) changed at :version and that the
+    // container now has :size items.
+    void
+    record_item_changes(
+        size_t first, size_t last, size_t size, unsigned version)
+    {
+        versions_.resize(size, version);
+        std::fill(
+            versions_.begin() + std::min(first, size),
+            versions_.begin() + std::min(last, size),
+            version);
+    }
+
+ private:
+    // the version at which all items last changed
+    unsigned base_version_ = 0;
+    // the versions of the individual items - This is either empty (if all
+    // items are at base_version_) or the same size as the container.
+    std::vector<unsigned> versions_;
+};
+
+// transaction batches the changes that are made to state within its scope.
+// While a transaction is active (on the current thread), a state_holder that's
+// changed keeps its current version, no matter how many times it's written.
+// When the transaction commits (i.e., ends), each changed state_holder gets
+// exactly one new version for all of its changes. Then, if anything changed,
+// the transaction requests a single refresh of the system.
+//
+// Note that writes still take effect immediately, so later actions within the
+// transaction see the results of earlier ones. However, since versions don't
+// change until the commit, anything that identifies state by its value ID
+// (e.g., an apply cache) only sees the changes once they're committed.
+//
+// Transactions can be nested, in which case the inner ones simply become part
+// of the outermost one.
+//
+// transaction_participant records a state_holder's participation in a
+// transaction (so the transaction can forget the state if it's destroyed
+// before the commit). Copies don't inherit the participation.
+struct transaction;
+struct transaction_participant
+{
+    transaction_participant()
+    {
+    }
+    transaction_participant(transaction_participant const&)
+    {
+    }
+    transaction_participant&
+    operator=(transaction_participant const&)
+    {
+        return *this;
+    }
+    ~transaction_participant();
+
+    // the serial number of the transaction that this is part of (or 0)
+    counter_type serial = 0;
+    // the (outermost) transaction that this is part of (or null)
+    transaction* owner = nullptr;
+};
+
+struct transaction : noncopyable
+{
+    explicit transaction(dataless_context ctx);
+
+    // This form is for use outside of a traversal (e.g., in a closure that's
+    // posted to the system).
+    explicit transaction(system& sys);
+
+    ~transaction();
+
+    // Get the number of state_holders that have changed within the
+    // (outermost) transaction so far.
+    size_t
+    changed_state_count() const;
+
+ private:
+    void
+    begin(system& sys);
+
+    // a state that has changed within the transaction
+    struct change
+    {
+        // This is null if the state was destroyed before the commit.
+        transaction_participant* participant;
+        void* owner;
+        void (*commit)(void* owner);
+    };
+
+    system* sys_;
+    // the active transaction when this one began (if any)
+    transaction* parent_;
+    // the outermost transaction (which may be this one)
+    transaction* root_;
+    // a serial number that identifies the outermost transaction
+    counter_type serial_;
+    // the changes within the outermost transaction (only used by the root)
+    std::vector<change> changes_;
+
+    friend counter_type
+    get_active_transaction_serial();
+    friend void
+    join_active_transaction(
+        transaction_participant& participant,
+        void* owner,
+        void (*commit)(void* owner));
+    friend struct transaction_participant;
+};
+
+// Get the serial number of the active transaction on this thread.
+// If there's no active transaction, this returns 0.
+counter_type
+get_active_transaction_serial();
+
+// Record that the owner of :participant has changed within the active
+// transaction. When the transaction commits, it calls :commit(owner).
+void
+join_active_transaction(
+    transaction_participant& participant,
+    void* owner,
+    void (*commit)(void* owner));
+
 // state_holder<Value> is designed to be stored persistently as actual
 // application state. Signals for it will track changes in it and report its ID
 // based on that.
 template<class Value>
-struct state_holder
+struct state_holder : state_item_versions<Value>
 {
     state_holder() : version_(0)
     {
@@ -21,10 +219,13 @@ struct state_holder
     {
     }
 
+    // Note that state that's initialized within a transaction is considered
+    // initialized immediately, even though its version doesn't change until
+    // the commit.
     bool
     is_initialized() const
     {
-        return version_ != 0;
+        return version_ != 0 || participant_.serial != 0;
     }
 
     Value const&
@@ -43,7 +244,7 @@ struct state_holder
     set(Value value)
     {
         value_ = std::move(value);
-        ++version_;
+        this->reset_item_versions(advance_version());
     }
 
     // If you REALLY need direct, non-const access to the underlying state,
@@ -62,15 +263,62 @@ struct state_holder
     Value&
     nonconst_get()
     {
-        ++version_;
+        this->reset_item_versions(advance_version());
         return value_;
     }
 
+    // For vector-like values, this applies :mutator to the value in place,
+    // recording that only the items in the index range [first, last) (as
+    // indexed after the mutation) have changed. (:last may extend past the end
+    // of the container.) The state must already be initialized.
+    //
+    // If the state tracks item versions (see above), only those items get new
+    // versions.
+    //
+    template<class Mutator>
+    void
+    mutate_items(size_t first, size_t last, Mutator&& mutator)
+    {
+        assert(is_initialized());
+        this->prepare_item_changes(value_.size());
+        std::forward<Mutator>(mutator)(value_);
+        this->record_item_changes(
+            first, last, value_.size(), advance_version());
+    }
+
  private:
+    // Advance the version to reflect a change in the value and return the
+    // version that the change is associated with.
+    // Within a transaction, the version doesn't actually change until the
+    // commit, so this just joins the transaction and returns the version that
+    // the commit will produce.
+    unsigned
+    advance_version()
+    {
+        counter_type transaction = get_active_transaction_serial();
+        if (transaction == 0)
+            return ++version_;
+        if (transaction != participant_.serial)
+        {
+            join_active_transaction(
+                participant_, this, &state_holder::commit_transaction);
+        }
+        return version_ + 1;
+    }
+
+    // Give the state its new version for the transaction that changed it.
+    static void
+    commit_transaction(void* owner)
+    {
+        ++static_cast<state_holder*>(owner)->version_;
+    }
+
     Value value_;
     // version_ is incremented for each change in the value of the state.
     // If this is 0, the state is considered uninitialized.
     unsigned version_;
+    // the state's participation in the active transaction (if any)
+    transaction_participant participant_;
 };
 
 template<class Value>
@@ -110,6 +358,33 @@ struct state_signal : signal<state_signal<Value>, Value, duplex_signal>
     {
         state_->set(value);
     }
+    void
+    write(Value&& value) const
+    {
+        state_->set(std::move(value));
+    }
+
+    // in-place mutation
+    template<class Mutator>
+    void
+    mutate(Mutator&& mutator) const
+    {
+        std::forward<Mutator>(mutator)(state_->nonconst_get());
+    }
+
+    // in-place item mutation and item versions (for vector-like values)
+    template<class Mutator, class V = Value>
+    std::enable_if_t<is_vector_like<V>::value && !is_map_like<V>::value>
+    mutate_items(size_t first, size_t last, Mutator&& mutator) const
+    {
+        state_->mutate_items(first, last, std::forward<Mutator>(mutator));
+    }
+    template<class V = Value>
+    std::enable_if_t<state_tracks_item_versions<V>::value, unsigned>
+    item_version(size_t index) const
+    {
+        return state_->item_version(index);
+    }
 
  private:
     state_holder<Value>* state_;
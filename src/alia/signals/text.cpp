@@ -1,41 +1,554 @@
 #include <alia/signals/text.hpp>
 
-#include <sstream>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <type_traits>
 
 namespace alia {
 
-template<class T>
-bool
-string_to_value(std::string const& str, T* value)
+// The numeric conversions below are implemented directly (rather than via
+// iostreams) so that they're locale-independent and don't allocate (beyond the
+// returned string, which is almost always small enough for the small string
+// optimization).
+
+static bool
+is_text_space(char c)
 {
-    std::istringstream s(str);
-    T x;
-    if (!(s >> x))
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f'
+           || c == '\v';
+}
+
+static bool
+is_text_digit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+namespace {
+
+// the result of parsing the (syntactic) form of a decimal number
+struct parsed_decimal_number
+{
+    bool negative = false;
+    // the first (up to) 19 significant digits
+    std::uint64_t mantissa = 0;
+    // the number of significant digits (including any beyond the 19th)
+    int digit_count = 0;
+    // the decimal exponent to apply to the mantissa
+    int exponent = 0;
+    // the range of the significant digits in the original text (including any
+    // decimal point)
+    char const* digits_begin = nullptr;
+    char const* digits_end = nullptr;
+};
+
+} // namespace
+
+// Parse a decimal number (with optional surrounding whitespace).
+// If :allow_real is false, only integers are accepted.
+static bool
+parse_decimal_number(
+    std::string const& str, bool allow_real, parsed_decimal_number* result)
+{
+    char const* p = str.data();
+    char const* end = p + str.size();
+    while (p != end && is_text_space(*p))
+        ++p;
+    if (p != end && (*p == '-' || *p == '+'))
+    {
+        result->negative = *p == '-';
+        ++p;
+    }
+
+    bool any_digits = false;
+    int exponent_adjustment = 0;
+    bool in_fraction = false;
+    for (; p != end; ++p)
+    {
+        if (is_text_digit(*p))
+        {
+            any_digits = true;
+            if (in_fraction)
+                --exponent_adjustment;
+            // Skip leading zeros.
+            if (result->digit_count == 0 && *p == '0')
+                continue;
+            if (result->digit_count == 0)
+                result->digits_begin = p;
+            result->digits_end = p + 1;
+            if (result->digit_count < 19)
+            {
+                result->mantissa = result->mantissa * 10 + unsigned(*p - '0');
+            }
+            else
+            {
+                // Digits beyond the 19th only affect the magnitude here.
+                ++exponent_adjustment;
+            }
+            ++result->digit_count;
+        }
+        else if (*p == '.' && allow_real && !in_fraction)
+        {
+            in_fraction = true;
+        }
+        else
+        {
+            break;
+        }
+    }
+    if (!any_digits)
         return false;
-    s >> std::ws;
-    if (s.eof())
+
+    int exponent = 0;
+    if (allow_real && p != end && (*p == 'e' || *p == 'E'))
     {
-        *value = x;
-        return true;
+        ++p;
+        bool negative_exponent = false;
+        if (p != end && (*p == '-' || *p == '+'))
+        {
+            negative_exponent = *p == '-';
+            ++p;
+        }
+        if (p == end || !is_text_digit(*p))
+            return false;
+        for (; p != end && is_text_digit(*p); ++p)
+        {
+            // Clamp absurd exponents (which will overflow or underflow
+            // anyway).
+            if (exponent < 100000)
+                exponent = exponent * 10 + (*p - '0');
+        }
+        if (negative_exponent)
+            exponent = -exponent;
     }
-    return false;
+    result->exponent = exponent + exponent_adjustment;
+
+    while (p != end && is_text_space(*p))
+        ++p;
+    return p == end;
 }
 
+static double const exact_powers_of_ten[]
+    = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+       1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+// float_parsing_traits<T> describes how to convert decimal numbers to T with
+// a single rounding: the range of the fast path (where the mantissa and the
+// power of ten are both exactly representable in T) and the strtod-style
+// function to use otherwise.
 template<class T>
-std::string
-value_to_string(T const& value)
+struct float_parsing_traits;
+template<>
+struct float_parsing_traits<double>
+{
+    static std::uint64_t const max_exact_mantissa = std::uint64_t(1) << 53;
+    static int const max_exact_exponent = 22;
+    static double
+    parse(char const* text)
+    {
+        return std::strtod(text, nullptr);
+    }
+};
+template<>
+struct float_parsing_traits<float>
 {
-    std::ostringstream s;
-    s << value;
-    return s.str();
+    static std::uint64_t const max_exact_mantissa = std::uint64_t(1) << 24;
+    static int const max_exact_exponent = 10;
+    static float
+    parse(char const* text)
+    {
+        return std::strtof(text, nullptr);
+    }
+};
+
+// Convert a parsed decimal number to the nearest T.
+// (Values that are out of range come out as infinity.)
+template<class T>
+T
+decimal_number_to_float(parsed_decimal_number const& number)
+{
+    typedef float_parsing_traits<T> traits;
+    T x;
+    if (number.mantissa == 0)
+    {
+        x = 0;
+    }
+    else if (
+        number.digit_count <= 19
+        && number.mantissa <= traits::max_exact_mantissa
+        && number.exponent >= -traits::max_exact_exponent
+        && number.exponent <= traits::max_exact_exponent)
+    {
+        // Both the mantissa and the power of ten are exactly representable,
+        // so a single (correctly rounded) operation gives the right answer.
+        // (The operation must be done in T itself, since rounding to double
+        // first and then to float can give a different result.)
+        x = T(number.mantissa);
+        if (number.exponent < 0)
+            x /= T(exact_powers_of_ten[-number.exponent]);
+        else
+            x *= T(exact_powers_of_ten[number.exponent]);
+    }
+    else
+    {
+        // Otherwise, defer to strtod/strtof. The digits are passed without a
+        // decimal point (as "<digits>e<exponent>"), so the locale doesn't
+        // matter.
+        char buffer[64];
+        std::string long_buffer;
+        char* text = buffer;
+        std::ptrdiff_t digit_space
+            = number.digits_end - number.digits_begin + 16;
+        if (digit_space > std::ptrdiff_t(sizeof(buffer)))
+        {
+            long_buffer.resize(size_t(digit_space));
+            text = &long_buffer[0];
+        }
+        char* q = text;
+        for (char const* p = number.digits_begin; p != number.digits_end; ++p)
+        {
+            // (This skips the decimal point, if any.)
+            if (is_text_digit(*p))
+                *q++ = *p;
+        }
+        // The exponent that was computed during parsing assumes that only
+        // the first 19 digits were kept, so account for the rest.
+        int exponent = number.exponent;
+        if (number.digit_count > 19)
+            exponent -= number.digit_count - 19;
+        std::snprintf(q, 16, "e%d", exponent);
+        x = traits::parse(text);
+    }
+    return number.negative ? -x : x;
 }
 
 template<class T>
 void
 float_from_string(T* value, std::string const& str)
 {
-    if (!string_to_value(str, value))
+    parsed_decimal_number number;
+    if (!parse_decimal_number(str, true, &number))
         throw validation_error("This input expects a number.");
+    T result = decimal_number_to_float<T>(number);
+    if (std::isinf(result))
+        throw validation_error("This number is outside the supported range.");
+    *value = result;
+}
+
+// Write the decimal digits of :n to the end of the buffer ending at :end.
+// Returns the start of the written text.
+static char*
+format_unsigned_integer(char* end, unsigned long long n)
+{
+    do
+    {
+        *--end = char('0' + n % 10);
+        n /= 10;
+    } while (n != 0);
+    return end;
+}
+
+// Round the :digit_count digits in :digits (with the given decimal exponent)
+// to :n digits, writing them to :rounded.
+static void
+round_decimal_digits(
+    char* rounded,
+    char const* digits,
+    int digit_count,
+    int n,
+    int exponent,
+    int* rounded_exponent)
+{
+    std::memcpy(rounded, digits, size_t(n));
+    *rounded_exponent = exponent;
+    if (n < digit_count && digits[n] >= '5')
+    {
+        int i = n - 1;
+        while (i >= 0 && rounded[i] == '9')
+            rounded[i--] = '0';
+        if (i >= 0)
+        {
+            ++rounded[i];
+        }
+        else
+        {
+            rounded[0] = '1';
+            ++*rounded_exponent;
+        }
+    }
+}
+
+// Are the given digits (which follow some rounding point) at or near the
+// midpoint between two roundings? (i.e., "5", "50...0", or "49...9")
+static bool
+is_near_decimal_midpoint(char const* digits, int count)
+{
+    if (count == 0)
+        return false;
+    char rest = digits[0] == '5' ? '0' : (digits[0] == '4' ? '9' : 'x');
+    if (rest == 'x')
+        return false;
+    for (int i = 1; i != count; ++i)
+    {
+        if (digits[i] != rest)
+            return false;
+    }
+    return true;
+}
+
+// Try to find a short decimal form (at most 15 digits) of the positive,
+// finite value :value using only (exact) double arithmetic. Common values
+// (like 0.25 or 1.2) are handled this way without any string formatting.
+// The result is always verified, so if this returns true, the digits are
+// correct, but if it returns false, the value needs to be handled by
+// find_precise_decimal_form.
+template<class T>
+bool
+find_short_decimal_form(T value, char* digits, int* digit_count, int* exponent)
+{
+    double const x = double(value);
+    int const magnitude = int(std::floor(std::log10(x)));
+    for (int n = 1; n <= 15; ++n)
+    {
+        // Try to represent x as m * 10^-k, where m has n digits.
+        int k = n - 1 - magnitude;
+        if (k < -22 || k > 22)
+            return false;
+        double m = std::round(
+            k >= 0 ? x * exact_powers_of_ten[k]
+                   : x / exact_powers_of_ten[-k]);
+        if (m < 1 || m > double(std::uint64_t(1) << 53))
+            continue;
+        // Since m and the power of ten are both exact, this is correctly
+        // rounded.
+        double y = k >= 0 ? m / exact_powers_of_ten[k]
+                          : m * exact_powers_of_ten[-k];
+        if (T(y) == value)
+        {
+            char buffer[20];
+            char* end = buffer + sizeof(buffer);
+            char* begin = format_unsigned_integer(
+                end, static_cast<unsigned long long>(m));
+            // Narrowing y to float rounds twice, so for floats, confirm that
+            // the digits parse back correctly.
+            if (!std::is_same<T, double>::value)
+            {
+                parsed_decimal_number candidate;
+                candidate.mantissa = static_cast<std::uint64_t>(m);
+                candidate.digit_count = int(end - begin);
+                candidate.exponent = -k;
+                candidate.digits_begin = begin;
+                candidate.digits_end = end;
+                if (decimal_number_to_float<T>(candidate) != value)
+                    continue;
+            }
+            *digit_count = int(end - begin);
+            std::memcpy(digits, begin, size_t(*digit_count));
+            *exponent = *digit_count - 1 - k;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Find the shortest decimal form of the positive, finite value :value.
+template<class T>
+void
+find_precise_decimal_form(
+    T value, char* digits, int* digit_count, int* exponent_out)
+{
+    // Get the maximum number of digits that could be needed (correctly
+    // rounded) and then find the shortest rounding of those that still
+    // round-trips.
+    int const max_digits = std::numeric_limits<T>::max_digits10;
+    char scientific[40];
+    std::snprintf(
+        scientific, sizeof(scientific), "%.*e", max_digits - 1, double(value));
+    char all_digits[20];
+    int exponent;
+    {
+        int n = 0;
+        char const* p = scientific;
+        for (; *p != 'e'; ++p)
+        {
+            // (This skips the decimal point, whatever it is.)
+            if (is_text_digit(*p))
+                all_digits[n++] = *p;
+        }
+        exponent = std::atoi(p + 1);
+    }
+
+    // All max_digits digits always round-trip, so binary search for the
+    // fewest digits that do. (Rounding the digits that are already rounded
+    // can occasionally produce a longer result than necessary, but it's
+    // always correct.)
+    *digit_count = max_digits;
+    int low = 1;
+    while (low < *digit_count)
+    {
+        int n = (low + *digit_count) / 2;
+        int candidate_exponent;
+        round_decimal_digits(
+            digits, all_digits, max_digits, n, exponent, &candidate_exponent);
+        parsed_decimal_number candidate;
+        for (int i = 0; i != n; ++i)
+        {
+            candidate.mantissa
+                = candidate.mantissa * 10 + unsigned(digits[i] - '0');
+        }
+        candidate.digit_count = n;
+        candidate.exponent = candidate_exponent - (n - 1);
+        candidate.digits_begin = digits;
+        candidate.digits_end = digits + n;
+        if (decimal_number_to_float<T>(candidate) == value)
+            *digit_count = n;
+        else
+            low = n + 1;
+    }
+    round_decimal_digits(
+        digits, all_digits, max_digits, *digit_count, exponent, exponent_out);
+
+    // If the digits that were dropped to get one fewer digit are right at the
+    // midpoint, the exact value might round the other way, so check that
+    // directly.
+    int fewer = *digit_count - 1;
+    if (fewer >= 1
+        && is_near_decimal_midpoint(all_digits + fewer, max_digits - fewer))
+    {
+        std::snprintf(
+            scientific, sizeof(scientific), "%.*e", fewer - 1, double(value));
+        parsed_decimal_number candidate;
+        char candidate_digits[20];
+        int n = 0;
+        char const* p = scientific;
+        for (; *p != 'e'; ++p)
+        {
+            if (is_text_digit(*p))
+            {
+                candidate_digits[n++] = *p;
+                candidate.mantissa
+                    = candidate.mantissa * 10 + unsigned(*p - '0');
+            }
+        }
+        candidate.digit_count = n;
+        candidate.exponent = std::atoi(p + 1) - (n - 1);
+        candidate.digits_begin = candidate_digits;
+        candidate.digits_end = candidate_digits + n;
+        if (decimal_number_to_float<T>(candidate) == value)
+        {
+            std::memcpy(digits, candidate_digits, size_t(n));
+            *digit_count = n;
+            *exponent_out = std::atoi(p + 1);
+        }
+    }
+}
+
+// Write the shortest decimal representation of :value that parses back to the
+// same value (of type T) to :buffer. Returns the end of the written text.
+template<class T>
+char*
+format_shortest_float(char* buffer, T value)
+{
+    char* out = buffer;
+    if (std::isnan(value))
+    {
+        std::memcpy(out, "nan", 3);
+        return out + 3;
+    }
+    if (std::signbit(value))
+    {
+        *out++ = '-';
+        value = -value;
+    }
+    if (std::isinf(value))
+    {
+        std::memcpy(out, "inf", 3);
+        return out + 3;
+    }
+    if (value == 0)
+    {
+        *out++ = '0';
+        return out;
+    }
+
+    char digits[20];
+    int digit_count, exponent;
+    if (!find_short_decimal_form(value, digits, &digit_count, &exponent))
+        find_precise_decimal_form(value, digits, &digit_count, &exponent);
+    while (digit_count > 1 && digits[digit_count - 1] == '0')
+        --digit_count;
+
+    // Use whichever of fixed or scientific notation is shorter (preferring
+    // fixed).
+    int exponent_length = std::abs(exponent) >= 100 ? 3 : 2;
+    int scientific_length
+        = digit_count + (digit_count > 1 ? 1 : 0) + 2 + exponent_length;
+    int fixed_length
+        = exponent >= digit_count - 1
+              ? exponent + 1
+              : (exponent >= 0 ? digit_count + 1 : digit_count + 1 - exponent);
+    if (fixed_length <= scientific_length)
+    {
+        if (exponent >= digit_count - 1)
+        {
+            std::memcpy(out, digits, size_t(digit_count));
+            out += digit_count;
+            for (int i = digit_count - 1; i != exponent; ++i)
+                *out++ = '0';
+        }
+        else if (exponent >= 0)
+        {
+            std::memcpy(out, digits, size_t(exponent + 1));
+            out += exponent + 1;
+            *out++ = '.';
+            std::memcpy(
+                out,
+                digits + exponent + 1,
+                size_t(digit_count - exponent - 1));
+            out += digit_count - exponent - 1;
+        }
+        else
+        {
+            *out++ = '0';
+            *out++ = '.';
+            for (int i = -1; i != exponent; --i)
+                *out++ = '0';
+            std::memcpy(out, digits, size_t(digit_count));
+            out += digit_count;
+        }
+    }
+    else
+    {
+        *out++ = digits[0];
+        if (digit_count > 1)
+        {
+            *out++ = '.';
+            std::memcpy(out, digits + 1, size_t(digit_count - 1));
+            out += digit_count - 1;
+        }
+        *out++ = 'e';
+        *out++ = exponent < 0 ? '-' : '+';
+        int magnitude = std::abs(exponent);
+        if (magnitude >= 100)
+            *out++ = char('0' + magnitude / 100);
+        *out++ = char('0' + magnitude / 10 % 10);
+        *out++ = char('0' + magnitude % 10);
+    }
+    return out;
+}
+
+template<class T>
+std::string
+float_to_string(T value)
+{
+    char buffer[48];
+    return std::string(buffer, format_shortest_float(buffer, value));
 }
 
 #define ALIA_FLOAT_CONVERSIONS(T)                                              \
@@ -45,36 +558,103 @@ float_from_string(T* value, std::string const& str)
     }                                                                          \
     std::string to_string(T value)                                             \
     {                                                                          \
-        return value_to_string(value);                                         \
+        return float_to_string(value);                                         \
     }
 
 ALIA_FLOAT_CONVERSIONS(float)
 ALIA_FLOAT_CONVERSIONS(double)
 
+// Parse an integer, yielding its magnitude and sign.
+// This throws a validation_error if the string isn't an integer or its
+// magnitude doesn't fit in 64 bits.
+static void
+parse_integer_text(
+    std::string const& str, bool* negative, unsigned long long* magnitude)
+{
+    parsed_decimal_number number;
+    if (!parse_decimal_number(str, false, &number))
+        throw validation_error("This input expects an integer.");
+    if (number.digit_count > 20
+        || (number.digit_count > 19
+            && (number.mantissa > ~std::uint64_t(0) / 10
+                || number.mantissa * 10
+                       > ~std::uint64_t(0)
+                             - unsigned(*(number.digits_end - 1) - '0'))))
+    {
+        throw validation_error("This integer is outside the supported range.");
+    }
+    unsigned long long n = number.mantissa;
+    if (number.digit_count == 20)
+        n = n * 10 + unsigned(*(number.digits_end - 1) - '0');
+    *negative = number.negative;
+    *magnitude = n;
+}
+
 template<class T>
 void
 signed_integer_from_string(T* value, std::string const& str)
 {
-    long long n;
-    if (!string_to_value(str, &n))
-        throw validation_error("This input expects an integer.");
-    T x = T(n);
-    if (x != n)
+    bool negative;
+    unsigned long long magnitude;
+    parse_integer_text(str, &negative, &magnitude);
+    typedef std::make_unsigned_t<T> unsigned_type;
+    unsigned long long limit = negative ? (unsigned long long)(
+                                   unsigned_type(std::numeric_limits<T>::max()))
+                                              + 1
+                                        : (unsigned long long)(
+                                            std::numeric_limits<T>::max());
+    if (magnitude > limit)
         throw validation_error("This integer is outside the supported range.");
-    *value = x;
+    // (This is done so that the minimum value doesn't overflow.)
+    *value = negative && magnitude != 0
+                 ? T(-static_cast<long long>(magnitude - 1) - 1)
+                 : T(magnitude);
 }
 
 template<class T>
 void
 unsigned_integer_from_string(T* value, std::string const& str)
 {
-    unsigned long long n;
-    if (!string_to_value(str, &n))
-        throw validation_error("This input expects an integer.");
-    T x = T(n);
-    if (x != n)
+    bool negative;
+    unsigned long long magnitude;
+    parse_integer_text(str, &negative, &magnitude);
+    if ((negative && magnitude != 0)
+        || magnitude > std::numeric_limits<T>::max())
+    {
         throw validation_error("This integer is outside the supported range.");
-    *value = x;
+    }
+    *value = T(magnitude);
+}
+
+template<class T>
+std::string
+signed_integer_to_string(T value)
+{
+    char buffer[24];
+    char* end = buffer + sizeof(buffer);
+    char* begin;
+    if (value < 0)
+    {
+        // (This avoids overflow when negating the minimum value.)
+        begin = format_unsigned_integer(
+            end, 0 - static_cast<unsigned long long>(value));
+        *--begin = '-';
+    }
+    else
+    {
+        begin = format_unsigned_integer(
+            end, static_cast<unsigned long long>(value));
+    }
+    return std::string(begin, end);
+}
+
+template<class T>
+std::string
+unsigned_integer_to_string(T value)
+{
+    char buffer[24];
+    char* end = buffer + sizeof(buffer);
+    return std::string(format_unsigned_integer(end, value), end);
 }
 
 #define ALIA_SIGNED_INTEGER_CONVERSIONS(T)                                     \
@@ -84,7 +664,7 @@ unsigned_integer_from_string(T* value, std::string const& str)
     }                                                                          \
     std::string to_string(T value)                                             \
     {                                                                          \
-        return value_to_string(value);                                         \
+        return signed_integer_to_string(value);                                \
     }
 
 #define ALIA_UNSIGNED_INTEGER_CONVERSIONS(T)                                   \
@@ -94,7 +674,7 @@ unsigned_integer_from_string(T* value, std::string const& str)
     }                                                                          \
     std::string to_string(T value)                                             \
     {                                                                          \
-        return value_to_string(value);                                         \
+        return unsigned_integer_to_string(value);                              \
     }
 
 ALIA_SIGNED_INTEGER_CONVERSIONS(short int)
@@ -106,6 +686,352 @@ ALIA_UNSIGNED_INTEGER_CONVERSIONS(unsigned long int)
 ALIA_SIGNED_INTEGER_CONVERSIONS(long long int)
 ALIA_UNSIGNED_INTEGER_CONVERSIONS(unsigned long long int)
 
+// printf format compilation
+
+static void
+add_printf_literal(printf_format& format, char const* begin, char const* end)
+{
+    if (begin == end)
+        return;
+    // Merge adjacent literals.
+    if (!format.segments.empty() && format.segments.back().is_literal)
+    {
+        format.segments.back().literal_length += size_t(end - begin);
+    }
+    else
+    {
+        printf_segment segment;
+        segment.is_literal = true;
+        segment.literal_offset = format.literals.size();
+        segment.literal_length = size_t(end - begin);
+        format.segments.push_back(std::move(segment));
+    }
+    format.literals.append(begin, end);
+}
+
+static bool
+is_printf_integer_conversion(char c)
+{
+    return c != '\0' && std::strchr("diouxX", c) != nullptr;
+}
+
+static bool
+is_printf_floating_conversion(char c)
+{
+    return c != '\0' && std::strchr("fFeEgGaA", c) != nullptr;
+}
+
+// Get the size of the integer type that the length modifiers specify.
+static unsigned char
+get_printf_integer_modifier_size(std::string const& modifiers)
+{
+    if (modifiers == "hh")
+        return sizeof(char);
+    if (modifiers == "h")
+        return sizeof(short);
+    if (modifiers == "l")
+        return sizeof(long);
+    if (modifiers == "ll")
+        return sizeof(long long);
+    if (modifiers == "j")
+        return sizeof(std::intmax_t);
+    if (modifiers == "z")
+        return sizeof(size_t);
+    if (modifiers == "t")
+        return sizeof(std::ptrdiff_t);
+    return 0;
+}
+
+void
+compile_printf_format(printf_format& format, char const* text)
+{
+    format.segments.clear();
+    format.literals.clear();
+    format.argument_count = 0;
+
+    char const* p = text;
+    char const* literal_start = p;
+    while (*p)
+    {
+        if (*p != '%')
+        {
+            ++p;
+            continue;
+        }
+        add_printf_literal(format, literal_start, p);
+        ++p;
+        if (*p == '%')
+        {
+            literal_start = p;
+            ++p;
+            continue;
+        }
+
+        printf_segment segment;
+        segment.is_literal = false;
+        segment.literal_offset = segment.literal_length = 0;
+        segment.argument_index = format.argument_count;
+        segment.star_count = 0;
+        segment.spec = "%";
+        char const* options_start = p;
+        // flags
+        while (*p && std::strchr("-+ #0", *p))
+            segment.spec += *p++;
+        // width
+        if (*p == '*')
+        {
+            ++segment.star_count;
+            segment.spec += *p++;
+        }
+        else
+        {
+            while (is_text_digit(*p))
+                segment.spec += *p++;
+        }
+        // precision
+        if (*p == '.')
+        {
+            segment.spec += *p++;
+            if (*p == '*')
+            {
+                ++segment.star_count;
+                segment.spec += *p++;
+            }
+            else
+            {
+                while (is_text_digit(*p))
+                    segment.spec += *p++;
+            }
+        }
+        segment.is_plain = p == options_start;
+        // length modifiers (which are replaced below to match the erased
+        // argument types, but are still honored when formatting integers)
+        char const* modifiers_start = p;
+        while (*p && std::strchr("hlLjzt", *p))
+            ++p;
+        segment.integer_size = get_printf_integer_modifier_size(
+            std::string(modifiers_start, p));
+        char conversion = *p;
+        if (is_printf_integer_conversion(conversion))
+            segment.spec += "ll";
+        else if (
+            !is_printf_floating_conversion(conversion)
+            && (conversion == '\0' || !std::strchr("csp", conversion)))
+        {
+            // This includes %n, which is deliberately unsupported.
+            throw printf_format_error();
+        }
+        segment.spec += conversion;
+        segment.conversion = conversion;
+        ++p;
+
+        format.argument_count += size_t(segment.star_count) + 1;
+        format.segments.push_back(std::move(segment));
+        literal_start = p;
+    }
+    add_printf_literal(format, literal_start, p);
+}
+
+// printf formatting
+
+static int
+get_printf_star_argument(printf_argument const& arg)
+{
+    switch (arg.type)
+    {
+        case printf_argument::kind::SIGNED:
+            return int(arg.signed_value);
+        case printf_argument::kind::UNSIGNED:
+            return int(arg.unsigned_value);
+        default:
+            throw printf_format_error();
+    }
+}
+
+// Format a single conversion with snprintf, appending it to :output.
+template<class Value>
+void
+append_printf_conversion(
+    std::string& output,
+    printf_segment const& segment,
+    int const* stars,
+    Value value)
+{
+    size_t start = output.size();
+    // Use whatever capacity the output already has (but at least a little).
+    size_t available = std::max(output.capacity(), start + 32) - start;
+    while (true)
+    {
+        output.resize(start + available);
+        char* buffer = &output[start];
+        // (The string's terminator isn't considered part of the buffer.)
+        int length;
+        switch (segment.star_count)
+        {
+            case 0:
+                length = std::snprintf(
+                    buffer, available, segment.spec.c_str(), value);
+                break;
+            case 1:
+                length = std::snprintf(
+                    buffer, available, segment.spec.c_str(), stars[0], value);
+                break;
+            default:
+                length = std::snprintf(
+                    buffer,
+                    available,
+                    segment.spec.c_str(),
+                    stars[0],
+                    stars[1],
+                    value);
+                break;
+        }
+        if (length < 0)
+            throw printf_format_error();
+        if (size_t(length) < available)
+        {
+            output.resize(start + size_t(length));
+            return;
+        }
+        available = size_t(length) + 1;
+    }
+}
+
+void
+format_printf(
+    std::string& output,
+    printf_format const& format,
+    printf_argument const* arguments,
+    size_t argument_count)
+{
+    if (argument_count < format.argument_count)
+        throw printf_format_error();
+
+    output.clear();
+    for (auto const& segment : format.segments)
+    {
+        if (segment.is_literal)
+        {
+            output.append(
+                format.literals,
+                segment.literal_offset,
+                segment.literal_length);
+            continue;
+        }
+
+        printf_argument const* arg = arguments + segment.argument_index;
+        int stars[2];
+        for (int i = 0; i != segment.star_count; ++i)
+            stars[i] = get_printf_star_argument(*arg++);
+
+        char c = segment.conversion;
+        bool is_integer = arg->type == printf_argument::kind::SIGNED
+                          || arg->type == printf_argument::kind::UNSIGNED;
+        if (c == 's')
+        {
+            if (arg->type != printf_argument::kind::STRING)
+                throw printf_format_error();
+            char const* s = arg->string_value ? arg->string_value : "(null)";
+            if (segment.is_plain)
+                output.append(s);
+            else
+                append_printf_conversion(output, segment, stars, s);
+        }
+        else if (c == 'p')
+        {
+            if (arg->type != printf_argument::kind::POINTER
+                && arg->type != printf_argument::kind::STRING)
+            {
+                throw printf_format_error();
+            }
+            append_printf_conversion(
+                output, segment, stars, arg->pointer_value);
+        }
+        else if (c == 'c')
+        {
+            if (!is_integer)
+                throw printf_format_error();
+            int value = arg->type == printf_argument::kind::SIGNED
+                            ? int(arg->signed_value)
+                            : int(arg->unsigned_value);
+            if (segment.is_plain)
+                output.push_back(char(value));
+            else
+                append_printf_conversion(output, segment, stars, value);
+        }
+        else if (is_printf_floating_conversion(c))
+        {
+            // Integers are accepted here (and converted) for convenience.
+            double value;
+            if (arg->type == printf_argument::kind::FLOATING)
+                value = arg->floating_value;
+            else if (arg->type == printf_argument::kind::SIGNED)
+                value = double(arg->signed_value);
+            else if (arg->type == printf_argument::kind::UNSIGNED)
+                value = double(arg->unsigned_value);
+            else
+                throw printf_format_error();
+            append_printf_conversion(output, segment, stars, value);
+        }
+        else
+        {
+            if (!is_integer)
+                throw printf_format_error();
+            bool is_signed_conversion = c == 'd' || c == 'i';
+            // Reduce the value to the width that printf would see: the type
+            // named by the length modifier, or else the argument's own type
+            // (after promotion to int).
+            unsigned size = segment.integer_size;
+            if (size == 0)
+                size = std::max(unsigned(arg->size), unsigned(sizeof(int)));
+            unsigned long long bits
+                = arg->type == printf_argument::kind::SIGNED
+                      ? static_cast<unsigned long long>(arg->signed_value)
+                      : arg->unsigned_value;
+            long long signed_value;
+            if (size < sizeof(bits))
+            {
+                unsigned long long sign_bit = 1ull << (size * 8 - 1);
+                bits &= (sign_bit << 1) - 1;
+                signed_value
+                    = (bits & sign_bit)
+                          ? -static_cast<long long>((sign_bit << 1) - bits)
+                          : static_cast<long long>(bits);
+            }
+            else
+            {
+                signed_value = static_cast<long long>(bits);
+            }
+            if (segment.is_plain && (is_signed_conversion || c == 'u'))
+            {
+                // Format plain decimal integers directly.
+                char buffer[24];
+                char* end = buffer + sizeof(buffer);
+                char* begin;
+                if (is_signed_conversion && signed_value < 0)
+                {
+                    begin = format_unsigned_integer(
+                        end, 0 - static_cast<unsigned long long>(signed_value));
+                    *--begin = '-';
+                }
+                else
+                {
+                    begin = format_unsigned_integer(end, bits);
+                }
+                output.append(begin, end);
+            }
+            else if (is_signed_conversion)
+            {
+                append_printf_conversion(output, segment, stars, signed_value);
+            }
+            else
+            {
+                append_printf_conversion(output, segment, stars, bits);
+            }
+        }
+    }
+}
+
 void
 from_string(std::string* value, std::string const& str)
 {
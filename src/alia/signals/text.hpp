@@ -6,6 +6,9 @@
 #include <alia/signals/basic.hpp>
 
 #include <cstdio>
+#include <string>
+#include <type_traits>
+#include <vector>
 
 namespace alia {
 
@@ -32,33 +35,299 @@ struct printf_format_error : exception
     }
 };
 
+// Format :args according to :format (using snprintf) and return the result.
+// (printf signals no longer use this, since they compile their formats, but it
+// remains available for one-off formatting.)
 template<class... Args>
 std::string
 invoke_snprintf(std::string const& format, Args const&... args)
 {
-    int length
-        = std::snprintf(0, 0, format.c_str(), make_printf_friendly(args)...);
+    // Try formatting into a local buffer first, since that's usually enough.
+    char buffer[256];
+    int length = std::snprintf(
+        buffer, sizeof(buffer), format.c_str(), make_printf_friendly(args)...);
     if (length < 0)
         throw printf_format_error();
+    if (length < int(sizeof(buffer)))
+        return std::string(buffer, buffer + length);
     std::string s;
-    if (length > 0)
+    s.resize(length);
+    std::snprintf(
+        &s[0], length + 1, format.c_str(), make_printf_friendly(args)...);
+    return s;
+}
+
+// printf_argument is a type-erased argument to a compiled printf format.
+struct printf_argument
+{
+    enum class kind
+    {
+        SIGNED,
+        UNSIGNED,
+        FLOATING,
+        STRING,
+        POINTER
+    };
+    kind type;
+    // for integers, the size (in bytes) of the original argument type
+    unsigned char size;
+    union
+    {
+        long long signed_value;
+        unsigned long long unsigned_value;
+        double floating_value;
+        char const* string_value;
+        void const* pointer_value;
+    };
+};
+
+template<class Integer>
+std::enable_if_t<
+    std::is_integral<Integer>::value && std::is_signed<Integer>::value,
+    printf_argument>
+make_printf_argument(Integer x)
+{
+    printf_argument arg;
+    arg.type = printf_argument::kind::SIGNED;
+    arg.size = sizeof(Integer);
+    arg.signed_value = x;
+    return arg;
+}
+template<class Integer>
+std::enable_if_t<
+    std::is_integral<Integer>::value && !std::is_signed<Integer>::value,
+    printf_argument>
+make_printf_argument(Integer x)
+{
+    printf_argument arg;
+    arg.type = printf_argument::kind::UNSIGNED;
+    arg.size = sizeof(Integer);
+    arg.unsigned_value = x;
+    return arg;
+}
+template<class Enum>
+std::enable_if_t<std::is_enum<Enum>::value, printf_argument>
+make_printf_argument(Enum x)
+{
+    return make_printf_argument(std::underlying_type_t<Enum>(x));
+}
+template<class Float>
+std::enable_if_t<std::is_floating_point<Float>::value, printf_argument>
+make_printf_argument(Float x)
+{
+    printf_argument arg;
+    arg.type = printf_argument::kind::FLOATING;
+    arg.floating_value = double(x);
+    return arg;
+}
+inline printf_argument
+make_printf_argument(char const* x)
+{
+    printf_argument arg;
+    arg.type = printf_argument::kind::STRING;
+    arg.string_value = x;
+    return arg;
+}
+template<class T>
+std::enable_if_t<
+    !std::is_same<std::remove_cv_t<T>, char>::value,
+    printf_argument>
+make_printf_argument(T* x)
+{
+    printf_argument arg;
+    arg.type = printf_argument::kind::POINTER;
+    arg.pointer_value = x;
+    return arg;
+}
+
+// printf_format is a printf format string that's been parsed into a list of
+// segments (literal text and conversions), so that it can be applied to
+// arguments repeatedly without being reparsed.
+struct printf_segment
+{
+    // If this is a literal segment, this is its range within
+    // printf_format::literals.
+    bool is_literal;
+    size_t literal_offset, literal_length;
+
+    // Otherwise, this is the conversion...
+    char conversion;
+    // the index of its first argument
+    size_t argument_index;
+    // the number of '*' (width/precision) arguments that precede its value
+    int star_count;
+    // Does it have any flags, width or precision?
+    bool is_plain;
+    // for integer conversions, the size (in bytes) of the type that the length
+    // modifier specifies (or 0 if there's no modifier)
+    unsigned char integer_size;
+    // the conversion specification to pass to snprintf
+    // (This is normalized to match the type-erased arguments.)
+    std::string spec;
+};
+
+struct printf_format
+{
+    std::vector<printf_segment> segments;
+    std::string literals;
+    // the number of arguments that the format consumes
+    size_t argument_count = 0;
+};
+
+// Parse a printf format string.
+// This throws a printf_format_error if the format is invalid.
+void
+compile_printf_format(printf_format& format, char const* text);
+
+// Apply a compiled format to a list of arguments, replacing the contents of
+// :output. (The output string's storage is reused.)
+// This throws a printf_format_error if the arguments don't match the format.
+void
+format_printf(
+    std::string& output,
+    printf_format const& format,
+    printf_argument const* arguments,
+    size_t argument_count);
+
+// printf(ctx, format, args...) yields a signal carrying the result of
+// formatting the values of :args according to :format.
+// The format is only parsed when its value ID changes, and the result is only
+// updated when the formatted text actually changes, so the signal's value ID
+// (and the storage for the text) is stable otherwise.
+
+template<size_t ArgumentCount>
+struct printf_data
+{
+    // the IDs of the format and the arguments, as last seen
+    captured_id ids[ArgumentCount + 1];
+    printf_format format;
+    bool format_valid = false;
+    // The text is formatted into scratch and then swapped into output if it's
+    // different.
+    std::string output, scratch;
+    bool output_valid = false;
+    counter_type output_version = 0;
+};
+
+template<size_t ArgumentCount>
+struct printf_signal : signal<
+                           printf_signal<ArgumentCount>,
+                           std::string,
+                           read_only_signal>
+{
+    printf_signal(printf_data<ArgumentCount>& data) : data_(&data)
     {
-        s.resize(length);
-        std::snprintf(
-            &s[0], length + 1, format.c_str(), make_printf_friendly(args)...);
     }
-    return s;
+    id_interface const&
+    value_id() const
+    {
+        id_ = make_id(data_->output_version);
+        return id_;
+    }
+    bool
+    has_value() const
+    {
+        return data_->output_valid;
+    }
+    std::string const&
+    read() const
+    {
+        return data_->output;
+    }
+
+ private:
+    printf_data<ArgumentCount>* data_;
+    mutable simple_id<counter_type> id_;
+};
+
+inline bool
+printf_signals_have_values()
+{
+    return true;
+}
+template<class Signal, class... Rest>
+bool
+printf_signals_have_values(Signal const& signal, Rest const&... rest)
+{
+    return signal_has_value(signal) && printf_signals_have_values(rest...);
+}
+
+// Capture the IDs of the given signals, returning true if any changed.
+inline bool
+capture_printf_ids(captured_id*)
+{
+    return false;
+}
+template<class Signal, class... Rest>
+bool
+capture_printf_ids(captured_id* ids, Signal const& signal, Rest const&... rest)
+{
+    bool changed = !ids->matches(signal.value_id());
+    if (changed)
+        ids->capture(signal.value_id());
+    return capture_printf_ids(ids + 1, rest...) || changed;
+}
+
+template<size_t ArgumentCount, class FormatSignal, class... ArgSignals>
+void
+update_printf(
+    printf_data<ArgumentCount>& data,
+    FormatSignal const& format,
+    ArgSignals const&... args)
+{
+    if (!printf_signals_have_values(format, args...))
+    {
+        data.output_valid = false;
+        // Forget the IDs so that the output is regenerated when the values
+        // return.
+        for (auto& id : data.ids)
+            id.clear();
+        return;
+    }
+    bool format_changed = !data.ids[0].matches(format.value_id());
+    if (!capture_printf_ids(data.ids, format, args...))
+        return;
+    try
+    {
+        if (format_changed)
+        {
+            data.format_valid = false;
+            compile_printf_format(
+                data.format, make_printf_friendly(read_signal(format)));
+            data.format_valid = true;
+        }
+        else if (!data.format_valid)
+        {
+            throw printf_format_error();
+        }
+        printf_argument arguments[ArgumentCount + 1] = {
+            make_printf_argument(make_printf_friendly(read_signal(args)))...};
+        format_printf(data.scratch, data.format, arguments, ArgumentCount);
+    }
+    catch (printf_format_error&)
+    {
+        data.output_valid = false;
+        return;
+    }
+    // Only update the output if it actually changed. (Swapping keeps the
+    // storage of both strings around for reuse.)
+    if (!data.output_valid || data.scratch != data.output)
+    {
+        swap(data.output, data.scratch);
+        ++data.output_version;
+    }
+    data.output_valid = true;
 }
 
 template<class Format, class... Args>
-auto
+printf_signal<sizeof...(Args)>
 printf(context ctx, Format format, Args... args)
 {
-    return apply(
-        ctx,
-        ALIA_LAMBDIFY(invoke_snprintf),
-        signalize(format),
-        signalize(args)...);
+    printf_data<sizeof...(Args)>* data;
+    get_cached_data(ctx, &data);
+    if (is_refresh_event(ctx))
+        update_printf(*data, signalize(format), signalize(args)...);
+    return printf_signal<sizeof...(Args)>(*data);
 }
 
 // All conversion of values to and from text goes through the functions
@@ -184,12 +453,17 @@ struct duplex_text_signal : signal<
     }
     void
     write(std::string const& s) const
+    {
+        write(std::string(s));
+    }
+    void
+    write(std::string&& s) const
     {
         typename Wrapped::value_type value;
         from_string(&value, s);
         data_->input_value = value;
-        wrapped_.write(value);
-        data_->output_text = s;
+        wrapped_.write(std::move(value));
+        data_->output_text = std::move(s);
         ++data_->output_version;
     }
 
@@ -8,9 +8,22 @@
 
 namespace alia {
 
+// type_prefers_hashed_id<Value>::value indicates whether or not signals that
+// would identify values of type Value by the values themselves should instead
+// identify them by their stable hashes (see stable_hash_traits). This is false
+// by default. Specialize it for large value types that are expensive to copy
+// (e.g., because they own many separate allocations). (Note that equal hashes
+// are taken to mean equal values, so a hash collision would cause a change to
+// be missed.)
+template<class Value>
+struct type_prefers_hashed_id : std::false_type
+{
+};
+
 // regular_signal is a partial implementation of the signal interface for
-// cases where the value ID of the signal is simply the value itself.
-template<class Derived, class Value, class Direction>
+// cases where the value ID of the signal is simply the value itself (or, if
+// type_prefers_hashed_id says so, the stable hash of the value).
+template<class Derived, class Value, class Direction, class = void>
 struct regular_signal : signal<Derived, Value, Direction>
 {
     id_interface const&
@@ -28,6 +41,29 @@ struct regular_signal : signal<Derived, Value, Direction>
     mutable simple_id_by_reference<Value> id_;
 };
 
+template<class Derived, class Value, class Direction>
+struct regular_signal<
+    Derived,
+    Value,
+    Direction,
+    std::enable_if_t<type_prefers_hashed_id<Value>::value>>
+    : signal<Derived, Value, Direction>
+{
+    id_interface const&
+    value_id() const
+    {
+        if (this->has_value())
+        {
+            id_ = make_id(get_stable_hash(this->read()));
+            return id_;
+        }
+        return null_id;
+    }
+
+ private:
+    mutable simple_id<std::uint64_t> id_;
+};
+
 // lazy_reader is used to create signals that lazily generate their values.
 // It provides storage for the computed value and ensures that it's only
 // computed once.
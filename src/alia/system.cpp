@@ -3,27 +3,131 @@
 #include <chrono>
 
 #include <alia/flow/events.hpp>
+#include <alia/tracing.hpp>
 
 namespace alia {
 
-millisecond_count
-get_default_tick_count()
+microsecond_count
+get_default_precise_tick_count()
 {
     static auto start = std::chrono::steady_clock::now();
     auto now = std::chrono::steady_clock::now();
     return std::chrono::duration_cast<
-               std::chrono::duration<millisecond_count, std::milli>>(
+               std::chrono::duration<microsecond_count, std::micro>>(
                now - start)
         .count();
 }
 
+millisecond_count
+get_default_tick_count()
+{
+    return millisecond_count(get_default_precise_tick_count() / 1000);
+}
+
+microsecond_count
+get_precise_tick_count(system const& sys)
+{
+    if (sys.clock)
+        return sys.clock->get_precise_tick_count();
+    if (sys.external)
+        return sys.external->get_precise_tick_count();
+    return get_default_precise_tick_count();
+}
+
+static void
+delete_posted_closures(posted_closure* list)
+{
+    while (list)
+    {
+        posted_closure* next = list->next;
+        delete list;
+        list = next;
+    }
+}
+
+system::~system()
+{
+    delete_posted_closures(unrun_closures);
+    delete_posted_closures(posted_closures.load(std::memory_order_acquire));
+}
+
 void
 refresh_system(system& sys)
 {
+    scoped_trace_span span(sys.tracer, "refresh_system", "alia");
+
     sys.refresh_needed = false;
+    sys.refresh_requested.store(false, std::memory_order_relaxed);
 
     refresh_event refresh;
     impl::dispatch_event(sys, refresh);
 }
 
+void
+request_refresh(system& sys)
+{
+    sys.refresh_requested.store(true, std::memory_order_release);
+    if (sys.external)
+        sys.external->wake();
+}
+
+void
+post_to_system(system& sys, std::function<void(system&)> closure)
+{
+    posted_closure* node = new posted_closure{std::move(closure), nullptr};
+    node->next = sys.posted_closures.load(std::memory_order_relaxed);
+    while (!sys.posted_closures.compare_exchange_weak(
+        node->next, node, std::memory_order_release, std::memory_order_relaxed))
+    {
+    }
+    // The flag is set after the closure is pushed, so if update_system clears
+    // the flag before it takes the closures, it will either see this closure
+    // or see the flag set again on its next call.
+    request_refresh(sys);
+}
+
+bool
+update_system(system& sys)
+{
+    bool requested
+        = sys.refresh_requested.exchange(false, std::memory_order_acq_rel);
+
+    // Take all the posted closures and reverse them so that they run in the
+    // order in which they were posted.
+    posted_closure* stack
+        = sys.posted_closures.exchange(nullptr, std::memory_order_acquire);
+    posted_closure* queue = nullptr;
+    while (stack)
+    {
+        posted_closure* next = stack->next;
+        stack->next = queue;
+        queue = stack;
+        stack = next;
+    }
+    // They go after any that are left over.
+    posted_closure** tail = &sys.unrun_closures;
+    while (*tail)
+        tail = &(*tail)->next;
+    *tail = queue;
+    // Closures always come with a refresh, but their requests may have already
+    // been consumed (by an earlier call or an intervening refresh_system).
+    if (sys.unrun_closures)
+        requested = true;
+
+    // If a closure throws, the rest stay queued for the next call.
+    while (sys.unrun_closures)
+    {
+        std::unique_ptr<posted_closure> closure(sys.unrun_closures);
+        sys.unrun_closures = closure->next;
+        closure->closure(sys);
+    }
+
+    if (requested || sys.refresh_needed)
+    {
+        refresh_system(sys);
+        return true;
+    }
+    return false;
+}
+
 } // namespace alia
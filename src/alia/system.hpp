@@ -1,6 +1,7 @@
 #ifndef ALIA_SYSTEM_HPP
 #define ALIA_SYSTEM_HPP
 
+#include <atomic>
 #include <functional>
 
 #include <alia/context/interface.hpp>
@@ -9,8 +10,11 @@
 
 namespace alia {
 
+// the default clock (based on std::chrono::steady_clock)
 millisecond_count
 get_default_tick_count();
+microsecond_count
+get_default_precise_tick_count();
 
 struct external_interface
 {
@@ -20,32 +24,147 @@ struct external_interface
     {
     }
 
+    // alia calls this after a refresh when something (e.g., an animation
+    // timer) needs the system to be refreshed again at the given tick count,
+    // but nothing needs to be refreshed before then. Hosts that support this
+    // can sleep until then and should return true.
+    //
+    // If this returns false (as the default implementation does), alia falls
+    // back to requesting an animation refresh, so the host keeps refreshing
+    // every frame until the deadline passes.
+    virtual bool
+    schedule_refresh_at(millisecond_count /*tick*/)
+    {
+        return false;
+    }
+
     // Get the current value of the system's millisecond tick counter.
-    // The default implementation of this uses std::chrono::steady_clock.
+    // This is the host's clock: unless get_precise_tick_count is also
+    // overridden, alia times everything with it. The default implementation
+    // uses std::chrono::steady_clock.
     virtual millisecond_count
     get_tick_count() const
     {
         return get_default_tick_count();
     }
+
+    // Get the current value of the system's microsecond tick counter.
+    // alia uses this (rather than get_tick_count) to time its traversals.
+    // The default implementation derives it from get_tick_count, so hosts
+    // that only provide a millisecond clock remain consistent. Hosts with a
+    // higher resolution clock can opt in to it by overriding this (and
+    // should keep get_tick_count consistent with it).
+    //
+    // (Note that a system's clock, if set, takes precedence over both of
+    // these. See system::clock.)
+    virtual microsecond_count
+    get_precise_tick_count() const
+    {
+        return microsecond_count(get_tick_count()) * 1000;
+    }
+
+    // alia calls this when a refresh is requested or work is posted to the
+    // system from another thread (see post_to_system). It can be used to wake
+    // up the host's event loop. Note that this may be called from any thread.
+    virtual void
+    wake()
+    {
+    }
 };
 
-struct system
+struct traversal_profiler;
+struct trace_event_sink;
+struct event_recorder;
+struct event_replayer;
+struct animation_engine;
+
+struct system;
+
+// a closure that's been posted to a system from another thread
+struct posted_closure
 {
+    std::function<void(system&)> closure;
+    posted_closure* next;
+};
+
+struct system : noncopyable
+{
+    ~system();
+
     data_graph data;
     std::function<void(context)> controller;
     bool refresh_needed = false;
+    // If the last refresh scheduled a future refresh (see
+    // external_interface::schedule_refresh_at), this is the tick count for it.
+    bool has_refresh_deadline = false;
+    millisecond_count refresh_deadline = 0;
     external_interface* external = nullptr;
+    // If this is set, it's used as the system's clock instead of the external
+    // interface. (This is mainly intended for plugging in a virtual_clock.)
+    tick_source* clock = nullptr;
+    // If this is set, refresh passes are profiled (as frames) using this
+    // profiler. (See flow/profiling.hpp.)
+    traversal_profiler* profiler = nullptr;
+    // If this is set, the system's activity is recorded to this trace.
+    // (See tracing.hpp.)
+    trace_event_sink* tracer = nullptr;
+    // If these are set, the system's activity is recorded/replayed.
+    // (See flow/recording.hpp.)
+    event_recorder* recorder = nullptr;
+    event_replayer* replayer = nullptr;
+    // If this is set, animated transitions are evaluated in batches by this
+    // engine. (See timing/animation_engine.hpp.)
+    animation_engine* animations = nullptr;
+    // closures that update_system has taken but not yet run (because an
+    // earlier one threw) - This is a queue, in the order they were posted.
+    posted_closure* unrun_closures = nullptr;
+
+    // These are the only members that can safely be accessed from other
+    // threads. (See request_refresh and post_to_system.)
+    std::atomic<bool> refresh_requested{false};
+    // the closures posted to the system that haven't been run yet
+    // (This is a lock-free stack, so it's in reverse order.)
+    std::atomic<posted_closure*> posted_closures{nullptr};
 };
 
 inline bool
 system_needs_refresh(system const& sys)
 {
-    return sys.refresh_needed;
+    return sys.refresh_needed
+           || sys.refresh_requested.load(std::memory_order_acquire)
+           || sys.unrun_closures
+           || sys.posted_closures.load(std::memory_order_acquire);
 }
 
+// Get the current value of the clock that's driving :sys.
+microsecond_count
+get_precise_tick_count(system const& sys);
+
 void
 refresh_system(system& sys);
 
+// Request that the system be refreshed soon.
+// Unlike everything else here, this is safe to call from any thread.
+void
+request_refresh(system& sys);
+
+// Post a closure to be run on the system's thread (along with a refresh).
+// This is safe to call from any thread. It's intended for background
+// producers that need to mutate application state.
+void
+post_to_system(system& sys, std::function<void(system&)> closure);
+
+// Run any closures that have been posted to the system (in the order in which
+// they were posted) and then, if the system needs a refresh for any reason,
+// refresh it. All pending requests are coalesced into a single refresh.
+// If a closure throws, the exception is propagated, and the closures after it
+// remain queued for the next call.
+// This is intended to be called from the host's event loop (e.g., when it's
+// woken up via external_interface::wake).
+// The return value indicates whether or not the system was refreshed.
+bool
+update_system(system& sys);
+
 } // namespace alia
 
 #endif
@@ -0,0 +1,185 @@
+#include <alia/timing/animation_engine.hpp>
+
+#include <algorithm>
+
+#include <alia/system.hpp>
+#include <alia/timing/smoothing.hpp>
+
+namespace alia {
+
+static animation_group&
+get_animation_group(
+    animation_engine& engine,
+    unit_cubic_bezier const& curve,
+    millisecond_count duration)
+{
+    // There are typically only a handful of distinct transitions in an
+    // application, so a linear search is fine here.
+    for (auto const& group : engine.groups)
+    {
+        if (group->curve == curve && group->duration == duration)
+            return *group;
+    }
+
+    std::unique_ptr<animation_group> group(new animation_group);
+    group->curve = curve;
+    group->duration = duration;
+    animation_curve_table const* builtin = get_builtin_curve_table(curve);
+    group->table = builtin ? *builtin : compile_curve<64>(curve);
+    group->use_table
+        = duration == 0 || group->table.max_error <= 1. / duration;
+    engine.groups.push_back(std::move(group));
+    return *engine.groups.back();
+}
+
+void
+acquire_animation_slot(
+    animation_engine& engine,
+    animation_slot& slot,
+    unit_cubic_bezier const& curve,
+    millisecond_count duration)
+{
+    release_animation_slot(slot);
+    animation_group& group = get_animation_group(engine, curve, duration);
+    if (group.free_slots.empty())
+    {
+        slot.index = group.values.size();
+        group.end_ticks.push_back(0);
+        group.inverse_durations.push_back(0);
+        group.from.push_back(0);
+        group.to.push_back(0);
+        group.values.push_back(0);
+        group.positions.push_back(0);
+    }
+    else
+    {
+        slot.index = group.free_slots.back();
+        group.free_slots.pop_back();
+    }
+    slot.group = &group;
+}
+
+void
+release_animation_slot(animation_slot& slot)
+{
+    if (slot.group)
+    {
+        stop_slot_transition(slot);
+        slot.group->free_slots.push_back(slot.index);
+        slot.group = nullptr;
+    }
+}
+
+animation_slot::~animation_slot()
+{
+    release_animation_slot(*this);
+}
+
+void
+start_slot_transition(
+    animation_slot& slot,
+    double from,
+    double to,
+    millisecond_count end_tick,
+    millisecond_count duration)
+{
+    animation_group& group = *slot.group;
+    std::size_t i = slot.index;
+    group.end_ticks[i] = end_tick;
+    group.inverse_durations[i] = duration != 0 ? 1. / duration : 0;
+    group.from[i] = from;
+    group.to[i] = to;
+    group.values[i] = from;
+    if (!slot.active)
+    {
+        slot.active = true;
+        ++group.active_count;
+    }
+}
+
+void
+stop_slot_transition(animation_slot& slot)
+{
+    if (slot.active)
+    {
+        animation_group& group = *slot.group;
+        std::size_t i = slot.index;
+        // Inactive slots are still advanced along with the active ones, so
+        // leave this one in a state where that's harmless.
+        group.inverse_durations[i] = 0;
+        group.from[i] = group.values[i] = group.to[i];
+        slot.active = false;
+        --group.active_count;
+    }
+}
+
+static void
+advance_animation_group(animation_group& group, millisecond_count tick)
+{
+    std::size_t const n = group.values.size();
+    millisecond_count const* end_ticks = group.end_ticks.data();
+    double const* inverse_durations = group.inverse_durations.data();
+    double const* from = group.from.data();
+    double const* to = group.to.data();
+    double* positions = group.positions.data();
+    double* values = group.values.data();
+
+    // Each of these loops is simple enough to be vectorized (except for the
+    // curve evaluation, which at least works on contiguous data).
+    // Free and inactive slots have an inverse duration of 0, so they're
+    // always at the end of their (degenerate) transitions.
+    for (std::size_t i = 0; i != n; ++i)
+    {
+        // (This handles wraparound the same way as the tick functions.)
+        double ticks_left = double(int(end_ticks[i] - tick));
+        double x = 1. - ticks_left * inverse_durations[i];
+        positions[i] = std::min(std::max(x, 0.), 1.);
+    }
+    if (group.use_table)
+    {
+        for (std::size_t i = 0; i != n; ++i)
+            positions[i] = eval_curve_at_x(group.table, positions[i]);
+    }
+    else
+    {
+        double const tolerance = 1. / group.duration;
+        for (std::size_t i = 0; i != n; ++i)
+        {
+            positions[i]
+                = eval_curve_at_x(group.curve, positions[i], tolerance);
+        }
+    }
+    for (std::size_t i = 0; i != n; ++i)
+        values[i] = from[i] + (to[i] - from[i]) * positions[i];
+}
+
+void
+advance_animation_engine(animation_engine& engine, millisecond_count tick)
+{
+    for (auto const& group : engine.groups)
+    {
+        if (group->active_count != 0)
+            advance_animation_group(*group, tick);
+    }
+}
+
+animation_engine_stats
+get_animation_engine_stats(animation_engine const& engine)
+{
+    animation_engine_stats stats;
+    stats.groups = engine.groups.size();
+    for (auto const& group : engine.groups)
+    {
+        stats.slots += group->values.size() - group->free_slots.size();
+        stats.active_transitions += group->active_count;
+    }
+    return stats;
+}
+
+animation_engine*
+get_animation_engine(dataless_context ctx)
+{
+    return ctx.get<system_tag>().animations;
+}
+
+} // namespace alia
@@ -0,0 +1,135 @@
+#ifndef ALIA_TIMING_ANIMATION_ENGINE_HPP
+#define ALIA_TIMING_ANIMATION_ENGINE_HPP
+
+#include <memory>
+#include <vector>
+
+#include <alia/context/interface.hpp>
+#include <alia/timing/cubic_bezier.hpp>
+
+// This file provides a system-level engine for evaluating many animated
+// transitions at once.
+//
+// Normally, each smooth() call evaluates its own transition as it's
+// traversed. When there are thousands of animated values, it's much more
+// efficient to store all the active transitions together (in
+// struct-of-arrays form) and advance them all in a few tight loops at the
+// start of each frame. Transitions are grouped by their curve and duration,
+// so each group can share a single curve table.
+//
+// To use the engine, create one and point the system at it (before the first
+// refresh):
+//
+//   animation_engine engine;
+//   alia::system sys;
+//   sys.animations = &engine;
+//
+// smooth() then automatically hands its (arithmetic) transitions to the
+// engine and reads the results back by slot index. Note that the engine must
+// outlive the system, since the system's data graph holds slots in it.
+
+namespace alia {
+
+// a group of transitions that share the same curve and duration
+struct animation_group : noncopyable
+{
+    unit_cubic_bezier curve;
+    millisecond_count duration;
+
+    // the table used to evaluate the curve
+    unit_cubic_bezier_table<64> table;
+    // If the table isn't accurate enough for the group's duration, the curve
+    // is solved directly instead.
+    bool use_table;
+
+    // the state of each transition in the group
+    // These are indexed by slot.
+    std::vector<millisecond_count> end_ticks;
+    std::vector<double> inverse_durations;
+    std::vector<double> from;
+    std::vector<double> to;
+    // the output for each transition (as of the last frame)
+    std::vector<double> values;
+
+    // scratch space for the curve positions of each transition
+    std::vector<double> positions;
+
+    // the slots that aren't in use
+    std::vector<std::size_t> free_slots;
+    // the number of slots that are currently transitioning
+    std::size_t active_count = 0;
+};
+
+struct animation_engine : noncopyable
+{
+    std::vector<std::unique_ptr<animation_group>> groups;
+};
+
+// A handle to a slot in an animation engine. Releasing the handle (or
+// destroying it) returns the slot to the engine.
+struct animation_slot : noncopyable
+{
+    animation_group* group = nullptr;
+    std::size_t index = 0;
+    bool active = false;
+
+    ~animation_slot();
+};
+
+// Acquire a slot for transitions with the given curve and duration.
+void
+acquire_animation_slot(
+    animation_engine& engine,
+    animation_slot& slot,
+    unit_cubic_bezier const& curve,
+    millisecond_count duration);
+
+void
+release_animation_slot(animation_slot& slot);
+
+// Start a transition in a slot.
+// The slot's value is :from until the engine is next advanced.
+// :duration is the actual duration of this transition (which can be shorter
+// than the group's).
+void
+start_slot_transition(
+    animation_slot& slot,
+    double from,
+    double to,
+    millisecond_count end_tick,
+    millisecond_count duration);
+
+// Stop the transition in a slot (leaving it at its target value).
+void
+stop_slot_transition(animation_slot& slot);
+
+// Get the current value of a slot.
+inline double
+read_animation_slot(animation_slot const& slot)
+{
+    return slot.group->values[slot.index];
+}
+
+// Advance all active transitions to the given tick count.
+// alia calls this at the start of every refresh pass.
+void
+advance_animation_engine(animation_engine& engine, millisecond_count tick);
+
+struct animation_engine_stats
+{
+    std::size_t groups = 0;
+    std::size_t slots = 0;
+    std::size_t active_transitions = 0;
+};
+
+animation_engine_stats
+get_animation_engine_stats(animation_engine const& engine);
+
+// Get the animation engine associated with a context (or null if there is
+// none).
+animation_engine*
+get_animation_engine(dataless_context ctx);
+
+} // namespace alia
+
+#endif
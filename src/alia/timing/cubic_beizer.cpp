@@ -4,41 +4,6 @@
 
 namespace alia {
 
-namespace {
-
-double
-sample_curve_x(unit_cubic_bezier_coefficients const& coeff, double t)
-{
-    return ((coeff.ax * t + coeff.bx) * t + coeff.cx) * t;
-}
-
-double
-sample_curve_y(unit_cubic_bezier_coefficients const& coeff, double t)
-{
-    return ((coeff.ay * t + coeff.by) * t + coeff.cy) * t;
-}
-
-double
-sample_curve_derivative(unit_cubic_bezier_coefficients const& coeff, double t)
-{
-    return (3 * coeff.ax * t + 2 * coeff.bx) * t + coeff.cx;
-}
-
-} // namespace
-
-unit_cubic_bezier_coefficients
-compute_curve_coefficients(unit_cubic_bezier const& bezier)
-{
-    unit_cubic_bezier_coefficients coeff;
-    coeff.cx = 3 * bezier.p1x;
-    coeff.bx = 3 * (bezier.p2x - bezier.p1x) - coeff.cx;
-    coeff.ax = 1 - coeff.cx - coeff.bx;
-    coeff.cy = 3 * bezier.p1y;
-    coeff.by = 3 * (bezier.p2y - bezier.p1y) - coeff.cy;
-    coeff.ay = 1 - coeff.cy - coeff.by;
-    return coeff;
-}
-
 double
 solve_for_t_at_x_with_bisection_search(
     unit_cubic_bezier_coefficients const& coeff,
@@ -17,8 +17,46 @@ struct unit_cubic_bezier_coefficients
     double ax, ay, bx, by, cx, cy;
 };
 
-unit_cubic_bezier_coefficients
-compute_curve_coefficients(unit_cubic_bezier const& bezier);
+constexpr unit_cubic_bezier_coefficients
+compute_curve_coefficients(unit_cubic_bezier const& bezier)
+{
+    unit_cubic_bezier_coefficients coeff{};
+    coeff.cx = 3 * bezier.p1x;
+    coeff.bx = 3 * (bezier.p2x - bezier.p1x) - coeff.cx;
+    coeff.ax = 1 - coeff.cx - coeff.bx;
+    coeff.cy = 3 * bezier.p1y;
+    coeff.by = 3 * (bezier.p2y - bezier.p1y) - coeff.cy;
+    coeff.ay = 1 - coeff.cy - coeff.by;
+    return coeff;
+}
+
+// Sample the x and y coordinates of a curve at t (and the derivatives of
+// them with respect to t).
+
+constexpr double
+sample_curve_x(unit_cubic_bezier_coefficients const& coeff, double t)
+{
+    return ((coeff.ax * t + coeff.bx) * t + coeff.cx) * t;
+}
+
+constexpr double
+sample_curve_y(unit_cubic_bezier_coefficients const& coeff, double t)
+{
+    return ((coeff.ay * t + coeff.by) * t + coeff.cy) * t;
+}
+
+constexpr double
+sample_curve_derivative(unit_cubic_bezier_coefficients const& coeff, double t)
+{
+    return (3 * coeff.ax * t + 2 * coeff.bx) * t + coeff.cx;
+}
+
+constexpr double
+sample_curve_y_derivative(
+    unit_cubic_bezier_coefficients const& coeff, double t)
+{
+    return (3 * coeff.ay * t + 2 * coeff.by) * t + coeff.cy;
+}
 
 // Solve for t at a point x in a unit cubic curve.
 // This should only be called on curves that are expressible in y = f(x) form.
@@ -43,6 +81,172 @@ double
 eval_curve_at_x(
     unit_cubic_bezier const& curve, double x, double error_tolerance);
 
+constexpr bool
+operator==(unit_cubic_bezier const& a, unit_cubic_bezier const& b)
+{
+    return a.p1x == b.p1x && a.p1y == b.p1y && a.p2x == b.p2x
+           && a.p2y == b.p2y;
+}
+constexpr bool
+operator!=(unit_cubic_bezier const& a, unit_cubic_bezier const& b)
+{
+    return !(a == b);
+}
+
+// Solving for t on every evaluation of a curve is relatively expensive, so
+// curves can also be compiled into tables of samples taken at evenly spaced
+// x values. Evaluating a table is just a lookup and an interpolation between
+// the neighboring samples, either linear or cubic Hermite (using the slope of
+// the curve at each sample).
+//
+// Tables can be computed at compile time (and are for the built-in animation
+// curves).
+
+enum class curve_interpolation
+{
+    LINEAR,
+    HERMITE
+};
+
+template<int Intervals>
+struct unit_cubic_bezier_table
+{
+    curve_interpolation interpolation;
+    // the y values and slopes (dy/dx) at x = i / Intervals
+    double y[Intervals + 1];
+    double slope[Intervals + 1];
+    // the maximum error of the table, as measured at several points within
+    // each interval (where the error of the interpolation is largest)
+    double max_error;
+};
+
+namespace impl {
+
+constexpr double
+curve_abs(double x)
+{
+    return x < 0 ? -x : x;
+}
+
+// This is a constexpr form of solve_for_t_at_x that solves to (nearly) the
+// limits of double precision.
+constexpr double
+solve_for_t_at_x_precisely(
+    unit_cubic_bezier_coefficients const& coeff, double x)
+{
+    double const tolerance = 1e-12;
+    double t = x;
+    for (int i = 0; i != 8; ++i)
+    {
+        double x_error = sample_curve_x(coeff, t) - x;
+        if (curve_abs(x_error) < tolerance)
+            return t;
+        double dx = sample_curve_derivative(coeff, t);
+        if (curve_abs(dx) < 1e-6)
+            break;
+        t -= x_error / dx;
+    }
+    double lower = 0, upper = 1;
+    t = x;
+    for (int i = 0; i != 64; ++i)
+    {
+        double x_at_t = sample_curve_x(coeff, t);
+        if (curve_abs(x_at_t - x) < tolerance)
+            break;
+        if (x > x_at_t)
+            lower = t;
+        else
+            upper = t;
+        t = (lower + upper) / 2;
+    }
+    return t;
+}
+
+} // namespace impl
+
+// Evaluate a compiled curve at the given x value.
+template<int Intervals>
+constexpr double
+eval_curve_at_x(unit_cubic_bezier_table<Intervals> const& table, double x)
+{
+    if (x <= 0)
+        return 0;
+    if (x >= 1)
+        return 1;
+    double scaled = x * Intervals;
+    int i = int(scaled);
+    if (i >= Intervals)
+        i = Intervals - 1;
+    double s = scaled - i;
+    double y0 = table.y[i], y1 = table.y[i + 1];
+    if (table.interpolation == curve_interpolation::LINEAR)
+        return y0 + (y1 - y0) * s;
+    double h = 1. / Intervals;
+    double s2 = s * s, s3 = s2 * s;
+    return (2 * s3 - 3 * s2 + 1) * y0 + (s3 - 2 * s2 + s) * h * table.slope[i]
+           + (3 * s2 - 2 * s3) * y1 + (s3 - s2) * h * table.slope[i + 1];
+}
+
+// Compile a curve into a table.
+template<int Intervals>
+constexpr unit_cubic_bezier_table<Intervals>
+compile_curve(
+    unit_cubic_bezier const& curve,
+    curve_interpolation interpolation = curve_interpolation::HERMITE)
+{
+    unit_cubic_bezier_table<Intervals> table{};
+    table.interpolation = interpolation;
+    auto coeff = compute_curve_coefficients(curve);
+
+    // Sample the curve (and its derivatives).
+    double dx_dt[Intervals + 1] = {};
+    double dy_dt[Intervals + 1] = {};
+    for (int i = 0; i <= Intervals; ++i)
+    {
+        double t = impl::solve_for_t_at_x_precisely(
+            coeff, double(i) / Intervals);
+        table.y[i] = sample_curve_y(coeff, t);
+        dx_dt[i] = sample_curve_derivative(coeff, t);
+        dy_dt[i] = sample_curve_y_derivative(coeff, t);
+    }
+    table.y[0] = 0;
+    table.y[Intervals] = 1;
+
+    // Compute the slopes. Where the curve is vertical (or nearly so), the
+    // slope is estimated from the neighboring samples instead.
+    for (int i = 0; i <= Intervals; ++i)
+    {
+        if (impl::curve_abs(dx_dt[i]) > 1e-6)
+        {
+            table.slope[i] = dy_dt[i] / dx_dt[i];
+        }
+        else
+        {
+            int lower = i > 0 ? i - 1 : i;
+            int upper = i < Intervals ? i + 1 : i;
+            table.slope[i] = (table.y[upper] - table.y[lower])
+                             / (double(upper - lower) / Intervals);
+        }
+    }
+
+    // Measure the error.
+    table.max_error = 0;
+    for (int i = 0; i != Intervals; ++i)
+    {
+        for (int j = 1; j != 4; ++j)
+        {
+            double x = (i + j / 4.) / Intervals;
+            double exact = sample_curve_y(
+                coeff, impl::solve_for_t_at_x_precisely(coeff, x));
+            double error = impl::curve_abs(eval_curve_at_x(table, x) - exact);
+            if (error > table.max_error)
+                table.max_error = error;
+        }
+    }
+
+    return table;
+}
+
 } // namespace alia
 
 #endif
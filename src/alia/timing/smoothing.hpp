@@ -6,6 +6,7 @@
 #include <alia/flow/events.hpp>
 #include <alia/signals/adaptors.hpp>
 #include <alia/signals/basic.hpp>
+#include <alia/timing/animation_engine.hpp>
 #include <alia/timing/cubic_bezier.hpp>
 
 #include <cmath>
@@ -14,11 +15,71 @@ namespace alia {
 
 // The following are interpolation curves that can be used for animations.
 typedef unit_cubic_bezier animation_curve;
-animation_curve const default_curve = {0.25, 0.1, 0.25, 1};
-animation_curve const linear_curve = {0, 0, 1, 1};
-animation_curve const ease_in_curve = {0.42, 0, 1, 1};
-animation_curve const ease_out_curve = {0, 0, 0.58, 1};
-animation_curve const ease_in_out_curve = {0.42, 0, 0.58, 1};
+constexpr animation_curve default_curve = {0.25, 0.1, 0.25, 1};
+constexpr animation_curve linear_curve = {0, 0, 1, 1};
+constexpr animation_curve ease_in_curve = {0.42, 0, 1, 1};
+constexpr animation_curve ease_out_curve = {0, 0, 0.58, 1};
+constexpr animation_curve ease_in_out_curve = {0.42, 0, 0.58, 1};
+
+// The built-in curves are precompiled into tables at compile time.
+// (They're wrapped in a template so that there's only one copy of each.)
+typedef unit_cubic_bezier_table<64> animation_curve_table;
+template<class Unused = void>
+struct builtin_curve_tables
+{
+    static constexpr animation_curve_table default_table
+        = compile_curve<64>(default_curve);
+    static constexpr animation_curve_table linear_table
+        = compile_curve<64>(linear_curve);
+    static constexpr animation_curve_table ease_in_table
+        = compile_curve<64>(ease_in_curve);
+    static constexpr animation_curve_table ease_out_table
+        = compile_curve<64>(ease_out_curve);
+    static constexpr animation_curve_table ease_in_out_table
+        = compile_curve<64>(ease_in_out_curve);
+};
+template<class Unused>
+constexpr animation_curve_table builtin_curve_tables<Unused>::default_table;
+template<class Unused>
+constexpr animation_curve_table builtin_curve_tables<Unused>::linear_table;
+template<class Unused>
+constexpr animation_curve_table builtin_curve_tables<Unused>::ease_in_table;
+template<class Unused>
+constexpr animation_curve_table builtin_curve_tables<Unused>::ease_out_table;
+template<class Unused>
+constexpr animation_curve_table
+    builtin_curve_tables<Unused>::ease_in_out_table;
+
+// Get the precompiled table for a curve, or null if it's not a built-in one.
+inline animation_curve_table const*
+get_builtin_curve_table(animation_curve const& curve)
+{
+    typedef builtin_curve_tables<> tables;
+    if (curve == default_curve)
+        return &tables::default_table;
+    if (curve == linear_curve)
+        return &tables::linear_table;
+    if (curve == ease_in_curve)
+        return &tables::ease_in_table;
+    if (curve == ease_out_curve)
+        return &tables::ease_out_table;
+    if (curve == ease_in_out_curve)
+        return &tables::ease_in_out_table;
+    return nullptr;
+}
+
+// Evaluate an animation curve at x (within the given error tolerance).
+// This uses the precompiled table for the curve if there is one and it's
+// accurate enough. Otherwise, it solves the curve directly.
+inline double
+eval_animation_curve(
+    animation_curve const& curve, double x, double error_tolerance)
+{
+    animation_curve_table const* table = get_builtin_curve_table(curve);
+    if (table && table->max_error <= error_tolerance)
+        return eval_curve_at_x(*table, x);
+    return eval_curve_at_x(curve, x, error_tolerance);
+}
 
 // animated_transition specifies an animated transition from one state to
 // another, defined by a duration and a curve to follow.
@@ -95,7 +156,7 @@ smooth_raw(
             = get_raw_animation_ticks_left(ctx, smoother.transition_end);
         if (ticks_left > 0)
         {
-            double fraction = eval_curve_at_x(
+            double fraction = eval_animation_curve(
                 transition.curve,
                 1. - double(ticks_left) / smoother.duration,
                 1. / smoother.duration);
@@ -123,6 +184,104 @@ smooth_raw(
     return current_value;
 }
 
+// A batched_value_smoother is a value_smoother that hands its transitions off
+// to the system's animation engine (if there is one). This is only possible
+// for arithmetic values.
+template<class Value>
+struct batched_value_smoother
+{
+    value_smoother<Value> state;
+    animation_slot slot;
+};
+
+template<class Value>
+struct is_batch_smoothable
+    : std::integral_constant<
+          bool,
+          std::is_arithmetic<Value>::value && !std::is_same<Value, bool>::value>
+{
+};
+
+// Convert a value computed by the animation engine back to the original type.
+// (Integers are rounded, as with interpolate.)
+template<class Value>
+std::enable_if_t<std::is_integral<Value>::value, Value>
+from_animation_value(double x)
+{
+    return Value(std::round(x));
+}
+template<class Value>
+std::enable_if_t<!std::is_integral<Value>::value, Value>
+from_animation_value(double x)
+{
+    return Value(x);
+}
+
+// smooth_raw(ctx, smoother, x, transition) for batched smoothers
+// This behaves exactly like the unbatched version, but the system's animation
+// engine evaluates the transition.
+template<class Value>
+Value
+smooth_raw(
+    dataless_context ctx,
+    batched_value_smoother<Value>& smoother,
+    Value const& x,
+    animated_transition const& transition = default_transition)
+{
+    animation_engine* engine = get_animation_engine(ctx);
+    if (!engine)
+        return smooth_raw(ctx, smoother.state, x, transition);
+
+    value_smoother<Value>& state = smoother.state;
+    if (!state.initialized)
+        reset_smoothing(state, x);
+    Value current_value = state.new_value;
+    if (state.in_transition)
+    {
+        millisecond_count ticks_left
+            = get_raw_animation_ticks_left(ctx, state.transition_end);
+        if (ticks_left > 0 && smoother.slot.active)
+        {
+            current_value = from_animation_value<Value>(
+                read_animation_slot(smoother.slot));
+        }
+        else
+        {
+            state.in_transition = false;
+            if (smoother.slot.group)
+                stop_slot_transition(smoother.slot);
+        }
+    }
+    if (is_refresh_event(ctx) && x != state.new_value)
+    {
+        state.duration
+            = state.in_transition && x == state.old_value
+                  ? (transition.duration
+                     - get_raw_animation_ticks_left(ctx, state.transition_end))
+                  : transition.duration;
+        state.transition_end
+            = get_raw_animation_tick_count(ctx) + state.duration;
+        state.old_value = current_value;
+        state.new_value = x;
+        state.in_transition = true;
+
+        animation_group const* group = smoother.slot.group;
+        if (!group || group->curve != transition.curve
+            || group->duration != transition.duration)
+        {
+            acquire_animation_slot(
+                *engine, smoother.slot, transition.curve, transition.duration);
+        }
+        start_slot_transition(
+            smoother.slot,
+            double(current_value),
+            double(x),
+            state.transition_end,
+            state.duration);
+    }
+    return current_value;
+}
+
 // smooth is analogous to smooth_raw, but it deals with signals instead of raw
 // values.
 
@@ -186,6 +345,22 @@ smooth(
     return make_smoothed_signal(x, output);
 }
 
+template<class Value, class Signal>
+auto
+smooth(
+    dataless_context ctx,
+    batched_value_smoother<Value>& smoother,
+    Signal x,
+    animated_transition const& transition = default_transition)
+{
+    Value output = Value();
+    if (signal_has_value(x))
+        output = smooth_raw(ctx, smoother, read_signal(x), transition);
+    return make_smoothed_signal(x, output);
+}
+
+// When the value type allows it, this uses a batched smoother, so the
+// transition is evaluated by the system's animation engine (if any).
 template<class Signal>
 auto
 smooth(
@@ -193,7 +368,11 @@ smooth(
     Signal x,
     animated_transition const& transition = default_transition)
 {
-    value_smoother<typename Signal::value_type>* data;
+    typedef typename Signal::value_type value_type;
+    std::conditional_t<
+        is_batch_smoothable<value_type>::value,
+        batched_value_smoother<value_type>,
+        value_smoother<value_type>>* data;
     get_cached_data(ctx, &data);
     return smooth(ctx, *data, x, transition);
 }
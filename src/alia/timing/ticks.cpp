@@ -33,6 +33,19 @@ get_animation_tick_count(dataless_context ctx)
     return value(get_raw_animation_tick_count(ctx));
 }
 
+microsecond_count
+get_raw_precise_animation_tick_count(dataless_context ctx)
+{
+    request_animation_refresh(ctx);
+    return ctx.get<timing_tag>().precise_tick_counter;
+}
+
+value_signal<microsecond_count>
+get_precise_animation_tick_count(dataless_context ctx)
+{
+    return value(get_raw_precise_animation_tick_count(ctx));
+}
+
 millisecond_count
 get_raw_animation_ticks_left(dataless_context ctx, millisecond_count end_time)
 {
@@ -46,4 +59,64 @@ get_raw_animation_ticks_left(dataless_context ctx, millisecond_count end_time)
     return 0;
 }
 
+millisecond_count
+get_raw_deadline_ticks_left(dataless_context ctx, millisecond_count end_time)
+{
+    int ticks_remaining = int(end_time - ctx.get<timing_tag>().tick_counter);
+    if (ticks_remaining > 0)
+    {
+        request_refresh_at(ctx, end_time);
+        return millisecond_count(ticks_remaining);
+    }
+    return 0;
+}
+
+microsecond_count
+get_raw_precise_animation_ticks_left(
+    dataless_context ctx, microsecond_count end_tick)
+{
+    microsecond_count now = ctx.get<timing_tag>().precise_tick_counter;
+    if (end_tick > now)
+    {
+        if (is_refresh_event(ctx))
+            request_animation_refresh(ctx);
+        return end_tick - now;
+    }
+    return 0;
+}
+
+void
+request_refresh_at(dataless_context ctx, millisecond_count tick)
+{
+    if (!is_refresh_event(ctx))
+        return;
+    timing_subsystem& timing = ctx.get<timing_tag>();
+    // (The comparison is done this way so that it handles wraparound.)
+    if (!timing.has_wake_deadline || int(tick - timing.wake_deadline) < 0)
+    {
+        timing.has_wake_deadline = true;
+        timing.wake_deadline = tick;
+    }
+}
+
+void
+report_refresh_deadline(system& sys, timing_subsystem const& timing)
+{
+    sys.has_refresh_deadline = timing.has_wake_deadline;
+    sys.refresh_deadline = timing.wake_deadline;
+    // If a refresh has already been requested for the next frame, there's no
+    // need to schedule one.
+    if (!timing.has_wake_deadline || sys.refresh_needed)
+        return;
+    if (!sys.external
+        || !sys.external->schedule_refresh_at(timing.wake_deadline))
+    {
+        // The host doesn't support deadlines, so fall back to refreshing
+        // every frame.
+        if (sys.external)
+            sys.external->request_animation_refresh();
+        sys.refresh_needed = true;
+    }
+}
+
 } // namespace alia
@@ -7,14 +7,60 @@
 
 namespace alia {
 
-// Currently, alia's only sense of time is that of a monotonically increasing
-// millisecond counter. It's understood to have an arbitrary start point and is
-// allowed to wrap around, so 'unsigned' is considered sufficient.
-typedef unsigned millisecond_count;
+// (millisecond_count is defined in common.hpp, since the data graph also needs
+// it.)
+
+// tick_source is the interface for clocks that can drive a system's timing.
+// (See system::clock.)
+struct tick_source
+{
+    virtual ~tick_source()
+    {
+    }
+
+    virtual microsecond_count
+    get_precise_tick_count() const = 0;
+};
+
+// virtual_clock is a tick_source that only advances when it's told to.
+// This allows tests and benchmarks to drive animations deterministically
+// (and without actually waiting).
+struct virtual_clock : tick_source
+{
+    microsecond_count now = 0;
+
+    microsecond_count
+    get_precise_tick_count() const override
+    {
+        return now;
+    }
+};
+
+inline void
+advance_virtual_clock(virtual_clock& clock, microsecond_count microseconds)
+{
+    clock.now += microseconds;
+}
+
+inline void
+advance_virtual_clock_ms(virtual_clock& clock, millisecond_count milliseconds)
+{
+    clock.now += microsecond_count(milliseconds) * 1000;
+}
 
 struct timing_subsystem
 {
+    // the tick counters for the current traversal
+    // (tick_counter is derived from precise_tick_counter.)
     millisecond_count tick_counter = 0;
+    microsecond_count precise_tick_counter = 0;
+
+    // the earliest tick count at which something has asked to be refreshed
+    // (during the current refresh pass)
+    // Since everything that's waiting re-registers its deadline on every
+    // refresh, only the earliest one needs to be tracked.
+    bool has_wake_deadline = false;
+    millisecond_count wake_deadline = 0;
 };
 
 // Request that the UI context refresh again quickly enough for smooth
@@ -22,6 +68,18 @@ struct timing_subsystem
 void
 request_animation_refresh(dataless_context ctx);
 
+// Request that the UI context refresh again once the tick counter reaches
+// :tick. Unlike request_animation_refresh, this doesn't require refreshes in
+// between (if the host supports that). It only has an effect during refresh
+// passes.
+void
+request_refresh_at(dataless_context ctx, millisecond_count tick);
+
+// Report the deadline registered in :timing (if any) to :sys.
+// This is called by alia at the end of every refresh pass.
+void
+report_refresh_deadline(system& sys, timing_subsystem const& timing);
+
 // Get the value of the millisecond tick counter associated with the given
 // UI context. This counter is updated every refresh pass, so it's consistent
 // within a single frame.
@@ -34,18 +92,48 @@ get_raw_animation_tick_count(dataless_context ctx);
 value_signal<millisecond_count>
 get_animation_tick_count(dataless_context ctx);
 
+// Get the value of the 64-bit microsecond tick counter associated with the
+// given UI context. This is the counter that the millisecond counter is derived
+// from, so the two are always consistent. Like the above, this requests a
+// refresh.
+microsecond_count
+get_raw_precise_animation_tick_count(dataless_context ctx);
+
+// Same as above, but returns a signal rather than a raw integer.
+value_signal<microsecond_count>
+get_precise_animation_tick_count(dataless_context ctx);
+
 // Get the number of ticks remaining until the given end time.
 // If the time has passed, this returns 0.
 // This ensures that the UI context refreshes until the end time is reached.
 millisecond_count
 get_raw_animation_ticks_left(dataless_context ctx, millisecond_count end_tick);
 
+// Same as above, but rather than refreshing continuously until the end time,
+// this only requests a refresh at the end time. (So the returned value is
+// only updated when something else causes a refresh.) This is appropriate
+// when the remaining time isn't being displayed.
+millisecond_count
+get_raw_deadline_ticks_left(dataless_context ctx, millisecond_count end_tick);
+
+// Same as get_raw_animation_ticks_left, but for the microsecond counter.
+// (Since this counter doesn't wrap around, there's no limit on how far in the
+// future the end time can be.)
+microsecond_count
+get_raw_precise_animation_ticks_left(
+    dataless_context ctx, microsecond_count end_tick);
+
 struct animation_timer_state
 {
     bool active = false;
     millisecond_count end_tick;
 };
 
+// raw_animation_timer only needs to know when it expires, so on its own, an
+// active timer just requests a refresh at its end tick (rather than continuous
+// refreshes). However, reading ticks_left() implies that the remaining time is
+// being displayed, so that requests continuous refreshes (and always reflects
+// the current tick).
 struct raw_animation_timer
 {
     raw_animation_timer(context ctx) : ctx_(ctx)
@@ -66,7 +154,9 @@ struct raw_animation_timer
     millisecond_count
     ticks_left() const
     {
-        return ticks_left_;
+        return state_->active
+                   ? get_raw_animation_ticks_left(ctx_, state_->end_tick)
+                   : 0;
     }
     void
     start(millisecond_count duration)
@@ -79,21 +169,15 @@ struct raw_animation_timer
     void
     update()
     {
-        if (state_->active)
-        {
-            ticks_left_ = get_raw_animation_ticks_left(ctx_, state_->end_tick);
-            if (ticks_left_ == 0)
-                state_->active = false;
-        }
-        else
+        if (state_->active
+            && get_raw_deadline_ticks_left(ctx_, state_->end_tick) == 0)
         {
-            ticks_left_ = 0;
+            state_->active = false;
         }
     }
 
     dataless_context ctx_;
     animation_timer_state* state_;
-    millisecond_count ticks_left_;
 };
 
 struct animation_timer
@@ -0,0 +1,187 @@
+#include <alia/tracing.hpp>
+
+#include <cstdio>
+#include <functional>
+#include <thread>
+
+namespace alia {
+
+trace_event_sink::trace_event_sink(std::ostream& out)
+    : out(&out), start_time(std::chrono::steady_clock::now())
+{
+    out << "[";
+}
+
+trace_event_sink::~trace_event_sink()
+{
+    *out << "\n]\n";
+    out->flush();
+}
+
+// Append :s to :json as the contents of a JSON string (i.e., escaped but
+// without the surrounding quotes).
+static void
+append_json_string_contents(std::string& json, char const* s)
+{
+    for (; *s; ++s)
+    {
+        char c = *s;
+        switch (c)
+        {
+            case '"':
+                json += "\\\"";
+                break;
+            case '\\':
+                json += "\\\\";
+                break;
+            case '\n':
+                json += "\\n";
+                break;
+            case '\r':
+                json += "\\r";
+                break;
+            case '\t':
+                json += "\\t";
+                break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20)
+                {
+                    char escaped[8];
+                    std::snprintf(
+                        escaped, sizeof(escaped), "\\u%04x", unsigned(c));
+                    json += escaped;
+                }
+                else
+                {
+                    json += c;
+                }
+        }
+    }
+}
+
+static void
+write_json_string(std::ostream& out, char const* s)
+{
+    std::string json;
+    json += '"';
+    append_json_string_contents(json, s);
+    json += '"';
+    out << json;
+}
+
+static void
+append_trace_arg_name(std::string& json, char const* name)
+{
+    if (!json.empty())
+        json += ',';
+    json += '"';
+    append_json_string_contents(json, name);
+    json += "\":";
+}
+
+trace_args&
+trace_args::operator()(char const* name, long long value)
+{
+    append_trace_arg_name(json, name);
+    json += std::to_string(value);
+    return *this;
+}
+
+trace_args&
+trace_args::operator()(char const* name, char const* value)
+{
+    append_trace_arg_name(json, name);
+    json += '"';
+    append_json_string_contents(json, value);
+    json += '"';
+    return *this;
+}
+
+static unsigned
+get_trace_thread_id()
+{
+    static thread_local unsigned id = unsigned(
+        std::hash<std::thread::id>()(std::this_thread::get_id()) & 0x7fffffff);
+    return id;
+}
+
+void
+write_trace_event(
+    trace_event_sink& sink,
+    char phase,
+    char const* name,
+    char const* category,
+    counter_type id,
+    trace_args const* args)
+{
+    auto now = std::chrono::steady_clock::now();
+    unsigned thread_id = get_trace_thread_id();
+
+    std::lock_guard<std::mutex> lock(sink.mutex);
+    std::ostream& out = *sink.out;
+    out << (sink.empty ? "\n" : ",\n");
+    sink.empty = false;
+    out << "{\"name\":";
+    write_json_string(out, name);
+    out << ",\"cat\":";
+    write_json_string(out, category);
+    out << ",\"ph\":\"" << phase << "\",\"ts\":"
+        << std::chrono::duration_cast<std::chrono::microseconds>(
+               now - sink.start_time)
+               .count()
+        << ",\"pid\":1,\"tid\":" << thread_id;
+    if (id != 0)
+        out << ",\"id\":" << id;
+    if (args && !args->json.empty())
+        out << ",\"args\":{" << args->json << "}";
+    out << "}";
+}
+
+void
+scoped_trace_span::begin(
+    trace_event_sink& sink,
+    char const* name,
+    char const* category,
+    trace_args const* args)
+{
+    write_trace_event(sink, 'B', name, category, 0, args);
+    sink_ = &sink;
+    name_ = name;
+    category_ = category;
+}
+
+void
+scoped_trace_span::end()
+{
+    if (sink_)
+    {
+        write_trace_event(*sink_, 'E', name_, category_);
+        sink_ = nullptr;
+    }
+}
+
+counter_type
+begin_async_trace_span(
+    trace_event_sink& sink, char const* name, char const* category)
+{
+    counter_type id;
+    {
+        std::lock_guard<std::mutex> lock(sink.mutex);
+        id = sink.next_async_id++;
+    }
+    write_trace_event(sink, 'b', name, category, id);
+    return id;
+}
+
+void
+end_async_trace_span(
+    trace_event_sink& sink,
+    char const* name,
+    char const* category,
+    counter_type id,
+    trace_args const* args)
+{
+    write_trace_event(sink, 'e', name, category, id, args);
+}
+
+} // namespace alia
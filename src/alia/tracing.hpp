@@ -0,0 +1,120 @@
+#ifndef ALIA_TRACING_HPP
+#define ALIA_TRACING_HPP
+
+#include <chrono>
+#include <mutex>
+#include <ostream>
+#include <string>
+
+#include <alia/common.hpp>
+
+// This file provides support for recording traces of alia's activity in the
+// Chrome trace event format (the JSON format that's understood by
+// chrome://tracing and Perfetto).
+//
+// To record a trace, attach a trace_event_sink to an alia::system (via
+// system::tracer). The system then records spans for refresh passes, event
+// dispatches (including the length of the routing path for targeted events),
+// apply() recomputations, and the intervals between the launch and completion
+// of async() operations.
+//
+// Since async operations can complete on other threads, a sink can be written
+// to concurrently.
+
+namespace alia {
+
+struct trace_event_sink : noncopyable
+{
+    // The trace is written to :out, which must outlive the sink.
+    explicit trace_event_sink(std::ostream& out);
+
+    // Destroying the sink terminates the trace.
+    ~trace_event_sink();
+
+    std::mutex mutex;
+    std::ostream* out;
+    bool empty = true;
+    // All timestamps are relative to the creation of the sink.
+    std::chrono::steady_clock::time_point start_time;
+    counter_type next_async_id = 1;
+};
+
+// trace_args is a builder for the arguments attached to a trace event.
+struct trace_args
+{
+    trace_args&
+    operator()(char const* name, long long value);
+
+    trace_args&
+    operator()(char const* name, char const* value);
+
+    // the arguments, as the contents of a JSON object
+    std::string json;
+};
+
+// Write a single event to a trace.
+// :phase is the Chrome trace event phase (e.g., 'B' to begin a span, 'E' to
+// end one, 'b' and 'e' to begin and end an async span).
+// :id is only used for async events.
+void
+write_trace_event(
+    trace_event_sink& sink,
+    char phase,
+    char const* name,
+    char const* category,
+    counter_type id = 0,
+    trace_args const* args = nullptr);
+
+// scoped_trace_span records a span on the current thread covering its scope.
+// It does nothing if it's given a null sink.
+struct scoped_trace_span : noncopyable
+{
+    scoped_trace_span() : sink_(nullptr)
+    {
+    }
+    scoped_trace_span(
+        trace_event_sink* sink, char const* name, char const* category)
+        : sink_(nullptr)
+    {
+        if (sink)
+            begin(*sink, name, category);
+    }
+    ~scoped_trace_span()
+    {
+        end();
+    }
+
+    void
+    begin(
+        trace_event_sink& sink,
+        char const* name,
+        char const* category,
+        trace_args const* args = nullptr);
+
+    void
+    end();
+
+ private:
+    trace_event_sink* sink_;
+    char const* name_;
+    char const* category_;
+};
+
+// Record the beginning of an async span.
+// The returned ID must be passed to end_async_trace_span to end the span.
+counter_type
+begin_async_trace_span(
+    trace_event_sink& sink, char const* name, char const* category);
+
+// Record the end of an async span.
+void
+end_async_trace_span(
+    trace_event_sink& sink,
+    char const* name,
+    char const* category,
+    counter_type id,
+    trace_args const* args = nullptr);
+
+} // namespace alia
+
+#endif
@@ -0,0 +1,60 @@
+#include <allocation_testing.hpp>
+
+#include <testing.hpp>
+
+namespace alia {
+
+allocation_counts
+count_steady_state_refresh_allocations(
+    alia::system& sys, int warm_up_refreshes, int measured_refreshes)
+{
+    for (int i = 0; i != warm_up_refreshes; ++i)
+        refresh_system(sys);
+    allocation_counts counts;
+    {
+        scoped_allocation_counter scoped(counts);
+        for (int i = 0; i != measured_refreshes; ++i)
+            refresh_system(sys);
+    }
+    return counts;
+}
+
+} // namespace alia
+
+using namespace alia;
+
+namespace {
+
+// Allocate (and free) an int in a way that the compiler can't elide.
+void
+allocate_int()
+{
+    int* volatile p = new int(1);
+    delete p;
+}
+
+} // namespace
+
+TEST_CASE("allocation tracking", "[allocation_tracking]")
+{
+    allocation_counts counts;
+    allocation_counts totals_before = get_allocation_counts();
+    {
+        scoped_allocation_counter scoped(counts);
+        allocate_int();
+    }
+    REQUIRE(counts.allocations == 1);
+    REQUIRE(counts.bytes == sizeof(int));
+
+    // Allocations outside the scope aren't counted.
+    allocate_int();
+    REQUIRE(counts.allocations == 1);
+
+    // ... but they're included in the process-wide totals.
+    allocation_counts totals_after = get_allocation_counts();
+    REQUIRE(totals_after.allocations - totals_before.allocations >= 2);
+
+    alia::system sys;
+    sys.controller = [](context) { allocate_int(); };
+    REQUIRE(count_steady_state_refresh_allocations(sys, 1, 3).allocations == 3);
+}
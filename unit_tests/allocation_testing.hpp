@@ -0,0 +1,23 @@
+#ifndef ALIA_TEST_ALLOCATION_TESTING_HPP
+#define ALIA_TEST_ALLOCATION_TESTING_HPP
+
+#include <allocation_tracking.hpp>
+
+#include <alia/system.hpp>
+
+// This file provides utilities for checking heap allocations within tests.
+// (The counting itself is done by the allocation tracking that's shared with
+// the benchmarks.)
+
+namespace alia {
+
+// Warm up :sys by refreshing it :warm_up_refreshes times and then count the
+// allocations made across another :measured_refreshes refreshes.
+// This is used to check that steady-state refreshes don't allocate.
+allocation_counts
+count_steady_state_refresh_allocations(
+    alia::system& sys, int warm_up_refreshes = 2, int measured_refreshes = 4);
+
+} // namespace alia
+
+#endif
@@ -0,0 +1,123 @@
+#include <alia/containers/persistent_map.hpp>
+
+#include <map>
+#include <string>
+
+#include <testing.hpp>
+
+using namespace alia;
+
+namespace {
+
+template<class Map>
+std::map<typename Map::key_type, typename Map::mapped_type>
+to_std_map(Map const& m)
+{
+    std::map<typename Map::key_type, typename Map::mapped_type> result;
+    for (auto const& entry : m)
+        result.insert(entry);
+    return result;
+}
+
+// This hashes all keys into only a few buckets, so many keys collide.
+struct colliding_hash
+{
+    size_t
+    operator()(int key) const
+    {
+        return size_t(key % 3);
+    }
+};
+
+template<class Map>
+void
+test_persistent_map_operations()
+{
+    Map m;
+    std::map<int, int> reference;
+    REQUIRE(m.empty());
+    REQUIRE(m.begin() == m.end());
+    REQUIRE(m.count(0) == 0);
+    REQUIRE_THROWS_AS(m.at(0), std::out_of_range);
+
+    for (int i = 0; i != 1000; ++i)
+    {
+        REQUIRE(m.insert_or_assign(i * 7, i));
+        reference[i * 7] = i;
+    }
+    REQUIRE(m.size() == 1000);
+    REQUIRE(to_std_map(m) == reference);
+    REQUIRE(m.at(70) == 10);
+    REQUIRE(m.count(71) == 0);
+
+    REQUIRE(!m.insert_or_assign(70, -10));
+    reference[70] = -10;
+    m[140] += 100;
+    reference[140] += 100;
+    m[1] = 1;
+    reference[1] = 1;
+    REQUIRE(to_std_map(m) == reference);
+
+    Map copy = m;
+    for (int i = 0; i != 1000; i += 2)
+    {
+        REQUIRE(m.erase(i * 7) == 1);
+        reference.erase(i * 7);
+    }
+    REQUIRE(m.erase(3) == 0);
+    REQUIRE(m.size() == reference.size());
+    REQUIRE(to_std_map(m) == reference);
+    REQUIRE(copy.size() == 1001);
+    REQUIRE(copy.at(0) == 0);
+
+    for (auto const& entry : reference)
+        m.erase(entry.first);
+    REQUIRE(m.empty());
+    REQUIRE(m.begin() == m.end());
+}
+
+} // namespace
+
+TEST_CASE("persistent_map operations", "[containers][persistent_map]")
+{
+    test_persistent_map_operations<persistent_map<int, int>>();
+    test_persistent_map_operations<
+        persistent_map<int, int, colliding_hash>>();
+}
+
+TEST_CASE("persistent_map sharing", "[containers][persistent_map]")
+{
+    persistent_map<std::string, int> original{
+        {"apple", 1}, {"banana", 2}, {"cherry", 3}};
+    REQUIRE(original.size() == 3);
+
+    auto copy = original;
+    REQUIRE(copy.shares_structure_with(original));
+    REQUIRE(copy == original);
+    REQUIRE(&copy.at("apple") == &original.at("apple"));
+
+    copy["banana"] = 20;
+    copy.insert_or_assign("date", 4);
+    copy.erase("apple");
+    REQUIRE(
+        to_std_map(original)
+        == std::map<std::string, int>(
+            {{"apple", 1}, {"banana", 2}, {"cherry", 3}}));
+    REQUIRE(
+        to_std_map(copy)
+        == std::map<std::string, int>(
+            {{"banana", 20}, {"cherry", 3}, {"date", 4}}));
+    REQUIRE(copy != original);
+
+    // Only the modified entries have new identities.
+    REQUIRE(copy.item_identity("banana") != original.item_identity("banana"));
+    REQUIRE(copy.item_identity("cherry") == original.item_identity("cherry"));
+    REQUIRE(!copy.item_identity("apple"));
+
+    // Maps with the same contents are equal regardless of history.
+    copy.insert_or_assign("apple", 1);
+    copy.insert_or_assign("banana", 2);
+    copy.erase("date");
+    REQUIRE(copy == original);
+    REQUIRE(!copy.shares_structure_with(original));
+}
@@ -0,0 +1,144 @@
+#include <alia/containers/persistent_vector.hpp>
+
+#include <string>
+#include <vector>
+
+#include <testing.hpp>
+
+using namespace alia;
+
+namespace {
+
+template<class T>
+std::vector<T>
+to_std_vector(persistent_vector<T> const& v)
+{
+    return std::vector<T>(v.begin(), v.end());
+}
+
+} // namespace
+
+TEST_CASE("persistent_vector basics", "[containers][persistent_vector]")
+{
+    persistent_vector<int> v;
+    REQUIRE(v.empty());
+    REQUIRE(v.size() == 0);
+    REQUIRE(v.begin() == v.end());
+    REQUIRE_THROWS_AS(v.at(0), std::out_of_range);
+
+    // Add enough items to give the trie three levels.
+    int const n = 2000;
+    for (int i = 0; i != n; ++i)
+        v.push_back(i * 3);
+    REQUIRE(v.size() == size_t(n));
+    REQUIRE(v.front() == 0);
+    REQUIRE(v.back() == (n - 1) * 3);
+    bool all_correct = true;
+    for (int i = 0; i != n; ++i)
+        all_correct = all_correct && v[i] == i * 3 && v.at(i) == i * 3;
+    REQUIRE(all_correct);
+    REQUIRE_THROWS_AS(v.at(n), std::out_of_range);
+
+    int expected = 0;
+    for (int x : v)
+    {
+        all_correct = all_correct && x == expected;
+        expected += 3;
+    }
+    REQUIRE(all_correct);
+    REQUIRE(v.end() - v.begin() == n);
+
+    v[7] = -1;
+    REQUIRE(v[7] == -1);
+    v.set(1500, -2);
+    REQUIRE(v[1500] == -2);
+
+    // Remove items until the trie shrinks back down.
+    for (int i = 0; i != n - 10; ++i)
+        v.pop_back();
+    REQUIRE(v.size() == 10);
+    REQUIRE(to_std_vector(v)
+            == std::vector<int>({0, 3, 6, 9, 12, 15, 18, -1, 24, 27}));
+    v.push_back(30);
+    REQUIRE(v.back() == 30);
+
+    v.clear();
+    REQUIRE(v.empty());
+}
+
+TEST_CASE("persistent_vector insert/erase", "[containers][persistent_vector]")
+{
+    persistent_vector<std::string> v{"a", "b", "c"};
+    REQUIRE(*v.insert(v.begin() + 1, "x") == "x");
+    REQUIRE(
+        to_std_vector(v) == std::vector<std::string>({"a", "x", "b", "c"}));
+    v.insert(v.end(), "y");
+    v.insert(v.begin(), "z");
+    REQUIRE(
+        to_std_vector(v)
+        == std::vector<std::string>({"z", "a", "x", "b", "c", "y"}));
+    REQUIRE(*v.erase(v.begin() + 2) == "b");
+    v.erase(v.begin());
+    v.erase(v.end() - 1);
+    REQUIRE(to_std_vector(v) == std::vector<std::string>({"a", "b", "c"}));
+
+    // Items keep their identities when they move.
+    auto b_identity = v.item_identity(1);
+    v.erase(v.begin());
+    REQUIRE(v.item_identity(0) == b_identity);
+    v.insert(v.begin(), "a");
+    REQUIRE(v.item_identity(1) == b_identity);
+}
+
+TEST_CASE("persistent_vector sharing", "[containers][persistent_vector]")
+{
+    persistent_vector<std::string> original;
+    for (int i = 0; i != 100; ++i)
+        original.push_back(std::to_string(i));
+
+    persistent_vector<std::string> copy = original;
+    REQUIRE(copy.shares_structure_with(original));
+    REQUIRE(copy == original);
+    for (size_t i = 0; i != 100; ++i)
+        REQUIRE(copy.item_identity(i) == original.item_identity(i));
+    REQUIRE(&copy.at(50) == &original.at(50));
+
+    // Modifying the copy doesn't affect the original.
+    copy.set(50, "fifty");
+    copy[60] += "!";
+    copy.push_back("100");
+    REQUIRE(original.at(50) == "50");
+    REQUIRE(original.at(60) == "60");
+    REQUIRE(original.size() == 100);
+    REQUIRE(copy.at(50) == "fifty");
+    REQUIRE(copy.at(60) == "60!");
+    REQUIRE(copy.size() == 101);
+    REQUIRE(!copy.shares_structure_with(original));
+    REQUIRE(copy != original);
+
+    // Only the modified items have new identities.
+    REQUIRE(copy.item_identity(50) != original.item_identity(50));
+    REQUIRE(copy.item_identity(60) != original.item_identity(60));
+    REQUIRE(copy.item_identity(49) == original.item_identity(49));
+    REQUIRE(copy.item_identity(61) == original.item_identity(61));
+    REQUIRE(!copy.item_identity(101));
+
+    // An item that's not shared is modified in place.
+    auto identity = copy.item_identity(50);
+    std::string const* address = &copy.at(50);
+    identity.reset();
+    copy.set(50, "FIFTY");
+    REQUIRE(&copy.at(50) == address);
+
+    // Restoring the old version restores the old identities.
+    copy = original;
+    REQUIRE(copy.item_identity(50) == original.item_identity(50));
+    REQUIRE(copy == original);
+    REQUIRE(!(copy < original));
+
+    persistent_vector<std::string> other(original.begin(), original.end());
+    REQUIRE(other == original);
+    REQUIRE(!other.shares_structure_with(original));
+    other.pop_back();
+    REQUIRE(other < original);
+}
@@ -196,6 +196,38 @@ TEST_CASE("push_back action", "[flow][actions]")
     }
 }
 
+TEST_CASE("container mutation actions", "[flow][actions]")
+{
+    auto x = std::vector<int>{1, 2};
+
+    perform_action(insert(direct(x)), size_t(0), 0);
+    REQUIRE(x == (std::vector<int>{0, 1, 2}));
+    perform_action(insert(direct(x)), size_t(3), 3);
+    REQUIRE(x == (std::vector<int>{0, 1, 2, 3}));
+    perform_action(insert(direct(x)), size_t(5), 5);
+    REQUIRE(x == (std::vector<int>{0, 1, 2, 3}));
+
+    perform_action(update_at(direct(x)), size_t(1), 4);
+    REQUIRE(x == (std::vector<int>{0, 4, 2, 3}));
+    perform_action(update_at(direct(x)) << 0, 5);
+    REQUIRE(x == (std::vector<int>{5, 4, 2, 3}));
+    perform_action(update_at(direct(x)), size_t(4), 7);
+    REQUIRE(x == (std::vector<int>{5, 4, 2, 3}));
+
+    perform_action(erase_at(direct(x)), size_t(1));
+    REQUIRE(x == (std::vector<int>{5, 2, 3}));
+    perform_action(erase_at(direct(x)), size_t(3));
+    REQUIRE(x == (std::vector<int>{5, 2, 3}));
+
+    // Combined actions see each other's effects.
+    perform_action((push_back(direct(x)) << 6, push_back(direct(x)) << 7));
+    REQUIRE(x == (std::vector<int>{5, 2, 3, 6, 7}));
+
+    REQUIRE(!insert(empty<std::vector<int>>()).is_ready());
+    REQUIRE(!erase_at(empty<std::vector<int>>()).is_ready());
+    REQUIRE(!update_at(empty<std::vector<int>>()).is_ready());
+}
+
 TEST_CASE("lambda actions", "[flow][actions]")
 {
     int x = 0;
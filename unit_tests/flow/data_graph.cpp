@@ -3,6 +3,7 @@
 
 #include <alia/flow/macros.hpp>
 #include <alia/signals/basic.hpp>
+#include <allocation_testing.hpp>
 
 #include <flow/testing.hpp>
 
@@ -123,6 +124,84 @@ TEST_CASE("mobile named blocks", "[flow][data_graph]")
         "destructing int;");
 }
 
+TEST_CASE("reordered named blocks", "[flow][data_graph]")
+{
+    clear_log();
+    {
+        data_graph graph;
+        auto make_controller = [](std::vector<int> indices) {
+            return [=](context ctx) {
+                naming_context nc(ctx);
+                for (auto i : indices)
+                {
+                    named_block nb(nc, make_id(i));
+                    do_int(ctx, i);
+                }
+                do_int(ctx, 0);
+            };
+        };
+        do_traversal(graph, make_controller({1, 2, 3, 4}));
+        check_log(
+            "initializing int: 1;"
+            "initializing int: 2;"
+            "initializing int: 3;"
+            "initializing int: 4;"
+            "initializing int: 0;");
+        // reversal
+        do_traversal(graph, make_controller({4, 3, 2, 1}));
+        check_log(
+            "visiting int: 4;"
+            "visiting int: 3;"
+            "visiting int: 2;"
+            "visiting int: 1;"
+            "visiting int: 0;");
+        // insertion at the front
+        do_traversal(graph, make_controller({5, 4, 3, 2, 1}));
+        check_log(
+            "initializing int: 5;"
+            "visiting int: 4;"
+            "visiting int: 3;"
+            "visiting int: 2;"
+            "visiting int: 1;"
+            "visiting int: 0;");
+        // a shuffle that also drops a block
+        do_traversal(graph, make_controller({2, 5, 1, 3}));
+        check_log(
+            "visiting int: 2;"
+            "visiting int: 5;"
+            "visiting int: 1;"
+            "visiting int: 3;"
+            "visiting int: 0;"
+            "destructing int;");
+        // a move followed by blocks that keep their relative order
+        do_traversal(graph, make_controller({3, 2, 5, 1}));
+        check_log(
+            "visiting int: 3;"
+            "visiting int: 2;"
+            "visiting int: 5;"
+            "visiting int: 1;"
+            "visiting int: 0;");
+        // a repeated block
+        do_traversal(graph, make_controller({1, 3, 1}));
+        check_log(
+            "visiting int: 1;"
+            "visiting int: 3;"
+            "visiting int: 1;"
+            "visiting int: 0;"
+            "destructing int;"
+            "destructing int;");
+        do_traversal(graph, make_controller({3, 1}));
+        check_log(
+            "visiting int: 3;"
+            "visiting int: 1;"
+            "visiting int: 0;");
+    }
+    check_log(
+        "destructing int;"
+        "destructing int;"
+        "destructing int;");
+}
+
 TEST_CASE("multiple naming contexts", "[flow][data_graph]")
 {
     clear_log();
@@ -336,6 +415,98 @@ TEST_CASE("manual deletion", "[data_graph]")
         "destructing int;");
 }
 
+TEST_CASE("inactive block retention", "[data_graph]")
+{
+    clear_log();
+    {
+        data_graph graph;
+        auto make_controller = [](std::vector<int> indices) {
+            return [=](context ctx) {
+                naming_context nc(ctx);
+                set_inactive_block_limit(nc, 2);
+                for (auto i : indices)
+                {
+                    named_block nb(nc, make_id(i), manual_delete(true));
+                    do_int(ctx, i);
+                }
+                REQUIRE(count_inactive_blocks(nc.map()) <= 2);
+            };
+        };
+        do_traversal(graph, make_controller({1, 2, 3, 4}));
+        check_log(
+            "initializing int: 1;"
+            "initializing int: 2;"
+            "initializing int: 3;"
+            "initializing int: 4;");
+        // Deactivate all but one block. Nothing is evicted until the next
+        // pass.
+        do_traversal(graph, make_controller({4}));
+        check_log("visiting int: 4;");
+        // The least recently used blocks are evicted first.
+        do_traversal(graph, make_controller({4}));
+        check_log(
+            "destructing int;"
+            "visiting int: 4;");
+        // Reactivating a retained block removes it from the inactive list.
+        do_traversal(graph, make_controller({3, 4}));
+        check_log(
+            "visiting int: 3;"
+            "visiting int: 4;");
+        do_traversal(graph, make_controller({5}));
+        check_log("initializing int: 5;");
+        do_traversal(graph, make_controller({5}));
+        check_log(
+            "destructing int;"
+            "visiting int: 5;");
+        // Manual deletion still works on retained blocks.
+        delete_named_block(graph, make_id(4));
+        check_log("destructing int;");
+        do_traversal(graph, make_controller({5}));
+        check_log("visiting int: 5;");
+    }
+    check_log(
+        "destructing int;"
+        "destructing int;");
+}
+
+TEST_CASE("graph-wide inactive block retention", "[data_graph]")
+{
+    clear_log();
+    {
+        data_graph graph;
+        graph.inactive_block_limit = 0;
+        auto make_controller = [](int n) {
+            return [=](context ctx) {
+                // clang-format off
+                ALIA_SWITCH(n)
+                {
+                    ALIA_CASE(0):
+                        do_int(ctx, 0);
+                        break;
+                    ALIA_CASE(1):
+                        do_int(ctx, 1);
+                        break;
+                }
+                ALIA_END
+                // clang-format on
+            };
+        };
+        do_traversal(graph, make_controller(0));
+        check_log("initializing int: 0;");
+        do_traversal(graph, make_controller(1));
+        check_log("initializing int: 1;");
+        do_traversal(graph, make_controller(1));
+        check_log(
+            "destructing int;"
+            "visiting int: 1;");
+        do_traversal(graph, make_controller(0));
+        check_log("initializing int: 0;");
+    }
+    check_log(
+        "destructing int;"
+        "destructing int;");
+}
+
 TEST_CASE("named block caching", "[data_graph]")
 {
     clear_log();
@@ -496,6 +667,297 @@ TEST_CASE("scoped_cache_clearing_disabler", "[data_graph]")
         "destructing int;");
 }
 
+TEST_CASE("scoped_cache_retention", "[data_graph]")
+{
+    clear_log();
+    {
+        data_graph graph;
+        auto make_controller = [](bool condition, millisecond_count tick) {
+            return [=](context ctx) {
+                get_data_traversal(ctx).tick_count = tick;
+                {
+                    scoped_cache_retention retention(ctx, 100);
+                    ALIA_IF(condition)
+                    {
+                        do_cached_int(ctx, 0);
+                    }
+                    ALIA_END
+                }
+                ALIA_IF(condition)
+                {
+                    do_cached_int(ctx, 1);
+                }
+                ALIA_END
+            };
+        };
+        do_traversal(graph, make_controller(true, 0));
+        check_log(
+            "initializing cached int: 0;"
+            "initializing cached int: 1;");
+        // The first block retains its cache while it's briefly inactive.
+        do_traversal(graph, make_controller(false, 10));
+        check_log("destructing int;");
+        do_traversal(graph, make_controller(false, 50));
+        check_log("");
+        do_traversal(graph, make_controller(true, 60));
+        check_log(
+            "visiting cached int: 0;"
+            "initializing cached int: 1;");
+        // The grace period restarts each time the block goes inactive.
+        do_traversal(graph, make_controller(false, 100));
+        check_log("destructing int;");
+        do_traversal(graph, make_controller(false, 150));
+        check_log("");
+        do_traversal(graph, make_controller(false, 200));
+        check_log("destructing int;");
+        do_traversal(graph, make_controller(true, 210));
+        check_log(
+            "initializing cached int: 0;"
+            "initializing cached int: 1;");
+    }
+    check_log(
+        "destructing int;"
+        "destructing int;");
+}
+
+TEST_CASE("data graph stats", "[data_graph]")
+{
+    clear_log();
+    {
+        data_graph graph;
+        auto make_controller = [](std::vector<int> indices, bool condition) {
+            return [=](context ctx) {
+                naming_context nc(ctx);
+                for (auto i : indices)
+                {
+                    named_block nb(nc, make_id(i), manual_delete(i >= 10));
+                    do_int(ctx, i);
+                }
+                ALIA_IF(condition)
+                {
+                    do_cached_int(ctx, 0);
+                }
+                ALIA_END
+            };
+        };
+
+        do_traversal(graph, make_controller({1, 10}, true));
+        check_log(
+            "initializing int: 1;"
+            "initializing int: 10;"
+            "initializing cached int: 0;");
+        {
+            auto stats = compute_data_graph_stats(graph);
+            // two naming maps (including the root one), two named blocks with
+            // ints, the ALIA_IF block, and its cached data
+            REQUIRE(stats.total_nodes == 6);
+            REQUIRE(
+                stats.node_counts[typeid(typed_data_node<int_object>)] == 2);
+            REQUIRE(
+                stats.node_counts[typeid(typed_data_node<data_block>)] == 1);
+            REQUIRE(stats.cached_data_objects == 1);
+            REQUIRE(
+                stats.cached_data_bytes
+                == sizeof(typed_cached_data<int_object>));
+            REQUIRE(stats.naming_maps.size() == 2);
+            REQUIRE(stats.named_blocks == 2);
+            REQUIRE(stats.manual_delete_blocks == 1);
+            REQUIRE(
+                stats.node_bytes
+                >= 2 * sizeof(typed_data_node<int_object>)
+                       + sizeof(typed_data_node<data_block>));
+            REQUIRE(
+                stats.estimated_bytes
+                > stats.node_bytes + stats.cached_data_bytes);
+        }
+        REQUIRE(graph.counters.nodes_created == 6);
+        REQUIRE(graph.counters.nodes_destroyed == 0);
+        REQUIRE(graph.counters.named_block_hits == 0);
+        REQUIRE(graph.counters.named_block_misses == 2);
+
+        graph.counters = data_graph_counters();
+        do_traversal(graph, make_controller({1}, false));
+        check_log(
+            "visiting int: 1;"
+            "destructing int;");
+        {
+            auto stats = compute_data_graph_stats(graph);
+            // The cached data is gone, but its node remains.
+            REQUIRE(stats.total_nodes == 6);
+            REQUIRE(stats.cached_data_objects == 0);
+            REQUIRE(stats.cached_data_bytes == 0);
+            REQUIRE(
+                stats.naming_maps[0].inactive_blocks
+                    + stats.naming_maps[1].inactive_blocks
+                == 1);
+        }
+        REQUIRE(graph.counters.nodes_created == 0);
+        REQUIRE(graph.counters.nodes_destroyed == 0);
+        // The ALIA_IF block and the named block for 10 are both cleared.
+        REQUIRE(graph.counters.cache_clears == 2);
+        REQUIRE(graph.counters.named_block_hits == 1);
+        REQUIRE(graph.counters.named_block_misses == 0);
+
+        graph.counters = data_graph_counters();
+        do_traversal(graph, make_controller({2}, false));
+        check_log(
+            "initializing int: 2;"
+            "destructing int;");
+        {
+            auto stats = compute_data_graph_stats(graph);
+            REQUIRE(stats.named_blocks == 2);
+            REQUIRE(stats.manual_delete_blocks == 1);
+        }
+        REQUIRE(graph.counters.nodes_created == 1);
+        REQUIRE(graph.counters.nodes_destroyed == 1);
+        REQUIRE(graph.counters.cache_clears == 1);
+        REQUIRE(graph.counters.named_block_hits == 0);
+        REQUIRE(graph.counters.named_block_misses == 1);
+
+        // Without resetting, the cumulative counters keep growing, but the
+        // last traversal's counters only reflect that traversal.
+        do_traversal(graph, make_controller({2}, false));
+        check_log("visiting int: 2;");
+        REQUIRE(graph.counters.nodes_created == 1);
+        REQUIRE(graph.counters.named_block_hits == 1);
+        REQUIRE(graph.counters.named_block_misses == 1);
+        REQUIRE(graph.last_traversal_counters.nodes_created == 0);
+        REQUIRE(graph.last_traversal_counters.nodes_destroyed == 0);
+        REQUIRE(graph.last_traversal_counters.cache_clears == 0);
+        REQUIRE(graph.last_traversal_counters.named_block_hits == 1);
+        REQUIRE(graph.last_traversal_counters.named_block_misses == 0);
+
+        do_traversal(graph, make_controller({1}, false));
+        check_log(
+            "initializing int: 1;"
+            "destructing int;");
+        REQUIRE(graph.counters.nodes_created == 2);
+        REQUIRE(graph.counters.named_block_misses == 2);
+        REQUIRE(graph.last_traversal_counters.nodes_created == 1);
+        REQUIRE(graph.last_traversal_counters.nodes_destroyed == 1);
+        REQUIRE(graph.last_traversal_counters.cache_clears == 1);
+        REQUIRE(graph.last_traversal_counters.named_block_hits == 0);
+        REQUIRE(graph.last_traversal_counters.named_block_misses == 1);
+    }
+    check_log(
+        "destructing int;"
+        "destructing int;");
+}
+
+TEST_CASE("named block cache retention", "[data_graph]")
+{
+    clear_log();
+    {
+        data_graph graph;
+        auto make_controller = [](bool show,
+                                  millisecond_count tick,
+                                  bool show_parent = true) {
+            return [=](context ctx) {
+                get_data_traversal(ctx).tick_count = tick;
+                ALIA_IF(show_parent)
+                {
+                    scoped_cache_retention retention(ctx, 100);
+                    naming_context nc(ctx);
+                    if (show)
+                    {
+                        named_block nb(nc, make_id(0));
+                        do_int(ctx, 0);
+                        do_cached_int(ctx, 0);
+                    }
+                    if (show)
+                    {
+                        named_block nb(nc, make_id(1), manual_delete(true));
+                        do_cached_int(ctx, 1);
+                    }
+                }
+                ALIA_END
+            };
+        };
+        do_traversal(graph, make_controller(true, 0));
+        check_log(
+            "initializing int: 0;"
+            "initializing cached int: 0;"
+            "initializing cached int: 1;");
+        // While they're briefly hidden, both blocks (and their data) are
+        // retained.
+        do_traversal(graph, make_controller(false, 10));
+        check_log("");
+        do_traversal(graph, make_controller(false, 50));
+        check_log("");
+        do_traversal(graph, make_controller(true, 60));
+        check_log(
+            "visiting int: 0;"
+            "visiting cached int: 0;"
+            "visiting cached int: 1;");
+        // Once the grace period expires, the unreferenced block is deleted,
+        // and the manual_delete block has its cache cleared.
+        do_traversal(graph, make_controller(false, 100));
+        check_log("");
+        do_traversal(graph, make_controller(false, 150));
+        check_log("");
+        do_traversal(graph, make_controller(false, 200));
+        check_log(
+            "destructing int;"
+            "destructing int;"
+            "destructing int;");
+        do_traversal(graph, make_controller(true, 210));
+        check_log(
+            "initializing int: 0;"
+            "initializing cached int: 0;"
+            "initializing cached int: 1;");
+        // If the block containing the naming map is cleared, so are the blocks
+        // it's retaining.
+        do_traversal(graph, make_controller(false, 220));
+        check_log("");
+        do_traversal(graph, make_controller(false, 230, false));
+        check_log(
+            "destructing int;"
+            "destructing int;"
+            "destructing int;");
+    }
+    check_log("");
+}
+
+TEST_CASE("switch case cache retention", "[data_graph]")
+{
+    clear_log();
+    {
+        data_graph graph;
+        auto make_controller = [](int n, millisecond_count tick) {
+            return [=](context ctx) {
+                get_data_traversal(ctx).tick_count = tick;
+                scoped_cache_retention retention(ctx, 100);
+                ALIA_SWITCH(n)
+                {
+                    ALIA_CASE(0):
+                        do_cached_int(ctx, 0);
+                        break;
+                    ALIA_CASE(1):
+                        do_cached_int(ctx, 1);
+                        break;
+                }
+                ALIA_END
+            };
+        };
+        do_traversal(graph, make_controller(0, 0));
+        check_log("initializing cached int: 0;");
+        do_traversal(graph, make_controller(1, 10));
+        check_log("initializing cached int: 1;");
+        do_traversal(graph, make_controller(0, 20));
+        check_log("visiting cached int: 0;");
+        // Case 1 has been inactive long enough to be cleared.
+        do_traversal(graph, make_controller(0, 120));
+        check_log(
+            "visiting cached int: 0;"
+            "destructing int;");
+        do_traversal(graph, make_controller(1, 130));
+        check_log("initializing cached int: 1;");
+    }
+    check_log(
+        "destructing int;"
+        "destructing int;");
+}
+
 TEST_CASE("keyed_data", "[data_graph]")
 {
     keyed_data<int> i;
@@ -596,3 +1058,17 @@ TEST_CASE("low-level get_keyed_data", "[data_graph]")
     }
     check_log("destructing int;");
 }
+
+TEST_CASE("get_keyed_data allocations", "[data_graph]")
+{
+    alia::system sys;
+    sys.controller = [](alia::context ctx) {
+        int* x;
+        if (get_keyed_data(ctx, make_id(1), &x))
+            *x = 1;
+        keyed_data_signal<int> s;
+        if (get_keyed_data(ctx, make_id(2), &s))
+            s.write(2);
+    };
+    REQUIRE(count_steady_state_refresh_allocations(sys).allocations == 0);
+}
@@ -6,6 +6,8 @@
 #include <list>
 #include <map>
 
+#include <alia/containers/persistent_map.hpp>
+#include <alia/containers/persistent_vector.hpp>
 #include <alia/signals/adaptors.hpp>
 #include <alia/signals/application.hpp>
 #include <alia/signals/basic.hpp>
@@ -13,6 +15,7 @@
 #include <alia/signals/operators.hpp>
 
 #include <testing.hpp>
+#include <allocation_testing.hpp>
 
 #include "traversal.hpp"
 
@@ -217,6 +220,92 @@ TEST_CASE("item map", "[flow][for_each]")
     REQUIRE(call_count == 4);
 }
 
+TEST_CASE("persistent vector", "[flow][for_each]")
+{
+    alia::system sys;
+
+    int call_count = 0;
+    auto counting_identity = [&](string s) {
+        ++call_count;
+        return s;
+    };
+
+    persistent_vector<string> container{"foo", "bar", "baz"};
+
+    auto controller = [&](context ctx) {
+        for_each(
+            ctx,
+            direct(container),
+            [&](context ctx, readable<string> const& item) {
+                do_text(ctx, apply(ctx, counting_identity, item));
+            });
+    };
+
+    check_traversal(sys, controller, "foo;bar;baz;");
+    REQUIRE(call_count == 3);
+
+    // The items are identified by their storage, so there's no need to
+    // simplify their IDs, and only the items that actually change are
+    // reprocessed.
+    auto saved = container;
+    container.set(1, "bar2");
+    check_traversal(sys, controller, "foo;bar2;baz;");
+    REQUIRE(call_count == 4);
+
+    container.push_back("qux");
+    check_traversal(sys, controller, "foo;bar2;baz;qux;");
+    REQUIRE(call_count == 5);
+
+    // Restoring an old version only affects the items that differ.
+    container = saved;
+    check_traversal(sys, controller, "foo;bar;baz;");
+    REQUIRE(call_count == 6);
+}
+
+TEST_CASE("persistent map", "[flow][for_each]")
+{
+    alia::system sys;
+
+    int call_count = 0;
+    auto counting_to_string = [&](int x) {
+        ++call_count;
+        return std::to_string(x);
+    };
+
+    persistent_map<string, int> container{{"foo", 2}, {"bar", 0}, {"baz", 3}};
+
+    // The iteration order of a persistent_map is unspecified, so generate the
+    // expected output from the map itself.
+    auto expected_output = [&]() {
+        string output;
+        for (auto const& item : container)
+            output += item.first + ";" + std::to_string(item.second) + ";";
+        return output;
+    };
+
+    auto controller = [&](context ctx) {
+        for_each(
+            ctx,
+            direct(container),
+            [&](context ctx, readable<string> key, duplex<int> value) {
+                do_text(ctx, key);
+                do_text(ctx, apply(ctx, counting_to_string, value));
+            });
+    };
+
+    check_traversal(sys, controller, expected_output());
+    REQUIRE(call_count == 3);
+
+    container.insert_or_assign("bar", 1);
+    container.insert_or_assign("alpha", 4);
+    check_traversal(sys, controller, expected_output());
+    REQUIRE(call_count == 5);
+
+    container.erase("foo");
+    check_traversal(sys, controller, expected_output());
+    REQUIRE(call_count == 5);
+}
+
 TEST_CASE("string list", "[flow][for_each]")
 {
     alia::system sys;
@@ -355,3 +444,20 @@ TEST_CASE("item list", "[for_each][list]")
     check_traversal(sys, controller, "cherry;banana;apple;");
     REQUIRE(call_count == 3);
 }
+
+TEST_CASE("for_each allocations", "[flow][for_each]")
+{
+    std::vector<std::string> vector{"foo", "bar", "baz"};
+    std::map<std::string, int> map{{"foo", 1}, {"bar", 2}};
+    alia::system sys;
+    sys.controller = [&](context ctx) {
+        for_each(ctx, direct(vector), [](context ctx, auto item) {
+            do_text(ctx, item);
+        });
+        for_each(ctx, direct(map), [](context ctx, auto key, auto value) {
+            do_text(ctx, key);
+            do_text(ctx, value);
+        });
+    };
+    REQUIRE(count_steady_state_refresh_allocations(sys).allocations == 0);
+}
@@ -0,0 +1,168 @@
+#include <alia/flow/profiling.hpp>
+
+#include <alia/flow/for_each.hpp>
+#include <alia/flow/macros.hpp>
+#include <alia/system.hpp>
+
+#include <map>
+#include <sstream>
+#include <vector>
+
+#include <flow/testing.hpp>
+
+TEST_CASE("traversal profiling", "[flow][profiling]")
+{
+    clear_log();
+    {
+        alia::system sys;
+        traversal_profiler profiler;
+        sys.profiler = &profiler;
+
+        int n = 3;
+        sys.controller = [&](context ctx) {
+            do_int(ctx, 0);
+            ALIA_FOR(int i = 0; i != n; ++i)
+            {
+                ALIA_IF(i != 1)
+                {
+                    do_int(ctx, i);
+                }
+                ALIA_END
+            }
+            ALIA_END
+        };
+
+        refresh_system(sys);
+        REQUIRE(profiler.frame_count == 1);
+
+        auto summaries = summarize_frame(profiler);
+        // frame, for and if
+        REQUIRE(summaries.size() == 3);
+        for (auto const& summary : summaries)
+        {
+            std::string label = summary.site->label;
+            if (label == "frame")
+            {
+                REQUIRE(summary.calls == 1);
+                REQUIRE(summary.inclusive_time >= summary.exclusive_time);
+            }
+            else if (label == "for")
+            {
+                REQUIRE(summary.calls == 1);
+                // the block for each iteration (plus one for the lookahead)
+                // and the blocks for the ifs
+                REQUIRE(summary.exclusive_data_requests == 7);
+                REQUIRE(summary.inclusive_data_requests == 9);
+            }
+            else
+            {
+                REQUIRE(label == "if");
+                // The if is only recorded when it's taken.
+                REQUIRE(summary.calls == 2);
+                REQUIRE(summary.inclusive_data_requests == 2);
+            }
+        }
+
+        std::ostringstream summary;
+        write_frame_summary(summary, profiler);
+        REQUIRE(summary.str().find("frame 1:") == 0);
+
+        refresh_system(sys);
+        REQUIRE(profiler.frame_count == 2);
+
+        std::ostringstream folded;
+        write_folded_stacks(folded, profiler);
+        std::istringstream lines(folded.str());
+        std::string line;
+        int line_count = 0;
+        while (std::getline(lines, line))
+        {
+            if (line_count == 0)
+                REQUIRE(line.find("frame ") == 0);
+            else
+                REQUIRE(line.find("frame;for@") == 0);
+            ++line_count;
+        }
+        REQUIRE(line_count == 3);
+
+        // Events other than refreshes aren't profiled.
+        impl::dispatch_event(sys, n);
+        REQUIRE(profiler.frame_count == 2);
+
+        reset_profiler(profiler);
+        REQUIRE(profiler.frame_count == 0);
+        std::ostringstream empty;
+        write_folded_stacks(empty, profiler);
+        REQUIRE(empty.str() == "");
+    }
+}
+
+TEST_CASE("named block profiling", "[flow][profiling]")
+{
+    clear_log();
+    {
+        alia::system sys;
+        traversal_profiler profiler;
+        sys.profiler = &profiler;
+
+        std::vector<int> items = {1, 2, 3};
+        data_block manual_block;
+        static profiling_site const manual_site
+            = {"manual", __FILE__, __LINE__};
+        sys.controller = [&](context ctx) {
+            // Each of these is attributed to its own call site.
+            for_each(ctx, direct(items), [&](auto ctx, auto item) {
+                do_int(ctx, read_signal(item));
+            });
+            for_each(ctx, direct(items), [&](auto ctx, auto item) {
+                do_int(ctx, -read_signal(item));
+            });
+            {
+                naming_context nc(ctx);
+                named_block nb;
+                ALIA_BEGIN_LOCATION_SPECIFIC_NAMED_BLOCK(nc, nb, make_id(0))
+                do_int(ctx, 4);
+            }
+            ALIA_SWITCH(items.size())
+            {
+                ALIA_CASE(3):
+                    do_int(ctx, 5);
+                    break;
+                ALIA_DEFAULT:
+                    break;
+            }
+            ALIA_END
+            {
+                scoped_data_block block(ctx, manual_block, &manual_site);
+                do_int(ctx, 6);
+            }
+        };
+
+        refresh_system(sys);
+
+        std::map<std::string, std::vector<profiling_site_summary>> by_label;
+        for (auto const& summary : summarize_frame(profiler))
+            by_label[summary.site->label].push_back(summary);
+
+        // The two for_each calls are recorded separately, with three items
+        // each.
+        REQUIRE(by_label["for_each"].size() == 2);
+        for (auto const& summary : by_label["for_each"])
+        {
+            REQUIRE(summary.site->file != nullptr);
+            REQUIRE(summary.calls == 3);
+            REQUIRE(summary.exclusive_data_requests == 3);
+        }
+
+        REQUIRE(by_label["named_block"].size() == 1);
+        REQUIRE(by_label["named_block"][0].site->file != nullptr);
+        REQUIRE(by_label["named_block"][0].calls == 1);
+
+        REQUIRE(by_label["case"].size() == 1);
+        REQUIRE(by_label["case"][0].calls == 1);
+
+        REQUIRE(by_label["manual"].size() == 1);
+        REQUIRE(by_label["manual"][0].site == &manual_site);
+        REQUIRE(by_label["manual"][0].inclusive_data_requests == 1);
+    }
+}
@@ -0,0 +1,275 @@
+#define ALIA_LOWERCASE_MACROS
+
+#include <alia/flow/recording.hpp>
+
+#include <sstream>
+#include <vector>
+
+#include <alia/signals/async.hpp>
+#include <alia/signals/basic.hpp>
+#include <alia/signals/state.hpp>
+
+#include <testing.hpp>
+
+using namespace alia;
+
+namespace {
+
+struct increment_event
+{
+    int amount;
+};
+
+struct unregistered_event
+{
+};
+
+struct recorded_clock : external_interface
+{
+    millisecond_count ticks = 0;
+
+    millisecond_count
+    get_tick_count() const override
+    {
+        return ticks;
+    }
+};
+
+// the state of a test application, which records everything it observes
+struct recording_test_app
+{
+    std::ostringstream observations;
+    routing_region_ptr region;
+    std::function<void(int)> report_async;
+    int async_input = 0;
+
+    void
+    operator()(context ctx)
+    {
+        auto count = get_state(ctx, value(0));
+
+        on_event<increment_event>(ctx, [&](auto, auto& e) {
+            write_signal(count, read_signal(count) + e.amount);
+        });
+
+        {
+            scoped_routing_region srr(ctx);
+            region = get_active_routing_region(ctx);
+            alia_if(srr.is_relevant())
+            {
+                on_event<increment_event>(ctx, [&](auto, auto& e) {
+                    write_signal(count, read_signal(count) + 100 * e.amount);
+                });
+            }
+            alia_end
+        }
+
+        // This one completes asynchronously (at some later time).
+        auto deferred = async<int>(
+            ctx,
+            [&](auto, auto report, int) { report_async = report; },
+            direct(async_input));
+        // This one completes immediately.
+        auto immediate = async<std::string>(
+            ctx,
+            [](auto, auto report, int x) { report(std::to_string(x)); },
+            direct(async_input));
+
+        on_refresh(ctx, [&](auto ctx) {
+            observations << "tick:"
+                         << ctx.template get<timing_tag>().tick_counter
+                         << ",count:" << read_signal(count);
+            if (signal_has_value(deferred))
+                observations << ",deferred:" << read_signal(deferred);
+            if (signal_has_value(immediate))
+                observations << ",immediate:" << read_signal(immediate);
+            observations << ";";
+        });
+    }
+};
+
+event_recording_registry
+make_test_registry()
+{
+    event_recording_registry registry;
+    register_recorded_event<increment_event>(registry, "increment");
+    return registry;
+}
+
+} // namespace
+
+TEST_CASE("recording codecs", "[flow][recording]")
+{
+    recording_writer writer;
+    write_varint(writer, 0);
+    write_varint(writer, 300);
+    write_varint(writer, ~std::uint64_t(0));
+    recording_codec<std::string>::write(writer, "text");
+    recording_codec<double>::write(writer, 1.5);
+
+    recording_reader reader;
+    reader.position = writer.bytes.data();
+    reader.end = writer.bytes.data() + writer.bytes.size();
+    REQUIRE(read_varint(reader) == 0);
+    REQUIRE(read_varint(reader) == 300);
+    REQUIRE(read_varint(reader) == ~std::uint64_t(0));
+    REQUIRE(recording_codec<std::string>::read(reader) == "text");
+    REQUIRE(recording_codec<double>::read(reader) == 1.5);
+    REQUIRE(reader.position == reader.end);
+    REQUIRE_THROWS_AS(read_varint(reader), replay_error);
+
+    REQUIRE(is_recordable<int>::value);
+    REQUIRE(is_recordable<std::string>::value);
+    REQUIRE(!is_recordable<std::vector<int>>::value);
+}
+
+TEST_CASE("event recording and replay", "[flow][recording]")
+{
+    auto registry = make_test_registry();
+
+    std::stringstream log;
+    std::string original_observations;
+    counter_type unrecorded_event_count;
+    {
+        recording_test_app app;
+        recorded_clock clock;
+        event_recorder recorder(log, registry);
+        alia::system sys;
+        sys.external = &clock;
+        sys.recorder = &recorder;
+        sys.controller = std::ref(app);
+
+        refresh_system(sys);
+        clock.ticks = 10;
+        increment_event event{1};
+        dispatch_event(sys, event);
+        clock.ticks = 25;
+        event.amount = 2;
+        impl::dispatch_targeted_event(sys, event, app.region);
+        refresh_system(sys);
+        clock.ticks = 40;
+        app.report_async(17);
+        unregistered_event other;
+        impl::dispatch_event(sys, other);
+        clock.ticks = 50;
+        app.async_input = 3;
+        refresh_system(sys);
+        clock.ticks = 60;
+        app.report_async(4);
+
+        original_observations = app.observations.str();
+        unrecorded_event_count = recorder.unrecorded_event_count;
+    }
+    REQUIRE(unrecorded_event_count == 1);
+    REQUIRE(
+        original_observations
+        == "tick:0,count:0,immediate:0;"
+           // (This is from the refresh triggered by the immediate result.)
+           "tick:0,count:0,immediate:0;"
+           // The untargeted increment is handled by both handlers.
+           "tick:10,count:101,immediate:0;"
+           // The targeted increment still reaches the handler outside the
+           // routing region.
+           "tick:25,count:303,immediate:0;"
+           "tick:40,count:303,deferred:17,immediate:0;"
+           "tick:50,count:303,immediate:3;"
+           "tick:50,count:303,immediate:3;"
+           "tick:60,count:303,deferred:4,immediate:3;");
+
+    {
+        recording_test_app app;
+        event_replayer replayer(log, registry);
+        alia::system sys;
+        sys.replayer = &replayer;
+        sys.controller = std::ref(app);
+
+        // The replayer doesn't need the model to change, since async results
+        // come from the log, but the controller still needs to see the same
+        // inputs.
+        for (int i = 0; i != 6; ++i)
+            REQUIRE(replay_next_record(sys, replayer));
+        app.async_input = 3;
+        replay_all_records(sys, replayer);
+
+        REQUIRE(app.observations.str() == original_observations);
+        REQUIRE(replayer.skipped_record_count == 1);
+        REQUIRE(!replay_next_record(sys, replayer));
+    }
+}
+
+TEST_CASE("replaying unrecordable async results", "[flow][recording]")
+{
+    auto registry = make_test_registry();
+
+    // std::vector<int> has no codec, so this is launched live when replaying.
+    int async_input = 0;
+    std::ostringstream observations;
+    auto controller = [&](context ctx) {
+        auto count = get_state(ctx, value(0));
+        on_event<increment_event>(ctx, [&](auto, auto& e) {
+            write_signal(count, read_signal(count) + e.amount);
+        });
+        auto result = async<std::vector<int>>(
+            ctx,
+            [](auto, auto report, int x) {
+                report(std::vector<int>{x, x + 1});
+            },
+            direct(async_input));
+        on_refresh(ctx, [&](auto ctx) {
+            observations << "tick:"
+                         << ctx.template get<timing_tag>().tick_counter
+                         << ",count:" << read_signal(count);
+            if (signal_has_value(result))
+                observations << ",result:" << read_signal(result).size();
+            observations << ";";
+        });
+    };
+
+    std::stringstream log;
+    std::string original_observations;
+    {
+        recorded_clock clock;
+        event_recorder recorder(log, registry);
+        alia::system sys;
+        sys.external = &clock;
+        sys.recorder = &recorder;
+        sys.controller = controller;
+        refresh_system(sys);
+        clock.ticks = 10;
+        increment_event event{2};
+        impl::dispatch_event(sys, event);
+        clock.ticks = 20;
+        async_input = 1;
+        refresh_system(sys);
+        original_observations = observations.str();
+    }
+    REQUIRE(
+        original_observations
+        == "tick:0,count:0,result:2;"
+           // (This is from the refresh triggered by the result.)
+           "tick:0,count:0,result:2;"
+           "tick:20,count:2,result:2;"
+           "tick:20,count:2,result:2;");
+
+    {
+        async_input = 0;
+        observations.str("");
+        event_replayer replayer(log, registry);
+        alia::system sys;
+        sys.replayer = &replayer;
+        sys.controller = controller;
+        for (int i = 0; i != 3; ++i)
+            REQUIRE(replay_next_record(sys, replayer));
+        async_input = 1;
+        replay_all_records(sys, replayer);
+        REQUIRE(observations.str() == original_observations);
+        REQUIRE(replayer.skipped_record_count == 0);
+    }
+}
+
+TEST_CASE("invalid recordings", "[flow][recording]")
+{
+    auto registry = make_test_registry();
+    std::istringstream garbage("not a recording");
+    REQUIRE_THROWS_AS(event_replayer(garbage, registry), replay_error);
+}
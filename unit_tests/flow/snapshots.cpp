@@ -0,0 +1,252 @@
+#define ALIA_LOWERCASE_MACROS
+#include <alia/flow/snapshots.hpp>
+
+#include <sstream>
+
+#include <alia/flow/macros.hpp>
+#include <alia/signals/basic.hpp>
+
+#include <flow/testing.hpp>
+
+using namespace alia;
+
+namespace {
+
+// the state of a test application that uses persistent data
+struct snapshot_test_app
+{
+    // the values that the application reads from its persistent data
+    int top = 0;
+    std::string panel;
+    int unaddressable = 0;
+    std::string computed;
+
+    // the number of times that the keyed data has been computed
+    int computations = 0;
+
+    // If this is set, the application writes new values to its state.
+    bool write = false;
+
+    bool show_panel = true;
+    int key = 1;
+
+    void
+    operator()(context ctx)
+    {
+        auto top_state = get_persistent_state(ctx, "top", value(1));
+        if (write)
+            write_signal(top_state, 2);
+        top = read_signal(top_state);
+
+        naming_context nc(ctx);
+        alia_if(show_panel)
+        {
+            named_block nb(nc, make_id(std::string("panel")));
+            auto panel_state = get_persistent_state(
+                ctx, "panel", value(std::string("initial")));
+            if (write)
+                write_signal(panel_state, std::string("written"));
+            panel = read_signal(panel_state);
+
+            keyed_data_signal<std::string> cache;
+            if (get_persistent_keyed_data(ctx, "cache", make_id(key), &cache))
+            {
+                ++computations;
+                write_signal(cache, std::to_string(key * 10));
+            }
+            computed = read_signal(cache);
+        }
+        alia_end
+
+        {
+            // Named blocks whose IDs aren't stable can't contain persistent
+            // data.
+            named_block nb(nc, make_id(&unaddressable));
+            auto unaddressable_state
+                = get_persistent_state(ctx, "unaddressable", value(0));
+            if (write)
+                write_signal(unaddressable_state, 7);
+            unaddressable = read_signal(unaddressable_state);
+        }
+    }
+};
+
+std::string
+write_snapshot(data_graph const& graph)
+{
+    std::ostringstream out;
+    write_data_snapshot(out, graph);
+    return out.str();
+}
+
+} // namespace
+
+TEST_CASE("data graph snapshots", "[flow][snapshots]")
+{
+    std::string contents;
+    {
+        snapshot_test_app app;
+        data_graph graph;
+        graph.persistence_enabled = true;
+        do_traversal(graph, std::ref(app));
+        REQUIRE(app.top == 1);
+        REQUIRE(app.panel == "initial");
+        REQUIRE(app.computed == "10");
+        REQUIRE(app.computations == 1);
+        app.write = true;
+        do_traversal(graph, std::ref(app));
+        REQUIRE(app.top == 2);
+        REQUIRE(app.panel == "written");
+        REQUIRE(app.unaddressable == 7);
+        contents = write_snapshot(graph);
+    }
+    REQUIRE(contents.substr(0, 8) == std::string("ALIASNP\1", 8));
+
+    // Restore the data in a new graph.
+    {
+        data_snapshot snapshot;
+        open_data_snapshot(snapshot, contents.data(), contents.size());
+        REQUIRE(snapshot.entry_count == 3);
+
+        snapshot_test_app app;
+        data_graph graph;
+        graph.persistence_enabled = true;
+        graph.snapshot = &snapshot;
+        do_traversal(graph, std::ref(app));
+        REQUIRE(app.top == 2);
+        REQUIRE(app.panel == "written");
+        REQUIRE(app.computed == "10");
+        REQUIRE(app.computations == 0);
+        REQUIRE(app.unaddressable == 0);
+
+        // Cached data is only restored if its key still matches.
+        app.show_panel = false;
+        do_traversal(graph, std::ref(app));
+        app.show_panel = true;
+        app.key = 2;
+        do_traversal(graph, std::ref(app));
+        REQUIRE(app.computed == "20");
+        REQUIRE(app.computations == 1);
+    }
+
+    // Data that hasn't been restored yet is carried over to new snapshots.
+    {
+        std::istringstream in(contents);
+        data_snapshot snapshot;
+        read_data_snapshot(snapshot, in);
+
+        snapshot_test_app app;
+        app.show_panel = false;
+        data_graph graph;
+        graph.persistence_enabled = true;
+        graph.snapshot = &snapshot;
+        do_traversal(graph, std::ref(app));
+        REQUIRE(app.top == 2);
+        REQUIRE(write_snapshot(graph) == contents);
+    }
+
+    // Without persistence, nothing is restored or written.
+    {
+        data_snapshot snapshot;
+        open_data_snapshot(snapshot, contents.data(), contents.size());
+
+        snapshot_test_app app;
+        data_graph graph;
+        graph.snapshot = &snapshot;
+        do_traversal(graph, std::ref(app));
+        REQUIRE(app.top == 1);
+        graph.snapshot = nullptr;
+        data_snapshot empty;
+        std::string written = write_snapshot(graph);
+        open_data_snapshot(empty, written.data(), written.size());
+        REQUIRE(empty.entry_count == 0);
+    }
+}
+
+TEST_CASE("ambiguous persistent data", "[flow][snapshots]")
+{
+    data_graph graph;
+    graph.persistence_enabled = true;
+    do_traversal(graph, [](context ctx) {
+        get_persistent_state(ctx, "x", value(1));
+        get_persistent_state(ctx, "x", value(2));
+        get_persistent_state(ctx, "y", value(3));
+    });
+    std::string contents = write_snapshot(graph);
+    data_snapshot snapshot;
+    open_data_snapshot(snapshot, contents.data(), contents.size());
+    REQUIRE(snapshot.entry_count == 1);
+}
+
+TEST_CASE("snapshot carry-over", "[flow][snapshots]")
+{
+    bool show = true;
+    bool duplicate = false;
+    auto app = [&](context ctx) {
+        get_persistent_state(ctx, "top", value(1));
+        naming_context nc(ctx);
+        if (show)
+        {
+            named_block nb(nc, make_id(std::string("block")));
+            auto s = get_persistent_state(ctx, "s", value(1));
+            write_signal(s, 2);
+        }
+        if (duplicate)
+        {
+            named_block nb(nc, make_id(std::string("other")));
+            get_persistent_state(ctx, "x", value(1));
+            get_persistent_state(ctx, "x", value(2));
+        }
+        else
+        {
+            named_block nb(nc, make_id(std::string("other")));
+            get_persistent_state(ctx, "x", value(1));
+        }
+    };
+
+    std::string contents;
+    {
+        data_graph graph;
+        graph.persistence_enabled = true;
+        do_traversal(graph, app);
+        contents = write_snapshot(graph);
+    }
+    data_snapshot snapshot;
+    open_data_snapshot(snapshot, contents.data(), contents.size());
+    REQUIRE(snapshot.entry_count == 3);
+
+    // Data that was restored and then destroyed isn't resurrected, and data
+    // that has become ambiguous isn't carried over from the old snapshot.
+    data_graph graph;
+    graph.persistence_enabled = true;
+    graph.snapshot = &snapshot;
+    do_traversal(graph, app);
+    show = false;
+    duplicate = true;
+    do_traversal(graph, app);
+    std::string written = write_snapshot(graph);
+    data_snapshot rewritten;
+    open_data_snapshot(rewritten, written.data(), written.size());
+    REQUIRE(rewritten.entry_count == 1);
+}
+
+TEST_CASE("invalid snapshots", "[flow][snapshots]")
+{
+    data_snapshot snapshot;
+    std::string garbage = "not a snapshot";
+    REQUIRE_THROWS_AS(
+        open_data_snapshot(snapshot, garbage.data(), garbage.size()),
+        snapshot_error);
+
+    data_graph graph;
+    graph.persistence_enabled = true;
+    do_traversal(graph, [](context ctx) {
+        get_persistent_state(ctx, "x", value(std::string("abc")));
+    });
+    std::string contents = write_snapshot(graph);
+    REQUIRE_THROWS_AS(
+        open_data_snapshot(snapshot, contents.data(), contents.size() - 1),
+        snapshot_error);
+    REQUIRE_NOTHROW(
+        open_data_snapshot(snapshot, contents.data(), contents.size()));
+}
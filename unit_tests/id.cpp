@@ -3,6 +3,7 @@
 #include <map>
 #include <unordered_map>
 #include <utility>
+#include <vector>
 
 #include <testing.hpp>
 
@@ -61,6 +62,26 @@ TEST_CASE("simple_id_by_reference", "[id]")
     test_different_ids(make_id_by_reference(x), make_id_by_reference(y));
 }
 
+TEST_CASE("simple_id_by_reference recapture", "[id]")
+{
+    int x = 0;
+    captured_id a;
+    a.capture(make_id_by_reference(x));
+    // b shares a's storage, so recapturing a must leave b alone.
+    captured_id b = a;
+    x = 1;
+    a.capture(make_id_by_reference(x));
+    REQUIRE(a.matches(make_id_by_reference(x)));
+    int zero = 0;
+    REQUIRE(b.matches(make_id_by_reference(zero)));
+    // Recapturing into storage that's no longer shared reuses it.
+    x = 2;
+    a.capture(make_id_by_reference(x));
+    REQUIRE(a.matches(make_id_by_reference(x)));
+    REQUIRE(b.matches(make_id_by_reference(zero)));
+    REQUIRE(!b.matches(make_id_by_reference(x)));
+}
+
 TEST_CASE("id_ref", "[id]")
 {
     test_different_ids(ref(make_id(0)), ref(make_id(1)));
@@ -236,3 +257,60 @@ TEST_CASE("map of IDs", "[id]")
     REQUIRE(m.at(&one) == 1);
     REQUIRE(m.at(&another_one) == 1);
 }
+
+TEST_CASE("stable ID hashes", "[id]")
+{
+    std::uint64_t a, b;
+    REQUIRE(make_id(1).stable_hash(a));
+    REQUIRE(make_id(1l).stable_hash(b));
+    REQUIRE(a == b);
+    REQUIRE(make_id(2).stable_hash(b));
+    REQUIRE(a != b);
+
+    std::string abc = "abc";
+    REQUIRE(make_id(abc).stable_hash(a));
+    REQUIRE(make_id_by_reference(abc).stable_hash(b));
+    REQUIRE(a == b);
+    REQUIRE(alia::ref(make_id(abc)).stable_hash(b));
+    REQUIRE(a == b);
+
+    REQUIRE(combine_ids(make_id(1), make_id(abc)).stable_hash(a));
+    REQUIRE(combine_ids(make_id(abc), make_id(1)).stable_hash(b));
+    REQUIRE(a != b);
+
+    int x = 0;
+    REQUIRE(!make_id(&x).stable_hash(a));
+    REQUIRE(!combine_ids(make_id(1), make_id(&x)).stable_hash(a));
+    REQUIRE(!null_id.stable_hash(a));
+}
+
+TEST_CASE("stable value hashes", "[id]")
+{
+    REQUIRE(has_stable_hash<int>::value);
+    REQUIRE(has_stable_hash<double>::value);
+    REQUIRE(has_stable_hash<std::string>::value);
+    REQUIRE(has_stable_hash<std::vector<std::string>>::value);
+    REQUIRE(!has_stable_hash<int*>::value);
+    REQUIRE(!has_stable_hash<std::vector<int*>>::value);
+
+    REQUIRE(get_stable_hash(0.) == get_stable_hash(-0.));
+    REQUIRE(get_stable_hash(1.5f) == get_stable_hash(1.5));
+    REQUIRE(get_stable_hash(1.5) != get_stable_hash(2.5));
+
+    std::vector<int> v{1, 2, 3};
+    REQUIRE(get_stable_hash(v) == get_stable_hash(std::vector<long>{1, 2, 3}));
+    REQUIRE(get_stable_hash(v) != get_stable_hash(std::vector<int>{1, 3, 2}));
+    REQUIRE(get_stable_hash(v) != get_stable_hash(std::vector<int>{1, 2}));
+    REQUIRE(get_stable_hash(std::vector<int>()) != get_stable_hash(0));
+
+    std::vector<std::string> strings{"ab", "c"};
+    REQUIRE(
+        get_stable_hash(strings)
+        != get_stable_hash(std::vector<std::string>{"a", "bc"}));
+    REQUIRE(
+        get_stable_hash(std::vector<std::vector<int>>{{1}, {2, 3}})
+        != get_stable_hash(std::vector<std::vector<int>>{{1, 2}, {3}}));
+
+    std::uint64_t hash;
+    REQUIRE(make_id(v).stable_hash(hash));
+}
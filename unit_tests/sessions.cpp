@@ -0,0 +1,316 @@
+#include <alia/sessions.hpp>
+
+#include <atomic>
+
+#include <alia/flow/events.hpp>
+#include <alia/signals/basic.hpp>
+#include <alia/timing/smoothing.hpp>
+#include <alia/timing/ticks.hpp>
+
+#include <testing.hpp>
+
+using namespace alia;
+
+namespace {
+
+struct increment_event
+{
+    int amount;
+};
+
+struct animate_event
+{
+};
+
+// the observable state of a hosted test session
+struct session_observations
+{
+    std::atomic<int> count{0};
+    std::atomic<int> refreshes{0};
+    // This is used to detect concurrent processing of the same session.
+    std::atomic<bool> busy{false};
+    std::atomic<bool> overlapped{false};
+    // If this is set, the session animates for this many refreshes.
+    std::atomic<int> animation_frames{0};
+};
+
+std::function<void(context)>
+make_session_controller(session_observations& observations)
+{
+    return [&observations](context ctx) {
+        if (observations.busy.exchange(true))
+            observations.overlapped = true;
+
+        auto count = get_persistent_state(ctx, "count", value(0));
+        on_event<increment_event>(ctx, [&](auto, auto& e) {
+            write_signal(count, read_signal(count) + e.amount);
+        });
+        if (is_refresh_event(ctx))
+        {
+            observations.count = read_signal(count);
+            ++observations.refreshes;
+            if (observations.animation_frames > 0)
+            {
+                --observations.animation_frames;
+                request_animation_refresh(ctx);
+            }
+        }
+
+        observations.busy = false;
+    };
+}
+
+} // namespace
+
+TEST_CASE("session processing", "[sessions]")
+{
+    millisecond_count ticks = 0;
+    session_host_config config;
+    config.memory_check_interval = 1;
+    config.frame_interval = 10;
+    config.get_tick_count = [&] { return ticks; };
+    session_host host(config);
+
+    session_observations a, b;
+    session_id a_id = create_session(host, make_session_controller(a));
+    session_id b_id = create_session(host, make_session_controller(b));
+    REQUIRE(get_session_host_stats(host).ready_sessions == 2);
+    REQUIRE(process_ready_sessions(host) == 2);
+    REQUIRE(a.refreshes == 1);
+    REQUIRE(b.refreshes == 1);
+    REQUIRE(get_session_memory_usage(host, a_id) > 0);
+
+    // Pending work is coalesced into a single refresh.
+    REQUIRE(post_event_to_session(host, a_id, increment_event{1}));
+    REQUIRE(post_event_to_session(host, a_id, increment_event{2}));
+    REQUIRE(process_ready_sessions(host) == 1);
+    REQUIRE(a.count == 3);
+    REQUIRE(a.refreshes == 2);
+    REQUIRE(b.refreshes == 1);
+
+    // Animating sessions are rescheduled for their next frames.
+    b.animation_frames = 2;
+    REQUIRE(post_event_to_session(host, b_id, animate_event()));
+    REQUIRE(process_ready_sessions(host) == 1);
+    REQUIRE(get_session_host_stats(host).waiting_sessions == 1);
+    REQUIRE(process_ready_sessions(host) == 0);
+    ticks = 9;
+    REQUIRE(process_ready_sessions(host) == 0);
+    ticks = 10;
+    REQUIRE(process_ready_sessions(host) == 1);
+    ticks = 20;
+    REQUIRE(process_ready_sessions(host) == 1);
+    REQUIRE(get_session_host_stats(host).waiting_sessions == 0);
+    ticks = 30;
+    REQUIRE(process_ready_sessions(host) == 0);
+    REQUIRE(b.refreshes == 4);
+
+    destroy_session(host, a_id);
+    REQUIRE(!post_event_to_session(host, a_id, increment_event{1}));
+
+    auto stats = get_session_host_stats(host);
+    REQUIRE(stats.sessions == 1);
+    REQUIRE(stats.refreshes == 6);
+    REQUIRE(stats.failures == 0);
+}
+
+TEST_CASE("posting directly to hosted systems", "[sessions]")
+{
+    session_host host(session_host_config{});
+
+    session_observations a;
+    session_id a_id = create_session(host, make_session_controller(a));
+    alia::system* sys = nullptr;
+    post_to_session(host, a_id, [&](alia::system& s) { sys = &s; });
+    REQUIRE(process_ready_sessions(host) == 1);
+    REQUIRE(a.refreshes == 1);
+
+    // Closures posted to the session's system schedule the session.
+    post_to_system(*sys, [](alia::system& s) {
+        increment_event event{2};
+        impl::dispatch_event(s, event);
+    });
+    REQUIRE(get_session_host_stats(host).ready_sessions == 1);
+    REQUIRE(process_ready_sessions(host) == 1);
+    REQUIRE(a.count == 2);
+    REQUIRE(a.refreshes == 2);
+
+    // So do refresh requests.
+    request_refresh(*sys);
+    REQUIRE(process_ready_sessions(host) == 1);
+    REQUIRE(a.refreshes == 3);
+    REQUIRE(process_ready_sessions(host) == 0);
+}
+
+TEST_CASE("animating sessions", "[sessions]")
+{
+    millisecond_count ticks = 0;
+    session_host_config config;
+    config.frame_interval = 16;
+    config.get_tick_count = [&] { return ticks; };
+    session_host host(config);
+
+    std::atomic<int> target{0};
+    std::atomic<int> refreshes{0};
+    double smoothed = 0;
+    session_id id = create_session(host, [&](context ctx) {
+        value_smoother<double>* smoother;
+        get_cached_data(ctx, &smoother);
+        double value = smooth_raw(
+            ctx,
+            *smoother,
+            double(target),
+            animated_transition{default_curve, 100});
+        if (is_refresh_event(ctx))
+        {
+            smoothed = value;
+            ++refreshes;
+        }
+    });
+    REQUIRE(process_ready_sessions(host) == 1);
+
+    // Starting a transition puts the session on a frame schedule rather than
+    // back in the ready queue.
+    target = 1;
+    post_to_session(host, id, [](alia::system&) {});
+    REQUIRE(process_ready_sessions(host) == 1);
+    REQUIRE(refreshes == 2);
+    REQUIRE(get_session_host_stats(host).ready_sessions == 0);
+    REQUIRE(get_session_host_stats(host).waiting_sessions == 1);
+    REQUIRE(process_ready_sessions(host) == 0);
+
+    // Each frame interval produces one refresh until the transition ends.
+    while (get_session_host_stats(host).waiting_sessions != 0)
+    {
+        ticks += 16;
+        REQUIRE(process_ready_sessions(host) == 1);
+        REQUIRE(process_ready_sessions(host) == 0);
+    }
+    REQUIRE(smoothed == 1);
+    REQUIRE(ticks >= 100);
+    REQUIRE(ticks <= 116);
+    REQUIRE(refreshes == 2 + int(ticks / 16));
+
+    // With workers (and a real clock), an animating session doesn't keep them
+    // busy, so the host still becomes idle.
+    session_host_config worker_config;
+    worker_config.worker_count = 1;
+    worker_config.frame_interval = 1000;
+    session_host worker_host(worker_config);
+    std::atomic<int> worker_refreshes{0};
+    create_session(worker_host, [&](context ctx) {
+        if (is_refresh_event(ctx))
+        {
+            ++worker_refreshes;
+            request_animation_refresh(ctx);
+        }
+    });
+    wait_for_idle_sessions(worker_host);
+    REQUIRE(worker_refreshes >= 1);
+    REQUIRE(worker_refreshes <= 2);
+}
+
+TEST_CASE("session memory budgets", "[sessions]")
+{
+    session_host_config config;
+    config.memory_check_interval = 2;
+    config.memory_budget = 1;
+    std::vector<session_id> violators;
+    config.on_budget_exceeded
+        = [&](session_id id, size_t) { violators.push_back(id); };
+    session_host host(config);
+
+    session_observations observations;
+    session_id id = create_session(host, make_session_controller(observations));
+    process_ready_sessions(host);
+    REQUIRE(violators.empty());
+    post_event_to_session(host, id, increment_event{1});
+    process_ready_sessions(host);
+    REQUIRE(violators == std::vector<session_id>{id});
+
+    auto stats = get_session_host_stats(host);
+    REQUIRE(stats.budget_cache_clears == 1);
+    REQUIRE(stats.budget_violations == 1);
+}
+
+TEST_CASE("session hibernation", "[sessions]")
+{
+    millisecond_count ticks = 0;
+    session_host_config config;
+    config.hibernation_directory = ".";
+    config.idle_timeout = 100;
+    config.get_tick_count = [&] { return ticks; };
+    session_host host(config);
+
+    session_observations a, b;
+    session_id a_id = create_session(host, make_session_controller(a));
+    session_id b_id = create_session(host, make_session_controller(b));
+    post_event_to_session(host, a_id, increment_event{4});
+    process_ready_sessions(host);
+    REQUIRE(a.count == 4);
+
+    ticks = 50;
+    post_event_to_session(host, b_id, increment_event{1});
+    process_ready_sessions(host);
+
+    ticks = 120;
+    REQUIRE(hibernate_idle_sessions(host) == 1);
+    REQUIRE(is_session_hibernated(host, a_id));
+    REQUIRE(!is_session_hibernated(host, b_id));
+    REQUIRE(get_session_host_stats(host).hibernated_sessions == 1);
+
+    // Posting to a hibernated session restores its persistent state.
+    post_event_to_session(host, a_id, increment_event{1});
+    process_ready_sessions(host);
+    REQUIRE(!is_session_hibernated(host, a_id));
+    REQUIRE(a.count == 5);
+
+    // Sessions that are waiting for their wake ticks aren't hibernated.
+    session_observations c;
+    c.animation_frames = 1;
+    session_id c_id = create_session(host, make_session_controller(c));
+    process_ready_sessions(host);
+    REQUIRE(get_session_host_stats(host).waiting_sessions == 1);
+
+    ticks = 1000;
+    REQUIRE(hibernate_idle_sessions(host) == 2);
+    REQUIRE(!is_session_hibernated(host, c_id));
+    destroy_session(host, b_id);
+    destroy_session(host, c_id);
+
+    auto stats = get_session_host_stats(host);
+    REQUIRE(stats.sessions == 1);
+    REQUIRE(stats.waiting_sessions == 0);
+    REQUIRE(stats.hibernated_sessions == 1);
+    REQUIRE(stats.hibernations == 3);
+    REQUIRE(stats.restorations == 1);
+}
+
+TEST_CASE("session workers", "[sessions]")
+{
+    session_host_config config;
+    config.worker_count = 4;
+    session_host host(config);
+
+    size_t const session_count = 20;
+    std::vector<std::unique_ptr<session_observations>> observations;
+    std::vector<session_id> ids;
+    for (size_t i = 0; i != session_count; ++i)
+    {
+        observations.emplace_back(new session_observations);
+        ids.push_back(
+            create_session(host, make_session_controller(*observations[i])));
+    }
+    for (int n = 0; n != 10; ++n)
+    {
+        for (auto id : ids)
+            post_event_to_session(host, id, increment_event{1});
+    }
+    wait_for_idle_sessions(host);
+
+    for (auto const& o : observations)
+    {
+        REQUIRE(o->count == 10);
+        REQUIRE(!o->overlapped);
+    }
+}
@@ -2,6 +2,7 @@
 
 #include <map>
 #include <type_traits>
+#include <vector>
 
 #include <alia/signals/basic.hpp>
 #include <alia/signals/lambdas.hpp>
@@ -268,6 +269,58 @@ TEST_CASE("simplify_id", "[signals][adaptors]")
     REQUIRE((c == std::map<int, std::string>{{2, "7"}, {0, "3"}}));
 }
 
+TEST_CASE("identify_by_hash", "[signals][adaptors]")
+{
+    std::vector<int> x{1, 2, 3};
+    auto s = identify_by_hash(direct(x));
+
+    typedef decltype(s) signal_t;
+    REQUIRE((std::is_same<signal_t::value_type, std::vector<int>>::value));
+    REQUIRE(signal_is_readable<signal_t>::value);
+    REQUIRE(signal_is_writable<signal_t>::value);
+
+    REQUIRE(s.value_id() == make_id(get_stable_hash(x)));
+    captured_id captured;
+    captured.capture(s.value_id());
+    REQUIRE(signal_has_value(s));
+    REQUIRE(read_signal(s) == x);
+    REQUIRE(signal_ready_to_write(s));
+    write_signal(s, std::vector<int>{1, 2, 4});
+    REQUIRE(x == std::vector<int>{1, 2, 4});
+    REQUIRE(!captured.matches(s.value_id()));
+    x[2] = 3;
+    REQUIRE(captured.matches(s.value_id()));
+
+    REQUIRE(identify_by_hash(empty<std::vector<int>>()).value_id() == null_id);
+}
+
+TEST_CASE("identify_by_version", "[signals][adaptors]")
+{
+    std::vector<int> x{1, 2, 3};
+    unsigned version = 1;
+    auto s = identify_by_version(direct(x), version);
+
+    typedef decltype(s) signal_t;
+    REQUIRE((std::is_same<signal_t::value_type, std::vector<int>>::value));
+    REQUIRE(signal_is_readable<signal_t>::value);
+    REQUIRE(signal_is_writable<signal_t>::value);
+
+    REQUIRE(s.value_id() == make_id(1u));
+    REQUIRE(signal_has_value(s));
+    REQUIRE(read_signal(s) == x);
+    REQUIRE(signal_ready_to_write(s));
+    write_signal(s, std::vector<int>{4});
+    REQUIRE(x == std::vector<int>{4});
+    // The ID only changes when the version does.
+    REQUIRE(s.value_id() == make_id(1u));
+    ++version;
+    REQUIRE(identify_by_version(direct(x), version).value_id() == make_id(2u));
+
+    REQUIRE(
+        identify_by_version(empty<std::vector<int>>(), version).value_id()
+        == null_id);
+}
+
 TEST_CASE("signalize a signal", "[signals][adaptors]")
 {
     int x = 12;
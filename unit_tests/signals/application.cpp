@@ -5,6 +5,7 @@
 #include <testing.hpp>
 
 #include <alia/signals/basic.hpp>
+#include <allocation_testing.hpp>
 
 #include "traversal.hpp"
 
@@ -191,3 +192,14 @@ TEST_CASE("alia_mem_fn", "[signals][application]")
     REQUIRE(
         read_signal(lazy_apply(alia_mem_fn(substr), v, value(5))) == "text");
 }
+
+TEST_CASE("apply allocations", "[signals][application]")
+{
+    alia::system sys;
+    sys.controller = [](context ctx) {
+        auto s = apply(
+            ctx, [](int x, int y) { return x * 2 + y; }, value(1), value(2));
+        do_text(ctx, s);
+    };
+    REQUIRE(count_steady_state_refresh_allocations(sys).allocations == 0);
+}
@@ -123,6 +123,65 @@ TEST_CASE("signal_ref", "[signals][core]")
     REQUIRE(read_signal(s) == 0);
 }
 
+namespace {
+
+// a signal that (like most custom signals) only implements the const& version
+// of write()
+struct copy_only_signal
+    : regular_signal<copy_only_signal, std::string, duplex_signal>
+{
+    explicit copy_only_signal(std::string* v) : v_(v)
+    {
+    }
+    bool
+    has_value() const
+    {
+        return true;
+    }
+    std::string const&
+    read() const
+    {
+        return *v_;
+    }
+    bool
+    ready_to_write() const
+    {
+        return true;
+    }
+    void
+    write(std::string const& value) const
+    {
+        *v_ = value;
+    }
+
+ private:
+    std::string* v_;
+};
+
+} // namespace
+
+TEST_CASE("rvalue writes", "[signals][core]")
+{
+    std::string x;
+
+    // Writing an rvalue to a signal that only implements the const& version
+    // of write() falls back to that version (directly or via signal_ref).
+    copy_only_signal c(&x);
+    write_signal(c, std::string("abc"));
+    REQUIRE(x == "abc");
+    signal_ref<std::string, duplex_signal> c_ref = c;
+    write_signal(c_ref, std::string("def"));
+    REQUIRE(x == "def");
+
+    // Signals that implement the rvalue version move the value through.
+    auto d = direct(x);
+    signal_ref<std::string, duplex_signal> d_ref = d;
+    std::string y(1000, 'a');
+    char const* buffer = y.data();
+    write_signal(d_ref, std::move(y));
+    REQUIRE(x.data() == buffer);
+}
+
 static void
 f_readable(alia::readable<int>)
 {
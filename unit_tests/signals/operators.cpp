@@ -8,6 +8,7 @@
 
 #include <alia/signals/basic.hpp>
 #include <alia/signals/lambdas.hpp>
+#include <alia/signals/state.hpp>
 #include <alia/signals/utilities.hpp>
 
 using namespace alia;
@@ -257,6 +258,60 @@ TEST_CASE("field signal", "[signals][operators]")
     REQUIRE(f.y == "0.5");
 }
 
+TEST_CASE("in-place field writes", "[signals][operators]")
+{
+    struct inner
+    {
+        std::vector<std::string> items;
+    };
+    struct model
+    {
+        std::string name;
+        inner details;
+    };
+    state_holder<model> state(model{"a", inner{{"x", "y"}}});
+    auto s = make_state_signal(state);
+    std::string const* name_storage = &state.get().name;
+
+    auto name = s->*&model::name;
+    REQUIRE(signal_supports_mutation<decltype(name)>::value);
+    captured_id name_id = name.value_id();
+    write_signal(name, "b");
+    REQUIRE(state.get().name == "b");
+    REQUIRE(state.version() == 2);
+    REQUIRE(!name_id.matches(name.value_id()));
+    // The model was modified in place.
+    REQUIRE(&state.get().name == name_storage);
+
+    // Nested fields (and containers within them) work as well.
+    auto items = s->*&model::details->*&inner::items;
+    REQUIRE(signal_supports_mutation<decltype(items)>::value);
+    perform_action(push_back(items) << "z");
+    REQUIRE(
+        state.get().details.items
+        == (std::vector<std::string>{"x", "y", "z"}));
+    REQUIRE(state.version() == 3);
+    write_signal(items[value(0)], "w");
+    REQUIRE(
+        state.get().details.items
+        == (std::vector<std::string>{"w", "y", "z"}));
+    REQUIRE(state.version() == 4);
+    REQUIRE(&state.get().name == name_storage);
+
+    // Signals without mutable access fall back to copying.
+    model m{"c", inner{}};
+    auto l = lambda_duplex(
+        always_has_value,
+        [&]() { return m; },
+        always_ready,
+        [&](model v) { m = std::move(v); },
+        [&]() { return make_id(m.name); });
+    auto l_name = l->*&model::name;
+    REQUIRE(!signal_supports_mutation<decltype(l_name)>::value);
+    write_signal(l_name, "d");
+    REQUIRE(m.name == "d");
+}
+
 struct my_array
 {
     int x[3] = {1, 2, 3};
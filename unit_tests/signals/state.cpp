@@ -2,8 +2,15 @@
 
 #include <testing.hpp>
 
+#include <alia/containers/persistent_vector.hpp>
+#include <alia/flow/actions.hpp>
+#include <alia/signals/adaptors.hpp>
 #include <alia/signals/basic.hpp>
+#include <alia/signals/lambdas.hpp>
 #include <alia/signals/operators.hpp>
+#include <allocation_testing.hpp>
+
+#include <thread>
 
 #include "traversal.hpp"
 
@@ -88,3 +95,336 @@ TEST_CASE("get_state with raw initial value", "[signals][state]")
         REQUIRE(!state_id.matches(state.value_id()));
     });
 }
+
+TEST_CASE("get_state allocations", "[signals][state]")
+{
+    // (The initial value is referenced directly so that the test itself
+    // doesn't allocate a copy of it on every pass.)
+    std::string const initial = "a string that's too long for SSO";
+    alia::system sys;
+    sys.controller = [&](context ctx) {
+        auto i = get_state(ctx, value(12));
+        auto s = get_state(ctx, direct(initial));
+        do_text(ctx, i);
+        do_text(ctx, s);
+    };
+    REQUIRE(count_steady_state_refresh_allocations(sys).allocations == 0);
+}
+
+TEST_CASE("moving values into state", "[signals][state]")
+{
+    state_holder<std::vector<int>> state;
+    auto s = make_state_signal(state);
+
+    // Each of these writes should move the vector all the way into the state,
+    // so the state should end up with the same buffer.
+    auto check_moved = [&](auto const& write) {
+        std::vector<int> v(1000, 1);
+        int const* buffer = v.data();
+        unsigned version = state.version();
+        write(std::move(v));
+        REQUIRE(state.get().data() == buffer);
+        REQUIRE(state.version() == version + 1);
+    };
+
+    check_moved([&](std::vector<int>&& v) { write_signal(s, std::move(v)); });
+    check_moved([&](std::vector<int>&& v) {
+        duplex<std::vector<int>> ref = s;
+        write_signal(ref, std::move(v));
+    });
+    check_moved([&](std::vector<int>&& v) {
+        write_signal(add_fallback(s, empty<std::vector<int>>()), std::move(v));
+    });
+    check_moved([&](std::vector<int>&& v) {
+        write_signal(mask_writes(s, true), std::move(v));
+    });
+    check_moved([&](std::vector<int>&& v) {
+        auto l = lambda_duplex(
+            [&] { return true; },
+            [&] { return state.get(); },
+            [&] { return true; },
+            [&](std::vector<int> x) { state.set(std::move(x)); });
+        write_signal(l, std::move(v));
+    });
+    check_moved([&](std::vector<int>&& v) {
+        auto a = lambda_action(
+            [&](std::vector<int> x) { write_signal(s, std::move(x)); });
+        perform_action(a, std::move(v));
+    });
+}
+
+TEST_CASE("in-place state mutation", "[signals][state]")
+{
+    state_holder<std::vector<std::string>> state(
+        std::vector<std::string>{"a", "b", "c"});
+    auto s = make_state_signal(state);
+    REQUIRE(signal_supports_item_mutation<decltype(s)>::value);
+    REQUIRE(signal_has_item_versions<decltype(s)>::value);
+
+    // Capture the IDs of all items, returning which ones have changed since
+    // the last call.
+    std::vector<captured_id> ids;
+    auto changed_items = [&]() {
+        std::vector<size_t> changed;
+        size_t n = read_signal(s).size();
+        ids.resize(n);
+        for (size_t i = 0; i != n; ++i)
+        {
+            auto item = s[value(i)];
+            if (!ids[i].matches(item.value_id()))
+            {
+                changed.push_back(i);
+                ids[i].capture(item.value_id());
+            }
+        }
+        return changed;
+    };
+    REQUIRE(changed_items() == (std::vector<size_t>{0, 1, 2}));
+    REQUIRE(changed_items() == (std::vector<size_t>{}));
+
+    auto buffer = read_signal(s).data();
+    auto check = [&](auto action, std::vector<std::string> const& expected) {
+        unsigned version = state.version();
+        perform_action(action);
+        REQUIRE(read_signal(s) == expected);
+        REQUIRE(state.version() == version + 1);
+    };
+
+    check(update_at(s) << 1 << "B", {"a", "B", "c"});
+    REQUIRE(changed_items() == (std::vector<size_t>{1}));
+    // The container was updated in place.
+    REQUIRE(read_signal(s).data() == buffer);
+
+    write_signal(s[value(2)], "C");
+    REQUIRE(read_signal(s) == (std::vector<std::string>{"a", "B", "C"}));
+    REQUIRE(changed_items() == (std::vector<size_t>{2}));
+    REQUIRE(read_signal(s).data() == buffer);
+
+    check(push_back(s) << "d", {"a", "B", "C", "d"});
+    REQUIRE(changed_items() == (std::vector<size_t>{3}));
+
+    check(insert(s) << 2 << "x", {"a", "B", "x", "C", "d"});
+    REQUIRE(changed_items() == (std::vector<size_t>{2, 3, 4}));
+
+    check(erase_at(s) << 3, {"a", "B", "x", "d"});
+    REQUIRE(changed_items() == (std::vector<size_t>{3}));
+
+    // Writing the whole container changes all items.
+    write_signal(s, std::vector<std::string>{"a", "B"});
+    REQUIRE(changed_items() == (std::vector<size_t>{0, 1}));
+
+    // Out-of-range updates do nothing.
+    unsigned version = state.version();
+    perform_action(update_at(s) << 7 << "z");
+    perform_action(erase_at(s) << 7);
+    REQUIRE(state.version() == version);
+    REQUIRE(changed_items() == (std::vector<size_t>{}));
+}
+
+TEST_CASE("persistent container state", "[signals][state]")
+{
+    typedef persistent_vector<std::string> list;
+    state_holder<list> state(list{"a", "b", "c"});
+    auto s = make_state_signal(state);
+    REQUIRE(signal_supports_item_mutation<decltype(s)>::value);
+    // The items identify themselves, so the state doesn't track their
+    // versions.
+    REQUIRE(!signal_has_item_versions<decltype(s)>::value);
+
+    std::vector<captured_id> ids;
+    auto changed_items = [&]() {
+        std::vector<size_t> changed;
+        size_t n = read_signal(s).size();
+        ids.resize(n);
+        for (size_t i = 0; i != n; ++i)
+        {
+            auto item = s[value(i)];
+            if (!ids[i].matches(item.value_id()))
+            {
+                changed.push_back(i);
+                ids[i].capture(item.value_id());
+            }
+        }
+        return changed;
+    };
+    REQUIRE(changed_items() == (std::vector<size_t>{0, 1, 2}));
+    REQUIRE(changed_items() == (std::vector<size_t>{}));
+
+    // Keeping every version around (e.g., for undo) is cheap since they all
+    // share structure.
+    std::vector<list> history;
+    auto check = [&](auto action, list const& expected) {
+        history.push_back(read_signal(s));
+        perform_action(action);
+        REQUIRE(read_signal(s) == expected);
+    };
+
+    check(update_at(s) << 1 << "B", {"a", "B", "c"});
+    REQUIRE(changed_items() == (std::vector<size_t>{1}));
+
+    check(push_back(s) << "d", {"a", "B", "c", "d"});
+    REQUIRE(changed_items() == (std::vector<size_t>{3}));
+
+    check(insert(s) << 2 << "x", {"a", "B", "x", "c", "d"});
+    REQUIRE(changed_items() == (std::vector<size_t>{2, 3, 4}));
+
+    check(erase_at(s) << 0, {"B", "x", "c", "d"});
+    REQUIRE(changed_items() == (std::vector<size_t>{0, 1, 2, 3}));
+
+    REQUIRE(history[0] == (list{"a", "b", "c"}));
+    REQUIRE(history[3] == (list{"a", "B", "x", "c", "d"}));
+
+    // Restoring an old version only changes the items that differ.
+    write_signal(s, history[2]);
+    REQUIRE(read_signal(s) == (list{"a", "B", "c", "d"}));
+    REQUIRE(changed_items() == (std::vector<size_t>{0, 1}));
+}
+
+TEST_CASE("state transactions", "[signals][state]")
+{
+    alia::system sys;
+    sys.controller = [](context) {};
+    state_holder<int> a(0), b(0), c(0);
+    auto sa = make_state_signal(a);
+    auto sb = make_state_signal(b);
+    auto sc = make_state_signal(c);
+
+    // Without a transaction, every write is a new version.
+    perform_action((sa <<= 1, sb <<= 1));
+    perform_action(sa <<= sa + 1);
+    REQUIRE(read_signal(sa) == 2);
+    REQUIRE(a.version() == 3);
+
+    captured_id intermediate_id;
+    {
+        transaction t(sys);
+        // Later actions see the results of earlier ones.
+        perform_action(sa <<= sa + 1);
+        intermediate_id.capture(sa.value_id());
+        perform_action((sa <<= sa + 1, sb <<= sa + 2));
+        REQUIRE(read_signal(sa) == 4);
+        REQUIRE(read_signal(sb) == 5);
+        // Versions don't change until the commit.
+        REQUIRE(intermediate_id.matches(sa.value_id()));
+        REQUIRE(a.version() == 3);
+        {
+            // A nested transaction becomes part of the outer one.
+            transaction nested(sys);
+            write_signal(sa, 5);
+            write_signal(sc, 1);
+            REQUIRE(nested.changed_state_count() == 3);
+        }
+        REQUIRE(!system_needs_refresh(sys));
+        REQUIRE(t.changed_state_count() == 3);
+    }
+    // Each state got exactly one new version for all of its changes, and a
+    // refresh was requested.
+    REQUIRE(read_signal(sa) == 5);
+    REQUIRE(!intermediate_id.matches(sa.value_id()));
+    REQUIRE(a.version() == 4);
+    REQUIRE(b.version() == 3);
+    REQUIRE(c.version() == 2);
+    REQUIRE(system_needs_refresh(sys));
+
+    // A transaction that doesn't change anything doesn't request a refresh.
+    refresh_system(sys);
+    {
+        transaction t(sys);
+    }
+    REQUIRE(!system_needs_refresh(sys));
+
+    // In-place item changes are batched too, and the item versions still
+    // reflect exactly which items changed.
+    state_holder<std::vector<std::string>> list(
+        std::vector<std::string>{"a", "b", "c"});
+    auto sl = make_state_signal(list);
+    unsigned version = list.version();
+    unsigned unchanged_version = list.item_version(1);
+    {
+        transaction t(sys);
+        perform_action(push_back(sl) << "d");
+        perform_action(update_at(sl) << 0 << "A");
+    }
+    REQUIRE(list.version() == version + 1);
+    REQUIRE(list.item_version(0) == version + 1);
+    REQUIRE(list.item_version(1) == unchanged_version);
+    REQUIRE(list.item_version(3) == version + 1);
+
+    // State that's initialized within a transaction has a value immediately,
+    // but it only gets its first version at the commit.
+    {
+        state_holder<int> uninitialized;
+        {
+            transaction t(sys);
+            make_state_signal(uninitialized).write(1);
+            make_state_signal(uninitialized).write(2);
+            REQUIRE(uninitialized.is_initialized());
+            REQUIRE(uninitialized.version() == 0);
+            REQUIRE(read_signal(make_state_signal(uninitialized)) == 2);
+        }
+        REQUIRE(uninitialized.version() == 1);
+    }
+
+    // A state that's destroyed within a transaction is simply forgotten.
+    {
+        transaction t(sys);
+        state_holder<int> temporary(0);
+        make_state_signal(temporary).write(1);
+        REQUIRE(t.changed_state_count() == 1);
+    }
+
+    // Transactions can also be started from within a traversal.
+    int write_count = 0;
+    sys.controller = [&](context ctx) {
+        on_refresh(ctx, [&](auto ctx) {
+            if (write_count == 0)
+            {
+                transaction t(ctx);
+                write_signal(sa, 6);
+                write_signal(sa, 7);
+                ++write_count;
+            }
+        });
+    };
+    refresh_system(sys);
+    REQUIRE(read_signal(sa) == 7);
+    REQUIRE(a.version() == 5);
+    REQUIRE(system_needs_refresh(sys));
+}
+
+TEST_CASE("state transactions on multiple threads", "[signals][state]")
+{
+    alia::system sys;
+    sys.controller = [](context) {};
+    state_holder<int> s(0);
+
+    // Transactions on different threads must still be distinguishable, since
+    // the same state can be written from any of them.
+    auto write_in_transaction = [&](int value) {
+        size_t changed_state_count = 0;
+        std::thread thread([&] {
+            transaction t(sys);
+            s.set(value);
+            changed_state_count = t.changed_state_count();
+        });
+        thread.join();
+        REQUIRE(changed_state_count == 1);
+    };
+    write_in_transaction(1);
+    unsigned version = s.version();
+    refresh_system(sys);
+    write_in_transaction(2);
+    REQUIRE(s.get() == 2);
+    REQUIRE(s.version() == version + 1);
+    REQUIRE(system_needs_refresh(sys));
+
+    // State that's destroyed on another thread is still forgotten by the
+    // transaction that it's part of.
+    {
+        transaction t(sys);
+        auto temporary = std::make_unique<state_holder<int>>(0);
+        temporary->set(1);
+        REQUIRE(t.changed_state_count() == 1);
+        std::thread([&] { temporary.reset(); }).join();
+    }
+}
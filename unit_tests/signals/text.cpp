@@ -5,6 +5,11 @@
 #include <testing.hpp>
 
 #include <alia/signals/basic.hpp>
+#include <allocation_testing.hpp>
+
+#include <cmath>
+#include <limits>
+#include <vector>
 
 #include "traversal.hpp"
 
@@ -27,6 +32,147 @@ TEST_CASE("printf", "[signals][text]")
     check_traversal(sys, controller, "hello world;n is  2.1;");
 }
 
+namespace {
+
+template<class... Args>
+std::vector<printf_argument>
+printf_args(Args... args)
+{
+    return std::vector<printf_argument>{make_printf_argument(args)...};
+}
+
+} // namespace
+
+TEST_CASE("printf formats", "[signals][text]")
+{
+    printf_format format;
+    std::string output;
+    auto check = [&](char const* text,
+                     std::vector<printf_argument> const& args,
+                     std::string const& expected) {
+        compile_printf_format(format, text);
+        format_printf(output, format, args.data(), args.size());
+        REQUIRE(output == expected);
+    };
+
+    check("%d|%i|%u", printf_args(-12, 0, 42u), "-12|0|42");
+    check("%hd %ld %lld %zu", printf_args(short(-1), -2l, -3ll, size_t(4)),
+          "-1 -2 -3 4");
+    check("%05d|%-4d|%+d", printf_args(42, 7, 3), "00042|7   |+3");
+    check("%x %X %o", printf_args(255, 255u, 8), "ff FF 10");
+
+    // Integers are formatted at the width of their own types (or the type
+    // named by the length modifier), as printf would do.
+    check(
+        "%x %X %o %u",
+        printf_args(-1, -1, -1, -1),
+        "ffffffff FFFFFFFF 37777777777 4294967295");
+    check("%x|%u", printf_args(short(-1), short(-1)), "ffffffff|4294967295");
+    check("%hx|%hu|%hd", printf_args(-1, -1, 65535), "ffff|65535|-1");
+    check("%hhd|%hhu|%hhx", printf_args(300, -1, 256), "44|255|0");
+    check("%5u|%d", printf_args(-2, 4294967295u), "4294967294|-1");
+    check("%llx", printf_args(-1ll), "ffffffffffffffff");
+    check("%c%c", printf_args('o', 'k'), "ok");
+    check("%.2f %g %e", printf_args(1.125, 0.5f, 2), "1.12 0.5 2.000000e+00");
+    check(
+        "%*d|%.*f|%*.*s",
+        printf_args(4, 1, 2, 3.14159, 5, 2, "abc"),
+        "   1|3.14|   ab");
+    check("100%% %s", printf_args("sure"), "100% sure");
+    check("%s", printf_args((char const*) nullptr), "(null)");
+    check("no conversions", printf_args(), "no conversions");
+    check(
+        "%d",
+        printf_args(std::numeric_limits<long long>::min()),
+        "-9223372036854775808");
+
+    // Long output is handled.
+    std::string long_string(1000, 'x');
+    check("[%s]", printf_args(long_string.c_str()), "[" + long_string + "]");
+    check("[%1000d]", printf_args(1), "[" + std::string(999, ' ') + "1]");
+
+    // Invalid formats are rejected.
+    REQUIRE_THROWS_AS(compile_printf_format(format, "%q"), printf_format_error);
+    REQUIRE_THROWS_AS(compile_printf_format(format, "%n"), printf_format_error);
+    REQUIRE_THROWS_AS(
+        compile_printf_format(format, "trailing %"), printf_format_error);
+
+    // Mismatched arguments are rejected.
+    auto check_error
+        = [&](char const* text, std::vector<printf_argument> const& args) {
+              compile_printf_format(format, text);
+              REQUIRE_THROWS_AS(
+                  format_printf(output, format, args.data(), args.size()),
+                  printf_format_error);
+          };
+    check_error("%d %d", printf_args(1));
+    check_error("%d", printf_args(1.5));
+    check_error("%s", printf_args(1));
+    check_error("%f", printf_args("1.5"));
+    check_error("%*d", printf_args(1.5, 1));
+}
+
+TEST_CASE("printf value IDs", "[signals][text]")
+{
+    alia::system sys;
+
+    double x = 1.2;
+    std::string format = "%.0f";
+    captured_id id;
+    char const* storage = nullptr;
+    std::string text;
+    auto refresh = [&]() {
+        do_traversal(sys, [&](context ctx) {
+            auto s = printf(ctx, direct(format), value(x));
+            REQUIRE(signal_has_value(s));
+            id.capture(s.value_id());
+            storage = read_signal(s).data();
+            text = read_signal(s);
+        });
+    };
+
+    refresh();
+    REQUIRE(text == "1");
+    auto original_id = id;
+    auto original_storage = storage;
+
+    // If the arguments change but the output doesn't, neither the ID nor the
+    // storage changes.
+    x = 1.3;
+    refresh();
+    REQUIRE(text == "1");
+    REQUIRE(id == original_id);
+    REQUIRE(storage == original_storage);
+
+    x = 2.4;
+    refresh();
+    REQUIRE(text == "2");
+    REQUIRE(id != original_id);
+
+    // Changing the format causes it to be recompiled.
+    format = "x=%.1f";
+    refresh();
+    REQUIRE(text == "x=2.4");
+}
+
+TEST_CASE("printf allocations", "[signals][text]")
+{
+    alia::system sys;
+    // The value changes on every refresh, so the text is reformatted each
+    // time. (It's long enough that it doesn't fit in a small string buffer.)
+    int n = 0;
+    std::size_t total_length = 0;
+    sys.controller = [&](context ctx) {
+        ++n;
+        auto text = printf(
+            ctx, "the value of n is %d, %s", value(n), value("abc"));
+        if (signal_has_value(text))
+            total_length += read_signal(text).size();
+    };
+    REQUIRE(count_steady_state_refresh_allocations(sys).allocations == 0);
+    REQUIRE(total_length != 0);
+}
+
 TEST_CASE("text conversions", "[signals][text]")
 {
     {
@@ -64,6 +210,127 @@ TEST_CASE("text conversions", "[signals][text]")
     }
 }
 
+TEST_CASE("numeric text formatting", "[signals][text]")
+{
+    REQUIRE(to_string(0) == "0");
+    REQUIRE(to_string(-121) == "-121");
+    REQUIRE(to_string(std::numeric_limits<short>::min()) == "-32768");
+    REQUIRE(to_string(65535u) == "65535");
+    REQUIRE(
+        to_string(std::numeric_limits<long long>::min())
+        == "-9223372036854775808");
+    REQUIRE(
+        to_string(std::numeric_limits<unsigned long long>::max())
+        == "18446744073709551615");
+
+    REQUIRE(to_string(0.) == "0");
+    REQUIRE(to_string(-0.) == "-0");
+    REQUIRE(to_string(1.2) == "1.2");
+    REQUIRE(to_string(-4.5) == "-4.5");
+    REQUIRE(to_string(100.) == "100");
+    REQUIRE(to_string(0.001) == "0.001");
+    REQUIRE(to_string(1e6) == "1e+06");
+    REQUIRE(to_string(1.5e-7) == "1.5e-07");
+    REQUIRE(to_string(1e300) == "1e+300");
+    REQUIRE(to_string(0.1 + 0.2) == "0.30000000000000004");
+    REQUIRE(to_string(1. / 3) == "0.3333333333333333");
+    REQUIRE(to_string(0.1f) == "0.1");
+    REQUIRE(to_string(16777216.f) == "16777216");
+    REQUIRE(to_string(std::numeric_limits<double>::infinity()) == "inf");
+    REQUIRE(to_string(-std::numeric_limits<float>::infinity()) == "-inf");
+    REQUIRE(to_string(std::numeric_limits<double>::quiet_NaN()) == "nan");
+
+    // Formatting is always shortest round-trip.
+    double doubles[]
+        = {std::numeric_limits<double>::min(),
+           std::numeric_limits<double>::max(),
+           std::numeric_limits<double>::denorm_min(),
+           std::numeric_limits<double>::epsilon(),
+           123456.789,
+           9007199254740993.,
+           5e-324,
+           2.2250738585072011e-308};
+    for (double x : doubles)
+    {
+        double y;
+        from_string(&y, to_string(x));
+        REQUIRE(y == x);
+    }
+    float floats[]
+        = {std::numeric_limits<float>::min(),
+           std::numeric_limits<float>::max(),
+           std::numeric_limits<float>::denorm_min(),
+           3.14159265f,
+           1e-10f};
+    for (float x : floats)
+    {
+        float y;
+        from_string(&y, to_string(x));
+        REQUIRE(y == x);
+    }
+}
+
+TEST_CASE("numeric text parsing", "[signals][text]")
+{
+    {
+        double x;
+        from_string(&x, " 1.25 ");
+        REQUIRE(x == 1.25);
+        from_string(&x, "+.5");
+        REQUIRE(x == 0.5);
+        from_string(&x, "3.");
+        REQUIRE(x == 3);
+        from_string(&x, "-2E3");
+        REQUIRE(x == -2000);
+        from_string(&x, "0.000000000000000000000000000001");
+        REQUIRE(x == 1e-30);
+        from_string(&x, "123456789012345678901234567890");
+        REQUIRE(x == 123456789012345678901234567890.);
+        from_string(&x, "0.1000000000000000055511151231257827");
+        REQUIRE(x == 0.1);
+        REQUIRE_THROWS_AS(from_string(&x, ""), validation_error);
+        REQUIRE_THROWS_AS(from_string(&x, "."), validation_error);
+        REQUIRE_THROWS_AS(from_string(&x, "1e"), validation_error);
+        REQUIRE_THROWS_AS(from_string(&x, "1.2.3"), validation_error);
+        REQUIRE_THROWS_AS(from_string(&x, "1e999"), validation_error);
+        REQUIRE_THROWS_AS(from_string(&x, "0x10"), validation_error);
+    }
+    {
+        float x;
+        from_string(&x, "0.1");
+        REQUIRE(x == 0.1f);
+        // This is just above the midpoint between 1 and the next float, so
+        // rounding it to double first would give 1.
+        from_string(&x, "1.00000005960464477539062500000000001");
+        REQUIRE(x == std::nextafter(1.f, 2.f));
+        REQUIRE_THROWS_AS(from_string(&x, "1e39"), validation_error);
+        REQUIRE_THROWS_AS(from_string(&x, "-1e39"), validation_error);
+    }
+    {
+        long long x;
+        from_string(&x, "-9223372036854775808");
+        REQUIRE(x == std::numeric_limits<long long>::min());
+        from_string(&x, " +42\t");
+        REQUIRE(x == 42);
+        from_string(&x, "-0");
+        REQUIRE(x == 0);
+        REQUIRE_THROWS_AS(
+            from_string(&x, "9223372036854775808"), validation_error);
+        REQUIRE_THROWS_AS(from_string(&x, "1.5"), validation_error);
+        REQUIRE_THROWS_AS(from_string(&x, "1e3"), validation_error);
+    }
+    {
+        unsigned long long x;
+        from_string(&x, "18446744073709551615");
+        REQUIRE(x == std::numeric_limits<unsigned long long>::max());
+        REQUIRE_THROWS_AS(
+            from_string(&x, "18446744073709551616"), validation_error);
+        REQUIRE_THROWS_AS(
+            from_string(&x, "100000000000000000000"), validation_error);
+        REQUIRE_THROWS_AS(from_string(&x, "-1"), validation_error);
+    }
+}
+
 TEST_CASE("as_text", "[signals][text]")
 {
     alia::system sys;
@@ -146,3 +413,13 @@ TEST_CASE("as_duplex_text value_id", "[signals][text]")
     REQUIRE(x == 7);
     REQUIRE(last_id != signal_id);
 }
+
+TEST_CASE("as_text allocations", "[signals][text]")
+{
+    alia::system sys;
+    sys.controller = [](context ctx) {
+        do_text(ctx, as_text(ctx, value(12)));
+        do_text(ctx, as_text(ctx, value(1.5)));
+    };
+    REQUIRE(count_steady_state_refresh_allocations(sys).allocations == 0);
+}
@@ -3,6 +3,9 @@
 #include <testing.hpp>
 
 #include <alia/signals/basic.hpp>
+#include <alia/signals/lambdas.hpp>
+
+#include <vector>
 
 using namespace alia;
 
@@ -150,6 +153,56 @@ TEST_CASE("simple ID preferring", "[signals][utilities]")
     REQUIRE(s.value_id() == simple_id<std::string>("a very complex ID"));
 }
 
+namespace {
+
+struct big_value
+{
+    std::vector<double> samples;
+};
+
+} // namespace
+
+namespace alia {
+
+template<>
+struct stable_hash_traits<big_value>
+{
+    static bool
+    compute(big_value const& value, std::uint64_t& hash)
+    {
+        return stable_hash_traits<std::vector<double>>::compute(
+            value.samples, hash);
+    }
+};
+
+template<>
+struct type_prefers_hashed_id<big_value> : std::true_type
+{
+};
+
+} // namespace alia
+
+TEST_CASE("hashed ID preferring", "[signals][utilities]")
+{
+    big_value x{{1.5, 2, 3}};
+    auto hash_id = make_id(get_stable_hash(x));
+
+    REQUIRE(value(x).value_id() == hash_id);
+    REQUIRE(direct(x).value_id() == hash_id);
+    REQUIRE(
+        lambda_reader([]() { return true; }, [&]() { return x; }).value_id()
+        == hash_id);
+    REQUIRE(lambda_reader([]() { return false; }, [&]() { return x; })
+                .value_id()
+            == null_id);
+
+    captured_id captured;
+    captured.capture(direct(x).value_id());
+    REQUIRE(captured.matches(direct(x).value_id()));
+    x.samples[1] = 2.5;
+    REQUIRE(!captured.matches(direct(x).value_id()));
+}
+
 TEST_CASE("refresh_signal_shadow", "[signals][utilities]")
 {
     int new_value_count = 0, lost_value_count = 0;
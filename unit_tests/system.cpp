@@ -0,0 +1,118 @@
+#include <alia/system.hpp>
+
+#include <alia/flow/events.hpp>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include <testing.hpp>
+
+using namespace alia;
+
+namespace {
+
+struct waking_external_interface : external_interface
+{
+    std::atomic<int> wake_count{0};
+
+    void
+    wake() override
+    {
+        ++wake_count;
+    }
+};
+
+} // namespace
+
+TEST_CASE("posted closures", "[system]")
+{
+    alia::system sys;
+    waking_external_interface external;
+    sys.external = &external;
+    int refresh_count = 0;
+    sys.controller = [&](context ctx) {
+        if (is_refresh_event(ctx))
+            ++refresh_count;
+    };
+
+    REQUIRE(!system_needs_refresh(sys));
+    REQUIRE(!update_system(sys));
+
+    std::vector<int> order;
+    post_to_system(sys, [&](alia::system&) { order.push_back(1); });
+    post_to_system(sys, [&](alia::system&) { order.push_back(2); });
+    request_refresh(sys);
+    REQUIRE(external.wake_count == 3);
+    REQUIRE(system_needs_refresh(sys));
+
+    // Everything is coalesced into a single refresh.
+    REQUIRE(update_system(sys));
+    REQUIRE(order == std::vector<int>{1, 2});
+    REQUIRE(refresh_count == 1);
+    REQUIRE(!system_needs_refresh(sys));
+    REQUIRE(!update_system(sys));
+
+    // If a closure throws, the ones after it stay queued.
+    post_to_system(sys, [&](alia::system&) { throw 0; });
+    post_to_system(sys, [&](alia::system&) { order.push_back(3); });
+    REQUIRE_THROWS(update_system(sys));
+    REQUIRE(order == std::vector<int>{1, 2});
+    REQUIRE(system_needs_refresh(sys));
+    post_to_system(sys, [&](alia::system&) { order.push_back(4); });
+    REQUIRE(update_system(sys));
+    REQUIRE(order == std::vector<int>{1, 2, 3, 4});
+    REQUIRE(refresh_count == 2);
+    REQUIRE(!system_needs_refresh(sys));
+
+    // A closure that's posted after update_system has taken the others (but
+    // before the refresh) isn't lost.
+    post_to_system(sys, [&](alia::system& sys) {
+        post_to_system(sys, [&](alia::system&) { order.push_back(6); });
+        order.push_back(5);
+    });
+    REQUIRE(update_system(sys));
+    REQUIRE(order == std::vector<int>{1, 2, 3, 4, 5});
+    REQUIRE(system_needs_refresh(sys));
+    REQUIRE(update_system(sys));
+    REQUIRE(order == std::vector<int>{1, 2, 3, 4, 5, 6});
+    REQUIRE(!system_needs_refresh(sys));
+
+    // Closures that are never run are cleaned up with the system.
+    post_to_system(sys, [&](alia::system&) { order.push_back(7); });
+    post_to_system(sys, [&](alia::system&) { throw 0; });
+    post_to_system(sys, [&](alia::system&) { order.push_back(8); });
+    REQUIRE_THROWS(update_system(sys));
+}
+
+TEST_CASE("cross-thread posting", "[system]")
+{
+    alia::system sys;
+    int refresh_count = 0;
+    sys.controller = [&](context ctx) {
+        if (is_refresh_event(ctx))
+            ++refresh_count;
+    };
+
+    int const thread_count = 4, posts_per_thread = 1000;
+    int total = 0;
+    std::atomic<int> finished_threads{0};
+    std::vector<std::thread> threads;
+    for (int i = 0; i != thread_count; ++i)
+    {
+        threads.emplace_back([&] {
+            for (int j = 0; j != posts_per_thread; ++j)
+                post_to_system(sys, [&](alia::system&) { ++total; });
+            ++finished_threads;
+        });
+    }
+    while (finished_threads != thread_count)
+        update_system(sys);
+    for (auto& thread : threads)
+        thread.join();
+    update_system(sys);
+
+    REQUIRE(total == thread_count * posts_per_thread);
+    REQUIRE(refresh_count <= thread_count * posts_per_thread);
+    REQUIRE(!system_needs_refresh(sys));
+}
@@ -0,0 +1,168 @@
+#include <alia/timing/animation_engine.hpp>
+
+#include <alia/flow/macros.hpp>
+#include <alia/timing/smoothing.hpp>
+
+#include <testing.hpp>
+
+#include <allocation_testing.hpp>
+
+#include "traversal.hpp"
+
+using namespace alia;
+
+namespace {
+
+struct manual_clock_external : external_interface
+{
+    millisecond_count tick_count = 0;
+
+    millisecond_count
+    get_tick_count() const override
+    {
+        return tick_count;
+    }
+};
+
+} // namespace
+
+TEST_CASE("batched smooth_raw", "[timing][animation_engine]")
+{
+    animation_engine engine;
+    alia::system sys;
+    manual_clock_external external;
+    sys.external = &external;
+    sys.animations = &engine;
+
+    batched_value_smoother<int> smoother;
+    auto transition = animated_transition{linear_curve, 100};
+
+    // This follows the same sequence as the unbatched smooth_raw test, so the
+    // results should be identical.
+    auto check = [&](millisecond_count tick, int x, int expected) {
+        external.tick_count = tick;
+        do_traversal(sys, [&](context ctx) {
+            REQUIRE(smooth_raw(ctx, smoother, x, transition) == expected);
+        });
+    };
+
+    check(0, 0, 0);
+    REQUIRE(!system_needs_refresh(sys));
+    REQUIRE(!smoother.slot.group);
+
+    check(100, 10, 0);
+    REQUIRE(system_needs_refresh(sys));
+    REQUIRE(get_animation_engine_stats(engine).active_transitions == 1);
+    check(110, 10, 1);
+    check(150, 0, 5);
+    check(170, 0, 3);
+    check(200, 0, 0);
+    REQUIRE(!system_needs_refresh(sys));
+    REQUIRE(get_animation_engine_stats(engine).active_transitions == 0);
+
+    check(300, 20, 0);
+    check(350, 30, 10);
+    check(400, 30, 20);
+    check(450, 30, 30);
+    REQUIRE(!system_needs_refresh(sys));
+
+    auto stats = get_animation_engine_stats(engine);
+    REQUIRE(stats.groups == 1);
+    REQUIRE(stats.slots == 1);
+    REQUIRE(stats.active_transitions == 0);
+}
+
+TEST_CASE("batched smooth", "[timing][animation_engine]")
+{
+    animation_engine engine;
+    alia::system sys;
+    manual_clock_external external;
+    sys.external = &external;
+    sys.animations = &engine;
+
+    int const count = 100;
+    double target = 0;
+    bool show = true;
+    std::vector<double> outputs(count);
+    sys.controller = [&](context ctx) {
+        ALIA_IF(show)
+        {
+            for (int i = 0; i != count; ++i)
+            {
+                auto transition = animated_transition{
+                    i % 2 == 0 ? linear_curve : ease_in_out_curve,
+                    millisecond_count(100 + (i % 3) * 100)};
+                auto x = smooth(ctx, value(target * i), transition);
+                outputs[i] = read_signal(x);
+            }
+        }
+        ALIA_END
+    };
+
+    refresh_system(sys);
+    REQUIRE(get_animation_engine_stats(engine).slots == 0);
+
+    target = 1;
+    external.tick_count = 1000;
+    refresh_system(sys);
+    auto stats = get_animation_engine_stats(engine);
+    REQUIRE(stats.groups == 6);
+    REQUIRE(stats.slots == count - 1);
+    REQUIRE(stats.active_transitions == count - 1);
+
+    // Compare the batched results against the curves themselves.
+    external.tick_count = 1050;
+    refresh_system(sys);
+    for (int i = 0; i != count; ++i)
+    {
+        auto curve = i % 2 == 0 ? linear_curve : ease_in_out_curve;
+        double duration = 100 + (i % 3) * 100;
+        double expected
+            = i * eval_curve_at_x(curve, 50 / duration, 1e-9);
+        REQUIRE(outputs[i] == Approx(expected).margin(0.001 * i));
+    }
+
+    external.tick_count = 1300;
+    refresh_system(sys);
+    for (int i = 0; i != count; ++i)
+        REQUIRE(outputs[i] == i);
+    REQUIRE(get_animation_engine_stats(engine).active_transitions == 0);
+    REQUIRE(!system_needs_refresh(sys));
+
+    // When the smoothers go away, their slots are released (and reused).
+    show = false;
+    refresh_system(sys);
+    REQUIRE(get_animation_engine_stats(engine).slots == 0);
+    show = true;
+    target = 2;
+    refresh_system(sys);
+    REQUIRE(get_animation_engine_stats(engine).slots == 0);
+    target = 3;
+    refresh_system(sys);
+    stats = get_animation_engine_stats(engine);
+    REQUIRE(stats.groups == 6);
+    REQUIRE(stats.slots == count - 1);
+    size_t allocated_slots = 0;
+    for (auto const& group : engine.groups)
+        allocated_slots += group->values.size();
+    REQUIRE(allocated_slots == size_t(count - 1));
+}
+
+TEST_CASE("batched smooth allocations", "[timing][animation_engine]")
+{
+    animation_engine engine;
+    alia::system sys;
+    sys.animations = &engine;
+    // The input changes on every refresh, so each one starts a new transition
+    // and reads the smoothed value.
+    int frame = 0;
+    double total = 0;
+    sys.controller = [&](context ctx) {
+        ++frame;
+        auto smoothed = smooth(ctx, value(frame % 2 == 0 ? 4.0 : 8.0));
+        if (signal_has_value(smoothed))
+            total += read_signal(smoothed);
+    };
+    REQUIRE(count_steady_state_refresh_allocations(sys).allocations == 0);
+    REQUIRE(total > 0);
+}
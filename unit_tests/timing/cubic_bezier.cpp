@@ -1,5 +1,8 @@
 #include <alia/timing/cubic_bezier.hpp>
 
+#include <algorithm>
+#include <cmath>
+
 #include <testing.hpp>
 
 using namespace alia;
@@ -75,3 +78,53 @@ TEST_CASE("degenerate cubic bezier", "[timing][cubic_bezier]")
                       coeff, 0.00001, error_tolerance))
                .epsilon(error_tolerance * 2));
 }
+
+TEST_CASE("compiled cubic bezier", "[timing][cubic_bezier]")
+{
+    unit_cubic_bezier curve = {0.25, 0.1, 0.25, 1};
+
+    // Tables can be computed at compile time.
+    constexpr auto compile_time_table
+        = compile_curve<16>({0.42, 0, 0.58, 1}, curve_interpolation::LINEAR);
+    static_assert(compile_time_table.y[0] == 0, "");
+    static_assert(compile_time_table.y[16] == 1, "");
+    static_assert(eval_curve_at_x(compile_time_table, 0.5) > 0.49, "");
+    static_assert(eval_curve_at_x(compile_time_table, 0.5) < 0.51, "");
+
+    auto hermite = compile_curve<64>(curve);
+    auto linear = compile_curve<64>(curve, curve_interpolation::LINEAR);
+    REQUIRE(hermite.max_error < linear.max_error);
+    REQUIRE(hermite.max_error < 0.001);
+
+    auto coeff = compute_curve_coefficients(curve);
+    double worst_hermite = 0, worst_linear = 0;
+    for (int i = 0; i <= 1000; ++i)
+    {
+        double x = i / 1000.;
+        double exact = eval_curve_at_x(curve, x, 1e-9);
+        worst_hermite = (std::max)(
+            worst_hermite, std::fabs(eval_curve_at_x(hermite, x) - exact));
+        worst_linear = (std::max)(
+            worst_linear, std::fabs(eval_curve_at_x(linear, x) - exact));
+        REQUIRE(
+            sample_curve_y(coeff, solve_for_t_at_x(coeff, x, 1e-9))
+            == Approx(exact));
+    }
+    // The measured error is a good estimate of the actual error.
+    REQUIRE(worst_hermite <= hermite.max_error * 1.5 + 1e-9);
+    REQUIRE(worst_linear <= linear.max_error * 1.5 + 1e-9);
+}
+
+TEST_CASE("degenerate compiled cubic bezier", "[timing][cubic_bezier]")
+{
+    // This curve is vertical at the start.
+    unit_cubic_bezier curve = {0, 0.5, 0, 1};
+    auto table = compile_curve<64>(curve);
+    for (int i = 0; i <= 100; ++i)
+    {
+        double x = i / 100.;
+        REQUIRE(
+            eval_curve_at_x(table, x)
+            == Approx(eval_curve_at_x(curve, x, 1e-9)).margin(table.max_error));
+    }
+}
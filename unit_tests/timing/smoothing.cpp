@@ -3,6 +3,7 @@
 #include <testing.hpp>
 
 #include <complex>
+#include <allocation_testing.hpp>
 
 #include "traversal.hpp"
 
@@ -31,6 +32,35 @@ TEST_CASE("interpolation", "[timing][smoothing]")
         == Approx(1));
 }
 
+TEST_CASE("built-in curve tables", "[timing][smoothing]")
+{
+    animation_curve curves[]
+        = {default_curve,
+           linear_curve,
+           ease_in_curve,
+           ease_out_curve,
+           ease_in_out_curve};
+    for (auto const& curve : curves)
+    {
+        auto const* table = get_builtin_curve_table(curve);
+        REQUIRE(table);
+        REQUIRE(table->max_error < 0.0001);
+        for (int i = 0; i <= 100; ++i)
+        {
+            double x = i / 100.;
+            REQUIRE(
+                eval_animation_curve(curve, x, 0.001)
+                == Approx(eval_curve_at_x(curve, x, 1e-9)).margin(0.001));
+        }
+    }
+
+    animation_curve custom = {0.1, 0.2, 0.3, 0.4};
+    REQUIRE(!get_builtin_curve_table(custom));
+    REQUIRE(
+        eval_animation_curve(custom, 0.5, 0.0001)
+        == eval_curve_at_x(custom, 0.5, 0.0001));
+}
+
 TEST_CASE("smooth_raw", "[timing][smoothing]")
 {
     alia::system sys;
@@ -177,3 +207,20 @@ TEST_CASE("smooth", "[timing][smoothing]")
     });
     REQUIRE(!system_needs_refresh(sys));
 }
+
+TEST_CASE("smooth allocations", "[timing][smoothing]")
+{
+    alia::system sys;
+    // The input changes on every refresh, so each one starts a new transition
+    // and reads the smoothed value.
+    int frame = 0;
+    double total = 0;
+    sys.controller = [&](context ctx) {
+        ++frame;
+        auto smoothed = smooth(ctx, value(frame % 2 == 0 ? 4.0 : 8.0));
+        if (signal_has_value(smoothed))
+            total += read_signal(smoothed);
+    };
+    REQUIRE(count_steady_state_refresh_allocations(sys).allocations == 0);
+    REQUIRE(total > 0);
+}
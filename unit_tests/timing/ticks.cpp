@@ -122,3 +122,144 @@ TEST_CASE("animation_timer", "[signals][temporal]")
 
     REQUIRE(!system_needs_refresh(sys));
 }
+
+struct deadline_external_interface : dummy_external_interface
+{
+    bool has_deadline = false;
+    millisecond_count deadline = 0;
+
+    bool
+    schedule_refresh_at(millisecond_count tick) override
+    {
+        has_deadline = true;
+        deadline = tick;
+        return true;
+    }
+};
+
+TEST_CASE("deadline scheduling", "[signals][temporal]")
+{
+    alia::system sys;
+    deadline_external_interface external;
+    sys.external = &external;
+
+    auto controller = [&](context ctx) {
+        // Two timers with different deadlines...
+        animation_timer_state* short_timer;
+        animation_timer_state* long_timer;
+        if (get_cached_data(ctx, &short_timer))
+        {
+            short_timer->active = true;
+            short_timer->end_tick = 100;
+        }
+        if (get_cached_data(ctx, &long_timer))
+        {
+            long_timer->active = true;
+            long_timer->end_tick = 30000;
+        }
+        raw_animation_timer(ctx, *short_timer);
+        raw_animation_timer(ctx, *long_timer);
+    };
+
+    do_traversal(sys, controller);
+    // The timers don't need continuous refreshes, just the earliest deadline.
+    REQUIRE(!system_needs_refresh(sys));
+    REQUIRE(!external.refresh_requested);
+    REQUIRE(external.has_deadline);
+    REQUIRE(external.deadline == 100);
+    REQUIRE(sys.has_refresh_deadline);
+    REQUIRE(sys.refresh_deadline == 100);
+
+    external.tick_count = 100;
+    external.has_deadline = false;
+    do_traversal(sys, controller);
+    REQUIRE(!system_needs_refresh(sys));
+    REQUIRE(external.has_deadline);
+    REQUIRE(external.deadline == 30000);
+
+    external.tick_count = 30000;
+    external.has_deadline = false;
+    do_traversal(sys, controller);
+    REQUIRE(!external.has_deadline);
+    REQUIRE(!sys.has_refresh_deadline);
+
+    // Reading the time left on a timer requires continuous refreshes, and the
+    // value reflects the current tick.
+    bool started = false;
+    auto displaying_controller = [&](context ctx) {
+        animation_timer_state* state;
+        get_cached_data(ctx, &state);
+        if (!started)
+        {
+            state->active = true;
+            state->end_tick = 30800;
+            started = true;
+        }
+        raw_animation_timer timer(ctx, *state);
+        REQUIRE(timer.ticks_left() == 30800 - external.tick_count);
+    };
+    do_traversal(sys, displaying_controller);
+    REQUIRE(system_needs_refresh(sys));
+    REQUIRE(external.refresh_requested);
+    external.tick_count = 30400;
+    external.refresh_requested = false;
+    do_traversal(sys, displaying_controller);
+    REQUIRE(external.refresh_requested);
+    external.tick_count = 30800;
+    external.refresh_requested = false;
+    do_traversal(sys, displaying_controller);
+    REQUIRE(!system_needs_refresh(sys));
+    REQUIRE(!external.refresh_requested);
+
+    // Interpolations still require continuous refreshes.
+    do_traversal(sys, [&](context ctx) {
+        get_raw_animation_ticks_left(ctx, 31000);
+        request_refresh_at(ctx, 40000);
+    });
+    REQUIRE(system_needs_refresh(sys));
+    REQUIRE(external.refresh_requested);
+    REQUIRE(!external.has_deadline);
+    REQUIRE(sys.refresh_deadline == 40000);
+}
+
+TEST_CASE("precise ticks", "[system]")
+{
+    alia::system sys;
+    dummy_external_interface external;
+    sys.external = &external;
+
+    // By default, the microsecond counter is derived from the external
+    // interface's millisecond counter.
+    external.tick_count = 12;
+    do_traversal(sys, [&](context ctx) {
+        REQUIRE(get_raw_precise_animation_tick_count(ctx) == 12000);
+        REQUIRE(get_raw_animation_tick_count(ctx) == 12);
+    });
+
+    // A clock overrides the external interface.
+    virtual_clock clock;
+    sys.clock = &clock;
+    advance_virtual_clock(clock, 1500);
+    do_traversal(sys, [&](context ctx) {
+        REQUIRE(read_signal(get_precise_animation_tick_count(ctx)) == 1500);
+        REQUIRE(get_raw_animation_tick_count(ctx) == 1);
+        REQUIRE(get_raw_precise_animation_ticks_left(ctx, 2000) == 500);
+    });
+    advance_virtual_clock_ms(clock, 1);
+    do_traversal(sys, [&](context ctx) {
+        REQUIRE(get_raw_precise_animation_tick_count(ctx) == 2500);
+        REQUIRE(get_raw_precise_animation_ticks_left(ctx, 2000) == 0);
+    });
+
+    // The microsecond counter doesn't wrap around when the millisecond
+    // counter does.
+    microsecond_count const wrap = microsecond_count(1) << 32;
+    clock.now = wrap * 1000 + 7000;
+    do_traversal(sys, [&](context ctx) {
+        REQUIRE(get_raw_animation_tick_count(ctx) == 7);
+        REQUIRE(get_raw_precise_animation_tick_count(ctx) == clock.now);
+        REQUIRE(
+            get_raw_precise_animation_ticks_left(ctx, clock.now + 10)
+            == 10);
+    });
+}
@@ -0,0 +1,125 @@
+#include <alia/tracing.hpp>
+
+#include <functional>
+#include <sstream>
+
+#include <testing.hpp>
+
+#include <alia/flow/events.hpp>
+#include <alia/signals/application.hpp>
+#include <alia/signals/async.hpp>
+#include <alia/signals/basic.hpp>
+#include <alia/system.hpp>
+
+using namespace alia;
+
+namespace {
+
+struct traced_event
+{
+};
+
+int
+count_occurrences(std::string const& s, std::string const& pattern)
+{
+    int count = 0;
+    for (size_t i = s.find(pattern); i != std::string::npos;
+         i = s.find(pattern, i + 1))
+    {
+        ++count;
+    }
+    return count;
+}
+
+} // namespace
+
+TEST_CASE("trace_args", "[tracing]")
+{
+    trace_args args;
+    args("n", 12)("s", "a \"quoted\" string");
+    REQUIRE(args.json == "\"n\":12,\"s\":\"a \\\"quoted\\\" string\"");
+}
+
+TEST_CASE("trace_args control characters", "[tracing]")
+{
+    trace_args args;
+    args("s", "tab\tcr\rnl\nbell\x07");
+    REQUIRE(args.json == "\"s\":\"tab\\tcr\\rnl\\nbell\\u0007\"");
+}
+
+TEST_CASE("trace event encoding", "[tracing]")
+{
+    std::ostringstream out;
+    {
+        trace_event_sink sink(out);
+        // Make the timestamp large enough that a default-precision double
+        // would be written in scientific notation.
+        sink.start_time -= std::chrono::seconds(1000);
+        write_trace_event(sink, 'i', "a\tb\x01", "test");
+    }
+    std::string trace = out.str();
+    REQUIRE(count_occurrences(trace, "\"name\":\"a\\tb\\u0001\"") == 1);
+    auto ts = trace.find("\"ts\":");
+    REQUIRE(ts != std::string::npos);
+    auto ts_end = trace.find(',', ts);
+    std::string ts_value = trace.substr(ts + 5, ts_end - ts - 5);
+    REQUIRE(ts_value.size() >= 10);
+    for (char c : ts_value)
+        REQUIRE((c >= '0' && c <= '9'));
+}
+
+TEST_CASE("system tracing", "[tracing]")
+{
+    std::ostringstream out;
+    {
+        trace_event_sink sink(out);
+
+        alia::system sys;
+        sys.tracer = &sink;
+
+        routing_region_ptr target;
+        std::function<void(int)> reporter;
+        int x = 1;
+        sys.controller = [&](context ctx) {
+            auto a = apply(
+                ctx, [](int x) { return x * 2; }, value(x));
+            REQUIRE(signal_has_value(a));
+            async<int>(
+                ctx,
+                [&](auto, auto report, int x) { reporter = report; },
+                a);
+            scoped_routing_region srr(ctx);
+            target = get_active_routing_region(ctx);
+        };
+
+        refresh_system(sys);
+        REQUIRE(reporter);
+
+        traced_event event;
+        impl::dispatch_targeted_event(sys, event, target);
+        impl::dispatch_event(sys, event);
+
+        // Completing the async operation also refreshes the system.
+        reporter(4);
+    }
+
+    std::string trace = out.str();
+    REQUIRE(trace.front() == '[');
+    REQUIRE(trace.substr(trace.size() - 3) == "\n]\n");
+
+    // one explicit refresh and one from the async completion (plus the
+    // untargeted event itself)
+    REQUIRE(count_occurrences(trace, "\"name\":\"refresh_system\"") == 4);
+    REQUIRE(count_occurrences(trace, "\"name\":\"dispatch_event\"") == 6);
+    REQUIRE(
+        count_occurrences(trace, "\"name\":\"dispatch_targeted_event\"") == 2);
+    REQUIRE(count_occurrences(trace, "\"path_length\":1") == 1);
+    REQUIRE(count_occurrences(trace, "\"path_length\":0") == 3);
+    REQUIRE(count_occurrences(trace, "\"name\":\"apply\"") == 2);
+    REQUIRE(count_occurrences(trace, "\"ph\":\"b\"") == 1);
+    REQUIRE(count_occurrences(trace, "\"ph\":\"e\"") == 1);
+    REQUIRE(count_occurrences(trace, "\"outcome\":\"complete\"") == 1);
+    REQUIRE(
+        count_occurrences(trace, "\"ph\":\"B\"")
+        == count_occurrences(trace, "\"ph\":\"E\""));
+}